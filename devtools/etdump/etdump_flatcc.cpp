@@ -427,6 +427,29 @@ void ETDumpGen::end_profiling(EventTracerEntry prof_entry) {
   etdump_RunData_events_push_end(builder);
 }
 
+void ETDumpGen::log_profiling(
+    const char* name,
+    ChainID chain_id,
+    DebugHandle debug_handle,
+    et_timestamp_t start_time,
+    et_timestamp_t end_time) {
+  check_ready_to_add_events();
+  int64_t string_id = name != nullptr ? create_string_entry(name) : -1;
+
+  etdump_ProfileEvent_start(builder);
+  etdump_ProfileEvent_start_time_add(builder, start_time);
+  etdump_ProfileEvent_end_time_add(builder, end_time);
+  etdump_ProfileEvent_chain_index_add(builder, chain_id);
+  etdump_ProfileEvent_instruction_id_add(builder, debug_handle);
+  if (string_id != -1) {
+    etdump_ProfileEvent_name_add(builder, string_id);
+  }
+  etdump_ProfileEvent_ref_t id = etdump_ProfileEvent_end(builder);
+  etdump_RunData_events_push_start(builder);
+  etdump_Event_profile_event_add(builder, id);
+  etdump_RunData_events_push_end(builder);
+}
+
 AllocatorID ETDumpGen::track_allocator(const char* name) {
   ET_CHECK_MSG(
       (etdump_gen_state == ETDumpGen_Block_Created ||
@@ -77,6 +77,16 @@ class ETDumpGen : public EventTracer {
       ChainID chain_id = -1,
       DebugHandle debug_handle = 0) override;
   virtual void end_profiling(EventTracerEntry prof_entry) override;
+  /**
+   * Log a profiling event that has already completed, e.g. one recorded by
+   * another EventTracer and replayed into this one.
+   */
+  void log_profiling(
+      const char* name,
+      ChainID chain_id,
+      DebugHandle debug_handle,
+      et_timestamp_t start_time,
+      et_timestamp_t end_time);
   virtual EventTracerEntry start_profiling_delegate(
       const char* name,
       DebugHandle delegate_debug_index) override;
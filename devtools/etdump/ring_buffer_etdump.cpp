@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/devtools/etdump/ring_buffer_etdump.h>
+
+#include <utility>
+#include <vector>
+
+#include <executorch/runtime/platform/log.h>
+
+namespace torch {
+namespace executor {
+
+Error ring_buffer_to_etdump(
+    const void* data,
+    size_t size,
+    ETDumpGen& etdump_gen) {
+  Result<RingBufferTrace> trace = RingBufferTrace::parse(data, size);
+  if (!trace.ok()) {
+    return trace.error();
+  }
+  const std::vector<std::string>& names = trace->names;
+  const std::vector<RingBufferEvent>& events = trace->events;
+  // Returns nullptr for unnamed events.
+  auto name_of = [&names](uint32_t id) -> const char* {
+    return id < names.size() ? names[id].c_str() : nullptr;
+  };
+
+  size_t begin = 0;
+  while (begin < events.size()) {
+    const char* block_name = "ring_buffer";
+    if (events[begin].kind == RingBufferEventKind::kBlock) {
+      const char* name = name_of(events[begin].id);
+      block_name = name != nullptr ? name : "";
+      ++begin;
+    }
+    size_t end = begin;
+    while (end < events.size() &&
+           events[end].kind != RingBufferEventKind::kBlock) {
+      ++end;
+    }
+    etdump_gen.create_event_block(block_name);
+
+    // ETDump wants the allocators of a block before any of its events.
+    std::vector<std::pair<AllocatorID, AllocatorID>> allocator_ids;
+    auto find_allocator =
+        [&allocator_ids](AllocatorID id) -> const AllocatorID* {
+      for (const auto& ids : allocator_ids) {
+        if (ids.first == id) {
+          return &ids.second;
+        }
+      }
+      return nullptr;
+    };
+    for (size_t i = begin; i < end; ++i) {
+      const RingBufferEvent& event = events[i];
+      if (event.kind == RingBufferEventKind::kAllocation &&
+          find_allocator(event.id) == nullptr) {
+        // Allocator ids are name indices plus one.
+        const char* name = name_of(event.id - 1);
+        allocator_ids.emplace_back(
+            event.id, etdump_gen.track_allocator(name != nullptr ? name : ""));
+      }
+    }
+
+    for (size_t i = begin; i < end; ++i) {
+      const RingBufferEvent& event = events[i];
+      switch (event.kind) {
+        case RingBufferEventKind::kOperator:
+          etdump_gen.log_profiling(
+              name_of(event.id),
+              event.chain_id,
+              event.debug_handle,
+              event.start_time,
+              event.end_time);
+          break;
+        case RingBufferEventKind::kDelegateInt:
+          etdump_gen.set_chain_debug_handle(event.chain_id, event.debug_handle);
+          etdump_gen.log_profiling_delegate(
+              nullptr,
+              event.id,
+              event.start_time,
+              event.end_time,
+              nullptr,
+              0);
+          break;
+        case RingBufferEventKind::kDelegateStr: {
+          const char* name = name_of(event.id);
+          etdump_gen.set_chain_debug_handle(event.chain_id, event.debug_handle);
+          etdump_gen.log_profiling_delegate(
+              name != nullptr ? name : "",
+              static_cast<DebugHandle>(-1),
+              event.start_time,
+              event.end_time,
+              nullptr,
+              0);
+          break;
+        }
+        case RingBufferEventKind::kAllocation:
+          etdump_gen.set_chain_debug_handle(event.chain_id, event.debug_handle);
+          etdump_gen.track_allocation(
+              *find_allocator(event.id), static_cast<size_t>(event.end_time));
+          break;
+        default:
+          ET_LOG(
+              Error,
+              "Unknown ring buffer event kind %d",
+              static_cast<int>(event.kind));
+          return Error::InvalidArgument;
+      }
+    }
+    begin = end;
+  }
+  etdump_gen.set_chain_debug_handle(kUnsetChainId, kUnsetDebugHandle);
+  return Error::Ok;
+}
+
+} // namespace executor
+} // namespace torch
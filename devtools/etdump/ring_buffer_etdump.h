@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include <executorch/devtools/etdump/etdump_flatcc.h>
+#include <executorch/devtools/etdump/ring_buffer_event_tracer.h>
+#include <executorch/runtime/core/error.h>
+
+namespace torch {
+namespace executor {
+
+/**
+ * Converts a dump of a RingBufferEventTracer into an ETDump.
+ *
+ * Events are replayed into `etdump_gen` in start time order. Each block
+ * becomes a RunData holding the allocators used in it, followed by its
+ * profiling and allocation events. Events recorded before the first block
+ * are placed in a block named "ring_buffer".
+ *
+ * @param[in] data The dump returned by RingBufferEventTracer::dump().
+ * @param[in] size The size of the dump in bytes.
+ * @param[in] etdump_gen The ETDumpGen to add the events to. Should not have
+ *     any events yet.
+ *
+ * @returns Error::Ok, or Error::InvalidArgument if the dump is malformed.
+ */
+Error ring_buffer_to_etdump(
+    const void* data,
+    size_t size,
+    ETDumpGen& etdump_gen);
+
+} // namespace executor
+} // namespace torch
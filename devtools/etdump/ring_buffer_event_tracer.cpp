@@ -0,0 +1,428 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/devtools/etdump/ring_buffer_event_tracer.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <thread>
+
+namespace torch {
+namespace executor {
+
+namespace {
+
+constexpr char kDumpMagic[4] = {'E', 'T', 'R', 'B'};
+constexpr uint32_t kDumpVersion = 1;
+
+/// The start of a dump. Followed by `num_names` DumpedNames, then by
+/// `num_events` RingBufferEvents.
+struct DumpHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t name_capacity;
+  uint32_t num_names;
+  uint32_t num_events;
+  uint64_t num_dropped_events;
+};
+
+struct DumpedName {
+  uint32_t index;
+  char name[RingBufferEventTracer::kMaxNameLength];
+};
+
+enum NameSlotState : uint32_t {
+  kNameSlotEmpty = 0,
+  kNameSlotWriting = 1,
+  kNameSlotReady = 2,
+};
+
+size_t next_power_of_two(size_t n) {
+  size_t power = 1;
+  while (power < n) {
+    power <<= 1;
+  }
+  return power;
+}
+
+/// FNV-1a over the part of the name that fits in the name table.
+uint32_t hash_name(const char* name, size_t* length) {
+  uint32_t hash = 2166136261u;
+  size_t i = 0;
+  for (; i < RingBufferEventTracer::kMaxNameLength - 1 && name[i] != '\0';
+       ++i) {
+    hash = (hash ^ static_cast<uint8_t>(name[i])) * 16777619u;
+  }
+  *length = i;
+  return hash;
+}
+
+std::atomic<uint64_t> next_serial{1};
+
+/// The ring the current thread used last, and the tracer it belongs to.
+struct ThreadRingCache {
+  uint64_t serial = 0;
+  void* ring = nullptr;
+};
+thread_local ThreadRingCache thread_ring_cache;
+
+} // namespace
+
+struct RingBufferEventTracer::Ring {
+  std::atomic<std::thread::id> owner{};
+  // Number of events ever written. Only the owner writes events.
+  std::atomic<uint64_t> head{0};
+  RingBufferEvent* events = nullptr;
+};
+
+struct RingBufferEventTracer::NameSlot {
+  std::atomic<uint32_t> state{kNameSlotEmpty};
+  uint32_t hash = 0;
+  char name[kMaxNameLength];
+};
+
+RingBufferEventTracer::RingBufferEventTracer(
+    size_t events_per_thread,
+    size_t max_threads,
+    size_t max_names)
+    : serial_(next_serial.fetch_add(1)),
+      ring_mask_(next_power_of_two(std::max<size_t>(events_per_thread, 1)) - 1),
+      max_threads_(std::max<size_t>(max_threads, 1)),
+      rings_(new Ring[max_threads_]),
+      events_(new RingBufferEvent[max_threads_ * (ring_mask_ + 1)]),
+      name_mask_(
+          next_power_of_two(
+              std::min(std::max<size_t>(max_names, 1), kMaxNames)) -
+          1),
+      names_(new NameSlot[name_mask_ + 1]) {
+  for (size_t i = 0; i < max_threads_; ++i) {
+    rings_[i].events = &events_[i * (ring_mask_ + 1)];
+  }
+}
+
+RingBufferEventTracer::~RingBufferEventTracer() = default;
+
+RingBufferEventTracer::Ring* RingBufferEventTracer::ring_for_current_thread() {
+  ThreadRingCache& cache = thread_ring_cache;
+  if (cache.serial == serial_) {
+    return static_cast<Ring*>(cache.ring);
+  }
+  const std::thread::id self = std::this_thread::get_id();
+  Ring* ring = nullptr;
+  for (size_t i = 0; i < max_threads_ && ring == nullptr; ++i) {
+    std::thread::id owner = rings_[i].owner.load(std::memory_order_acquire);
+    if (owner == self) {
+      ring = &rings_[i];
+    } else if (
+        owner == std::thread::id() &&
+        rings_[i].owner.compare_exchange_strong(
+            owner, self, std::memory_order_acq_rel)) {
+      ring = &rings_[i];
+    }
+  }
+  if (ring != nullptr) {
+    cache.serial = serial_;
+    cache.ring = ring;
+  }
+  return ring;
+}
+
+void RingBufferEventTracer::record(const RingBufferEvent& event) {
+  Ring* ring = ring_for_current_thread();
+  if (ring == nullptr) {
+    num_unowned_events_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  const uint64_t head = ring->head.load(std::memory_order_relaxed);
+  ring->events[head & ring_mask_] = event;
+  ring->head.store(head + 1, std::memory_order_release);
+}
+
+uint32_t RingBufferEventTracer::intern(const char* name) {
+  if (name == nullptr) {
+    return kNoName;
+  }
+  size_t length = 0;
+  const uint32_t hash = hash_name(name, &length);
+  for (size_t probe = 0; probe <= name_mask_; ++probe) {
+    const size_t index = (hash + probe) & name_mask_;
+    NameSlot& slot = names_[index];
+    uint32_t state = slot.state.load(std::memory_order_acquire);
+    if (state == kNameSlotEmpty &&
+        slot.state.compare_exchange_strong(
+            state, kNameSlotWriting, std::memory_order_acq_rel)) {
+      slot.hash = hash;
+      std::memcpy(slot.name, name, length);
+      slot.name[length] = '\0';
+      slot.state.store(kNameSlotReady, std::memory_order_release);
+      return index;
+    }
+    // Another thread may be writing this slot, possibly with the same name.
+    while (state == kNameSlotWriting) {
+      std::this_thread::yield();
+      state = slot.state.load(std::memory_order_acquire);
+    }
+    if (slot.hash == hash && std::strncmp(slot.name, name, length) == 0 &&
+        slot.name[length] == '\0') {
+      return index;
+    }
+  }
+  // The table is full.
+  return kNoName;
+}
+
+void RingBufferEventTracer::create_event_block(const char* name) {
+  RingBufferEvent event{};
+  event.start_time = et_pal_current_ticks();
+  event.end_time = event.start_time;
+  event.chain_id = kUnsetChainId;
+  event.debug_handle = kUnsetDebugHandle;
+  event.id = intern(name);
+  event.kind = RingBufferEventKind::kBlock;
+  record(event);
+}
+
+EventTracerEntry RingBufferEventTracer::start_profiling(
+    const char* name,
+    ChainID chain_id,
+    DebugHandle debug_handle) {
+  EventTracerEntry prof_entry;
+  prof_entry.event_id = intern(name);
+  prof_entry.delegate_event_id_type = DelegateDebugIdType::kNone;
+  if (chain_id == kUnsetChainId) {
+    prof_entry.chain_id = chain_id_;
+    prof_entry.debug_handle = debug_handle_;
+  } else {
+    prof_entry.chain_id = chain_id;
+    prof_entry.debug_handle = debug_handle;
+  }
+  prof_entry.start_time = et_pal_current_ticks();
+  return prof_entry;
+}
+
+void RingBufferEventTracer::end_profiling(EventTracerEntry prof_entry) {
+  RingBufferEvent event{};
+  event.end_time = et_pal_current_ticks();
+  event.start_time = prof_entry.start_time;
+  event.chain_id = prof_entry.chain_id;
+  event.debug_handle = prof_entry.debug_handle;
+  event.id = static_cast<uint32_t>(prof_entry.event_id);
+  event.kind = RingBufferEventKind::kOperator;
+  record(event);
+}
+
+EventTracerEntry RingBufferEventTracer::start_profiling_delegate(
+    const char* name,
+    DebugHandle delegate_debug_index) {
+  EventTracerEntry prof_entry;
+  if (name == nullptr) {
+    prof_entry.delegate_event_id_type = DelegateDebugIdType::kInt;
+    prof_entry.event_id = delegate_debug_index;
+  } else {
+    prof_entry.delegate_event_id_type = DelegateDebugIdType::kStr;
+    prof_entry.event_id = intern(name);
+  }
+  prof_entry.chain_id = chain_id_;
+  prof_entry.debug_handle = debug_handle_;
+  prof_entry.start_time = et_pal_current_ticks();
+  return prof_entry;
+}
+
+void RingBufferEventTracer::end_profiling_delegate(
+    EventTracerEntry event_tracer_entry,
+    ET_UNUSED const void* metadata,
+    ET_UNUSED size_t metadata_len) {
+  RingBufferEvent event{};
+  event.end_time = et_pal_current_ticks();
+  event.start_time = event_tracer_entry.start_time;
+  event.chain_id = event_tracer_entry.chain_id;
+  event.debug_handle = event_tracer_entry.debug_handle;
+  event.id = static_cast<uint32_t>(event_tracer_entry.event_id);
+  event.kind =
+      event_tracer_entry.delegate_event_id_type == DelegateDebugIdType::kInt
+      ? RingBufferEventKind::kDelegateInt
+      : RingBufferEventKind::kDelegateStr;
+  record(event);
+}
+
+void RingBufferEventTracer::log_profiling_delegate(
+    const char* name,
+    DebugHandle delegate_debug_index,
+    et_timestamp_t start_time,
+    et_timestamp_t end_time,
+    ET_UNUSED const void* metadata,
+    ET_UNUSED size_t metadata_len) {
+  RingBufferEvent event{};
+  event.start_time = start_time;
+  event.end_time = end_time;
+  event.chain_id = chain_id_;
+  event.debug_handle = debug_handle_;
+  if (name == nullptr) {
+    event.id = delegate_debug_index;
+    event.kind = RingBufferEventKind::kDelegateInt;
+  } else {
+    event.id = intern(name);
+    event.kind = RingBufferEventKind::kDelegateStr;
+  }
+  record(event);
+}
+
+AllocatorID RingBufferEventTracer::track_allocator(const char* name) {
+  // Allocator ids are name indices plus one, so that kNoName maps to 0.
+  return intern(name) + 1;
+}
+
+void RingBufferEventTracer::track_allocation(AllocatorID id, size_t size) {
+  RingBufferEvent event{};
+  event.start_time = et_pal_current_ticks();
+  event.end_time = size;
+  event.chain_id = chain_id_;
+  event.debug_handle = debug_handle_;
+  event.id = id;
+  event.kind = RingBufferEventKind::kAllocation;
+  record(event);
+}
+
+uint64_t RingBufferEventTracer::num_dropped_events() const {
+  uint64_t dropped = num_unowned_events_.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < max_threads_; ++i) {
+    const uint64_t head = rings_[i].head.load(std::memory_order_acquire);
+    if (head > ring_mask_ + 1) {
+      dropped += head - (ring_mask_ + 1);
+    }
+  }
+  return dropped;
+}
+
+void RingBufferEventTracer::reset() {
+  for (size_t i = 0; i < max_threads_; ++i) {
+    rings_[i].head.store(0, std::memory_order_release);
+  }
+  num_unowned_events_.store(0, std::memory_order_relaxed);
+}
+
+std::vector<uint8_t> RingBufferEventTracer::dump() const {
+  std::vector<DumpedName> names;
+  for (size_t i = 0; i <= name_mask_; ++i) {
+    if (names_[i].state.load(std::memory_order_acquire) == kNameSlotReady) {
+      DumpedName name{};
+      name.index = i;
+      std::memcpy(name.name, names_[i].name, kMaxNameLength);
+      names.push_back(name);
+    }
+  }
+
+  std::vector<RingBufferEvent> events;
+  for (size_t i = 0; i < max_threads_; ++i) {
+    const uint64_t head = rings_[i].head.load(std::memory_order_acquire);
+    const uint64_t count = std::min<uint64_t>(head, ring_mask_ + 1);
+    for (uint64_t j = head - count; j < head; ++j) {
+      events.push_back(rings_[i].events[j & ring_mask_]);
+    }
+  }
+  // Each ring is ordered by completion; merge them by start time.
+  std::stable_sort(
+      events.begin(),
+      events.end(),
+      [](const RingBufferEvent& a, const RingBufferEvent& b) {
+        return a.start_time < b.start_time;
+      });
+
+  DumpHeader header{};
+  std::memcpy(header.magic, kDumpMagic, sizeof(kDumpMagic));
+  header.version = kDumpVersion;
+  header.name_capacity = name_mask_ + 1;
+  header.num_names = names.size();
+  header.num_events = events.size();
+  header.num_dropped_events = num_dropped_events();
+
+  std::vector<uint8_t> out(
+      sizeof(header) + names.size() * sizeof(DumpedName) +
+      events.size() * sizeof(RingBufferEvent));
+  uint8_t* cursor = out.data();
+  std::memcpy(cursor, &header, sizeof(header));
+  cursor += sizeof(header);
+  std::memcpy(cursor, names.data(), names.size() * sizeof(DumpedName));
+  cursor += names.size() * sizeof(DumpedName);
+  std::memcpy(cursor, events.data(), events.size() * sizeof(RingBufferEvent));
+  return out;
+}
+
+Result<RingBufferTrace> RingBufferTrace::parse(const void* data, size_t size) {
+  const uint8_t* cursor = static_cast<const uint8_t*>(data);
+  DumpHeader header;
+  ET_CHECK_OR_RETURN_ERROR(
+      data != nullptr && size >= sizeof(header),
+      InvalidArgument,
+      "Dump too small: %zu bytes",
+      size);
+  std::memcpy(&header, cursor, sizeof(header));
+  cursor += sizeof(header);
+  ET_CHECK_OR_RETURN_ERROR(
+      std::memcmp(header.magic, kDumpMagic, sizeof(kDumpMagic)) == 0 &&
+          header.version == kDumpVersion,
+      InvalidArgument,
+      "Not a ring buffer dump, or unsupported version");
+  // Check the counts against the size first, so that computing the expected
+  // size can't overflow.
+  const size_t body_size = size - sizeof(header);
+  ET_CHECK_OR_RETURN_ERROR(
+      header.num_names <= body_size / sizeof(DumpedName) &&
+          header.num_events <= body_size / sizeof(RingBufferEvent),
+      InvalidArgument,
+      "Dump of %zu bytes can't hold %" PRIu32 " names and %" PRIu32 " events",
+      size,
+      header.num_names,
+      header.num_events);
+  const size_t expected_size = sizeof(header) +
+      size_t(header.num_names) * sizeof(DumpedName) +
+      size_t(header.num_events) * sizeof(RingBufferEvent);
+  ET_CHECK_OR_RETURN_ERROR(
+      size == expected_size,
+      InvalidArgument,
+      "Dump is %zu bytes, expected %zu",
+      size,
+      expected_size);
+  // The name table is allocated from name_capacity, so don't trust it beyond
+  // what the tracer can produce.
+  ET_CHECK_OR_RETURN_ERROR(
+      header.name_capacity > 0 &&
+          (header.name_capacity & (header.name_capacity - 1)) == 0 &&
+          header.name_capacity <= RingBufferEventTracer::kMaxNames &&
+          header.num_names <= header.name_capacity,
+      InvalidArgument,
+      "Invalid name table capacity %" PRIu32 " for %" PRIu32 " names",
+      header.name_capacity,
+      header.num_names);
+
+  RingBufferTrace trace;
+  trace.names.resize(header.name_capacity);
+  for (uint32_t i = 0; i < header.num_names; ++i) {
+    DumpedName name;
+    std::memcpy(&name, cursor, sizeof(name));
+    cursor += sizeof(name);
+    ET_CHECK_OR_RETURN_ERROR(
+        name.index < header.name_capacity,
+        InvalidArgument,
+        "Invalid name index %" PRIu32,
+        name.index);
+    trace.names[name.index].assign(
+        name.name, strnlen(name.name, sizeof(name.name)));
+  }
+  trace.events.resize(header.num_events);
+  std::memcpy(
+      trace.events.data(),
+      cursor,
+      trace.events.size() * sizeof(RingBufferEvent));
+  trace.num_dropped_events = header.num_dropped_events;
+  return trace;
+}
+
+} // namespace executor
+} // namespace torch
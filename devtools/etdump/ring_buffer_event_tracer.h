@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <executorch/runtime/core/event_tracer.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/core/span.h>
+#include <executorch/runtime/platform/platform.h>
+
+namespace torch {
+namespace executor {
+
+/// Kinds of events recorded by RingBufferEventTracer. Serialized; don't
+/// reorder.
+enum class RingBufferEventKind : uint8_t {
+  /// create_event_block(). `id` is the name index.
+  kBlock = 0,
+  /// start_profiling()/end_profiling(). `id` is the name index.
+  kOperator = 1,
+  /// A delegate event with an integer debug id, stored in `id`.
+  kDelegateInt = 2,
+  /// A delegate event with a string debug id. `id` is the name index.
+  kDelegateStr = 3,
+  /// track_allocation(). `id` is the allocator id, `end_time` the size.
+  kAllocation = 4,
+};
+
+/// A fixed-size event, as stored in the ring buffers and in dumps.
+struct RingBufferEvent {
+  et_timestamp_t start_time;
+  /// The end time of profiling events, or the size of allocations.
+  uint64_t end_time;
+  ChainID chain_id;
+  DebugHandle debug_handle;
+  uint32_t id;
+  RingBufferEventKind kind;
+};
+static_assert(sizeof(RingBufferEvent) == 32, "Events should be 32 bytes");
+
+/// The contents of a dump produced by RingBufferEventTracer::dump().
+struct RingBufferTrace {
+  /// Interned names, indexed by the `id` of events that refer to a name.
+  std::vector<std::string> names;
+  /// Events of all threads, ordered by start time.
+  std::vector<RingBufferEvent> events;
+  /// Events lost because a ring wrapped around, or no ring was left for the
+  /// thread that logged them.
+  uint64_t num_dropped_events;
+
+  /**
+   * Parses a dump.
+   *
+   * @param[in] data The dump.
+   * @param[in] size The size of the dump in bytes.
+   *
+   * @returns The trace, or Error::InvalidArgument if the dump is malformed.
+   */
+  static Result<RingBufferTrace> parse(const void* data, size_t size);
+};
+
+/**
+ * An EventTracer cheap enough to leave on in production.
+ *
+ * Instead of building an ETDump as events arrive, like ETDumpGen does, it
+ * writes fixed-size RingBufferEvent records into ring buffers allocated up
+ * front. Each thread that logs events gets a ring of its own, so logging
+ * takes no locks and does no allocation. When a ring is full, its oldest
+ * events are overwritten, so the trace always holds the most recent events.
+ *
+ * Names (of events, blocks and allocators) are copied into a fixed-size table
+ * the first time they are seen. Names longer than kMaxNameLength - 1
+ * characters are truncated.
+ *
+ * Debug events (log_evalue() and log_intermediate_output_delegate()) and
+ * delegate metadata are not recorded: use ETDumpGen to debug numerics.
+ *
+ * dump() serializes the trace; ring_buffer_to_etdump() converts a dump into
+ * an ETDump later, possibly elsewhere. dump() and reset() must not run
+ * concurrently with the logging of events, e.g. call them between executions.
+ */
+class RingBufferEventTracer final : public EventTracer {
+ public:
+  /// The size of each entry in the name table, including the terminator.
+  static constexpr size_t kMaxNameLength = 64;
+  /// The name index of unnamed events.
+  static constexpr uint32_t kNoName = UINT32_MAX;
+  /// The largest capacity of the name table.
+  static constexpr size_t kMaxNames = size_t(1) << 16;
+
+  /**
+   * @param[in] events_per_thread The capacity of each ring, rounded up to a
+   *     power of two.
+   * @param[in] max_threads The number of rings. Events from additional
+   *     threads are dropped.
+   * @param[in] max_names The capacity of the name table, rounded up to a
+   *     power of two and capped at kMaxNames.
+   */
+  explicit RingBufferEventTracer(
+      size_t events_per_thread = 4096,
+      size_t max_threads = 4,
+      size_t max_names = 1024);
+  ~RingBufferEventTracer() override;
+
+  RingBufferEventTracer(const RingBufferEventTracer&) = delete;
+  RingBufferEventTracer& operator=(const RingBufferEventTracer&) = delete;
+
+  void create_event_block(const char* name) override;
+  EventTracerEntry start_profiling(
+      const char* name,
+      ChainID chain_id = kUnsetChainId,
+      DebugHandle debug_handle = kUnsetDebugHandle) override;
+  void end_profiling(EventTracerEntry prof_entry) override;
+  EventTracerEntry start_profiling_delegate(
+      const char* name,
+      DebugHandle delegate_debug_index) override;
+  void end_profiling_delegate(
+      EventTracerEntry event_tracer_entry,
+      const void* metadata = nullptr,
+      size_t metadata_len = 0) override;
+  void log_profiling_delegate(
+      const char* name,
+      DebugHandle delegate_debug_index,
+      et_timestamp_t start_time,
+      et_timestamp_t end_time,
+      const void* metadata = nullptr,
+      size_t metadata_len = 0) override;
+  void track_allocation(AllocatorID id, size_t size) override;
+  AllocatorID track_allocator(const char* name) override;
+  void log_evalue(const EValue& evalue, LoggedEValueType evalue_type)
+      override {}
+  void log_intermediate_output_delegate(
+      const char* name,
+      DebugHandle delegate_debug_index,
+      const exec_aten::Tensor& output) override {}
+  void log_intermediate_output_delegate(
+      const char* name,
+      DebugHandle delegate_debug_index,
+      const ArrayRef<exec_aten::Tensor> output) override {}
+  void log_intermediate_output_delegate(
+      const char* name,
+      DebugHandle delegate_debug_index,
+      const int& output) override {}
+  void log_intermediate_output_delegate(
+      const char* name,
+      DebugHandle delegate_debug_index,
+      const bool& output) override {}
+  void log_intermediate_output_delegate(
+      const char* name,
+      DebugHandle delegate_debug_index,
+      const double& output) override {}
+
+  /**
+   * Serializes the names and the events currently in the rings. The dump can
+   * be read back with RingBufferTrace::parse().
+   */
+  std::vector<uint8_t> dump() const;
+
+  /// Discards all events. Names are kept.
+  void reset();
+
+  /// Returns the number of events lost so far.
+  uint64_t num_dropped_events() const;
+
+ private:
+  struct Ring;
+  struct NameSlot;
+
+  Ring* ring_for_current_thread();
+  void record(const RingBufferEvent& event);
+  uint32_t intern(const char* name);
+
+  // Identifies this tracer in the per-thread cache of rings, even if another
+  // tracer is later created at the same address.
+  const uint64_t serial_;
+  const size_t ring_mask_;
+  const size_t max_threads_;
+  std::unique_ptr<Ring[]> rings_;
+  std::unique_ptr<RingBufferEvent[]> events_;
+  const size_t name_mask_;
+  std::unique_ptr<NameSlot[]> names_;
+  std::atomic<uint64_t> num_unowned_events_{0};
+};
+
+} // namespace executor
+} // namespace torch
@@ -112,3 +112,39 @@ def define_common_targets():
                 "@EXECUTORCH_CLIENTS",
             ],
         )
+
+        runtime.cxx_library(
+            name = "ring_buffer_event_tracer" + aten_suffix,
+            srcs = [
+                "ring_buffer_event_tracer.cpp",
+            ],
+            exported_headers = [
+                "ring_buffer_event_tracer.h",
+            ],
+            exported_deps = [
+                "//executorch/runtime/core:event_tracer" + aten_suffix,
+                "//executorch/runtime/platform:platform",
+            ],
+            visibility = [
+                "//executorch/...",
+                "@EXECUTORCH_CLIENTS",
+            ],
+        )
+
+        runtime.cxx_library(
+            name = "ring_buffer_etdump" + aten_suffix,
+            srcs = [
+                "ring_buffer_etdump.cpp",
+            ],
+            exported_headers = [
+                "ring_buffer_etdump.h",
+            ],
+            exported_deps = [
+                ":etdump_flatcc" + aten_suffix,
+                ":ring_buffer_event_tracer" + aten_suffix,
+            ],
+            visibility = [
+                "//executorch/...",
+                "@EXECUTORCH_CLIENTS",
+            ],
+        )
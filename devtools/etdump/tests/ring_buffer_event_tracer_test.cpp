@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include <executorch/devtools/etdump/etdump_flatcc.h>
+#include <executorch/devtools/etdump/etdump_schema_flatcc_reader.h>
+#include <executorch/devtools/etdump/ring_buffer_etdump.h>
+#include <executorch/devtools/etdump/ring_buffer_event_tracer.h>
+#include <executorch/runtime/platform/runtime.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace torch {
+namespace executor {
+
+class RingBufferEventTracerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    torch::executor::runtime_init();
+  }
+
+  static RingBufferTrace parse(const RingBufferEventTracer& tracer) {
+    std::vector<uint8_t> dump = tracer.dump();
+    Result<RingBufferTrace> trace =
+        RingBufferTrace::parse(dump.data(), dump.size());
+    EXPECT_EQ(trace.error(), Error::Ok);
+    return std::move(trace.get());
+  }
+};
+
+TEST_F(RingBufferEventTracerTest, RecordsEvents) {
+  RingBufferEventTracer tracer;
+  tracer.create_event_block("test_block");
+  AllocatorID allocator = tracer.track_allocator("test_allocator");
+
+  EventTracerEntry entry = tracer.start_profiling("test_event", 2, 3);
+  tracer.end_profiling(entry);
+  tracer.track_allocation(allocator, 128);
+
+  tracer.set_chain_debug_handle(4, 5);
+  entry = tracer.start_profiling_delegate(nullptr, 7);
+  tracer.end_profiling_delegate(entry);
+  const et_timestamp_t start_time = et_pal_current_ticks();
+  tracer.log_profiling_delegate(
+      "delegate_event", -1, start_time, start_time + 100);
+
+  RingBufferTrace trace = parse(tracer);
+  EXPECT_EQ(trace.num_dropped_events, 0);
+  ASSERT_EQ(trace.events.size(), 5);
+
+  const RingBufferEvent& block = trace.events[0];
+  EXPECT_EQ(block.kind, RingBufferEventKind::kBlock);
+  EXPECT_EQ(trace.names[block.id], "test_block");
+
+  const RingBufferEvent& op = trace.events[1];
+  EXPECT_EQ(op.kind, RingBufferEventKind::kOperator);
+  EXPECT_EQ(trace.names[op.id], "test_event");
+  EXPECT_EQ(op.chain_id, 2);
+  EXPECT_EQ(op.debug_handle, 3);
+  EXPECT_LE(op.start_time, op.end_time);
+
+  const RingBufferEvent& allocation = trace.events[2];
+  EXPECT_EQ(allocation.kind, RingBufferEventKind::kAllocation);
+  EXPECT_EQ(allocation.id, allocator);
+  EXPECT_EQ(allocation.end_time, 128);
+  EXPECT_EQ(trace.names[allocation.id - 1], "test_allocator");
+
+  const RingBufferEvent& delegate_int = trace.events[3];
+  EXPECT_EQ(delegate_int.kind, RingBufferEventKind::kDelegateInt);
+  EXPECT_EQ(delegate_int.id, 7);
+  EXPECT_EQ(delegate_int.chain_id, 4);
+  EXPECT_EQ(delegate_int.debug_handle, 5);
+
+  const RingBufferEvent& delegate_str = trace.events[4];
+  EXPECT_EQ(delegate_str.kind, RingBufferEventKind::kDelegateStr);
+  EXPECT_EQ(trace.names[delegate_str.id], "delegate_event");
+  EXPECT_EQ(delegate_str.start_time, start_time);
+  EXPECT_EQ(delegate_str.end_time, start_time + 100);
+}
+
+TEST_F(RingBufferEventTracerTest, InternsNames) {
+  RingBufferEventTracer tracer;
+  EventTracerEntry entry1 = tracer.start_profiling("name");
+  std::string copy = "name";
+  EventTracerEntry entry2 = tracer.start_profiling(copy.c_str());
+  EventTracerEntry entry3 = tracer.start_profiling("other_name");
+  EXPECT_EQ(entry1.event_id, entry2.event_id);
+  EXPECT_NE(entry1.event_id, entry3.event_id);
+
+  // Names are truncated to fit in the table.
+  const std::string long_name(200, 'x');
+  tracer.end_profiling(tracer.start_profiling(long_name.c_str()));
+  RingBufferTrace trace = parse(tracer);
+  ASSERT_EQ(trace.events.size(), 1);
+  EXPECT_EQ(
+      trace.names[trace.events[0].id],
+      long_name.substr(0, RingBufferEventTracer::kMaxNameLength - 1));
+}
+
+TEST_F(RingBufferEventTracerTest, FullNameTableLeavesEventsUnnamed) {
+  RingBufferEventTracer tracer(16, 1, /*max_names=*/2);
+  EXPECT_NE(
+      tracer.start_profiling("a").event_id, RingBufferEventTracer::kNoName);
+  EXPECT_NE(
+      tracer.start_profiling("b").event_id, RingBufferEventTracer::kNoName);
+  EXPECT_EQ(
+      tracer.start_profiling("c").event_id, RingBufferEventTracer::kNoName);
+}
+
+TEST_F(RingBufferEventTracerTest, KeepsMostRecentEvents) {
+  RingBufferEventTracer tracer(/*events_per_thread=*/4);
+  for (int i = 0; i < 10; ++i) {
+    tracer.end_profiling(tracer.start_profiling(nullptr, 0, i));
+  }
+  EXPECT_EQ(tracer.num_dropped_events(), 6);
+
+  RingBufferTrace trace = parse(tracer);
+  EXPECT_EQ(trace.num_dropped_events, 6);
+  ASSERT_EQ(trace.events.size(), 4);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(trace.events[i].debug_handle, 6 + i);
+    EXPECT_EQ(trace.events[i].id, RingBufferEventTracer::kNoName);
+  }
+
+  tracer.reset();
+  EXPECT_EQ(tracer.num_dropped_events(), 0);
+  EXPECT_EQ(parse(tracer).events.size(), 0);
+}
+
+TEST_F(RingBufferEventTracerTest, RecordsEventsFromThreads) {
+  constexpr int kNumThreads = 4;
+  constexpr int kEventsPerThread = 100;
+  RingBufferEventTracer tracer(
+      /*events_per_thread=*/kEventsPerThread, /*max_threads=*/kNumThreads);
+
+  auto log_events = [&tracer](int thread_index) {
+    const std::string name = "thread_" + std::to_string(thread_index);
+    for (int i = 0; i < kEventsPerThread; ++i) {
+      tracer.end_profiling(tracer.start_profiling(name.c_str(), thread_index));
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back(log_events, i);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  RingBufferTrace trace = parse(tracer);
+  EXPECT_EQ(trace.num_dropped_events, 0);
+  ASSERT_EQ(trace.events.size(), kNumThreads * kEventsPerThread);
+  std::vector<int> counts(kNumThreads);
+  for (const auto& event : trace.events) {
+    ASSERT_GE(event.chain_id, 0);
+    ASSERT_LT(event.chain_id, kNumThreads);
+    EXPECT_EQ(
+        trace.names[event.id], "thread_" + std::to_string(event.chain_id));
+    counts[event.chain_id]++;
+  }
+  for (int count : counts) {
+    EXPECT_EQ(count, kEventsPerThread);
+  }
+}
+
+TEST_F(RingBufferEventTracerTest, DropsEventsOfThreadsWithoutRing) {
+  RingBufferEventTracer tracer(16, /*max_threads=*/1);
+  tracer.end_profiling(tracer.start_profiling("main"));
+  std::thread([&tracer]() {
+    tracer.end_profiling(tracer.start_profiling("other"));
+  }).join();
+
+  EXPECT_EQ(tracer.num_dropped_events(), 1);
+  EXPECT_EQ(parse(tracer).events.size(), 1);
+}
+
+TEST_F(RingBufferEventTracerTest, ParseRejectsMalformedDumps) {
+  RingBufferEventTracer tracer;
+  tracer.end_profiling(tracer.start_profiling("event"));
+  std::vector<uint8_t> dump = tracer.dump();
+
+  EXPECT_EQ(
+      RingBufferTrace::parse(dump.data(), dump.size() - 1).error(),
+      Error::InvalidArgument);
+  EXPECT_EQ(
+      RingBufferTrace::parse(dump.data(), 4).error(), Error::InvalidArgument);
+  dump[0] = 'X';
+  EXPECT_EQ(
+      RingBufferTrace::parse(dump.data(), dump.size()).error(),
+      Error::InvalidArgument);
+}
+
+TEST_F(RingBufferEventTracerTest, ParseRejectsInvalidNameCapacity) {
+  RingBufferEventTracer tracer(/*events_per_thread=*/16, /*max_threads=*/1);
+  tracer.end_profiling(tracer.start_profiling("a"));
+  tracer.end_profiling(tracer.start_profiling("b"));
+  const std::vector<uint8_t> dump = tracer.dump();
+  // The header is the magic and version, then name_capacity and num_names.
+  constexpr size_t kNameCapacityOffset = 8;
+  constexpr size_t kNumNamesOffset = 12;
+
+  auto parse_with = [&dump](size_t offset, uint32_t value) {
+    std::vector<uint8_t> modified = dump;
+    std::memcpy(modified.data() + offset, &value, sizeof(value));
+    return RingBufferTrace::parse(modified.data(), modified.size()).error();
+  };
+  EXPECT_EQ(parse_with(kNameCapacityOffset, 1024), Error::Ok);
+  // Not a power of two.
+  EXPECT_EQ(parse_with(kNameCapacityOffset, 1000), Error::InvalidArgument);
+  EXPECT_EQ(parse_with(kNameCapacityOffset, 0), Error::InvalidArgument);
+  // Fewer slots than names.
+  EXPECT_EQ(parse_with(kNameCapacityOffset, 1), Error::InvalidArgument);
+  // Larger than any tracer's table.
+  EXPECT_EQ(
+      parse_with(kNameCapacityOffset, uint32_t(1) << 31),
+      Error::InvalidArgument);
+  // More names than the dump holds, even if the size computation wraps.
+  EXPECT_EQ(parse_with(kNumNamesOffset, 3), Error::InvalidArgument);
+  EXPECT_EQ(parse_with(kNumNamesOffset, UINT32_MAX), Error::InvalidArgument);
+}
+
+TEST_F(RingBufferEventTracerTest, CapsNameCapacity) {
+  RingBufferEventTracer tracer(
+      /*events_per_thread=*/16,
+      /*max_threads=*/1,
+      /*max_names=*/RingBufferEventTracer::kMaxNames * 4);
+  tracer.end_profiling(tracer.start_profiling("event"));
+  RingBufferTrace trace = parse(tracer);
+  EXPECT_EQ(trace.names.size(), RingBufferEventTracer::kMaxNames);
+}
+
+TEST_F(RingBufferEventTracerTest, ConvertsToETDump) {
+  RingBufferEventTracer tracer;
+  tracer.end_profiling(tracer.start_profiling("before_block"));
+  tracer.create_event_block("test_block");
+  AllocatorID allocator = tracer.track_allocator("test_allocator");
+  EventTracerEntry entry = tracer.start_profiling("test_event", 0, 1);
+  tracer.end_profiling(entry);
+  tracer.track_allocation(allocator, 64);
+  std::vector<uint8_t> dump = tracer.dump();
+
+  ETDumpGen etdump_gen;
+  ASSERT_EQ(
+      ring_buffer_to_etdump(dump.data(), dump.size(), etdump_gen), Error::Ok);
+  EXPECT_EQ(etdump_gen.get_num_blocks(), 2);
+
+  etdump_result result = etdump_gen.get_etdump_data();
+  ASSERT_NE(result.buf, nullptr);
+  size_t size = 0;
+  void* buf = flatbuffers_read_size_prefix(result.buf, &size);
+  etdump_ETDump_table_t etdump = etdump_ETDump_as_root_with_identifier(
+      buf, etdump_ETDump_file_identifier);
+  ASSERT_NE(etdump, nullptr);
+
+  etdump_RunData_vec_t run_data_vec = etdump_ETDump_run_data(etdump);
+  ASSERT_EQ(etdump_RunData_vec_len(run_data_vec), 2);
+  etdump_RunData_table_t first = etdump_RunData_vec_at(run_data_vec, 0);
+  EXPECT_EQ(std::string(etdump_RunData_name(first)), "ring_buffer");
+
+  etdump_RunData_table_t second = etdump_RunData_vec_at(run_data_vec, 1);
+  EXPECT_EQ(std::string(etdump_RunData_name(second)), "test_block");
+  etdump_Allocator_vec_t allocators = etdump_RunData_allocators(second);
+  ASSERT_EQ(etdump_Allocator_vec_len(allocators), 1);
+  EXPECT_EQ(
+      std::string(etdump_Allocator_name(etdump_Allocator_vec_at(allocators, 0))),
+      "test_allocator");
+
+  etdump_Event_vec_t events = etdump_RunData_events(second);
+  ASSERT_EQ(etdump_Event_vec_len(events), 2);
+  etdump_ProfileEvent_table_t profile_event =
+      etdump_Event_profile_event(etdump_Event_vec_at(events, 0));
+  EXPECT_EQ(std::string(etdump_ProfileEvent_name(profile_event)), "test_event");
+  EXPECT_EQ(etdump_ProfileEvent_chain_index(profile_event), 0);
+  EXPECT_EQ(etdump_ProfileEvent_instruction_id(profile_event), 1);
+  EXPECT_EQ(
+      etdump_ProfileEvent_start_time(profile_event), entry.start_time);
+  etdump_AllocationEvent_table_t allocation_event =
+      etdump_Event_allocation_event(etdump_Event_vec_at(events, 1));
+  EXPECT_EQ(etdump_AllocationEvent_allocator_id(allocation_event), 1);
+  EXPECT_EQ(etdump_AllocationEvent_allocation_size(allocation_event), 64);
+
+  free(result.buf);
+}
+
+} // namespace executor
+} // namespace torch
@@ -19,3 +19,17 @@ def define_common_targets():
             "//executorch/runtime/core/exec_aten/testing_util:tensor_util",
         ],
     )
+
+    runtime.cxx_test(
+        name = "ring_buffer_event_tracer_test",
+        srcs = [
+            "ring_buffer_event_tracer_test.cpp",
+        ],
+        deps = [
+            "//executorch/devtools/etdump:etdump_flatcc",
+            "//executorch/devtools/etdump:etdump_schema_flatcc",
+            "//executorch/devtools/etdump:ring_buffer_etdump",
+            "//executorch/devtools/etdump:ring_buffer_event_tracer",
+            "//executorch/runtime/platform:platform",
+        ],
+    )
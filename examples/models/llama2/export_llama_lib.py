@@ -55,6 +55,7 @@ from .source_transformation.sdpa import (
     replace_kv_cache_with_simple_kv_cache,
     replace_sdpa_with_custom_op,
     replace_sdpa_with_flex_sdpa,
+    replace_sdpa_with_quantized_kv_cache_custom_op,
     replace_sdpa_with_simple_sdpa,
 )
 
@@ -205,6 +206,12 @@ def build_args_parser() -> argparse.ArgumentParser:
         action="store_true",
         help="Whether to use sdpa_with_kv_cache update op when using kv cache",
     )
+    parser.add_argument(
+        "--quantize_kv_cache",
+        default=False,
+        action="store_true",
+        help="Store the kv cache as int8 with per token, per head scales. Requires --use_sdpa_with_kv_cache.",
+    )
     parser.add_argument(
         "--disable_dynamic_shape",
         dest="enable_dynamic_shape",
@@ -212,6 +219,12 @@ def build_args_parser() -> argparse.ArgumentParser:
         action="store_false",
         help="Enable dynamic shape along seq dim. Used for faster prefill",
     )
+    parser.add_argument(
+        "--max_prefill_chunk_size",
+        type=int,
+        default=None,
+        help="Max number of tokens per call of a model with kv cache and dynamic shape. Its activations are planned for this many tokens, and the runner prefills longer prompts in chunks. Defaults to max_seq_length - 1.",
+    )
     parser.add_argument(
         "-p",
         "--params",
@@ -396,7 +409,12 @@ def _prepare_for_llama_export(modelname: str, args) -> LLMEdgeManager:
     if args.expand_rope_table:
         transforms.append(materialze_broadcast_of_rope_freq_cis)
 
-    if args.use_sdpa_with_kv_cache:
+    if args.quantize_kv_cache:
+        assert (
+            args.use_sdpa_with_kv_cache
+        ), "--quantize_kv_cache requires --use_sdpa_with_kv_cache"
+        transforms.append(replace_sdpa_with_quantized_kv_cache_custom_op)
+    elif args.use_sdpa_with_kv_cache:
         transforms.append(replace_sdpa_with_custom_op)
 
     if args.use_kv_cache:
@@ -423,6 +441,7 @@ def _prepare_for_llama_export(modelname: str, args) -> LLMEdgeManager:
             enable_dynamic_shape=args.enable_dynamic_shape,
             verbose=args.verbose,
             max_seq_len=args.max_seq_length,
+            max_prefill_chunk_size=args.max_prefill_chunk_size,
             metadata_str=args.metadata,
         )
         .set_output_dir(output_dir_path)
@@ -632,6 +651,7 @@ def _load_llama_model(
     enable_dynamic_shape: bool = False,
     verbose: bool = False,
     max_seq_len: int = 128,
+    max_prefill_chunk_size: Optional[int] = None,
     metadata_str: Optional[str] = None,
 ) -> "LLMEdgeManager":
     """
@@ -686,6 +706,7 @@ def _load_llama_model(
         example_inputs=example_inputs,
         enable_dynamic_shape=enable_dynamic_shape,
         verbose=verbose,
+        max_prefill_chunk_size=max_prefill_chunk_size,
         metadata=_load_llama_model_metadata(
             weight_type,
             use_kv_cache,
@@ -6,6 +6,8 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
+
 #include <gflags/gflags.h>
 
 #include <executorch/examples/models/llama2/runner/runner.h>
@@ -39,6 +41,21 @@ DEFINE_int32(
     -1,
     "Number of CPU threads for inference. Defaults to -1, which implies we'll use a heuristic to derive the # of performant cores for a specific device.");
 
+DEFINE_string(
+    draft_model_path,
+    "",
+    "Optional draft model for speculative decoding. It must share the tokenizer of the model, and the model must output the logits of every input position.");
+
+DEFINE_int32(
+    num_draft_tokens,
+    4,
+    "Number of tokens the draft model proposes per step of the model, when --draft_model_path is set.");
+
+DEFINE_int32(
+    prefix_cache_mb,
+    0,
+    "Size in MB of the snapshots of the KV cache kept for prompt prefixes, which later prompts that share a prefix restore instead of prefilling it. Defaults to 0, which disables the cache.");
+
 int32_t main(int32_t argc, char** argv) {
   gflags::ParseCommandLineFlags(&argc, &argv, true);
 
@@ -57,6 +74,13 @@ int32_t main(int32_t argc, char** argv) {
 
   int32_t cpu_threads = FLAGS_cpu_threads;
 
+  const char* draft_model_path = FLAGS_draft_model_path.c_str();
+
+  int32_t num_draft_tokens = FLAGS_num_draft_tokens;
+
+  size_t prefix_cache_bytes =
+      static_cast<size_t>(std::max(FLAGS_prefix_cache_mb, 0)) << 20;
+
 #if defined(ET_USE_THREADPOOL)
   uint32_t num_performant_cores = cpu_threads == -1
       ? torch::executorch::cpuinfo::get_num_performant_cores()
@@ -69,7 +93,13 @@ int32_t main(int32_t argc, char** argv) {
   }
 #endif
   // create llama runner
-  ::torch::executor::Runner runner(model_path, tokenizer_path, temperature);
+  ::torch::executor::Runner runner(
+      model_path,
+      tokenizer_path,
+      temperature,
+      draft_model_path,
+      num_draft_tokens,
+      prefix_cache_bytes);
 
   // generate
   runner.generate(prompt, seq_len);
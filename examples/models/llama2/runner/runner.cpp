@@ -11,6 +11,7 @@
 
 #include <executorch/examples/models/llama2/runner/runner.h>
 
+#include <algorithm>
 #include <ctime>
 
 #include <executorch/extension/llm/runner/util.h>
@@ -35,7 +36,10 @@ static constexpr auto kUseSDPAWithKVCache = "use_sdpa_with_kv_cache";
 Runner::Runner(
     const std::string& model_path,
     const std::string& tokenizer_path,
-    const float temperature)
+    const float temperature,
+    const std::string& draft_model_path,
+    const int32_t num_draft_tokens,
+    const size_t prefix_cache_bytes)
     // NOTE: we observed ~2x loading performance increase on iPhone 15
     // and a ~5% improvement on Galaxy S22 by switching to
     // FileDataLoader instead of MmapDataLoader + UseMlockIgnoreErrors.
@@ -50,17 +54,35 @@ Runner::Runner(
           {kNEos, 1},
           {kUseKVCache, true},
           {kUseSDPAWithKVCache, false},
-      }) {
+      }),
+      draft_module_(
+          draft_model_path.empty() ? nullptr
+                                   : std::make_unique<Module>(
+                                         draft_model_path,
+                                         Module::LoadMode::File)),
+      num_draft_tokens_(num_draft_tokens),
+      prefix_cache_bytes_(prefix_cache_bytes) {
   ET_LOG(
       Info,
       "Creating LLaMa runner: model_path=%s, tokenizer_path=%s",
       model_path.c_str(),
       tokenizer_path.c_str());
+  if (draft_module_) {
+    ET_LOG(
+        Info,
+        "Decoding speculatively: draft_model_path=%s, num_draft_tokens=%d",
+        draft_model_path.c_str(),
+        num_draft_tokens);
+  }
+  if (prefix_cache_bytes_ > 0) {
+    ET_LOG(Info, "Caching prompt prefixes: %zu bytes", prefix_cache_bytes_);
+  }
 }
 
 bool Runner::is_loaded() const {
   return module_->is_loaded() && tokenizer_ && text_decoder_runner_ &&
-      text_prefiller_ && text_token_generator_;
+      text_prefiller_ && text_token_generator_ &&
+      (!draft_module_ || speculative_token_generator_);
 }
 
 Error Runner::load() {
@@ -129,6 +151,36 @@ Error Runner::load() {
       metadata_.at(kUseKVCache),
       metadata_.at(kEnableDynamicShape));
 
+  if (draft_module_) {
+    ET_CHECK_OK_OR_RETURN_ERROR(draft_module_->load_method("forward"));
+    const auto draft_method_names = ET_UNWRAP(
+        draft_module_->method_names(), "Failed reading draft method names");
+    bool draft_enable_dynamic_shape = false;
+    if (draft_method_names.count(kEnableDynamicShape)) {
+      draft_enable_dynamic_shape =
+          ET_UNWRAP(draft_module_->get(kEnableDynamicShape))
+              .toScalar()
+              .to<bool>();
+    }
+    draft_decoder_runner_ = std::make_unique<TextDecoderRunner>(
+        draft_module_.get(),
+        /*use_kv_cache=*/true,
+        metadata_.at(kVocabSize),
+        temperature_);
+    draft_prefiller_ = std::make_unique<TextPrefiller>(
+        draft_decoder_runner_.get(),
+        /*use_kv_cache=*/true,
+        draft_enable_dynamic_shape);
+    speculative_token_generator_ = std::make_unique<SpeculativeTokenGenerator>(
+        tokenizer_.get(),
+        text_decoder_runner_.get(),
+        draft_decoder_runner_.get(),
+        num_draft_tokens_,
+        metadata_.at(kUseKVCache),
+        std::make_unique<std::unordered_set<uint64_t>>(*eos_ids),
+        &stats_);
+  }
+
   text_token_generator_ = std::make_unique<TextTokenGenerator>(
       tokenizer_.get(),
       text_decoder_runner_.get(),
@@ -136,6 +188,15 @@ Error Runner::load() {
       std::move(eos_ids),
       &stats_);
 
+  if (prefix_cache_bytes_ > 0) {
+    if (metadata_.at(kUseKVCache)) {
+      prefix_cache_ =
+          std::make_unique<PrefixCache>(module_.get(), prefix_cache_bytes_);
+    } else {
+      ET_LOG(Info, "Model has no KV cache, not caching prompt prefixes");
+    }
+  }
+
   return Error::Ok;
 }
 
@@ -205,19 +266,56 @@ Error Runner::generate(
   // print prompts
   wrapped_callback(prompt);
   int64_t pos = 0;
-  auto prefill_res = text_prefiller_->prefill(prompt_tokens, pos);
+  stats_.num_cached_prompt_tokens = 0;
+  if (prefix_cache_) {
+    // Keep at least the last prompt token to prefill, for its logits.
+    const int64_t max_reuse = num_prompt_tokens - 1;
+    pos = ET_UNWRAP(prefix_cache_->restore(prompt_tokens, max_reuse));
+    stats_.num_cached_prompt_tokens = pos;
+    // Snapshot where this prompt branches off a previous one, e.g. after a
+    // shared system prompt, so that later prompts can restore it too.
+    const int64_t branch_pos = std::min(
+        prefix_cache_->shared_prefix_length(prompt_tokens), max_reuse);
+    if (branch_pos > pos) {
+      std::vector<uint64_t> shared_tokens(
+          prompt_tokens.begin() + pos, prompt_tokens.begin() + branch_pos);
+      ET_CHECK_OK_OR_RETURN_ERROR(
+          text_prefiller_->prefill(shared_tokens, pos).error());
+      ET_CHECK_OK_OR_RETURN_ERROR(prefix_cache_->save(prompt_tokens, pos));
+    }
+  }
+  std::vector<uint64_t> remaining_tokens(
+      prompt_tokens.begin() + pos, prompt_tokens.end());
+  auto prefill_res = text_prefiller_->prefill(remaining_tokens, pos);
   stats_.first_token_ms = util::time_in_ms();
   stats_.prompt_eval_end_ms = util::time_in_ms();
   ET_CHECK_OK_OR_RETURN_ERROR(prefill_res.error());
   uint64_t cur_token = prefill_res.get();
+  if (prefix_cache_) {
+    ET_CHECK_OK_OR_RETURN_ERROR(
+        prefix_cache_->save(prompt_tokens, num_prompt_tokens));
+  }
+  if (draft_prefiller_) {
+    // The draft model proposes tokens from its own KV cache, so it needs the
+    // prompt as well.
+    int64_t draft_pos = 0;
+    ET_CHECK_OK_OR_RETURN_ERROR(
+        draft_prefiller_->prefill(prompt_tokens, draft_pos).error());
+  }
 
   // print the first token from prefill. No prev_token so use cur_token for it.
   wrapped_callback(ET_UNWRAP(tokenizer_->decode(cur_token, cur_token)));
 
   // start the main loop
   prompt_tokens.push_back(cur_token);
-  int64_t num_generated_tokens = ET_UNWRAP(text_token_generator_->generate(
-      prompt_tokens, num_prompt_tokens, seq_len, wrapped_callback));
+  int64_t num_generated_tokens = 0;
+  if (speculative_token_generator_) {
+    num_generated_tokens = ET_UNWRAP(speculative_token_generator_->generate(
+        prompt_tokens, num_prompt_tokens, seq_len, wrapped_callback));
+  } else {
+    num_generated_tokens = ET_UNWRAP(text_token_generator_->generate(
+        prompt_tokens, num_prompt_tokens, seq_len, wrapped_callback));
+  }
 
   stats_.inference_end_ms = util::time_in_ms();
   printf("\n");
@@ -239,6 +337,9 @@ Error Runner::generate(
 void Runner::stop() {
   if (is_loaded()) {
     text_token_generator_->stop();
+    if (speculative_token_generator_) {
+      speculative_token_generator_->stop();
+    }
   } else {
     ET_LOG(Error, "Token generator is not loaded, cannot stop");
   }
@@ -17,6 +17,8 @@
 #include <string>
 #include <unordered_map>
 
+#include <executorch/extension/llm/runner/prefix_cache.h>
+#include <executorch/extension/llm/runner/speculative_token_generator.h>
 #include <executorch/extension/llm/runner/stats.h>
 #include <executorch/extension/llm/runner/text_decoder_runner.h>
 #include <executorch/extension/llm/runner/text_prefiller.h>
@@ -32,7 +34,10 @@ class Runner {
   explicit Runner(
       const std::string& model_path,
       const std::string& tokenizer_path,
-      const float temperature = 0.8f);
+      const float temperature = 0.8f,
+      const std::string& draft_model_path = "",
+      const int32_t num_draft_tokens = 4,
+      const size_t prefix_cache_bytes = 0);
 
   bool is_loaded() const;
   Error load();
@@ -56,6 +61,17 @@ class Runner {
   std::unique_ptr<TextPrefiller> text_prefiller_;
   std::unique_ptr<TextTokenGenerator> text_token_generator_;
 
+  // draft model for speculative decoding, if any
+  std::unique_ptr<Module> draft_module_;
+  int32_t num_draft_tokens_;
+  std::unique_ptr<TextDecoderRunner> draft_decoder_runner_;
+  std::unique_ptr<TextPrefiller> draft_prefiller_;
+  std::unique_ptr<SpeculativeTokenGenerator> speculative_token_generator_;
+
+  // snapshots of the KV cache for prompt prefixes, if enabled
+  size_t prefix_cache_bytes_;
+  std::unique_ptr<PrefixCache> prefix_cache_;
+
   // stats
   Stats stats_;
 };
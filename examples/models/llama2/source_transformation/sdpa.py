@@ -70,6 +70,83 @@ def replace_sdpa_with_custom_op(module: torch.nn.Module) -> torch.nn.Module:
     return module
 
 
+class SDPACustomQuantizedKVCache(torch.nn.Module):
+    """
+    Same as SDPACustom, but keeps the KV cache as int8, with a float scale for
+    each token of each head, using llama.sdpa_with_quantized_kv_cache.
+    """
+
+    def __init__(
+        self,
+        kv_cache: KVCache,
+        dim: int,
+    ):
+        super().__init__()
+        # Only the shape of the float cache is kept.
+        cache_shape = kv_cache.k_cache.shape
+        scales_shape = cache_shape[:-1] + (1,)
+        self.register_buffer("k_cache", torch.zeros(cache_shape, dtype=torch.int8))
+        self.register_buffer("v_cache", torch.zeros(cache_shape, dtype=torch.int8))
+        self.register_buffer(
+            "k_cache_scales", torch.zeros(scales_shape, dtype=torch.float32)
+        )
+        self.register_buffer(
+            "v_cache_scales", torch.zeros(scales_shape, dtype=torch.float32)
+        )
+        self.dim = dim
+
+    def forward(
+        self,
+        input_pos: torch.Tensor,
+        q: torch.Tensor,
+        k: torch.Tensor,
+        v: torch.Tensor,
+        bsz,
+        seqlen,
+        mask,
+    ):
+        output = torch.ops.llama.sdpa_with_quantized_kv_cache(
+            q,
+            k,
+            v,
+            self.k_cache,
+            self.v_cache,
+            self.k_cache_scales,
+            self.v_cache_scales,
+            input_pos[-1].item(),
+            seqlen,
+            None,  # Attention mask
+            0,  # dropout probability. Ignored by the code
+            True,  # is_causal
+        )
+        return output.view(bsz, seqlen, self.dim)
+
+
+def _replace_sdpa_with_quantized_kv_cache_custom_op(module: torch.nn.Module):
+    for name, child in module.named_children():
+        if isinstance(child, SDPA):
+            setattr(
+                module,
+                name,
+                SDPACustomQuantizedKVCache(child.kv_cache, child.dim),
+            )
+            # Drop the float cache, so that it isn't exported next to the int8
+            # one.
+            if isinstance(getattr(module, "kv_cache", None), KVCache):
+                del module.kv_cache
+        else:
+            _replace_sdpa_with_quantized_kv_cache_custom_op(child)
+
+
+def replace_sdpa_with_quantized_kv_cache_custom_op(
+    module: torch.nn.Module,
+) -> torch.nn.Module:
+    from executorch.extension.llm.custom_ops import sdpa_with_kv_cache  # noqa
+
+    _replace_sdpa_with_quantized_kv_cache_custom_op(module)
+    return module
+
+
 class SDPASimple(torch.nn.Module):
 
     def __init__(
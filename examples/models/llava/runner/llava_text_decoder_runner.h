@@ -82,6 +82,23 @@ class LlavaTextDecoderRunner : public TextDecoderRunner {
     return methods_loaded;
   }
 
+  /**
+   * Get the max number of tokens that step() takes at once, from the shape
+   * bound of the text model's embeddings input.
+   * @return The max number of tokens per step.
+   */
+  inline Result<int64_t> max_seq_len_per_step() override {
+    auto method_meta = ET_UNWRAP(module_->method_meta(kTextModelMethod));
+    // The embeddings are the second input, of shape [batch, seq_len, dim].
+    auto embeddings_meta = ET_UNWRAP(method_meta.input_tensor_meta(1));
+    ET_CHECK_OR_RETURN_ERROR(
+        embeddings_meta.sizes().size() == 3,
+        InvalidProgram,
+        "Expected embeddings of rank 3, got rank %zu",
+        embeddings_meta.sizes().size());
+    return embeddings_meta.sizes()[1];
+  }
+
   inline static const std::string kTokenEmbeddingMethod = "token_embedding";
   inline static const std::string kTextModelMethod = "text_model";
 };
@@ -55,6 +55,56 @@ Range get_overlapping_pages(uintptr_t offset, size_t size, size_t page_size) {
   };
 }
 
+/**
+ * Passes the hints in `policy` for the mapped pages to madvise(). Failures are
+ * logged and otherwise ignored, since the pages are usable either way.
+ */
+void advise_pages(
+    void* pages,
+    size_t size,
+    const MmapDataLoader::SegmentPolicy& policy) {
+  int advice = MADV_NORMAL;
+  switch (policy.advice) {
+    case MmapDataLoader::AccessAdvice::Normal:
+      break;
+    case MmapDataLoader::AccessAdvice::Sequential:
+      advice = MADV_SEQUENTIAL;
+      break;
+    case MmapDataLoader::AccessAdvice::Random:
+      advice = MADV_RANDOM;
+      break;
+    case MmapDataLoader::AccessAdvice::WillNeed:
+      advice = MADV_WILLNEED;
+      break;
+  }
+#if !defined(MAP_POPULATE)
+  if (policy.populate) {
+    advice = MADV_WILLNEED;
+  }
+#endif
+  if (advice != MADV_NORMAL && ::madvise(pages, size, advice) < 0) {
+    ET_LOG(
+        Debug,
+        "Ignoring madvise(%p, %zu, %d) error: %s (%d)",
+        pages,
+        size,
+        advice,
+        ::strerror(errno),
+        errno);
+  }
+#if defined(MADV_HUGEPAGE)
+  if (policy.huge_pages && ::madvise(pages, size, MADV_HUGEPAGE) < 0) {
+    ET_LOG(
+        Debug,
+        "Ignoring madvise(%p, %zu, MADV_HUGEPAGE) error: %s (%d)",
+        pages,
+        size,
+        ::strerror(errno),
+        errno);
+  }
+#endif
+}
+
 } // namespace
 
 MmapDataLoader::~MmapDataLoader() {
@@ -69,6 +119,13 @@ MmapDataLoader::~MmapDataLoader() {
 Result<MmapDataLoader> MmapDataLoader::from(
     const char* file_name,
     MmapDataLoader::MlockConfig mlock_config) {
+  return from(file_name, mlock_config, SegmentPolicies());
+}
+
+Result<MmapDataLoader> MmapDataLoader::from(
+    const char* file_name,
+    MmapDataLoader::MlockConfig mlock_config,
+    const SegmentPolicies& segment_policies) {
   // Cache the page size.
   long page_size = sysconf(_SC_PAGESIZE);
   if (page_size < 0) {
@@ -120,20 +177,52 @@ Result<MmapDataLoader> MmapDataLoader::from(
       file_size,
       file_name_copy,
       static_cast<size_t>(page_size),
-      mlock_config);
+      mlock_config,
+      segment_policies);
+}
+
+const MmapDataLoader::SegmentPolicy& MmapDataLoader::segment_policy(
+    DataLoader::SegmentInfo::Type segment_type) const {
+  switch (segment_type) {
+    case DataLoader::SegmentInfo::Type::Constant:
+      return segment_policies_.constant;
+    case DataLoader::SegmentInfo::Type::Backend:
+      return segment_policies_.backend;
+    case DataLoader::SegmentInfo::Type::Mutable:
+      return segment_policies_.mutable_data;
+    case DataLoader::SegmentInfo::Type::Program:
+    default:
+      return segment_policies_.program;
+  }
 }
 
 namespace {
+/**
+ * Set in the MunmapSegment() context when the pages should be reclaimed before
+ * they are unmapped. Page sizes are powers of two larger than one, so the low
+ * bit is otherwise always clear.
+ */
+constexpr uintptr_t kReleasePagesOnFree = 1;
+
 /**
  * FreeableBuffer::FreeFn-compatible callback.
  *
- * `context` is actually the OS page size as a uintptr_t.
+ * `context` is actually the OS page size as a uintptr_t, possibly or'd with
+ * kReleasePagesOnFree.
  */
 void MunmapSegment(void* context, void* data, size_t size) {
-  const uintptr_t page_size = reinterpret_cast<uintptr_t>(context);
+  const uintptr_t context_bits = reinterpret_cast<uintptr_t>(context);
+  const uintptr_t page_size = context_bits & ~kReleasePagesOnFree;
 
   Range range =
       get_overlapping_pages(reinterpret_cast<uintptr_t>(data), size, page_size);
+  if (context_bits & kReleasePagesOnFree) {
+    // Only a hint; the pages are unmapped below either way. Unlike
+    // MADV_PAGEOUT, this doesn't evict the file's pages from the page cache,
+    // which other Modules or processes may be mapping.
+    (void)::madvise(
+        reinterpret_cast<void*>(range.start), range.size, MADV_DONTNEED);
+  }
   int ret = ::munmap(reinterpret_cast<void*>(range.start), range.size);
   if (ret < 0) {
     // Let the user know that something went wrong, but there's nothing we can
@@ -152,7 +241,7 @@ void MunmapSegment(void* context, void* data, size_t size) {
 Result<FreeableBuffer> MmapDataLoader::load(
     size_t offset,
     size_t size,
-    ET_UNUSED const DataLoader::SegmentInfo& segment_info) const {
+    const DataLoader::SegmentInfo& segment_info) const {
   ET_CHECK_OR_RETURN_ERROR(
       // Probably had its value moved to another instance.
       fd_ >= 0,
@@ -182,6 +271,14 @@ Result<FreeableBuffer> MmapDataLoader::load(
   Range range =
       get_overlapping_pages(static_cast<uintptr_t>(offset), size, page_size_);
 
+  const SegmentPolicy& policy = segment_policy(segment_info.segment_type);
+  int flags = MAP_PRIVATE;
+#if defined(MAP_POPULATE)
+  if (policy.populate) {
+    flags |= MAP_POPULATE;
+  }
+#endif
+
   // Map the pages read-only. MAP_PRIVATE vs. MAP_SHARED doesn't matter since
   // the data is read-only, but use PRIVATE just to further avoid accidentally
   // modifying the file.
@@ -189,7 +286,7 @@ Result<FreeableBuffer> MmapDataLoader::load(
       nullptr,
       range.size,
       PROT_READ,
-      MAP_PRIVATE,
+      flags,
       fd_,
       static_cast<off_t>(range.start));
   ET_CHECK_OR_RETURN_ERROR(
@@ -201,6 +298,8 @@ Result<FreeableBuffer> MmapDataLoader::load(
       fd_,
       range.start);
 
+  advise_pages(pages, range.size, policy);
+
   if (mlock_config_ == MlockConfig::UseMlock ||
       mlock_config_ == MlockConfig::UseMlockIgnoreErrors) {
     int err = ::mlock(pages, size);
@@ -245,7 +344,8 @@ Result<FreeableBuffer> MmapDataLoader::load(
       reinterpret_cast<void*>(
           // Pass the cached OS page size to the callback so it doesn't need to
           // query it again.
-          static_cast<uintptr_t>(page_size_)));
+          static_cast<uintptr_t>(page_size_) |
+          (policy.release_pages_on_free ? kReleasePagesOnFree : 0)));
 }
 
 Result<size_t> MmapDataLoader::size() const {
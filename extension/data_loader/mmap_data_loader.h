@@ -40,6 +40,62 @@ class MmapDataLoader final : public executorch::runtime::DataLoader {
     UseMlockIgnoreErrors,
   };
 
+  /**
+   * How the pages of a mapped segment are expected to be accessed. Passed to
+   * `madvise()` as a hint; ignored where unsupported.
+   */
+  enum class AccessAdvice {
+    /// No special treatment.
+    Normal,
+    /// Pages will be read once, in order. The kernel reads further ahead and
+    /// may drop pages soon after they have been read.
+    Sequential,
+    /// Pages will be read in no particular order. The kernel reads less ahead.
+    Random,
+    /// Pages will be needed soon. The kernel starts reading them from the
+    /// file in the background, and load() returns without waiting.
+    WillNeed,
+  };
+
+  /**
+   * How to map the segments of one DataLoader::SegmentInfo::Type.
+   */
+  struct SegmentPolicy {
+    /// Access hint for the segment's pages.
+    AccessAdvice advice = AccessAdvice::Normal;
+    /// Read every page of the segment, and map it, before load() returns, so
+    /// that later accesses do not page-fault. Uses `MAP_POPULATE` where
+    /// available, and falls back to `AccessAdvice::WillNeed` elsewhere.
+    bool populate = false;
+    /// Ask for transparent huge pages (`MADV_HUGEPAGE`), to reduce TLB misses
+    /// and page faults on large segments. Only takes effect on kernels that
+    /// support huge pages for read-only file mappings.
+    bool huge_pages = false;
+    /// When the buffer is freed, drop its pages from this mapping
+    /// (`MADV_DONTNEED`) before unmapping them. Useful for segments that are
+    /// only read once, such as backend data that is copied during init. The
+    /// file stays in the shared page cache, so other mappings of it are not
+    /// affected.
+    bool release_pages_on_free = false;
+  };
+
+  /**
+   * A SegmentPolicy for each DataLoader::SegmentInfo::Type.
+   *
+   * The defaults start reading constant segments as soon as they are mapped,
+   * and treat backend segments as read-once data.
+   */
+  struct SegmentPolicies {
+    SegmentPolicy program;
+    SegmentPolicy constant = {AccessAdvice::WillNeed};
+    SegmentPolicy backend = {
+        AccessAdvice::Sequential,
+        /*populate=*/false,
+        /*huge_pages=*/false,
+        /*release_pages_on_free=*/true};
+    SegmentPolicy mutable_data;
+  };
+
   /**
    * Creates a new MmapDataLoader that wraps the named file. Fails if
    * the file can't be opened for reading or if its size can't be found.
@@ -49,6 +105,16 @@ class MmapDataLoader final : public executorch::runtime::DataLoader {
    *     overhead of opening it again for every load() call.
    * @param[in] mlock_config How and whether to lock loaded pages with
    *     `mlock()`.
+   * @param[in] segment_policies How to map each type of segment.
+   */
+  static executorch::runtime::Result<MmapDataLoader> from(
+      const char* file_name,
+      MlockConfig mlock_config,
+      const SegmentPolicies& segment_policies);
+
+  /**
+   * Creates a new MmapDataLoader that wraps the named file, using the default
+   * SegmentPolicies.
    */
   static executorch::runtime::Result<MmapDataLoader> from(
       const char* file_name,
@@ -77,7 +143,8 @@ class MmapDataLoader final : public executorch::runtime::DataLoader {
         file_size_(rhs.file_size_),
         page_size_(rhs.page_size_),
         fd_(rhs.fd_),
-        mlock_config_(rhs.mlock_config_) {
+        mlock_config_(rhs.mlock_config_),
+        segment_policies_(rhs.segment_policies_) {
     const_cast<const char*&>(rhs.file_name_) = nullptr;
     const_cast<size_t&>(rhs.file_size_) = 0;
     const_cast<size_t&>(rhs.page_size_) = 0;
@@ -101,12 +168,17 @@ class MmapDataLoader final : public executorch::runtime::DataLoader {
       size_t file_size,
       const char* file_name,
       size_t page_size,
-      MlockConfig mlock_config)
+      MlockConfig mlock_config,
+      const SegmentPolicies& segment_policies)
       : file_name_(file_name),
         file_size_(file_size),
         page_size_(page_size),
         fd_(fd),
-        mlock_config_(mlock_config) {}
+        mlock_config_(mlock_config),
+        segment_policies_(segment_policies) {}
+
+  const SegmentPolicy& segment_policy(
+      DataLoader::SegmentInfo::Type segment_type) const;
 
   // Not safely copyable.
   MmapDataLoader(const MmapDataLoader&) = delete;
@@ -118,6 +190,7 @@ class MmapDataLoader final : public executorch::runtime::DataLoader {
   const size_t page_size_;
   const int fd_; // Owned by the instance.
   const MlockConfig mlock_config_;
+  const SegmentPolicies segment_policies_;
 };
 
 } // namespace extension
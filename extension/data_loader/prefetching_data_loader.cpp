@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/data_loader/prefetching_data_loader.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <executorch/extension/data_loader/file_data_loader.h>
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/log.h>
+
+using executorch::runtime::Error;
+using executorch::runtime::FreeableBuffer;
+using executorch::runtime::Result;
+
+namespace executorch {
+namespace extension {
+
+namespace {
+
+/// One prefetched range, from the prefetch() call until it is loaded.
+struct PendingRead {
+  enum class Status {
+    /// Waiting for an I/O thread.
+    Queued,
+    /// An I/O thread is reading it.
+    Reading,
+    /// The read finished; `error` and `buffer` hold the result.
+    Done,
+  };
+
+  PendingRead(size_t size_, const runtime::DataLoader::SegmentInfo& info)
+      : size(size_), segment_info(info) {}
+
+  const size_t size;
+  const runtime::DataLoader::SegmentInfo segment_info;
+  Status status = Status::Queued;
+  Error error = Error::Ok;
+  // FreeableBuffer can't be assigned, so the I/O thread replaces this instead.
+  std::unique_ptr<FreeableBuffer> buffer;
+};
+
+} // namespace
+
+struct PrefetchingDataLoader::State {
+  explicit State(FileDataLoader&& loader) : file_loader(std::move(loader)) {}
+
+  ~State() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stop = true;
+    }
+    work_available.notify_all();
+    // Threads finish the read they are on, then exit without starting
+    // another. Buffers they leave behind are freed with `pending`.
+    for (auto& thread : io_threads) {
+      thread.join();
+    }
+  }
+
+  void io_thread_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      work_available.wait(lock, [&]() { return stop || !queue.empty(); });
+      if (stop) {
+        return;
+      }
+      const size_t offset = queue.front();
+      queue.pop_front();
+      auto it = pending.find(offset);
+      // Skip ranges that load() has already taken over.
+      if (it == pending.end() ||
+          it->second->status != PendingRead::Status::Queued) {
+        continue;
+      }
+      PendingRead* read = it->second.get();
+      read->status = PendingRead::Status::Reading;
+
+      // `read` stays in `pending` while it is Reading, so it can be used
+      // without the lock.
+      lock.unlock();
+      Result<FreeableBuffer> buffer =
+          file_loader.load(offset, read->size, read->segment_info);
+      lock.lock();
+
+      if (buffer.ok()) {
+        read->buffer.reset(new FreeableBuffer(std::move(buffer.get())));
+      } else {
+        read->error = buffer.error();
+      }
+      read->status = PendingRead::Status::Done;
+      read_done.notify_all();
+    }
+  }
+
+  // Does the actual reads. Its methods are thread-safe.
+  FileDataLoader file_loader;
+  std::vector<std::thread> io_threads;
+
+  // Guards everything below.
+  std::mutex mutex;
+  std::condition_variable work_available;
+  std::condition_variable read_done;
+  bool stop = false;
+  // Offsets of queued ranges, in prefetch() order.
+  std::deque<size_t> queue;
+  // Prefetched ranges that have not been loaded yet, keyed by offset.
+  std::unordered_map<size_t, std::unique_ptr<PendingRead>> pending;
+};
+
+PrefetchingDataLoader::PrefetchingDataLoader(std::unique_ptr<State> state)
+    : state_(std::move(state)) {}
+
+PrefetchingDataLoader::PrefetchingDataLoader(
+    PrefetchingDataLoader&& rhs) noexcept = default;
+
+PrefetchingDataLoader::~PrefetchingDataLoader() = default;
+
+Result<PrefetchingDataLoader> PrefetchingDataLoader::from(
+    const char* file_name,
+    size_t alignment,
+    size_t num_io_threads) {
+  ET_CHECK_OR_RETURN_ERROR(
+      num_io_threads > 0, InvalidArgument, "num_io_threads must be positive");
+  Result<FileDataLoader> file_loader =
+      FileDataLoader::from(file_name, alignment);
+  if (!file_loader.ok()) {
+    return file_loader.error();
+  }
+
+  std::unique_ptr<State> state(new State(std::move(file_loader.get())));
+  State* state_ptr = state.get();
+  state->io_threads.reserve(num_io_threads);
+  for (size_t i = 0; i < num_io_threads; ++i) {
+    state->io_threads.emplace_back(
+        [state_ptr]() { state_ptr->io_thread_loop(); });
+  }
+  return PrefetchingDataLoader(std::move(state));
+}
+
+void PrefetchingDataLoader::prefetch(
+    size_t offset,
+    size_t size,
+    const SegmentInfo& segment_info) const {
+  if (state_ == nullptr || size == 0) {
+    return;
+  }
+  Result<size_t> file_size = state_->file_loader.size();
+  if (!file_size.ok() || offset + size > file_size.get()) {
+    // load() will report the error if this range is ever loaded.
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if (state_->pending.count(offset) != 0) {
+      return;
+    }
+    state_->pending.emplace(
+        offset,
+        std::unique_ptr<PendingRead>(new PendingRead(size, segment_info)));
+    state_->queue.push_back(offset);
+  }
+  state_->work_available.notify_one();
+}
+
+Result<FreeableBuffer> PrefetchingDataLoader::load(
+    size_t offset,
+    size_t size,
+    const DataLoader::SegmentInfo& segment_info) const {
+  ET_CHECK_OR_RETURN_ERROR(
+      // Probably had its value moved to another instance.
+      state_ != nullptr,
+      InvalidState,
+      "Uninitialized");
+
+  std::unique_ptr<PendingRead> read;
+  {
+    std::unique_lock<std::mutex> lock(state_->mutex);
+    auto it = state_->pending.find(offset);
+    if (it != state_->pending.end() &&
+        it->second->status == PendingRead::Status::Reading) {
+      // Look the range up again after waking up: another load() of the same
+      // range may have taken it in the meantime.
+      state_->read_done.wait(lock, [&]() {
+        it = state_->pending.find(offset);
+        return it == state_->pending.end() ||
+            it->second->status != PendingRead::Status::Reading;
+      });
+    }
+    // A read that is still queued is taken over too: reading it on this
+    // thread is no slower than waiting for an I/O thread to get to it.
+    if (it != state_->pending.end() && it->second->size == size) {
+      read = std::move(it->second);
+      state_->pending.erase(it);
+    }
+  }
+
+  if (read == nullptr || read->status != PendingRead::Status::Done) {
+    return state_->file_loader.load(offset, size, segment_info);
+  }
+  if (read->error != Error::Ok) {
+    return read->error;
+  }
+  return std::move(*read->buffer);
+}
+
+Result<size_t> PrefetchingDataLoader::size() const {
+  ET_CHECK_OR_RETURN_ERROR(
+      // Probably had its value moved to another instance.
+      state_ != nullptr,
+      InvalidState,
+      "Uninitialized");
+  return state_->file_loader.size();
+}
+
+ET_NODISCARD Error PrefetchingDataLoader::load_into(
+    size_t offset,
+    size_t size,
+    const SegmentInfo& segment_info,
+    void* buffer) const {
+  ET_CHECK_OR_RETURN_ERROR(
+      // Probably had its value moved to another instance.
+      state_ != nullptr,
+      InvalidState,
+      "Uninitialized");
+  return state_->file_loader.load_into(offset, size, segment_info, buffer);
+}
+
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include <executorch/runtime/core/data_loader.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/compiler.h>
+
+namespace executorch {
+namespace extension {
+
+/**
+ * A DataLoader that loads segments from a file, allocating the memory with
+ * `malloc()`, and that can read ranges ahead of time on a small pool of I/O
+ * threads.
+ *
+ * Ranges passed to prefetch() are queued and read concurrently in the
+ * background. A later load() of exactly the same range only waits for that
+ * one read to finish, and hands over its buffer without copying it. Any other
+ * load() reads the file synchronously, like FileDataLoader.
+ *
+ * Program::load() prefetches every segment of the program as soon as it has
+ * parsed the program header, so loading a program and its methods with this
+ * loader overlaps the segment reads instead of issuing them one at a time.
+ *
+ * Buffers for prefetched ranges that are never loaded are held until the
+ * loader is destroyed.
+ */
+class PrefetchingDataLoader final : public executorch::runtime::DataLoader {
+ public:
+  /// Default number of background I/O threads.
+  static constexpr size_t kDefaultNumIoThreads = 4;
+
+  /**
+   * Creates a new PrefetchingDataLoader that wraps the named file.
+   *
+   * @param[in] file_name Path to the file to read from.
+   * @param[in] alignment Alignment in bytes of pointers returned by this
+   *     instance. Must be a power of two.
+   * @param[in] num_io_threads Number of threads that read prefetched ranges.
+   *     Must be at least 1.
+   *
+   * @returns A new PrefetchingDataLoader on success.
+   * @retval Error::InvalidArgument `alignment` is not a power of two, or
+   *     `num_io_threads` is zero.
+   * @retval Error::AccessFailed `file_name` could not be opened, or its size
+   *     could not be found.
+   * @retval Error::MemoryAllocationFailed Internal memory allocation failure.
+   */
+  static executorch::runtime::Result<PrefetchingDataLoader> from(
+      const char* file_name,
+      size_t alignment = alignof(std::max_align_t),
+      size_t num_io_threads = kDefaultNumIoThreads);
+
+  // Movable to be compatible with Result.
+  PrefetchingDataLoader(PrefetchingDataLoader&& rhs) noexcept;
+
+  ~PrefetchingDataLoader() override;
+
+  ET_NODISCARD
+  executorch::runtime::Result<executorch::runtime::FreeableBuffer> load(
+      size_t offset,
+      size_t size,
+      const DataLoader::SegmentInfo& segment_info) const override;
+
+  ET_NODISCARD executorch::runtime::Result<size_t> size() const override;
+
+  ET_NODISCARD executorch::runtime::Error load_into(
+      size_t offset,
+      size_t size,
+      const SegmentInfo& segment_info,
+      void* buffer) const override;
+
+  /**
+   * Queues a background read of `[offset, offset + size)`. Does nothing if a
+   * prefetch of a range starting at `offset` is already pending, or if the
+   * range is empty or out of bounds.
+   */
+  void prefetch(size_t offset, size_t size, const SegmentInfo& segment_info)
+      const override;
+
+ private:
+  struct State;
+
+  explicit PrefetchingDataLoader(std::unique_ptr<State> state);
+
+  // Not safely copyable.
+  PrefetchingDataLoader(const PrefetchingDataLoader&) = delete;
+  PrefetchingDataLoader& operator=(const PrefetchingDataLoader&) = delete;
+  PrefetchingDataLoader& operator=(PrefetchingDataLoader&&) = delete;
+
+  // Owns the file and the I/O threads. Heap-allocated so that the threads can
+  // keep pointing at it when the loader is moved.
+  std::unique_ptr<State> state_;
+};
+
+} // namespace extension
+} // namespace executorch
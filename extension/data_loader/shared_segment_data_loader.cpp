@@ -0,0 +1,280 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/data_loader/shared_segment_data_loader.h>
+
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/log.h>
+
+using executorch::runtime::DataLoader;
+using executorch::runtime::Error;
+using executorch::runtime::FreeableBuffer;
+using executorch::runtime::Result;
+
+namespace executorch {
+namespace extension {
+
+namespace {
+
+/// A range of a specific version of a file.
+struct RangeKey {
+  FileIdentity file;
+  size_t offset;
+  size_t size;
+
+  bool operator==(const RangeKey& other) const {
+    return file == other.file && offset == other.offset && size == other.size;
+  }
+};
+
+struct RangeKeyHash {
+  size_t operator()(const RangeKey& key) const {
+    const uint64_t values[] = {
+        key.file.device,
+        key.file.inode,
+        key.file.size,
+        key.file.mtime_ns,
+        key.offset,
+        key.size,
+    };
+    // boost::hash_combine.
+    size_t hash = 0;
+    for (uint64_t value : values) {
+      hash ^= std::hash<uint64_t>()(value) + 0x9e3779b9 + (hash << 6) +
+          (hash >> 2);
+    }
+    return hash;
+  }
+};
+
+} // namespace
+
+Result<FileIdentity> FileIdentity::of(const char* file_name) {
+  struct stat st;
+  if (::stat(file_name, &st) < 0) {
+    ET_LOG(
+        Error,
+        "Could not stat %s: %s (%d)",
+        file_name,
+        ::strerror(errno),
+        errno);
+    return Error::AccessFailed;
+  }
+#if defined(__APPLE__)
+  const struct timespec& mtime = st.st_mtimespec;
+#else
+  const struct timespec& mtime = st.st_mtim;
+#endif
+  FileIdentity identity;
+  identity.device = static_cast<uint64_t>(st.st_dev);
+  identity.inode = static_cast<uint64_t>(st.st_ino);
+  identity.size = static_cast<uint64_t>(st.st_size);
+  identity.mtime_ns = static_cast<uint64_t>(mtime.tv_sec) * 1000000000 +
+      static_cast<uint64_t>(mtime.tv_nsec);
+  return identity;
+}
+
+/// One loaded range. Deleted when the last buffer handed out for it is freed.
+struct SegmentCache::Entry {
+  Entry(const RangeKey& key_, std::shared_ptr<SegmentCache> owner_)
+      : key(key_), owner(std::move(owner_)) {}
+
+  const RangeKey key;
+  // Keeps the cache alive until the entry is gone.
+  const std::shared_ptr<SegmentCache> owner;
+
+  // The fields below are guarded by the owner's mutex.
+
+  // Buffers handed out, plus callers waiting for the load to finish.
+  size_t refs = 0;
+  bool loading = true;
+  Error error = Error::Ok;
+  // FreeableBuffer can't be assigned, so this is filled in once loaded.
+  std::unique_ptr<FreeableBuffer> buffer;
+};
+
+struct SegmentCache::Impl {
+  mutable std::mutex mutex;
+  std::condition_variable load_finished;
+  std::unordered_map<RangeKey, Entry*, RangeKeyHash> entries;
+};
+
+SegmentCache::SegmentCache() : impl_(new Impl()) {}
+
+SegmentCache::~SegmentCache() = default;
+
+std::shared_ptr<SegmentCache> SegmentCache::create() {
+  return std::shared_ptr<SegmentCache>(new SegmentCache());
+}
+
+std::shared_ptr<SegmentCache> SegmentCache::shared() {
+  static const std::shared_ptr<SegmentCache> cache = create();
+  return cache;
+}
+
+size_t SegmentCache::num_entries() const {
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  return impl_->entries.size();
+}
+
+Result<FreeableBuffer> SegmentCache::load(
+    const FileIdentity& file,
+    size_t offset,
+    size_t size,
+    const DataLoader::SegmentInfo& segment_info,
+    const DataLoader& loader) {
+  const RangeKey key{file, offset, size};
+  Entry* entry = nullptr;
+  {
+    std::unique_lock<std::mutex> lock(impl_->mutex);
+    auto it = impl_->entries.find(key);
+    if (it != impl_->entries.end()) {
+      // Someone else loaded it, or is loading it. The reference keeps the
+      // entry alive while waiting.
+      entry = it->second;
+      entry->refs++;
+      impl_->load_finished.wait(lock, [&]() { return !entry->loading; });
+      if (entry->error == Error::Ok) {
+        return FreeableBuffer(
+            entry->buffer->data(), entry->buffer->size(), release, entry);
+      }
+      const Error error = entry->error;
+      const bool last = --entry->refs == 0;
+      lock.unlock();
+      if (last) {
+        delete entry;
+      }
+      return error;
+    }
+    entry = new Entry(key, shared_from_this());
+    entry->refs = 1;
+    impl_->entries.emplace(key, entry);
+  }
+
+  // Load without holding the lock, so that other ranges can be loaded
+  // concurrently.
+  Result<FreeableBuffer> loaded = loader.load(offset, size, segment_info);
+
+  std::unique_lock<std::mutex> lock(impl_->mutex);
+  entry->loading = false;
+  impl_->load_finished.notify_all();
+  if (loaded.ok()) {
+    entry->buffer.reset(new FreeableBuffer(std::move(loaded.get())));
+    return FreeableBuffer(
+        entry->buffer->data(), entry->buffer->size(), release, entry);
+  }
+  // Don't cache failures: the next load of this range tries again.
+  entry->error = loaded.error();
+  impl_->entries.erase(key);
+  const bool last = --entry->refs == 0;
+  lock.unlock();
+  if (last) {
+    delete entry;
+  }
+  return loaded.error();
+}
+
+void SegmentCache::release(
+    void* context,
+    ET_UNUSED void* data,
+    ET_UNUSED size_t size) {
+  Entry* entry = static_cast<Entry*>(context);
+  Impl* impl = entry->owner->impl_.get();
+  {
+    std::lock_guard<std::mutex> lock(impl->mutex);
+    if (--entry->refs > 0) {
+      return;
+    }
+    impl->entries.erase(entry->key);
+  }
+  // Frees the data, and possibly the cache, outside of the lock.
+  delete entry;
+}
+
+Result<SharedSegmentDataLoader> SharedSegmentDataLoader::from(
+    const char* file_name,
+    std::unique_ptr<DataLoader> loader,
+    std::shared_ptr<SegmentCache> cache) {
+  ET_CHECK_OR_RETURN_ERROR(
+      loader != nullptr, InvalidArgument, "loader must not be null");
+  ET_CHECK_OR_RETURN_ERROR(
+      cache != nullptr, InvalidArgument, "cache must not be null");
+  Result<FileIdentity> file = FileIdentity::of(file_name);
+  if (!file.ok()) {
+    return file.error();
+  }
+  return SharedSegmentDataLoader(*file, std::move(loader), std::move(cache));
+}
+
+Result<FreeableBuffer> SharedSegmentDataLoader::load(
+    size_t offset,
+    size_t size,
+    const DataLoader::SegmentInfo& segment_info) const {
+  ET_CHECK_OR_RETURN_ERROR(
+      // Probably had its value moved to another instance.
+      loader_ != nullptr,
+      InvalidState,
+      "Uninitialized");
+  if (size == 0) {
+    // Nothing to share.
+    return loader_->load(offset, size, segment_info);
+  }
+  return cache_->load(file_, offset, size, segment_info, *loader_);
+}
+
+Result<size_t> SharedSegmentDataLoader::size() const {
+  ET_CHECK_OR_RETURN_ERROR(
+      // Probably had its value moved to another instance.
+      loader_ != nullptr,
+      InvalidState,
+      "Uninitialized");
+  return loader_->size();
+}
+
+ET_NODISCARD Error SharedSegmentDataLoader::load_into(
+    size_t offset,
+    size_t size,
+    const SegmentInfo& segment_info,
+    void* buffer) const {
+  ET_CHECK_OR_RETURN_ERROR(
+      // Probably had its value moved to another instance.
+      loader_ != nullptr,
+      InvalidState,
+      "Uninitialized");
+  return loader_->load_into(offset, size, segment_info, buffer);
+}
+
+void SharedSegmentDataLoader::prefetch(
+    size_t offset,
+    size_t size,
+    const SegmentInfo& segment_info) const {
+  if (loader_ == nullptr) {
+    return;
+  }
+  {
+    // Don't read ahead what another loader already loaded.
+    std::lock_guard<std::mutex> lock(cache_->impl_->mutex);
+    if (cache_->impl_->entries.count(RangeKey{file_, offset, size}) != 0) {
+      return;
+    }
+  }
+  loader_->prefetch(offset, size, segment_info);
+}
+
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <executorch/runtime/core/data_loader.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/compiler.h>
+
+namespace executorch {
+namespace extension {
+
+/**
+ * Identifies the contents of a file: which file it is, and which version of
+ * it. Two FileIdentity values compare equal only if they refer to the same
+ * file, unmodified.
+ */
+struct FileIdentity {
+  uint64_t device;
+  uint64_t inode;
+  uint64_t size;
+  /// Last modification time in nanoseconds, so that rewriting the file in
+  /// place does not alias data loaded from its previous contents.
+  uint64_t mtime_ns;
+
+  /**
+   * Returns the identity of the named file.
+   *
+   * @retval Error::AccessFailed The file could not be stat()ed.
+   */
+  static executorch::runtime::Result<FileIdentity> of(const char* file_name);
+
+  bool operator==(const FileIdentity& other) const {
+    return device == other.device && inode == other.inode &&
+        size == other.size && mtime_ns == other.mtime_ns;
+  }
+};
+
+/**
+ * A thread-safe cache of loaded file ranges, shared by any number of
+ * SharedSegmentDataLoader instances.
+ *
+ * Each range is loaded once, and handed out as read-only FreeableBuffers that
+ * all point at the same data. The data is freed when the last of those
+ * buffers is freed, so the cache never keeps memory alive on its own.
+ *
+ * The cache stays alive as long as any SharedSegmentDataLoader or buffer that
+ * uses it.
+ */
+class SegmentCache final : public std::enable_shared_from_this<SegmentCache> {
+ public:
+  /// Returns a new, empty cache.
+  static std::shared_ptr<SegmentCache> create();
+
+  /// Returns the process-wide cache used by default.
+  static std::shared_ptr<SegmentCache> shared();
+
+  ~SegmentCache();
+
+  /// Returns the number of ranges currently loaded.
+  size_t num_entries() const;
+
+ private:
+  struct Entry;
+  struct Impl;
+  friend class SharedSegmentDataLoader;
+
+  SegmentCache();
+
+  executorch::runtime::Result<executorch::runtime::FreeableBuffer> load(
+      const FileIdentity& file,
+      size_t offset,
+      size_t size,
+      const executorch::runtime::DataLoader::SegmentInfo& segment_info,
+      const executorch::runtime::DataLoader& loader);
+
+  static void release(void* context, void* data, size_t size);
+
+  std::unique_ptr<Impl> impl_;
+};
+
+/**
+ * A DataLoader that shares loaded data between every loader of the same file
+ * that uses the same SegmentCache.
+ *
+ * Wrap the loader of each Program (or Module) that uses a given .pte file in a
+ * SharedSegmentDataLoader, and the program data, constant segments and
+ * backend segments are only loaded into memory once in the process, however
+ * many Programs use them. Partial loads with load_into() are not shared.
+ *
+ * Within a process this works with any underlying loader. To share memory
+ * between processes as well, use an MmapDataLoader as the underlying loader:
+ * its file-backed mappings are backed by the same page cache pages in every
+ * process that maps the file.
+ */
+class SharedSegmentDataLoader final : public executorch::runtime::DataLoader {
+ public:
+  /**
+   * Creates a loader that reads `file_name` through `loader`, sharing the
+   * results through `cache`.
+   *
+   * @param[in] file_name The file that `loader` reads from. Only used to
+   *     identify the file.
+   * @param[in] loader The loader that does the actual reads.
+   * @param[in] cache The cache to share loaded data through.
+   *
+   * @retval Error::InvalidArgument `loader` or `cache` is null.
+   * @retval Error::AccessFailed `file_name` could not be stat()ed.
+   */
+  static executorch::runtime::Result<SharedSegmentDataLoader> from(
+      const char* file_name,
+      std::unique_ptr<executorch::runtime::DataLoader> loader,
+      std::shared_ptr<SegmentCache> cache = SegmentCache::shared());
+
+  // Movable to be compatible with Result.
+  SharedSegmentDataLoader(SharedSegmentDataLoader&&) noexcept = default;
+  ~SharedSegmentDataLoader() override = default;
+
+  ET_NODISCARD
+  executorch::runtime::Result<executorch::runtime::FreeableBuffer> load(
+      size_t offset,
+      size_t size,
+      const DataLoader::SegmentInfo& segment_info) const override;
+
+  ET_NODISCARD executorch::runtime::Result<size_t> size() const override;
+
+  ET_NODISCARD executorch::runtime::Error load_into(
+      size_t offset,
+      size_t size,
+      const SegmentInfo& segment_info,
+      void* buffer) const override;
+
+  void prefetch(size_t offset, size_t size, const SegmentInfo& segment_info)
+      const override;
+
+ private:
+  SharedSegmentDataLoader(
+      const FileIdentity& file,
+      std::unique_ptr<executorch::runtime::DataLoader> loader,
+      std::shared_ptr<SegmentCache> cache)
+      : file_(file), loader_(std::move(loader)), cache_(std::move(cache)) {}
+
+  // Not safely copyable.
+  SharedSegmentDataLoader(const SharedSegmentDataLoader&) = delete;
+  SharedSegmentDataLoader& operator=(const SharedSegmentDataLoader&) = delete;
+  SharedSegmentDataLoader& operator=(SharedSegmentDataLoader&&) = delete;
+
+  FileIdentity file_;
+  std::unique_ptr<executorch::runtime::DataLoader> loader_;
+  std::shared_ptr<SegmentCache> cache_;
+};
+
+} // namespace extension
+} // namespace executorch
@@ -244,6 +244,61 @@ TEST_F(MmapDataLoaderTest, InBoundsLoadsSucceedUseMlockIgnoreErrors) {
       MmapDataLoader::MlockConfig::UseMlockIgnoreErrors);
 }
 
+TEST_F(MmapDataLoaderTest, SegmentPoliciesLoadSameData) {
+  // Create a multi-page file where each 4-byte word has a different value.
+  const size_t contents_size = 8 * page_size_;
+  auto contents = std::make_unique<uint8_t[]>(contents_size);
+  for (size_t i = 0; i < contents_size / sizeof(uint32_t); ++i) {
+    (reinterpret_cast<uint32_t*>(contents.get()))[i] = i;
+  }
+  TempFile tf(contents.get(), contents_size);
+
+  // Give each segment type a different policy. There's no portable way to
+  // check that the hints take effect, but exercise each path to make sure the
+  // data is still loaded correctly.
+  MmapDataLoader::SegmentPolicies policies;
+  policies.program.advice = MmapDataLoader::AccessAdvice::Random;
+  policies.constant.advice = MmapDataLoader::AccessAdvice::WillNeed;
+  policies.constant.populate = true;
+  policies.constant.huge_pages = true;
+  policies.backend.advice = MmapDataLoader::AccessAdvice::Sequential;
+  policies.backend.release_pages_on_free = true;
+  policies.mutable_data.populate = true;
+
+  Result<MmapDataLoader> mdl = MmapDataLoader::from(
+      tf.path().c_str(), MmapDataLoader::MlockConfig::NoMlock, policies);
+  ASSERT_EQ(mdl.error(), Error::Ok);
+
+  const DataLoader::SegmentInfo::Type segment_types[] = {
+      DataLoader::SegmentInfo::Type::Program,
+      DataLoader::SegmentInfo::Type::Constant,
+      DataLoader::SegmentInfo::Type::Backend,
+      DataLoader::SegmentInfo::Type::Mutable,
+  };
+  for (const auto segment_type : segment_types) {
+    // Use an unaligned range that spans several pages.
+    const size_t offset = page_size_ / 2 + 4;
+    const size_t size = 5 * page_size_ + 12;
+    Result<FreeableBuffer> fb =
+        mdl->load(offset, size, DataLoader::SegmentInfo(segment_type));
+    ASSERT_EQ(fb.error(), Error::Ok);
+    EXPECT_EQ(fb->size(), size);
+    EXPECT_EQ(0, std::memcmp(fb->data(), &contents[offset], fb->size()));
+
+    // Freeing should unmap the pages, whatever the policy.
+    fb->Free();
+    EXPECT_EQ(fb->data(), nullptr);
+  }
+
+  // Data is still readable after pages from an earlier load were released.
+  Result<FreeableBuffer> fb = mdl->load(
+      0,
+      contents_size,
+      DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Backend));
+  ASSERT_EQ(fb.error(), Error::Ok);
+  EXPECT_EQ(0, std::memcmp(fb->data(), contents.get(), fb->size()));
+}
+
 TEST_F(MmapDataLoaderTest, FinalPageOfUnevenFileSucceeds) {
   // Create a file whose length is not an even multiple of a page.
   // Each 4-byte word in the file has a different value.
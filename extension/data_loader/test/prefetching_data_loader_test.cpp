@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/data_loader/prefetching_data_loader.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <executorch/extension/testing_util/temp_file.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/runtime.h>
+#include <executorch/test/utils/alignment.h>
+
+using namespace ::testing;
+using executorch::extension::PrefetchingDataLoader;
+using executorch::extension::testing::TempFile;
+using executorch::runtime::DataLoader;
+using executorch::runtime::Error;
+using executorch::runtime::FreeableBuffer;
+using executorch::runtime::Result;
+
+class PrefetchingDataLoaderTest : public ::testing::TestWithParam<size_t> {
+ protected:
+  void SetUp() override {
+    // Since these tests cause ET_LOG to be called, the PAL must be initialized
+    // first.
+    executorch::runtime::runtime_init();
+
+    // Heterogeneous data, large enough to split into many ranges.
+    data_.resize(kDataSize);
+    for (size_t i = 0; i < data_.size(); ++i) {
+      data_[i] = static_cast<uint8_t>((i * 7) ^ (i >> 8));
+    }
+    temp_file_ = std::make_unique<TempFile>(data_.data(), data_.size());
+  }
+
+  // The alignment in bytes that tests should use. The values are set by the
+  // list in the INSTANTIATE_TEST_SUITE_P call below.
+  size_t alignment() const {
+    return GetParam();
+  }
+
+  Result<PrefetchingDataLoader> make_loader(size_t num_io_threads = 4) {
+    return PrefetchingDataLoader::from(
+        temp_file_->path().c_str(), alignment(), num_io_threads);
+  }
+
+  void expect_loaded(
+      const PrefetchingDataLoader& loader,
+      size_t offset,
+      size_t size) {
+    Result<FreeableBuffer> fb = loader.load(
+        offset,
+        size,
+        DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Backend));
+    ASSERT_EQ(fb.error(), Error::Ok);
+    EXPECT_ALIGNED(fb->data(), alignment());
+    EXPECT_EQ(fb->size(), size);
+    EXPECT_EQ(0, std::memcmp(fb->data(), data_.data() + offset, size));
+  }
+
+  static constexpr size_t kDataSize = 1 << 20;
+  static constexpr size_t kRangeSize = kDataSize / 16;
+
+  std::vector<uint8_t> data_;
+  std::unique_ptr<TempFile> temp_file_;
+};
+
+TEST_P(PrefetchingDataLoaderTest, LoadsWithoutPrefetchSucceed) {
+  Result<PrefetchingDataLoader> loader = make_loader();
+  ASSERT_EQ(loader.error(), Error::Ok);
+
+  Result<size_t> size = loader->size();
+  ASSERT_EQ(size.error(), Error::Ok);
+  EXPECT_EQ(*size, kDataSize);
+
+  expect_loaded(*loader, 0, 8);
+  expect_loaded(*loader, kDataSize - 3, 3);
+  expect_loaded(*loader, 0, kDataSize);
+}
+
+TEST_P(PrefetchingDataLoaderTest, PrefetchedLoadsSucceed) {
+  Result<PrefetchingDataLoader> loader = make_loader();
+  ASSERT_EQ(loader.error(), Error::Ok);
+
+  const DataLoader::SegmentInfo info(DataLoader::SegmentInfo::Type::Backend);
+  for (size_t offset = 0; offset < kDataSize; offset += kRangeSize) {
+    loader->prefetch(offset, kRangeSize, info);
+  }
+  // Load in the opposite order, so that some loads wait for a read in flight
+  // and others take over reads that are still queued.
+  for (size_t offset = kDataSize; offset > 0; offset -= kRangeSize) {
+    expect_loaded(*loader, offset - kRangeSize, kRangeSize);
+  }
+  // Loading a range again after its prefetch was used reads it again.
+  expect_loaded(*loader, 0, kRangeSize);
+}
+
+TEST_P(PrefetchingDataLoaderTest, LoadOfDifferentSizeIgnoresPrefetch) {
+  Result<PrefetchingDataLoader> loader = make_loader();
+  ASSERT_EQ(loader.error(), Error::Ok);
+
+  loader->prefetch(
+      kRangeSize,
+      kRangeSize,
+      DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Backend));
+  expect_loaded(*loader, kRangeSize, kRangeSize / 2);
+  expect_loaded(*loader, kRangeSize, kRangeSize);
+}
+
+TEST_P(PrefetchingDataLoaderTest, ConcurrentLoadsOfOnePrefetchedRange) {
+  Result<PrefetchingDataLoader> loader = make_loader(/*num_io_threads=*/1);
+  ASSERT_EQ(loader.error(), Error::Ok);
+
+  loader->prefetch(
+      0,
+      kDataSize,
+      DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Backend));
+  // Only one load can take the prefetched buffer; the rest read the file
+  // themselves, but all of them see the same data.
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&]() { expect_loaded(*loader, 0, kDataSize); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+TEST_P(PrefetchingDataLoaderTest, UnusedPrefetchesAreReleased) {
+  // Destroying the loader with reads queued, in flight and finished must not
+  // leak or crash. Run under ASAN to check for leaks.
+  Result<PrefetchingDataLoader> loader = make_loader(/*num_io_threads=*/2);
+  ASSERT_EQ(loader.error(), Error::Ok);
+  for (size_t offset = 0; offset < kDataSize; offset += kRangeSize) {
+    loader->prefetch(
+        offset,
+        kRangeSize,
+        DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Backend));
+  }
+}
+
+TEST_P(PrefetchingDataLoaderTest, OutOfBoundsPrefetchIsIgnored) {
+  Result<PrefetchingDataLoader> loader = make_loader();
+  ASSERT_EQ(loader.error(), Error::Ok);
+
+  const DataLoader::SegmentInfo info(DataLoader::SegmentInfo::Type::Backend);
+  loader->prefetch(kDataSize - 1, 2, info);
+  Result<FreeableBuffer> fb = loader->load(kDataSize - 1, 2, info);
+  EXPECT_NE(fb.error(), Error::Ok);
+
+  // Empty ranges are fine.
+  loader->prefetch(kDataSize, 0, info);
+  Result<FreeableBuffer> empty = loader->load(kDataSize, 0, info);
+  ASSERT_EQ(empty.error(), Error::Ok);
+  EXPECT_EQ(empty->size(), 0);
+}
+
+TEST_P(PrefetchingDataLoaderTest, LoadIntoSucceeds) {
+  Result<PrefetchingDataLoader> loader = make_loader();
+  ASSERT_EQ(loader.error(), Error::Ok);
+
+  std::vector<uint8_t> buffer(kRangeSize);
+  Error err = loader->load_into(
+      kRangeSize,
+      kRangeSize,
+      DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Mutable),
+      buffer.data());
+  ASSERT_EQ(err, Error::Ok);
+  EXPECT_EQ(
+      0, std::memcmp(buffer.data(), data_.data() + kRangeSize, kRangeSize));
+}
+
+TEST_P(PrefetchingDataLoaderTest, FromMissingFileFails) {
+  Result<PrefetchingDataLoader> loader =
+      PrefetchingDataLoader::from("/tmp/FILE_DOES_NOT_EXIST_EXECUTORCH_MMAP");
+  EXPECT_NE(loader.error(), Error::Ok);
+}
+
+TEST_P(PrefetchingDataLoaderTest, ZeroIoThreadsFails) {
+  Result<PrefetchingDataLoader> loader = make_loader(/*num_io_threads=*/0);
+  EXPECT_EQ(loader.error(), Error::InvalidArgument);
+}
+
+TEST_P(PrefetchingDataLoaderTest, MoveCtor) {
+  Result<PrefetchingDataLoader> loader = make_loader();
+  ASSERT_EQ(loader.error(), Error::Ok);
+  loader->prefetch(
+      0,
+      kRangeSize,
+      DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Backend));
+
+  // Move it into another instance; pending prefetches move with it.
+  PrefetchingDataLoader loader2(std::move(*loader));
+
+  // Old loader should now be invalid.
+  EXPECT_EQ(
+      loader->load(
+                0,
+                kRangeSize,
+                DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Backend))
+          .error(),
+      Error::InvalidState);
+  EXPECT_EQ(loader->size().error(), Error::InvalidState);
+
+  expect_loaded(loader2, 0, kRangeSize);
+}
+
+// Run all tests with the default alignment, and with alignments smaller and
+// larger than what malloc() returns by default.
+INSTANTIATE_TEST_SUITE_P(
+    VariedSegments,
+    PrefetchingDataLoaderTest,
+    testing::Values(
+        1, // Use an alignment of 1 to ensure non-trivial alignment is tested.
+        alignof(std::max_align_t),
+        4 * alignof(std::max_align_t)));
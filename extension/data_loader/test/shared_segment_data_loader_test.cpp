@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/data_loader/shared_segment_data_loader.h>
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <executorch/extension/data_loader/file_data_loader.h>
+#include <executorch/extension/testing_util/temp_file.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/runtime.h>
+
+using namespace ::testing;
+using executorch::extension::FileDataLoader;
+using executorch::extension::FileIdentity;
+using executorch::extension::SegmentCache;
+using executorch::extension::SharedSegmentDataLoader;
+using executorch::extension::testing::TempFile;
+using executorch::runtime::DataLoader;
+using executorch::runtime::Error;
+using executorch::runtime::FreeableBuffer;
+using executorch::runtime::Result;
+
+namespace {
+
+/// Forwards to a FileDataLoader, counting calls to load().
+class CountingDataLoader final : public DataLoader {
+ public:
+  CountingDataLoader(FileDataLoader&& loader, std::atomic<int>* num_loads)
+      : loader_(std::move(loader)), num_loads_(num_loads) {}
+
+  Result<FreeableBuffer> load(
+      size_t offset,
+      size_t size,
+      const SegmentInfo& segment_info) const override {
+    (*num_loads_)++;
+    return loader_.load(offset, size, segment_info);
+  }
+
+  Result<size_t> size() const override {
+    return loader_.size();
+  }
+
+ private:
+  FileDataLoader loader_;
+  std::atomic<int>* num_loads_;
+};
+
+} // namespace
+
+class SharedSegmentDataLoaderTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // Since these tests cause ET_LOG to be called, the PAL must be initialized
+    // first.
+    executorch::runtime::runtime_init();
+
+    for (size_t i = 0; i < sizeof(data_); ++i) {
+      data_[i] = static_cast<uint8_t>(i * 3);
+    }
+    temp_file_ = std::make_unique<TempFile>(data_, sizeof(data_));
+  }
+
+  SharedSegmentDataLoader make_loader(std::shared_ptr<SegmentCache> cache) {
+    Result<FileDataLoader> file_loader =
+        FileDataLoader::from(temp_file_->path().c_str());
+    EXPECT_EQ(file_loader.error(), Error::Ok);
+    Result<SharedSegmentDataLoader> loader = SharedSegmentDataLoader::from(
+        temp_file_->path().c_str(),
+        std::make_unique<CountingDataLoader>(
+            std::move(file_loader.get()), &num_loads_),
+        std::move(cache));
+    EXPECT_EQ(loader.error(), Error::Ok);
+    return std::move(loader.get());
+  }
+
+  const DataLoader::SegmentInfo kConstant{
+      DataLoader::SegmentInfo::Type::Constant};
+
+  uint8_t data_[1024];
+  std::unique_ptr<TempFile> temp_file_;
+  std::atomic<int> num_loads_{0};
+};
+
+TEST_F(SharedSegmentDataLoaderTest, LoadersOfSameFileShareData) {
+  auto cache = SegmentCache::create();
+  SharedSegmentDataLoader loader1 = make_loader(cache);
+  SharedSegmentDataLoader loader2 = make_loader(cache);
+
+  Result<FreeableBuffer> fb1 = loader1.load(16, 256, kConstant);
+  ASSERT_EQ(fb1.error(), Error::Ok);
+  Result<FreeableBuffer> fb2 = loader2.load(16, 256, kConstant);
+  ASSERT_EQ(fb2.error(), Error::Ok);
+
+  // Same memory, loaded once.
+  EXPECT_EQ(fb1->data(), fb2->data());
+  EXPECT_EQ(fb2->size(), 256);
+  EXPECT_EQ(0, std::memcmp(fb2->data(), data_ + 16, 256));
+  EXPECT_EQ(num_loads_, 1);
+  EXPECT_EQ(cache->num_entries(), 1);
+
+  // A different range is loaded separately.
+  Result<FreeableBuffer> fb3 = loader1.load(16, 128, kConstant);
+  ASSERT_EQ(fb3.error(), Error::Ok);
+  EXPECT_NE(fb3->data(), fb1->data());
+  EXPECT_EQ(0, std::memcmp(fb3->data(), data_ + 16, 128));
+  EXPECT_EQ(num_loads_, 2);
+  EXPECT_EQ(cache->num_entries(), 2);
+
+  // The data stays loaded until every buffer that uses it is freed.
+  fb1->Free();
+  EXPECT_EQ(cache->num_entries(), 2);
+  EXPECT_EQ(0, std::memcmp(fb2->data(), data_ + 16, 256));
+  fb2->Free();
+  fb3->Free();
+  EXPECT_EQ(cache->num_entries(), 0);
+
+  // Loading again after everything was freed reads the file again.
+  Result<FreeableBuffer> fb4 = loader2.load(16, 256, kConstant);
+  ASSERT_EQ(fb4.error(), Error::Ok);
+  EXPECT_EQ(num_loads_, 3);
+}
+
+TEST_F(SharedSegmentDataLoaderTest, SeparateCachesDoNotShare) {
+  SharedSegmentDataLoader loader1 = make_loader(SegmentCache::create());
+  SharedSegmentDataLoader loader2 = make_loader(SegmentCache::create());
+
+  Result<FreeableBuffer> fb1 = loader1.load(0, 64, kConstant);
+  ASSERT_EQ(fb1.error(), Error::Ok);
+  Result<FreeableBuffer> fb2 = loader2.load(0, 64, kConstant);
+  ASSERT_EQ(fb2.error(), Error::Ok);
+  EXPECT_NE(fb1->data(), fb2->data());
+  EXPECT_EQ(num_loads_, 2);
+}
+
+TEST_F(SharedSegmentDataLoaderTest, ConcurrentLoadsShareOneRead) {
+  auto cache = SegmentCache::create();
+  SharedSegmentDataLoader loader = make_loader(cache);
+
+  constexpr int kNumThreads = 8;
+  std::vector<const void*> pointers(kNumThreads);
+  std::vector<std::unique_ptr<FreeableBuffer>> buffers(kNumThreads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&, i]() {
+      Result<FreeableBuffer> fb = loader.load(0, sizeof(data_), kConstant);
+      ASSERT_EQ(fb.error(), Error::Ok);
+      pointers[i] = fb->data();
+      buffers[i] = std::make_unique<FreeableBuffer>(std::move(fb.get()));
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int i = 0; i < kNumThreads; ++i) {
+    EXPECT_EQ(pointers[i], pointers[0]);
+  }
+  EXPECT_EQ(num_loads_, 1);
+  EXPECT_EQ(0, std::memcmp(pointers[0], data_, sizeof(data_)));
+
+  buffers.clear();
+  EXPECT_EQ(cache->num_entries(), 0);
+}
+
+TEST_F(SharedSegmentDataLoaderTest, FailedLoadsAreNotCached) {
+  auto cache = SegmentCache::create();
+  SharedSegmentDataLoader loader = make_loader(cache);
+
+  Result<FreeableBuffer> fb = loader.load(sizeof(data_) - 4, 8, kConstant);
+  EXPECT_NE(fb.error(), Error::Ok);
+  EXPECT_EQ(cache->num_entries(), 0);
+}
+
+TEST_F(SharedSegmentDataLoaderTest, BuffersOutliveLoaderAndCache) {
+  std::unique_ptr<FreeableBuffer> fb;
+  {
+    SharedSegmentDataLoader loader = make_loader(SegmentCache::create());
+    Result<FreeableBuffer> loaded = loader.load(8, 32, kConstant);
+    ASSERT_EQ(loaded.error(), Error::Ok);
+    fb = std::make_unique<FreeableBuffer>(std::move(loaded.get()));
+  }
+  // The loader and the last handle to the cache are gone; the data is still
+  // valid, and freeing it cleans up the cache. Run under ASAN to check.
+  EXPECT_EQ(0, std::memcmp(fb->data(), data_ + 8, 32));
+  fb->Free();
+}
+
+TEST_F(SharedSegmentDataLoaderTest, FromMissingFileFails) {
+  Result<FileDataLoader> file_loader =
+      FileDataLoader::from(temp_file_->path().c_str());
+  ASSERT_EQ(file_loader.error(), Error::Ok);
+  Result<SharedSegmentDataLoader> loader = SharedSegmentDataLoader::from(
+      "/tmp/FILE_DOES_NOT_EXIST_EXECUTORCH_SHARED",
+      std::make_unique<FileDataLoader>(std::move(file_loader.get())));
+  EXPECT_EQ(loader.error(), Error::AccessFailed);
+}
+
+TEST_F(SharedSegmentDataLoaderTest, FileIdentity) {
+  Result<FileIdentity> id1 = FileIdentity::of(temp_file_->path().c_str());
+  ASSERT_EQ(id1.error(), Error::Ok);
+  Result<FileIdentity> id2 = FileIdentity::of(temp_file_->path().c_str());
+  ASSERT_EQ(id2.error(), Error::Ok);
+  EXPECT_TRUE(*id1 == *id2);
+  EXPECT_EQ(id1->size, sizeof(data_));
+
+  TempFile other(data_, sizeof(data_));
+  Result<FileIdentity> id3 = FileIdentity::of(other.path().c_str());
+  ASSERT_EQ(id3.error(), Error::Ok);
+  EXPECT_FALSE(*id1 == *id3);
+}
@@ -48,3 +48,26 @@ def define_common_targets():
             "//executorch/extension/data_loader:mmap_data_loader",
         ],
     )
+
+    runtime.cxx_test(
+        name = "prefetching_data_loader_test",
+        srcs = [
+            "prefetching_data_loader_test.cpp",
+        ],
+        deps = [
+            "//executorch/extension/testing_util:temp_file",
+            "//executorch/extension/data_loader:prefetching_data_loader",
+        ],
+    )
+
+    runtime.cxx_test(
+        name = "shared_segment_data_loader_test",
+        srcs = [
+            "shared_segment_data_loader_test.cpp",
+        ],
+        deps = [
+            "//executorch/extension/testing_util:temp_file",
+            "//executorch/extension/data_loader:file_data_loader",
+            "//executorch/extension/data_loader:shared_segment_data_loader",
+        ],
+    )
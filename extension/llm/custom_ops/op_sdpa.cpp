@@ -15,7 +15,9 @@
 // @lint-ignore CLANGTIDY facebook-unused-include-check
 #include <executorch/runtime/core/exec_aten/util/scalar_type_util.h>
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 // patternlint-disable-next-line executorch-cpp-nostdinc
 #include <vector>
 
@@ -178,6 +180,47 @@ inline void fill_stub(scalar_t* data, scalar_t val, int64_t size) {
   }
 }
 
+// Returns a [rows, cols] tile of a key or value cache, to be used as a gemm
+// operand with leading dimension ld. A tile of a float cache is used in place.
+template <typename scalar_t>
+inline const scalar_t* load_kv_tile(
+    const scalar_t* data,
+    int64_t stride,
+    const float* /* scales */,
+    int64_t /* scales_stride */,
+    int64_t /* rows */,
+    int64_t /* cols */,
+    scalar_t* /* buf */,
+    int64_t& ld) {
+  ld = stride;
+  return data;
+}
+
+// A tile of an int8 cache is dequantized into buf, one scale per row. Only the
+// tiles that the kernel works on are dequantized, so the cache is read as int8.
+template <typename scalar_t>
+inline const scalar_t* load_kv_tile(
+    const int8_t* data,
+    int64_t stride,
+    const float* scales,
+    int64_t scales_stride,
+    int64_t rows,
+    int64_t cols,
+    scalar_t* buf,
+    int64_t& ld) {
+  for (int64_t row = 0; row < rows; ++row) {
+    const int8_t* src = data + row * stride;
+    const scalar_t row_scale =
+        static_cast<scalar_t>(scales[row * scales_stride]);
+    scalar_t* dst = buf + row * cols;
+    for (int64_t col = 0; col < cols; ++col) {
+      dst[col] = static_cast<scalar_t>(src[col]) * row_scale;
+    }
+  }
+  ld = cols;
+  return buf;
+}
+
 /*
 Note on start_pos as a parameter:
 What is start_pos?
@@ -213,8 +256,27 @@ can increase memory footprint, which is right now optimized away since
 sdpa_with_kv_cache does not use attn_mask.
 
 TODO: Just handle conversion of bool mask to float
+
+Quantized KV cache:
+- With kv_t = int8_t, key and value are int8 caches, and key_scales and
+value_scales hold the scale of each token of each head, in the same
+[Batch x KV_seq_len x Num_heads x 1] layout. The kernel dequantizes a kv split
+right before each gemm that uses it.
+
+Splitting the keys across threads (flash decoding):
+- Work is split by (batch, head, q block), which during decode, with a single
+q block, leaves threads idle when batch x heads is less than the number of
+threads, while each of them scans the whole KV sequence. In that case the keys
+are also split into num_kv_splits ranges of whole kv splits. Each range yields
+a partial output, max and sum per query row, which are merged with their
+log-sum-exp weights once all are done. Every range starts at a key that all
+the rows of the q block attend to, so no row of a range is fully masked.
 */
-template <typename scalar_t, int64_t q_split_size, int64_t kv_split_size>
+template <
+    typename scalar_t,
+    int64_t q_split_size,
+    int64_t kv_split_size,
+    typename kv_t = scalar_t>
 void cpu_flash_attention(
     Tensor& output,
     const Tensor& query,
@@ -225,7 +287,9 @@ void cpu_flash_attention(
     const optional<Tensor>& attn_mask,
     const optional<double>& scale,
     bool is_with_kv_cache = false,
-    const int64_t start_pos = 0) {
+    const int64_t start_pos = 0,
+    const optional<Tensor>& key_scales = {},
+    const optional<Tensor>& value_scales = {}) {
   (void)dropout_p;
   // Query (Batch x Num_heads  x Q_seq_len  x Dim_per_head)
   // Key   (Batch x Num_heads  x KV_seq_len x Dim_per_head)
@@ -251,6 +315,12 @@ void cpu_flash_attention(
 
   ET_CHECK_MSG(
       !is_reduced_type, "FlashAttention does not support reduced types.");
+  constexpr bool is_quantized_kv = std::is_same<kv_t, int8_t>::value;
+  ET_CHECK_MSG(
+      !is_quantized_kv ||
+          (is_with_kv_cache && key_scales.has_value() &&
+           value_scales.has_value()),
+      "FlashAttention with a quantized KV cache needs the cache scales");
   // Figure out mixed precision a little later
   // using accum_t = at::opmath_type<scalar_t>;
   using accum_t = scalar_t;
@@ -346,6 +416,24 @@ void cpu_flash_attention(
     oStrideM = strides[1];
   }
 
+  // Scales are [Batch x KV_seq_len x Num_heads x 1].
+  int64_t ksStrideB = 0;
+  int64_t ksStrideH = 0;
+  int64_t ksStrideN = 0;
+  int64_t vsStrideB = 0;
+  int64_t vsStrideH = 0;
+  int64_t vsStrideN = 0;
+  if (is_quantized_kv) {
+    strides = key_scales.value().strides();
+    ksStrideB = strides[0];
+    ksStrideN = strides[1];
+    ksStrideH = strides[2];
+    strides = value_scales.value().strides();
+    vsStrideB = strides[0];
+    vsStrideN = strides[1];
+    vsStrideH = strides[2];
+  }
+
   int64_t mStrideB = 0;
   int64_t mStrideH = 0;
   int64_t mStrideM = 0;
@@ -393,11 +481,40 @@ void cpu_flash_attention(
   // at::Tensor buf_reduced = at::empty(
   //    {num_thread, qSplitSize, is_reduced_type ? kvSplitSize : 0},
   //    query.options());
+  // Dequantized key and value splits
+  int64_t kv_dequant_size_per_thread =
+      is_quantized_kv ? 2 * kvSplitSize * headSize : 0;
+  std::vector<accum_t> kv_dequant_vec(num_thread * kv_dequant_size_per_thread);
+
+  // Split the keys when there is a single q block and too few of them to
+  // keep the threads busy. The keys that every query row attends to are
+  // split, as whole kv splits.
+  int64_t num_kv_splits = 1;
+  if (qSlice == 1 && !has_attn_mask) {
+    int64_t num_work = batchSize * num_head;
+    int64_t common_keys = is_causal ? std::min(start_pos + 1, kvSize) : kvSize;
+    int64_t num_kv_tiles = (common_keys - 1) / kvSplitSize + 1;
+    if (num_work < num_thread && num_kv_tiles > 1) {
+      num_kv_splits =
+          std::min(num_kv_tiles, (num_thread + num_work - 1) / num_work);
+    }
+  }
+  // Per (batch, head, q block, kv range): max, sum and unnormalized output of
+  // each query row.
+  int64_t partial_size = qSplitSize * (2 + headSize);
+  std::vector<accum_t> partials_vec(
+      num_kv_splits > 1
+          ? batchSize * num_head * qSlice * num_kv_splits * partial_size
+          : 0);
 
   // Data ptrs
   const scalar_t* q_data = query.const_data_ptr<scalar_t>();
-  const scalar_t* k_data = key.const_data_ptr<scalar_t>();
-  const scalar_t* v_data = value.const_data_ptr<scalar_t>();
+  const kv_t* k_data = key.const_data_ptr<kv_t>();
+  const kv_t* v_data = value.const_data_ptr<kv_t>();
+  const float* k_scale_data =
+      is_quantized_kv ? key_scales.value().const_data_ptr<float>() : nullptr;
+  const float* v_scale_data =
+      is_quantized_kv ? value_scales.value().const_data_ptr<float>() : nullptr;
   const accum_t* mask_data =
       has_attn_mask ? attn_mask.value().const_data_ptr<accum_t>() : nullptr;
   scalar_t* out_data = output.mutable_data_ptr<scalar_t>();
@@ -406,8 +523,9 @@ void cpu_flash_attention(
       is_reduced_type ? reinterpret_cast<scalar_t*>(buf_reduced) : nullptr;
 
   auto compute_lambda = [&](int64_t begin, int64_t end) {
-    int64_t i = 0, j = 0, k = 0;
-    util::data_index_init(begin, i, batchSize, j, num_head, k, qSlice);
+    int64_t i = 0, j = 0, k = 0, s = 0;
+    util::data_index_init(
+        begin, i, batchSize, j, num_head, k, qSlice, s, num_kv_splits);
     int ompIdx = torch::executor::get_thread_num();
     accum_t* buf_ptr = buf_data + ompIdx * size_per_thread;
     accum_t* qk_data = buf_ptr;
@@ -417,6 +535,9 @@ void cpu_flash_attention(
     scalar_t* qk_reduced_data = is_reduced_type
         ? buf_reduced_data + ompIdx * qSplitSize * kvSplitSize
         : nullptr;
+    accum_t* k_dequant_data =
+        kv_dequant_vec.data() + ompIdx * kv_dequant_size_per_thread;
+    accum_t* v_dequant_data = k_dequant_data + kvSplitSize * headSize;
 
     for (int64_t z = begin; z < end; z++) {
       int64_t m = k * qSplitSize;
@@ -424,6 +545,7 @@ void cpu_flash_attention(
       // Initialize max and sum
       fill_stub(
           qk_max_data, -std::numeric_limits<accum_t>::infinity(), qBlockSize);
+      fill_stub(qk_sum_data, static_cast<accum_t>(0), qBlockSize);
       // Original flash sdpa wasnt really meant to be used
       // for decode the way we are using via start_pos here.
       // Thus when num_keys is 1 during decode phase, we
@@ -453,11 +575,39 @@ void cpu_flash_attention(
       // However, lets just fix that as well.
       int64_t num_keys =
           is_causal ? std::min(m + start_pos + qBlockSize, kvSize) : kvSize;
+      int64_t kv_begin = 0;
+      int64_t kv_end = num_keys;
+      if (num_kv_splits > 1) {
+        // Range s of the keys that all the rows attend to. The range with the
+        // last of them also takes the keys that only the later rows see.
+        int64_t common_keys =
+            is_causal ? std::min(m + start_pos + 1, kvSize) : kvSize;
+        int64_t num_kv_tiles = (common_keys - 1) / kvSplitSize + 1;
+        int64_t range_size =
+            ((num_kv_tiles - 1) / num_kv_splits + 1) * kvSplitSize;
+        kv_begin = std::min(s * range_size, num_keys);
+        kv_end = kv_begin + range_size >= common_keys
+            ? num_keys
+            : kv_begin + range_size;
+        if (kv_begin >= common_keys) {
+          kv_begin = num_keys;
+        }
+      }
       auto j_kv = j / num_reps;
-      for (int64_t n = 0; n < num_keys; n += kvSplitSize) {
+      for (int64_t n = kv_begin; n < kv_end; n += kvSplitSize) {
         int64_t kvBlockSize = std::min(kvSplitSize, kvSize - n);
         // Calculate scale * q @ k.T
         fill_stub(qk_data, static_cast<accum_t>(0), qSplitSize * kvSplitSize);
+        int64_t k_ld = 0;
+        const accum_t* k_tile = load_kv_tile(
+            k_data + i * kStrideB + j_kv * kStrideH + n * kStrideN,
+            kStrideN,
+            k_scale_data + i * ksStrideB + j_kv * ksStrideH + n * ksStrideN,
+            ksStrideN,
+            kvBlockSize,
+            headSize,
+            k_dequant_data,
+            k_ld);
         ::executorch::cpublas::gemm(
             ::executorch::cpublas::TransposeType::Transpose,
             ::executorch::cpublas::TransposeType::NoTranspose,
@@ -465,8 +615,8 @@ void cpu_flash_attention(
             qBlockSize,
             headSize,
             static_cast<accum_t>(1),
-            k_data + i * kStrideB + j_kv * kStrideH + n * kStrideN,
-            kStrideN,
+            k_tile,
+            k_ld,
             q_data + i * qStrideB + j * qStrideH + m * qStrideM,
             qStrideM,
             static_cast<accum_t>(0),
@@ -547,7 +697,7 @@ void cpu_flash_attention(
           // max[row] <- max
           qk_max_data[row] = tmp_max;
           // dst <- dst * exp_tmp
-          if (n > 0) {
+          if (n > kv_begin) {
             vec::map<accum_t>(
                 [exp_tmp](Vec x) { return x * Vec(exp_tmp); },
                 dst_data + row * headSize,
@@ -556,6 +706,16 @@ void cpu_flash_attention(
           }
         }
         // Calculate Softmax(q @ k.T) @ v
+        int64_t v_ld = 0;
+        const accum_t* v_tile = load_kv_tile(
+            v_data + i * vStrideB + j_kv * vStrideH + n * vStrideN,
+            vStrideN,
+            v_scale_data + i * vsStrideB + j_kv * vsStrideH + n * vsStrideN,
+            vsStrideN,
+            kvBlockSize,
+            headSize,
+            v_dequant_data,
+            v_ld);
         ::executorch::cpublas::gemm(
             ::executorch::cpublas::TransposeType::NoTranspose,
             ::executorch::cpublas::TransposeType::NoTranspose,
@@ -563,31 +723,290 @@ void cpu_flash_attention(
             qBlockSize,
             kvBlockSize,
             static_cast<accum_t>(1),
-            v_data + i * vStrideB + j_kv * vStrideH + n * vStrideN,
-            vStrideN,
+            v_tile,
+            v_ld,
             conditional_data_ptr(qk_data, qk_reduced_data),
             kvBlockSize,
+            n == kv_begin ? static_cast<accum_t>(0) : static_cast<accum_t>(1),
+            dst_data,
+            headSize);
+      }
+      if (num_kv_splits > 1) {
+        // Keep the partial results of the range for the merge. An empty range
+        // has a sum of 0.
+        accum_t* partial = partials_vec.data() + z * partial_size;
+        if (kv_begin == kv_end) {
+          fill_stub(
+              partial, -std::numeric_limits<accum_t>::infinity(), qBlockSize);
+          fill_stub(partial + qSplitSize, static_cast<accum_t>(0), qBlockSize);
+        } else {
+          std::copy(qk_max_data, qk_max_data + qBlockSize, partial);
+          std::copy(
+              qk_sum_data, qk_sum_data + qBlockSize, partial + qSplitSize);
+          std::copy(
+              dst_data,
+              dst_data + qBlockSize * headSize,
+              partial + 2 * qSplitSize);
+        }
+      } else {
+        // dst <- dst / sum[row]
+        // reorder MHA output with strides
+        for (int64_t row = 0; row < qBlockSize; ++row) {
+          accum_t sum_reciprocal = 1 / qk_sum_data[row];
+          vec::map<scalar_t>(
+              [sum_reciprocal](Vec x) { return x * Vec(sum_reciprocal); },
+              out_data + i * oStrideB + j * oStrideH + m * oStrideM +
+                  row * oStrideM,
+              dst_data + row * headSize,
+              headSize);
+        }
+      }
+      // Move to the next query
+      util::data_index_step(
+          i, batchSize, j, num_head, k, qSlice, s, num_kv_splits);
+    }
+  };
+  torch::executor::parallel_for(
+      0, batchSize * num_head * qSlice * num_kv_splits, 1, compute_lambda);
+  if (num_kv_splits == 1) {
+    return;
+  }
+
+  // Merge the partial results of the kv ranges of each query row:
+  // out = sum_s(exp(max_s - max) * dst_s) / sum_s(exp(max_s - max) * sum_s)
+  auto merge_lambda = [&](int64_t begin, int64_t end) {
+    int64_t i = 0, j = 0, k = 0;
+    util::data_index_init(begin, i, batchSize, j, num_head, k, qSlice);
+    for (int64_t z = begin; z < end; z++) {
+      int64_t m = k * qSplitSize;
+      int64_t qBlockSize = std::min(qSplitSize, qSize - m);
+      const accum_t* partials =
+          partials_vec.data() + z * num_kv_splits * partial_size;
+      for (int64_t row = 0; row < qBlockSize; ++row) {
+        accum_t max = -std::numeric_limits<accum_t>::infinity();
+        for (int64_t split = 0; split < num_kv_splits; ++split) {
+          max = std::max(max, partials[split * partial_size + row]);
+        }
+        accum_t sum = 0;
+        for (int64_t split = 0; split < num_kv_splits; ++split) {
+          const accum_t* partial = partials + split * partial_size;
+          if (partial[qSplitSize + row] > 0) {
+            sum += std::exp(partial[row] - max) * partial[qSplitSize + row];
+          }
+        }
+        scalar_t* out_ptr = out_data + i * oStrideB + j * oStrideH +
+            m * oStrideM + row * oStrideM;
+        fill_stub(out_ptr, static_cast<scalar_t>(0), headSize);
+        for (int64_t split = 0; split < num_kv_splits; ++split) {
+          const accum_t* partial = partials + split * partial_size;
+          if (partial[qSplitSize + row] > 0) {
+            accum_t weight = std::exp(partial[row] - max) / sum;
+            vec::map2<accum_t>(
+                [weight](Vec x, Vec y) { return x + y * Vec(weight); },
+                out_ptr,
+                out_ptr,
+                partial + 2 * qSplitSize + row * headSize,
+                headSize);
+          }
+        }
+      }
+      util::data_index_step(i, batchSize, j, num_head, k, qSlice);
+    }
+  };
+  torch::executor::parallel_for(
+      0, batchSize * num_head * qSlice, 1, merge_lambda);
+}
+
+/*
+Attention over a paged KV cache, for batched decoding of many sequences.
+
+Instead of one [1, max_seq_len, num heads, head dim] cache per sequence, the
+cache of a layer is a pool of fixed size blocks,
+[num blocks, block size, num heads, head dim], shared by all the sequences of
+the batch. Row b of block_table lists the blocks holding the keys and values of
+sequence b, in order: position p of the sequence lives at offset
+p % block_size of block block_table[b][p / block_size]. start_pos[b] is the
+position of the first query of sequence b, so sequences of different lengths
+can be decoded together.
+
+Each block is laid out like a slice of the contiguous cache, so the kernel
+follows cpu_flash_attention with one kv split per block. Work is split by
+(batch, query position, kv head): the query heads that share a kv head are
+processed together, so each block of keys and values is read once per group.
+Attention is always causal.
+*/
+template <typename scalar_t>
+void cpu_paged_attention(
+    Tensor& output,
+    const Tensor& query,
+    const Tensor& key_cache,
+    const Tensor& value_cache,
+    const Tensor& block_table,
+    const Tensor& start_pos,
+    const optional<double>& scale) {
+  using accum_t = scalar_t;
+  using Vec = vec::Vectorized<accum_t>;
+  accum_t scaling_factor =
+      static_cast<accum_t>(util::calculate_scale(query, scale));
+
+  // Query/Output (Batch x Q_seq_len x Num_heads    x Dim_per_head)
+  // Key/Value    (Blocks x Block_size x Num_heads_kv x Dim_per_head)
+  int64_t batchSize = query.size(0);
+  int64_t qSize = query.size(1);
+  int64_t num_head = query.size(2);
+  int64_t headSize = query.size(3);
+  int64_t blockSize = key_cache.size(1);
+  int64_t num_heads_kv = key_cache.size(2);
+  int64_t num_reps = num_head / num_heads_kv;
+  int64_t maxBlocks = block_table.size(1);
+
+  auto strides = query.strides();
+  int64_t qStrideB = strides[0];
+  int64_t qStrideM = strides[1];
+  int64_t qStrideH = strides[2];
+
+  strides = key_cache.strides();
+  int64_t kStrideBlock = strides[0];
+  int64_t kStrideN = strides[1];
+  int64_t kStrideH = strides[2];
+
+  strides = value_cache.strides();
+  int64_t vStrideBlock = strides[0];
+  int64_t vStrideN = strides[1];
+  int64_t vStrideH = strides[2];
+
+  strides = output.strides();
+  int64_t oStrideB = strides[0];
+  int64_t oStrideM = strides[1];
+  int64_t oStrideH = strides[2];
+
+#ifdef ET_USE_THREADPOOL
+  int64_t num_thread =
+      torch::executorch::threadpool::get_threadpool()->get_thread_count();
+#else
+  int64_t num_thread = 1;
+#endif
+
+  // allocate per thread temp buf (accumulate type)
+  int64_t size_per_thread =
+      /* qk     */ num_reps * blockSize +
+      /* qk_max */ num_reps +
+      /* qk_sum */ num_reps +
+      /* dst    */ num_reps * headSize;
+  std::vector<accum_t> buf(size_per_thread * num_thread);
+
+  // Data ptrs
+  const scalar_t* q_data = query.const_data_ptr<scalar_t>();
+  const scalar_t* k_data = key_cache.const_data_ptr<scalar_t>();
+  const scalar_t* v_data = value_cache.const_data_ptr<scalar_t>();
+  const int64_t* block_table_data = block_table.const_data_ptr<int64_t>();
+  const int64_t* start_pos_data = start_pos.const_data_ptr<int64_t>();
+  scalar_t* out_data = output.mutable_data_ptr<scalar_t>();
+
+  auto compute_lambda = [&](int64_t begin, int64_t end) {
+    int64_t i = 0, m = 0, j_kv = 0;
+    util::data_index_init(begin, i, batchSize, m, qSize, j_kv, num_heads_kv);
+    int ompIdx = torch::executor::get_thread_num();
+    accum_t* buf_ptr = buf.data() + ompIdx * size_per_thread;
+    accum_t* qk_data = buf_ptr;
+    accum_t* qk_max_data = qk_data + num_reps * blockSize;
+    accum_t* qk_sum_data = qk_max_data + num_reps;
+    accum_t* dst_data = qk_sum_data + num_reps;
+
+    for (int64_t z = begin; z < end; z++) {
+      // The query heads of the group are consecutive rows, qStrideH apart.
+      const scalar_t* q_ptr =
+          q_data + i * qStrideB + m * qStrideM + j_kv * num_reps * qStrideH;
+      const int64_t* blocks = block_table_data + i * maxBlocks;
+      int64_t num_keys = start_pos_data[i] + m + 1;
+      fill_stub(
+          qk_max_data, -std::numeric_limits<accum_t>::infinity(), num_reps);
+      fill_stub(qk_sum_data, static_cast<accum_t>(0), num_reps);
+      for (int64_t n = 0; n < num_keys; n += blockSize) {
+        int64_t kvBlockSize = std::min(blockSize, num_keys - n);
+        int64_t block = blocks[n / blockSize];
+        // Calculate scale * q @ k.T
+        ::executorch::cpublas::gemm(
+            ::executorch::cpublas::TransposeType::Transpose,
+            ::executorch::cpublas::TransposeType::NoTranspose,
+            kvBlockSize,
+            num_reps,
+            headSize,
+            static_cast<accum_t>(1),
+            k_data + block * kStrideBlock + j_kv * kStrideH,
+            kStrideN,
+            q_ptr,
+            qStrideH,
+            static_cast<accum_t>(0),
+            qk_data,
+            kvBlockSize);
+        // Update coefficients with Softmax. Keys past num_keys are never
+        // read, so no causal mask is needed.
+        accum_t tmp_max = 0, tmp_sum = 0, exp_tmp = 0;
+        for (int64_t row = 0; row < num_reps; ++row) {
+          // apply scaling factor and max per row in fusion
+          _mul_reduce_max_fusion_kernel(
+              qk_data + row * kvBlockSize,
+              scaling_factor,
+              kvBlockSize,
+              qk_data + row * kvBlockSize,
+              tmp_max);
+          tmp_max = qk_max_data[row] > tmp_max ? qk_max_data[row] : tmp_max;
+          // qk <- exp(qk - max) and sum per row
+          tmp_sum = tmp_max;
+          _exp_reduce_sum_fusion_kernel(
+              qk_data + row * kvBlockSize,
+              kvBlockSize,
+              qk_data + row * kvBlockSize,
+              tmp_sum);
+          // exp_tmp <- exp(max[row] - max)
+          exp_tmp = std::exp(qk_max_data[row] - tmp_max);
+          // sum[row] <- sum + exp_tmp * sum[row]
+          qk_sum_data[row] = tmp_sum + exp_tmp * qk_sum_data[row];
+          // max[row] <- max
+          qk_max_data[row] = tmp_max;
+          // dst <- dst * exp_tmp
+          if (n > 0) {
+            vec::map<accum_t>(
+                [exp_tmp](Vec x) { return x * Vec(exp_tmp); },
+                dst_data + row * headSize,
+                dst_data + row * headSize,
+                headSize);
+          }
+        }
+        // Calculate Softmax(q @ k.T) @ v
+        ::executorch::cpublas::gemm(
+            ::executorch::cpublas::TransposeType::NoTranspose,
+            ::executorch::cpublas::TransposeType::NoTranspose,
+            headSize,
+            num_reps,
+            kvBlockSize,
+            static_cast<accum_t>(1),
+            v_data + block * vStrideBlock + j_kv * vStrideH,
+            vStrideN,
+            qk_data,
+            kvBlockSize,
             n == 0 ? static_cast<accum_t>(0) : static_cast<accum_t>(1),
             dst_data,
             headSize);
       }
       // dst <- dst / sum[row]
       // reorder MHA output with strides
-      for (int64_t row = 0; row < qBlockSize; ++row) {
+      for (int64_t row = 0; row < num_reps; ++row) {
         accum_t sum_reciprocal = 1 / qk_sum_data[row];
         vec::map<scalar_t>(
             [sum_reciprocal](Vec x) { return x * Vec(sum_reciprocal); },
-            out_data + i * oStrideB + j * oStrideH + m * oStrideM +
-                row * oStrideM,
+            out_data + i * oStrideB + m * oStrideM +
+                (j_kv * num_reps + row) * oStrideH,
             dst_data + row * headSize,
             headSize);
       }
       // Move to the next query
-      util::data_index_step(i, batchSize, j, num_head, k, qSlice);
+      util::data_index_step(i, batchSize, m, qSize, j_kv, num_heads_kv);
     }
   };
   torch::executor::parallel_for(
-      0, batchSize * num_head * qSlice, 1, compute_lambda);
+      0, batchSize * qSize * num_heads_kv, 1, compute_lambda);
 }
 
 bool validate_flash_attention_args(
@@ -694,6 +1113,175 @@ bool validate_cache_params(
   return true;
 }
 
+bool validate_quantized_cache_params(
+    const Tensor& q_projected,
+    const Tensor& k_projected,
+    const Tensor& v_projected,
+    const Tensor& key_cache,
+    const Tensor& value_cache,
+    const Tensor& key_cache_scales,
+    const Tensor& value_cache_scales) {
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      q_projected.dim() == 4 && k_projected.dim() == 4 &&
+          v_projected.dim() == 4,
+      "query, key and value must be 4D tensors");
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      q_projected.scalar_type() == ScalarType::Float &&
+          k_projected.scalar_type() == ScalarType::Float &&
+          v_projected.scalar_type() == ScalarType::Float,
+      "query, key and value must be Float tensors");
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      key_cache.scalar_type() == ScalarType::Char &&
+          value_cache.scalar_type() == ScalarType::Char,
+      "key_cache and value_cache must be Char tensors");
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      key_cache_scales.scalar_type() == ScalarType::Float &&
+          value_cache_scales.scalar_type() == ScalarType::Float,
+      "key_cache_scales and value_cache_scales must be Float tensors");
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      key_cache_scales.dim() == 4 && value_cache_scales.dim() == 4,
+      "key_cache_scales and value_cache_scales must be 4D tensors");
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      k_projected.size(0) == 1 && key_cache.size(0) == 1,
+      "quantized cache must have batch size of 1");
+  for (size_t d = 0; d < util::kKVDim; ++d) {
+    ET_LOG_MSG_AND_RETURN_IF_FALSE(
+        key_cache.size(d) == value_cache.size(d),
+        "key_cache and value_cache must have the same sizes");
+    ET_LOG_MSG_AND_RETURN_IF_FALSE(
+        k_projected.size(d) == v_projected.size(d),
+        "key and value must have the same sizes");
+    // One scale per token per head.
+    const int64_t scales_size = d == util::kKVDim - 1 ? 1 : key_cache.size(d);
+    ET_LOG_MSG_AND_RETURN_IF_FALSE(
+        key_cache_scales.size(d) == scales_size &&
+            value_cache_scales.size(d) == scales_size,
+        "cache scales must be [1, max seq len, num heads, 1]");
+  }
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      k_projected.size(2) == key_cache.size(2) &&
+          k_projected.size(3) == key_cache.size(3),
+      "key and key_cache must have the same number of heads and head dim");
+
+  // Make sure they are in contiguous dim order
+  const Tensor* tensors[] = {
+      &k_projected, &v_projected, &key_cache_scales, &value_cache_scales};
+  for (const Tensor* tensor : tensors) {
+    ET_LOG_MSG_AND_RETURN_IF_FALSE(
+        is_contiguous_dim_order(tensor->dim_order().data(), tensor->dim()),
+        "quantized cache inputs must be in contiguous dim order");
+  }
+
+  return true;
+}
+
+bool validate_paged_cache_params(
+    const Tensor& q_projected,
+    const Tensor& k_projected,
+    const Tensor& v_projected,
+    const Tensor& key_cache,
+    const Tensor& value_cache,
+    const Tensor& block_table,
+    const Tensor& start_pos) {
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      q_projected.dim() == 4 && k_projected.dim() == 4 &&
+          v_projected.dim() == 4,
+      "query, key and value must be 4D tensors");
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      key_cache.dim() == 4, "key_cache must be a 4D tensor");
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      value_cache.dim() == 4, "value_cache must be a 4D tensor");
+  for (size_t d = 0; d < util::kKVDim; ++d) {
+    ET_LOG_MSG_AND_RETURN_IF_FALSE(
+        key_cache.size(d) == value_cache.size(d),
+        "key_cache and value_cache must have the same sizes");
+    ET_LOG_MSG_AND_RETURN_IF_FALSE(
+        k_projected.size(d) == v_projected.size(d),
+        "key and value must have the same sizes");
+  }
+
+  const int64_t batch_size = q_projected.size(0);
+  const int64_t seq_len = q_projected.size(1);
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      k_projected.size(0) == batch_size && k_projected.size(1) == seq_len,
+      "query, key and value must have the same batch size and sequence length");
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      k_projected.size(2) == key_cache.size(2) &&
+          k_projected.size(3) == key_cache.size(3),
+      "key and key_cache must have the same number of heads and head dim");
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      q_projected.size(3) == key_cache.size(3),
+      "query and key_cache must have the same head dim");
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      q_projected.size(2) % key_cache.size(2) == 0,
+      "num query heads must be divisible by num kv heads but got num query heads=%zd"
+      " and num kv heads=%zd",
+      q_projected.size(2),
+      key_cache.size(2));
+
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      q_projected.scalar_type() == k_projected.scalar_type() &&
+          q_projected.scalar_type() == v_projected.scalar_type() &&
+          q_projected.scalar_type() == key_cache.scalar_type() &&
+          q_projected.scalar_type() == value_cache.scalar_type(),
+      "query, key, value and the caches must have the same data type");
+
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      block_table.dim() == 2 && block_table.size(0) == batch_size,
+      "block_table must be a [batch size, max blocks per sequence] tensor");
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      start_pos.dim() == 1 && start_pos.size(0) == batch_size,
+      "start_pos must be a [batch size] tensor");
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      block_table.scalar_type() == ScalarType::Long &&
+          start_pos.scalar_type() == ScalarType::Long,
+      "block_table and start_pos must be Long tensors");
+
+  // Make sure they are in contiguous dim order
+  const Tensor* tensors[] = {
+      &q_projected,
+      &k_projected,
+      &v_projected,
+      &key_cache,
+      &value_cache,
+      &block_table};
+  for (const Tensor* tensor : tensors) {
+    ET_LOG_MSG_AND_RETURN_IF_FALSE(
+        is_contiguous_dim_order(tensor->dim_order().data(), tensor->dim()),
+        "paged attention inputs must be in contiguous dim order");
+  }
+
+  // Every block that the batch reads or writes must be in the cache.
+  const int64_t num_blocks = key_cache.size(0);
+  const int64_t block_size = key_cache.size(1);
+  const int64_t max_blocks = block_table.size(1);
+  const int64_t* block_table_data = block_table.const_data_ptr<int64_t>();
+  const int64_t* start_pos_data = start_pos.const_data_ptr<int64_t>();
+  for (int64_t b = 0; b < batch_size; ++b) {
+    const int64_t end_pos = start_pos_data[b] + seq_len;
+    ET_LOG_MSG_AND_RETURN_IF_FALSE(
+        start_pos_data[b] >= 0 && end_pos <= max_blocks * block_size,
+        "sequence %" PRId64 " spans positions [%" PRId64 ", %" PRId64
+        "), past the %" PRId64 " positions of its block table",
+        b,
+        start_pos_data[b],
+        end_pos,
+        max_blocks * block_size);
+    const int64_t used_blocks = (end_pos + block_size - 1) / block_size;
+    for (int64_t n = 0; n < used_blocks; ++n) {
+      const int64_t block = block_table_data[b * max_blocks + n];
+      ET_LOG_MSG_AND_RETURN_IF_FALSE(
+          block >= 0 && block < num_blocks,
+          "block %" PRId64 " of sequence %" PRId64 " is out of range: %" PRId64,
+          n,
+          b,
+          block);
+    }
+  }
+
+  return true;
+}
+
 // TODO: seq_length is not yet used for copy
 void update_cache(
     const Tensor& projected_value,
@@ -726,6 +1314,128 @@ void update_cache(
       (uint8_t*)cache_data + pos_offset_bytes, projected_value_data, num_bytes);
 }
 
+// Quantizes projected_value, [1, seq_len, num heads, head dim], into an int8
+// cache from start_pos. Each token of each head gets its own symmetric scale,
+// max(abs(x)) / 127, so outliers in one head don't cost precision in others.
+void update_quantized_cache(
+    const Tensor& projected_value,
+    const Tensor& cache,
+    const Tensor& cache_scales,
+    int64_t start_pos) {
+  ET_CHECK_MSG(
+      projected_value.size(0) == 1,
+      "projected_value must have batch size of 1");
+  const float* projected_value_data = projected_value.const_data_ptr<float>();
+  int8_t* cache_data = cache.mutable_data_ptr<int8_t>();
+  float* scales_data = cache_scales.mutable_data_ptr<float>();
+
+  ET_CHECK_MSG(projected_value_data != nullptr, "projected_value data is null");
+  ET_CHECK_MSG(cache_data, "cache data is null");
+  ET_CHECK_MSG(scales_data, "cache scales data is null");
+
+  const int64_t seq_len = projected_value.size(1);
+  const int64_t num_heads = projected_value.size(2);
+  const int64_t head_dim = projected_value.size(3);
+  const auto cache_strides = cache.strides();
+  const auto scales_strides = cache_scales.strides();
+  for (int64_t t = 0; t < seq_len; ++t) {
+    const int64_t pos = start_pos + t;
+    for (int64_t h = 0; h < num_heads; ++h) {
+      const float* src = projected_value_data + (t * num_heads + h) * head_dim;
+      int8_t* dst =
+          cache_data + pos * cache_strides[1] + h * cache_strides[2];
+      float max_abs = 0;
+      for (int64_t d = 0; d < head_dim; ++d) {
+        max_abs = std::max(max_abs, std::abs(src[d]));
+      }
+      const float inv_scale = max_abs > 0 ? 127.0f / max_abs : 0.0f;
+      for (int64_t d = 0; d < head_dim; ++d) {
+        dst[d] = static_cast<int8_t>(std::lrintf(src[d] * inv_scale));
+      }
+      scales_data[pos * scales_strides[1] + h * scales_strides[2]] =
+          max_abs / 127.0f;
+    }
+  }
+}
+
+// Writes projected_value, [batch size, seq_len, num heads, head dim], to the
+// blocks of a paged cache. Sequence b is written from position start_pos[b].
+void update_paged_cache(
+    const Tensor& projected_value,
+    const Tensor& cache,
+    const Tensor& block_table,
+    const Tensor& start_pos) {
+  const int64_t batch_size = projected_value.size(0);
+  const int64_t seq_len = projected_value.size(1);
+  const int64_t block_size = cache.size(1);
+  const int64_t max_blocks = block_table.size(1);
+  const int64_t* block_table_data = block_table.const_data_ptr<int64_t>();
+  const int64_t* start_pos_data = start_pos.const_data_ptr<int64_t>();
+  const uint8_t* projected_value_data =
+      static_cast<const uint8_t*>(projected_value.const_data_ptr());
+  uint8_t* cache_data = static_cast<uint8_t*>(cache.mutable_data_ptr());
+
+  ET_CHECK_MSG(projected_value_data != nullptr, "projected_value data is null");
+  ET_CHECK_MSG(cache_data, "cache data is null");
+
+  // One token of a sequence is [num heads, head dim].
+  const size_t token_bytes = cache.strides()[1] * cache.element_size();
+  for (int64_t b = 0; b < batch_size; ++b) {
+    for (int64_t t = 0; t < seq_len; ++t) {
+      const int64_t pos = start_pos_data[b] + t;
+      const int64_t block = block_table_data[b * max_blocks + pos / block_size];
+      // NOLINTNEXTLINE
+      std::memcpy(
+          cache_data + (block * block_size + pos % block_size) * token_bytes,
+          projected_value_data + (b * seq_len + t) * token_bytes,
+          token_bytes);
+    }
+  }
+}
+
+// A [batch size, num_tokens, num heads, head dim] view of the first num_tokens
+// positions of a [batch size, max_seq_len, num heads, head dim] cache.
+class KVCacheSlice {
+ public:
+  KVCacheSlice(Tensor& cache, int64_t num_tokens)
+      : sizes_{
+            static_cast<exec_aten::SizesType>(cache.size(0)),
+            static_cast<exec_aten::SizesType>(num_tokens),
+            static_cast<exec_aten::SizesType>(cache.size(2)),
+            static_cast<exec_aten::SizesType>(cache.size(3))},
+        strides_(contiguous_strides(sizes_, dim_order_)),
+        impl_(
+            cache.scalar_type(),
+            util::kKVDim,
+            sizes_.data(),
+            cache.mutable_data_ptr(),
+            dim_order_.data(),
+            strides_.data(),
+            TensorShapeDynamism::STATIC) {}
+
+  KVCacheSlice(const KVCacheSlice&) = delete;
+  KVCacheSlice& operator=(const KVCacheSlice&) = delete;
+
+  Tensor tensor() {
+    return Tensor(&impl_);
+  }
+
+ private:
+  static std::array<exec_aten::StridesType, util::kKVDim> contiguous_strides(
+      const std::array<exec_aten::SizesType, util::kKVDim>& sizes,
+      const std::array<exec_aten::DimOrderType, util::kKVDim>& dim_order) {
+    std::array<exec_aten::StridesType, util::kKVDim> strides;
+    dim_order_to_stride_nocheck(
+        sizes.data(), dim_order.data(), util::kKVDim, strides.data());
+    return strides;
+  }
+
+  std::array<exec_aten::DimOrderType, util::kKVDim> dim_order_{0, 1, 2, 3};
+  std::array<exec_aten::SizesType, util::kKVDim> sizes_;
+  std::array<exec_aten::StridesType, util::kKVDim> strides_;
+  TensorImpl impl_;
+};
+
 } // anonymous namespace
 
 Tensor& flash_attention_kernel_out(
@@ -846,53 +1556,8 @@ Tensor& sdpa_with_kv_cache_out(
 
   auto q_seq_len = q_projected.size(1);
 
-  std::array<exec_aten::DimOrderType, util::kKVDim> sliced_key_dim_order{
-      0, 1, 2, 3};
-  std::array<exec_aten::SizesType, util::kKVDim> sliced_key_sizes;
-  sliced_key_sizes[0] = key_cache.size(0);
-  sliced_key_sizes[1] = start_pos + seq_len; // key_cache.size(2);
-  sliced_key_sizes[2] = key_cache.size(2);
-  sliced_key_sizes[3] = key_cache.size(3);
-  std::array<exec_aten::StridesType, util::kKVDim> sliced_key_strides;
-  dim_order_to_stride_nocheck(
-      sliced_key_sizes.data(),
-      sliced_key_dim_order.data(),
-      util::kKVDim,
-      sliced_key_strides.data());
-  void* key_cache_data = key_cache.mutable_data_ptr();
-  TensorImpl k_impl = TensorImpl(
-      key_cache.scalar_type(),
-      util::kKVDim,
-      sliced_key_sizes.data(),
-      key_cache_data,
-      sliced_key_dim_order.data(),
-      sliced_key_strides.data(),
-      TensorShapeDynamism::STATIC);
-  Tensor sliced_key_cache(&k_impl);
-
-  std::array<exec_aten::DimOrderType, util::kKVDim> sliced_value_dim_order{
-      0, 1, 2, 3};
-  std::array<exec_aten::SizesType, util::kKVDim> sliced_value_sizes;
-  sliced_value_sizes[0] = value_cache.size(0);
-  sliced_value_sizes[1] = start_pos + seq_len; // value_cache.size(2);
-  sliced_value_sizes[2] = value_cache.size(2);
-  sliced_value_sizes[3] = value_cache.size(3);
-  std::array<exec_aten::StridesType, util::kKVDim> sliced_value_strides;
-  dim_order_to_stride_nocheck(
-      sliced_value_sizes.data(),
-      sliced_value_dim_order.data(),
-      util::kKVDim,
-      sliced_value_strides.data());
-  void* value_cache_data = value_cache.mutable_data_ptr();
-  TensorImpl value_impl = TensorImpl(
-      value_cache.scalar_type(),
-      util::kKVDim,
-      sliced_value_sizes.data(),
-      value_cache_data,
-      sliced_value_dim_order.data(),
-      sliced_value_strides.data(),
-      TensorShapeDynamism::STATIC);
-  Tensor sliced_value_cache(&value_impl);
+  KVCacheSlice sliced_key_cache(key_cache, start_pos + seq_len);
+  KVCacheSlice sliced_value_cache(value_cache, start_pos + seq_len);
 
   // Is this true?
   // Cant do this as is because the expectation of this kernel is
@@ -917,8 +1582,8 @@ Tensor& sdpa_with_kv_cache_out(
           cpu_flash_attention<CTYPE, 256, 512>(
               output,
               q_projected,
-              sliced_key_cache,
-              sliced_value_cache,
+              sliced_key_cache.tensor(),
+              sliced_value_cache.tensor(),
               dropout_p,
               is_causal,
               attn_mask,
@@ -929,8 +1594,8 @@ Tensor& sdpa_with_kv_cache_out(
           cpu_flash_attention<CTYPE, 64, 512>(
               output,
               q_projected,
-              sliced_key_cache,
-              sliced_value_cache,
+              sliced_key_cache.tensor(),
+              sliced_value_cache.tensor(),
               dropout_p,
               is_causal,
               attn_mask,
@@ -941,8 +1606,8 @@ Tensor& sdpa_with_kv_cache_out(
           cpu_flash_attention<CTYPE, 32, 512>(
               output,
               q_projected,
-              sliced_key_cache,
-              sliced_value_cache,
+              sliced_key_cache.tensor(),
+              sliced_value_cache.tensor(),
               dropout_p,
               is_causal,
               attn_mask,
@@ -953,11 +1618,224 @@ Tensor& sdpa_with_kv_cache_out(
       });
   return output;
 }
+
+/*
+  Input params
+  @param[in] q_projected Projected query with query weights.
+  Format [batch size, seq_len, num heads, head dim]
+  @param[in] k_projected Projected query with key weights.
+  Format [batch size, seq_len, num kv heads, head dim]
+  @param[in] v_projected Projected query with value weights.
+  Format [batch size, seq_len, num kv heads, head dim]
+  @param[in] key_cache Blocks of previous k_projected, shared by all sequences.
+  Format [num blocks, block size, num kv heads, head dim]
+  @param[in] value_cache Blocks of previous v_projected.
+  Format [num blocks, block size, num kv heads, head dim]
+  @param[in] block_table The blocks of each sequence, in order. Entries past
+  the last position of a sequence are ignored.
+  Format [batch size, max blocks per sequence], Long
+  @param[in] start_pos Position of the first query of each sequence.
+  Format [batch size], Long
+  @param[in] scale Softmax scale, 1 / sqrt(head dim) by default.
+
+  Attention is causal. The keys and values are written to the cache first, so
+  sequence b attends to positions [0, start_pos[b] + seq_len).
+*/
+Tensor& sdpa_with_paged_kv_cache_out(
+    RuntimeContext& ctx,
+    const Tensor& q_projected,
+    const Tensor& k_projected,
+    const Tensor& v_projected,
+    Tensor& key_cache,
+    Tensor& value_cache,
+    const Tensor& block_table,
+    const Tensor& start_pos,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<double> scale,
+    Tensor& output) {
+  ET_KERNEL_CHECK(
+      ctx,
+      validate_paged_cache_params(
+          q_projected,
+          k_projected,
+          v_projected,
+          key_cache,
+          value_cache,
+          block_table,
+          start_pos),
+      InvalidArgument,
+      output);
+
+  update_paged_cache(k_projected, key_cache, block_table, start_pos);
+  update_paged_cache(v_projected, value_cache, block_table, start_pos);
+
+  ET_KERNEL_CHECK(
+      ctx,
+      resize_tensor(output, q_projected.sizes()) == Error::Ok,
+      InvalidArgument,
+      output);
+
+  ET_SWITCH_FLOAT_TYPES(
+      q_projected.scalar_type(), ctx, "sdpa_with_paged_kv_cache", CTYPE, [&] {
+        cpu_paged_attention<CTYPE>(
+            output,
+            q_projected,
+            key_cache,
+            value_cache,
+            block_table,
+            start_pos,
+            scale);
+      });
+  return output;
+}
+
+/*
+  Input params
+  @param[in] q_projected Projected query with query weights.
+  Format [batch size, seq_len, num heads, head dim], Float
+  @param[in] k_projected Projected query with key weights.
+  Format [batch size, seq_len, num kv heads, head dim], Float
+  @param[in] v_projected Projected query with value weights.
+  Format [batch size, seq_len, num kv heads, head dim], Float
+  @param[in] key_cache Cache of previous k_projected, quantized.
+  Format [batch size, max_seq_len, num kv heads, head dim], Char
+  @param[in] value_cache Cache of previous v_projected, quantized.
+  Format [batch size, max_seq_len, num kv heads, head dim], Char
+  @param[in] key_cache_scales Scale of each token of each head of key_cache.
+  Format [batch size, max_seq_len, num kv heads, 1], Float
+  @param[in] value_cache_scales Scale of each token of each head of
+  value_cache.
+  Format [batch size, max_seq_len, num kv heads, 1], Float
+  ....
+  @param[in] start_pos: sequence position
+  @param[in] seq_len: Seq length. e.g. seq_len dim of q_projected.
+
+  Same as sdpa_with_kv_cache, except that the cache is stored as symmetric
+  int8, which takes a quarter of the memory and bandwidth of a Float cache.
+  The keys and values are quantized as they are written to the cache, and
+  dequantized a tile at a time inside the attention loop.
+*/
+Tensor& sdpa_with_quantized_kv_cache_out(
+    RuntimeContext& ctx,
+    const Tensor& q_projected,
+    const Tensor& k_projected,
+    const Tensor& v_projected,
+    Tensor& key_cache,
+    Tensor& value_cache,
+    Tensor& key_cache_scales,
+    Tensor& value_cache_scales,
+    const int64_t start_pos,
+    const int64_t seq_len,
+    const optional<Tensor>& attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<double> scale,
+    Tensor& output) {
+  ET_KERNEL_CHECK(
+      ctx,
+      validate_cache_params(key_cache, value_cache, start_pos, seq_len),
+      InvalidArgument,
+      output);
+
+  ET_KERNEL_CHECK(
+      ctx,
+      validate_quantized_cache_params(
+          q_projected,
+          k_projected,
+          v_projected,
+          key_cache,
+          value_cache,
+          key_cache_scales,
+          value_cache_scales),
+      InvalidArgument,
+      output);
+
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      !attn_mask.has_value() || !is_causal,
+      InvalidArgument,
+      output,
+      "attn_mask and is_causal cannot be set at the same time");
+
+  update_quantized_cache(k_projected, key_cache, key_cache_scales, start_pos);
+  update_quantized_cache(
+      v_projected, value_cache, value_cache_scales, start_pos);
+
+  auto q_seq_len = q_projected.size(1);
+
+  KVCacheSlice sliced_key_cache(key_cache, start_pos + seq_len);
+  KVCacheSlice sliced_value_cache(value_cache, start_pos + seq_len);
+
+  ET_KERNEL_CHECK(
+      ctx,
+      resize_tensor(output, q_projected.sizes()) == Error::Ok,
+      InvalidArgument,
+      output);
+
+  if (q_seq_len >= 768) {
+    cpu_flash_attention<float, 256, 512, int8_t>(
+        output,
+        q_projected,
+        sliced_key_cache.tensor(),
+        sliced_value_cache.tensor(),
+        dropout_p,
+        is_causal,
+        attn_mask,
+        scale,
+        true,
+        start_pos,
+        key_cache_scales,
+        value_cache_scales);
+  } else if (q_seq_len >= 192) {
+    cpu_flash_attention<float, 64, 512, int8_t>(
+        output,
+        q_projected,
+        sliced_key_cache.tensor(),
+        sliced_value_cache.tensor(),
+        dropout_p,
+        is_causal,
+        attn_mask,
+        scale,
+        true,
+        start_pos,
+        key_cache_scales,
+        value_cache_scales);
+  } else {
+    cpu_flash_attention<float, 32, 512, int8_t>(
+        output,
+        q_projected,
+        sliced_key_cache.tensor(),
+        sliced_value_cache.tensor(),
+        dropout_p,
+        is_causal,
+        attn_mask,
+        scale,
+        true,
+        start_pos,
+        key_cache_scales,
+        value_cache_scales);
+  }
+  return output;
+}
 } // namespace native
 } // namespace executor
 } // namespace torch
 
-EXECUTORCH_LIBRARY(
-    llama,
-    "sdpa_with_kv_cache.out",
-    torch::executor::native::sdpa_with_kv_cache_out);
+namespace {
+// EXECUTORCH_LIBRARY can only register one kernel per namespace in a file, so
+// register the kernels of this file together.
+const ::executorch::runtime::Kernel sdpa_kernels[] = {
+    ::executorch::extension::make_boxed_kernel(
+        "llama::sdpa_with_kv_cache.out",
+        EXECUTORCH_FN(torch::executor::native::sdpa_with_kv_cache_out)),
+    ::executorch::extension::make_boxed_kernel(
+        "llama::sdpa_with_paged_kv_cache.out",
+        EXECUTORCH_FN(torch::executor::native::sdpa_with_paged_kv_cache_out)),
+    ::executorch::extension::make_boxed_kernel(
+        "llama::sdpa_with_quantized_kv_cache.out",
+        EXECUTORCH_FN(
+            torch::executor::native::sdpa_with_quantized_kv_cache_out)),
+};
+static auto res_llama = ::executorch::runtime::register_kernels(sdpa_kernels);
+} // namespace
@@ -6,9 +6,13 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <cmath>
 #include <limits>
+#include <random>
+#include <vector>
 
 #include <executorch/extension/llm/custom_ops/op_sdpa.h> // Declares the operator
+#include <executorch/extension/threadpool/threadpool.h>
 #include <executorch/kernels/test/TestUtil.h>
 #include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
 #include <executorch/runtime/core/exec_aten/testing_util/tensor_util.h>
@@ -985,3 +989,83 @@ TEST(OpScaledDotProductAttentionTest, SequenceTest) {
       out);
   EXPECT_TENSOR_CLOSE_WITH_TOL(ret, ret_expected_3, 1e-4, 1e-4);
 }
+
+TEST(OpScaledDotProductAttentionTest, LongContextDecodeTest) {
+  // Decode one token against a cache that spans several kv splits of the
+  // kernel. With few heads and more threads than heads, the kernel splits the
+  // keys across threads and merges the partial results, so fix the thread
+  // count rather than rely on the cores of the machine running the test.
+  auto* threadpool = torch::executorch::threadpool::get_threadpool();
+  const auto num_threads = threadpool->get_thread_count();
+  ASSERT_TRUE(threadpool->_unsafe_reset_threadpool(8));
+  TensorFactory<exec_aten::ScalarType::Float> tfFloat;
+  constexpr int32_t kMaxSeqLen = 2048;
+  constexpr int32_t kNumHeads = 2;
+  constexpr int32_t kHeadDim = 8;
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  auto random = [&](const std::vector<int32_t>& sizes) {
+    exec_aten::Tensor t = tfFloat.zeros(sizes);
+    float* data = t.mutable_data_ptr<float>();
+    for (size_t i = 0; i < t.numel(); ++i) {
+      data[i] = dist(rng);
+    }
+    return t;
+  };
+
+  exec_aten::Tensor key_cache = random({1, kMaxSeqLen, kNumHeads, kHeadDim});
+  exec_aten::Tensor value_cache =
+      random({1, kMaxSeqLen, kNumHeads, kHeadDim});
+  for (int64_t start_pos : {511, 512, 1023, 1500, 2047}) {
+    exec_aten::Tensor query = random({1, 1, kNumHeads, kHeadDim});
+    exec_aten::Tensor key = random({1, 1, kNumHeads, kHeadDim});
+    exec_aten::Tensor value = random({1, 1, kNumHeads, kHeadDim});
+    exec_aten::Tensor out = tfFloat.zeros({1, 1, kNumHeads, kHeadDim});
+    op_sdpa_with_kv_cache(
+        query,
+        key,
+        value,
+        key_cache,
+        value_cache,
+        start_pos,
+        1,
+        {},
+        0.0,
+        /*is_causal=*/true,
+        {},
+        out);
+
+    // softmax(q @ k.T / sqrt(head dim)) @ v over positions 0...start_pos.
+    exec_aten::Tensor expected = tfFloat.zeros({1, 1, kNumHeads, kHeadDim});
+    const float* q = query.const_data_ptr<float>();
+    const float* k = key_cache.const_data_ptr<float>();
+    const float* v = value_cache.const_data_ptr<float>();
+    float* e = expected.mutable_data_ptr<float>();
+    for (int32_t h = 0; h < kNumHeads; ++h) {
+      std::vector<float> scores(start_pos + 1);
+      float max_score = -std::numeric_limits<float>::infinity();
+      for (int64_t t = 0; t <= start_pos; ++t) {
+        float score = 0;
+        for (int32_t d = 0; d < kHeadDim; ++d) {
+          score += q[h * kHeadDim + d] *
+              k[(t * kNumHeads + h) * kHeadDim + d];
+        }
+        scores[t] = score / std::sqrt(static_cast<float>(kHeadDim));
+        max_score = std::max(max_score, scores[t]);
+      }
+      float sum = 0;
+      for (int64_t t = 0; t <= start_pos; ++t) {
+        scores[t] = std::exp(scores[t] - max_score);
+        sum += scores[t];
+      }
+      for (int64_t t = 0; t <= start_pos; ++t) {
+        for (int32_t d = 0; d < kHeadDim; ++d) {
+          e[h * kHeadDim + d] +=
+              scores[t] / sum * v[(t * kNumHeads + h) * kHeadDim + d];
+        }
+      }
+    }
+    EXPECT_TENSOR_CLOSE_WITH_TOL(out, expected, 1e-5, 1e-5);
+  }
+  threadpool->_unsafe_reset_threadpool(num_threads);
+}
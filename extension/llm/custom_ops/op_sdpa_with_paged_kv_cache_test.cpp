@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <executorch/extension/llm/custom_ops/op_sdpa.h> // Declares the operator
+#include <executorch/kernels/test/TestUtil.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_util.h>
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using exec_aten::ScalarType;
+using exec_aten::Tensor;
+using executorch::runtime::testing::TensorFactory;
+
+namespace {
+
+constexpr int32_t kNumHeads = 4;
+constexpr int32_t kNumKVHeads = 2;
+constexpr int32_t kHeadDim = 8;
+constexpr int32_t kBlockSize = 4;
+constexpr int32_t kNumBlocks = 16;
+constexpr int32_t kMaxBlocks = 5;
+
+class OpSdpaWithPagedKVCacheTest : public OperatorTest {
+ protected:
+  Tensor& op_sdpa_with_paged_kv_cache(
+      const Tensor& query,
+      const Tensor& key,
+      const Tensor& value,
+      Tensor& key_cache,
+      Tensor& value_cache,
+      const Tensor& block_table,
+      const Tensor& start_pos,
+      Tensor& out) {
+    return torch::executor::native::sdpa_with_paged_kv_cache_out(
+        context_,
+        query,
+        key,
+        value,
+        key_cache,
+        value_cache,
+        block_table,
+        start_pos,
+        {},
+        out);
+  }
+
+  Tensor random(const std::vector<int32_t>& sizes) {
+    Tensor t = tf_.zeros(sizes);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    float* data = t.mutable_data_ptr<float>();
+    for (size_t i = 0; i < t.numel(); ++i) {
+      data[i] = dist(rng_);
+    }
+    return t;
+  }
+
+  // Copies sequence b, of seq_len tokens, out of a batched tensor.
+  Tensor select(const Tensor& t, int32_t b) {
+    std::vector<int32_t> sizes(t.sizes().begin(), t.sizes().end());
+    sizes[0] = 1;
+    Tensor out = tf_.zeros(sizes);
+    std::copy(
+        t.const_data_ptr<float>() + b * out.numel(),
+        t.const_data_ptr<float>() + (b + 1) * out.numel(),
+        out.mutable_data_ptr<float>());
+    return out;
+  }
+
+  TensorFactory<ScalarType::Float> tf_;
+  TensorFactory<ScalarType::Long> tf_long_;
+  std::mt19937 rng_{0};
+};
+
+} // namespace
+
+TEST_F(OpSdpaWithPagedKVCacheTest, MatchesContiguousCache) {
+  // Three sequences of different lengths, whose blocks are scattered through
+  // the cache.
+  const std::vector<int64_t> prompt_lengths = {5, 1, 9};
+  const int32_t batch_size = prompt_lengths.size();
+  std::vector<int64_t> free_blocks(kNumBlocks);
+  for (int32_t i = 0; i < kNumBlocks; ++i) {
+    free_blocks[i] = i;
+  }
+  std::shuffle(free_blocks.begin(), free_blocks.end(), rng_);
+  std::vector<int64_t> block_table_data(batch_size * kMaxBlocks);
+  for (int32_t b = 0; b < batch_size; ++b) {
+    for (int32_t n = 0; n < kMaxBlocks && !free_blocks.empty(); ++n) {
+      block_table_data[b * kMaxBlocks + n] = free_blocks.back();
+      free_blocks.pop_back();
+    }
+  }
+
+  Tensor key_cache = tf_.zeros({kNumBlocks, kBlockSize, kNumKVHeads, kHeadDim});
+  Tensor value_cache =
+      tf_.zeros({kNumBlocks, kBlockSize, kNumKVHeads, kHeadDim});
+  std::vector<Tensor> ref_key_caches;
+  std::vector<Tensor> ref_value_caches;
+  for (int32_t b = 0; b < batch_size; ++b) {
+    ref_key_caches.push_back(
+        tf_.zeros({1, kMaxBlocks * kBlockSize, kNumKVHeads, kHeadDim}));
+    ref_value_caches.push_back(
+        tf_.zeros({1, kMaxBlocks * kBlockSize, kNumKVHeads, kHeadDim}));
+  }
+
+  auto check_against_reference = [&](const Tensor& query,
+                                     const Tensor& key,
+                                     const Tensor& value,
+                                     const Tensor& out,
+                                     int32_t b,
+                                     int32_t out_b,
+                                     int64_t start_pos) {
+    const int64_t seq_len = query.size(1);
+    Tensor expected = tf_.zeros({1, (int32_t)seq_len, kNumHeads, kHeadDim});
+    exec_aten::RuntimeContext context{};
+    torch::executor::native::sdpa_with_kv_cache_out(
+        context,
+        select(query, out_b),
+        select(key, out_b),
+        select(value, out_b),
+        ref_key_caches[b],
+        ref_value_caches[b],
+        start_pos,
+        seq_len,
+        {},
+        0.0,
+        /*is_causal=*/true,
+        {},
+        expected);
+    EXPECT_TENSOR_CLOSE_WITH_TOL(select(out, out_b), expected, 1e-5, 1e-5);
+  };
+
+  // Prefill each sequence on its own.
+  std::vector<int64_t> positions(batch_size);
+  for (int32_t b = 0; b < batch_size; ++b) {
+    const int32_t seq_len = prompt_lengths[b];
+    Tensor query = random({1, seq_len, kNumHeads, kHeadDim});
+    Tensor key = random({1, seq_len, kNumKVHeads, kHeadDim});
+    Tensor value = random({1, seq_len, kNumKVHeads, kHeadDim});
+    Tensor block_table = tf_long_.make(
+        {1, kMaxBlocks},
+        std::vector<int64_t>(
+            block_table_data.begin() + b * kMaxBlocks,
+            block_table_data.begin() + (b + 1) * kMaxBlocks));
+    Tensor start_pos = tf_long_.make({1}, {0});
+    Tensor out = tf_.zeros({1, seq_len, kNumHeads, kHeadDim});
+    op_sdpa_with_paged_kv_cache(
+        query, key, value, key_cache, value_cache, block_table, start_pos, out);
+    check_against_reference(query, key, value, out, b, 0, 0);
+    positions[b] = seq_len;
+  }
+
+  // Then decode all of them together, across block boundaries.
+  Tensor block_table = tf_long_.make({batch_size, kMaxBlocks}, block_table_data);
+  for (int32_t step = 0; step < 6; ++step) {
+    Tensor query = random({batch_size, 1, kNumHeads, kHeadDim});
+    Tensor key = random({batch_size, 1, kNumKVHeads, kHeadDim});
+    Tensor value = random({batch_size, 1, kNumKVHeads, kHeadDim});
+    Tensor start_pos = tf_long_.make({batch_size}, positions);
+    Tensor out = tf_.zeros({batch_size, 1, kNumHeads, kHeadDim});
+    op_sdpa_with_paged_kv_cache(
+        query, key, value, key_cache, value_cache, block_table, start_pos, out);
+    for (int32_t b = 0; b < batch_size; ++b) {
+      check_against_reference(query, key, value, out, b, b, positions[b]);
+      positions[b]++;
+    }
+  }
+}
+
+TEST_F(OpSdpaWithPagedKVCacheTest, RejectsBlockOutOfRange) {
+  Tensor query = random({1, 1, kNumHeads, kHeadDim});
+  Tensor key = random({1, 1, kNumKVHeads, kHeadDim});
+  Tensor value = random({1, 1, kNumKVHeads, kHeadDim});
+  Tensor key_cache = tf_.zeros({kNumBlocks, kBlockSize, kNumKVHeads, kHeadDim});
+  Tensor value_cache =
+      tf_.zeros({kNumBlocks, kBlockSize, kNumKVHeads, kHeadDim});
+  Tensor block_table = tf_long_.make({1, 2}, {0, kNumBlocks});
+  // Position 4 is in the second block.
+  Tensor start_pos = tf_long_.make({1}, {kBlockSize});
+  Tensor out = tf_.zeros({1, 1, kNumHeads, kHeadDim});
+  ET_EXPECT_KERNEL_FAILURE(
+      context_,
+      op_sdpa_with_paged_kv_cache(
+          query,
+          key,
+          value,
+          key_cache,
+          value_cache,
+          block_table,
+          start_pos,
+          out));
+}
+
+TEST_F(OpSdpaWithPagedKVCacheTest, RejectsPositionPastBlockTable) {
+  Tensor query = random({1, 2, kNumHeads, kHeadDim});
+  Tensor key = random({1, 2, kNumKVHeads, kHeadDim});
+  Tensor value = random({1, 2, kNumKVHeads, kHeadDim});
+  Tensor key_cache = tf_.zeros({kNumBlocks, kBlockSize, kNumKVHeads, kHeadDim});
+  Tensor value_cache =
+      tf_.zeros({kNumBlocks, kBlockSize, kNumKVHeads, kHeadDim});
+  Tensor block_table = tf_long_.make({1, 1}, {3});
+  Tensor start_pos = tf_long_.make({1}, {kBlockSize - 1});
+  Tensor out = tf_.zeros({1, 2, kNumHeads, kHeadDim});
+  ET_EXPECT_KERNEL_FAILURE(
+      context_,
+      op_sdpa_with_paged_kv_cache(
+          query,
+          key,
+          value,
+          key_cache,
+          value_cache,
+          block_table,
+          start_pos,
+          out));
+}
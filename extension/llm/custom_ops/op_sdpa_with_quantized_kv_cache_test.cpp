@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <executorch/extension/llm/custom_ops/op_sdpa.h> // Declares the operator
+#include <executorch/kernels/test/TestUtil.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_util.h>
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using exec_aten::ScalarType;
+using exec_aten::Tensor;
+using executorch::runtime::testing::TensorFactory;
+
+namespace {
+
+constexpr int32_t kNumHeads = 4;
+constexpr int32_t kNumKVHeads = 2;
+constexpr int32_t kHeadDim = 16;
+
+class OpSdpaWithQuantizedKVCacheTest : public OperatorTest {
+ protected:
+  Tensor& op_sdpa_with_quantized_kv_cache(
+      const Tensor& query,
+      const Tensor& key,
+      const Tensor& value,
+      Tensor& key_cache,
+      Tensor& value_cache,
+      Tensor& key_cache_scales,
+      Tensor& value_cache_scales,
+      int64_t start_pos,
+      Tensor& out) {
+    return torch::executor::native::sdpa_with_quantized_kv_cache_out(
+        context_,
+        query,
+        key,
+        value,
+        key_cache,
+        value_cache,
+        key_cache_scales,
+        value_cache_scales,
+        start_pos,
+        query.size(1),
+        {},
+        0.0,
+        /*is_causal=*/true,
+        {},
+        out);
+  }
+
+  Tensor random(const std::vector<int32_t>& sizes) {
+    Tensor t = tf_.zeros(sizes);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    float* data = t.mutable_data_ptr<float>();
+    for (size_t i = 0; i < t.numel(); ++i) {
+      data[i] = dist(rng_);
+    }
+    return t;
+  }
+
+  TensorFactory<ScalarType::Float> tf_;
+  TensorFactory<ScalarType::Char> tf_char_;
+  std::mt19937 rng_{0};
+};
+
+} // namespace
+
+TEST_F(OpSdpaWithQuantizedKVCacheTest, MatchesFloatCache) {
+  // Long enough for the keys to span two kv splits of the kernel.
+  constexpr int32_t kMaxSeqLen = 600;
+  constexpr int32_t kPromptLen = 530;
+  Tensor key_cache = tf_char_.zeros({1, kMaxSeqLen, kNumKVHeads, kHeadDim});
+  Tensor value_cache = tf_char_.zeros({1, kMaxSeqLen, kNumKVHeads, kHeadDim});
+  Tensor key_cache_scales = tf_.zeros({1, kMaxSeqLen, kNumKVHeads, 1});
+  Tensor value_cache_scales = tf_.zeros({1, kMaxSeqLen, kNumKVHeads, 1});
+  Tensor ref_key_cache = tf_.zeros({1, kMaxSeqLen, kNumKVHeads, kHeadDim});
+  Tensor ref_value_cache = tf_.zeros({1, kMaxSeqLen, kNumKVHeads, kHeadDim});
+
+  int64_t start_pos = 0;
+  for (int32_t seq_len : {kPromptLen, 1, 1, 1}) {
+    Tensor query = random({1, seq_len, kNumHeads, kHeadDim});
+    Tensor key = random({1, seq_len, kNumKVHeads, kHeadDim});
+    Tensor value = random({1, seq_len, kNumKVHeads, kHeadDim});
+    Tensor out = tf_.zeros({1, seq_len, kNumHeads, kHeadDim});
+    op_sdpa_with_quantized_kv_cache(
+        query,
+        key,
+        value,
+        key_cache,
+        value_cache,
+        key_cache_scales,
+        value_cache_scales,
+        start_pos,
+        out);
+
+    Tensor expected = tf_.zeros({1, seq_len, kNumHeads, kHeadDim});
+    exec_aten::RuntimeContext context{};
+    torch::executor::native::sdpa_with_kv_cache_out(
+        context,
+        query,
+        key,
+        value,
+        ref_key_cache,
+        ref_value_cache,
+        start_pos,
+        seq_len,
+        {},
+        0.0,
+        /*is_causal=*/true,
+        {},
+        expected);
+    // int8 keeps about two decimal digits of each key and value.
+    EXPECT_TENSOR_CLOSE_WITH_TOL(out, expected, 0, 5e-3);
+    start_pos += seq_len;
+  }
+}
+
+TEST_F(OpSdpaWithQuantizedKVCacheTest, QuantizesEachTokenAndHead) {
+  constexpr int32_t kMaxSeqLen = 8;
+  constexpr int64_t kStartPos = 3;
+  Tensor key_cache = tf_char_.zeros({1, kMaxSeqLen, kNumKVHeads, kHeadDim});
+  Tensor value_cache = tf_char_.zeros({1, kMaxSeqLen, kNumKVHeads, kHeadDim});
+  Tensor key_cache_scales = tf_.zeros({1, kMaxSeqLen, kNumKVHeads, 1});
+  Tensor value_cache_scales = tf_.zeros({1, kMaxSeqLen, kNumKVHeads, 1});
+  Tensor query = random({1, 2, kNumHeads, kHeadDim});
+  Tensor key = random({1, 2, kNumKVHeads, kHeadDim});
+  Tensor value = random({1, 2, kNumKVHeads, kHeadDim});
+  // A head of zeros must not produce NaNs.
+  std::fill(
+      key.mutable_data_ptr<float>(),
+      key.mutable_data_ptr<float>() + kHeadDim,
+      0.0f);
+  Tensor out = tf_.zeros({1, 2, kNumHeads, kHeadDim});
+  op_sdpa_with_quantized_kv_cache(
+      query,
+      key,
+      value,
+      key_cache,
+      value_cache,
+      key_cache_scales,
+      value_cache_scales,
+      kStartPos,
+      out);
+
+  const float* key_data = key.const_data_ptr<float>();
+  const int8_t* key_cache_data = key_cache.const_data_ptr<int8_t>();
+  const float* key_scales_data = key_cache_scales.const_data_ptr<float>();
+  for (int32_t t = 0; t < 2; ++t) {
+    for (int32_t h = 0; h < kNumKVHeads; ++h) {
+      const float* src = key_data + (t * kNumKVHeads + h) * kHeadDim;
+      const int64_t row = (kStartPos + t) * kNumKVHeads + h;
+      float max_abs = 0;
+      for (int32_t d = 0; d < kHeadDim; ++d) {
+        max_abs = std::max(max_abs, std::abs(src[d]));
+      }
+      const float scale = key_scales_data[row];
+      EXPECT_FLOAT_EQ(scale, max_abs / 127.0f);
+      for (int32_t d = 0; d < kHeadDim; ++d) {
+        EXPECT_NEAR(
+            key_cache_data[row * kHeadDim + d] * scale,
+            src[d],
+            scale / 2 + 1e-6);
+      }
+    }
+  }
+  // Positions that weren't written are left alone.
+  EXPECT_EQ(key_scales_data[0], 0.0f);
+  for (size_t i = 0; i < out.numel(); ++i) {
+    EXPECT_FALSE(std::isnan(out.const_data_ptr<float>()[i]));
+  }
+}
+
+TEST_F(OpSdpaWithQuantizedKVCacheTest, RejectsFloatCache) {
+  Tensor query = random({1, 1, kNumHeads, kHeadDim});
+  Tensor key = random({1, 1, kNumKVHeads, kHeadDim});
+  Tensor value = random({1, 1, kNumKVHeads, kHeadDim});
+  Tensor key_cache = tf_.zeros({1, 4, kNumKVHeads, kHeadDim});
+  Tensor value_cache = tf_.zeros({1, 4, kNumKVHeads, kHeadDim});
+  Tensor key_cache_scales = tf_.zeros({1, 4, kNumKVHeads, 1});
+  Tensor value_cache_scales = tf_.zeros({1, 4, kNumKVHeads, 1});
+  Tensor out = tf_.zeros({1, 1, kNumHeads, kHeadDim});
+  ET_EXPECT_KERNEL_FAILURE(
+      context_,
+      op_sdpa_with_quantized_kv_cache(
+          query,
+          key,
+          value,
+          key_cache,
+          value_cache,
+          key_cache_scales,
+          value_cache_scales,
+          0,
+          out));
+}
@@ -126,3 +126,80 @@ def sdpa_with_kv_cache_meta(
     )
 
     return torch.empty_like(query)
+
+
+@impl(custom_ops_lib, "sdpa_with_paged_kv_cache", "Meta")
+def sdpa_with_paged_kv_cache_meta(
+    query,
+    key,
+    value,
+    key_cache,
+    value_cache,
+    block_table,
+    start_pos,
+    scale=None,
+):
+    assert (
+        query.dim() == 4
+    ), f"Expected query to be 4 dimensional but got {query.dim()} dimensions."
+    assert (
+        key.size() == value.size()
+    ), f"Key and value must have same size but got {key.size()} and {value.size()}"
+    assert (
+        key_cache.dim() == 4
+    ), f"Expected key_cache to be 4 dimensional but got {key_cache.dim()}"
+    assert (
+        key_cache.size() == value_cache.size()
+    ), f"Key cache and value cache must have same size but got {key_cache.size()} and {value_cache.size()}"
+    assert (
+        query.dtype == key_cache.dtype
+    ), f"Expected key_cache to be {query.dtype} but got {key_cache.dtype}"
+    assert (
+        block_table.dim() == 2 and block_table.dtype == torch.int64
+    ), f"Expected block_table to be a 2 dimensional int64 tensor but got {block_table.dim()} dimensions of {block_table.dtype}"
+    assert (
+        start_pos.dim() == 1 and start_pos.dtype == torch.int64
+    ), f"Expected start_pos to be a 1 dimensional int64 tensor but got {start_pos.dim()} dimensions of {start_pos.dtype}"
+
+    return torch.empty_like(query)
+
+
+@impl(custom_ops_lib, "sdpa_with_quantized_kv_cache", "Meta")
+def sdpa_with_quantized_kv_cache_meta(
+    query,
+    key,
+    value,
+    key_cache,
+    value_cache,
+    key_cache_scales,
+    value_cache_scales,
+    start_pos,
+    seq_len,
+    attn_mask=None,
+    drpout_p=0.0,
+    is_causal=False,
+    scale=None,
+):
+    assert (
+        query.dim() == 4
+    ), f"Expected query to be 4 dimensional but got {query.dim()} dimensions."
+    assert (
+        query.dtype == torch.float32
+    ), f"Expected query to be float32 but got {query.dtype}"
+    assert (
+        key.size() == value.size()
+    ), f"Key and value must have same size but got {key.size()} and {value.size()}"
+    assert (
+        key_cache.dtype == torch.int8
+    ), f"Expected key_cache to be int8 but got {key_cache.dtype}"
+    assert (
+        key_cache.size() == value_cache.size()
+    ), f"Key cache and value cache must have same size but got {key_cache.size()} and {value_cache.size()}"
+    assert (
+        key_cache_scales.size() == key_cache.size()[:-1] + (1,)
+    ), f"Expected key_cache_scales to be {key_cache.size()[:-1] + (1,)} but got {key_cache_scales.size()}"
+    assert (
+        value_cache_scales.size() == key_cache_scales.size()
+    ), f"Key and value cache scales must have same size but got {key_cache_scales.size()} and {value_cache_scales.size()}"
+
+    return torch.empty_like(query)
@@ -83,6 +83,35 @@ def define_common_targets():
             "op_sdpa_with_kv_cache_test.cpp",
         ],
         visibility = ["//executorch/..."],
+        deps = [
+            "//executorch/runtime/core/exec_aten:lib",
+            "//executorch/runtime/core/exec_aten/testing_util:tensor_util",
+            "//executorch/kernels/test:test_util",
+            "//executorch/extension/threadpool:threadpool",
+            ":custom_ops",
+        ],
+    )
+
+    runtime.cxx_test(
+        name = "op_sdpa_with_paged_kv_cache_test",
+        srcs = [
+            "op_sdpa_with_paged_kv_cache_test.cpp",
+        ],
+        visibility = ["//executorch/..."],
+        deps = [
+            "//executorch/runtime/core/exec_aten:lib",
+            "//executorch/runtime/core/exec_aten/testing_util:tensor_util",
+            "//executorch/kernels/test:test_util",
+            ":custom_ops",
+        ],
+    )
+
+    runtime.cxx_test(
+        name = "op_sdpa_with_quantized_kv_cache_test",
+        srcs = [
+            "op_sdpa_with_quantized_kv_cache_test.cpp",
+        ],
+        visibility = ["//executorch/..."],
         deps = [
             "//executorch/runtime/core/exec_aten:lib",
             "//executorch/runtime/core/exec_aten/testing_util:tensor_util",
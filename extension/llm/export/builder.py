@@ -69,6 +69,7 @@ class LLMEdgeManager:
         verbose: bool = False,
         metadata: Optional[dict] = None,
         dynamic_shapes: Optional[Any] = None,
+        max_prefill_chunk_size: Optional[int] = None,
     ):
         self.model = model
         # graph module returned from capture_pre_autograd_graph
@@ -86,6 +87,7 @@ class LLMEdgeManager:
         self.export_program = None
         self.output_dir = "."
         self.dynamic_shapes = dynamic_shapes
+        self.max_prefill_chunk_size = max_prefill_chunk_size
         self._saved_pte_filename = None
 
     def set_output_dir(self, output_dir: str) -> "LLMEdgeManager":
@@ -137,6 +139,17 @@ class LLMEdgeManager:
 
         dim = torch.export.Dim("token_dim", max=self.max_seq_len - 1)
 
+        if self.use_kv_cache and self.max_prefill_chunk_size:
+            # With a kv cache, prompts are prefilled in chunks of up to this
+            # many tokens, which bounds the planned activation memory.
+            assert (
+                self.enable_dynamic_shape
+            ), "max_prefill_chunk_size requires dynamic shape"
+            dim = torch.export.Dim(
+                "token_dim",
+                max=min(self.max_prefill_chunk_size, self.max_seq_len - 1),
+            )
+
         if not self.use_kv_cache:
             # Only one input argument: tokens
             self.dynamic_shapes = ({1: dim},)
@@ -0,0 +1,324 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Generate tokens for many concurrent sessions, decoding them together on a
+// model with a paged KV cache.
+
+#include <executorch/extension/llm/runner/batched_text_generator.h>
+
+#include <algorithm>
+#include <ctime>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+using ::executorch::runtime::Error;
+using ::executorch::runtime::Result;
+
+BatchedTextGenerator::BatchedTextGenerator(
+    Module* module,
+    Tokenizer* tokenizer,
+    int32_t vocab_size,
+    float temperature,
+    int32_t num_kv_blocks,
+    int32_t kv_block_size,
+    int32_t max_seq_len,
+    int32_t max_batch_size,
+    std::unique_ptr<std::unordered_set<uint64_t>>&& eos_ids,
+    Stats* stats)
+    : module_(module),
+      tokenizer_(tokenizer),
+      sampler_(std::make_unique<Sampler>(
+          vocab_size,
+          temperature,
+          kTopp,
+          static_cast<unsigned long long>(std::time(nullptr)))),
+      kv_cache_(
+          num_kv_blocks,
+          kv_block_size,
+          (max_seq_len + kv_block_size - 1) / kv_block_size),
+      max_seq_len_(max_seq_len),
+      max_batch_size_(max_batch_size),
+      eos_ids_(std::move(eos_ids)),
+      stats_(stats) {
+  stats_->num_prompt_tokens = 0;
+  stats_->num_generated_tokens = 0;
+}
+
+Result<uint64_t> BatchedTextGenerator::add_session(
+    std::vector<uint64_t> prompt_tokens,
+    int32_t seq_len,
+    std::function<void(const std::string&)> token_callback) {
+  // Set the sequence length to the max seq length if not provided
+  seq_len = (seq_len > 0 && seq_len <= max_seq_len_) ? seq_len : max_seq_len_;
+  ET_CHECK_OR_RETURN_ERROR(
+      !prompt_tokens.empty(), InvalidArgument, "Prompt cannot be empty");
+  ET_CHECK_OR_RETURN_ERROR(
+      prompt_tokens.size() < static_cast<size_t>(seq_len),
+      InvalidArgument,
+      "num_prompt_tokens %zu >= seq_len %" PRId32,
+      prompt_tokens.size(),
+      seq_len);
+
+  Session session;
+  session.id = next_session_id_++;
+  session.num_prompt_tokens = prompt_tokens.size();
+  session.tokens = std::move(prompt_tokens);
+  session.pos = 0;
+  session.seq_len = seq_len;
+  session.sequence = 0;
+  session.token_callback = std::move(token_callback);
+  stats_->num_prompt_tokens += session.num_prompt_tokens;
+  waiting_.push_back(std::move(session));
+  return waiting_.back().id;
+}
+
+Result<size_t> BatchedTextGenerator::step() {
+  // Start the queued sessions that fit. A session that starts gets room for
+  // its next token too, so that it can't be preempted right away.
+  while (!should_stop_ && !waiting_.empty() &&
+         running_.size() < static_cast<size_t>(max_batch_size_)) {
+    Session& session = waiting_.front();
+    const bool started = session.tokens.size() >
+        static_cast<size_t>(session.num_prompt_tokens);
+    session.sequence = kv_cache_.add_sequence();
+    const Error err = kv_cache_.reserve(
+        session.sequence, session.tokens.size() + (started ? 0 : 1));
+    if (err != Error::Ok) {
+      kv_cache_.remove_sequence(session.sequence);
+      if (err == Error::MemoryAllocationFailed && !running_.empty()) {
+        // Wait for the running sessions to free some blocks.
+        break;
+      }
+      ET_LOG(
+          Error,
+          "Session %" PRIu64 " doesn't fit in the KV cache, dropping it",
+          session.id);
+      waiting_.pop_front();
+      continue;
+    }
+    running_.push_back(std::move(session));
+    waiting_.pop_front();
+    ET_CHECK_OK_OR_RETURN_ERROR(prefill(running_.back()));
+    if (running_.back().done) {
+      kv_cache_.remove_sequence(running_.back().sequence);
+      running_.pop_back();
+    }
+  }
+
+  if (!should_stop_) {
+    ET_CHECK_OK_OR_RETURN_ERROR(decode());
+  }
+
+  stats_->num_generated_tokens = num_generated_tokens_;
+  return running_.size() + waiting_.size();
+}
+
+Error BatchedTextGenerator::generate() {
+  while (!should_stop_) {
+    if (ET_UNWRAP(step()) == 0) {
+      break;
+    }
+  }
+  return Error::Ok;
+}
+
+Error BatchedTextGenerator::prefill(Session& session) {
+  // A preempted session already sampled its last token, which is only fed to
+  // the model by the next decode.
+  const bool started =
+      session.tokens.size() > static_cast<size_t>(session.num_prompt_tokens);
+  const int32_t num_tokens = session.tokens.size() - (started ? 1 : 0);
+  token_data_.assign(
+      session.tokens.begin(), session.tokens.begin() + num_tokens);
+  start_pos_data_.assign(1, 0);
+  block_table_data_.resize(kv_cache_.max_blocks_per_sequence());
+  kv_cache_.fill_block_table(session.sequence, block_table_data_.data());
+
+  auto logits_res = forward(1, num_tokens);
+  ET_CHECK_OK_OR_RETURN_ERROR(logits_res.error());
+  session.pos = num_tokens;
+  if (!started) {
+    ET_CHECK_OK_OR_RETURN_ERROR(emit(session, sample(logits_res.get(), 0)));
+  }
+  return Error::Ok;
+}
+
+Error BatchedTextGenerator::decode() {
+  // Make room for one more token of every session, preempting the most
+  // recently started sessions while the cache is full.
+  for (size_t i = 0; i < running_.size();) {
+    Session& session = running_[i];
+    const Error err = kv_cache_.reserve(session.sequence, session.pos + 1);
+    if (err == Error::Ok) {
+      ++i;
+      continue;
+    }
+    ET_CHECK_OR_RETURN_ERROR(
+        err == Error::MemoryAllocationFailed,
+        Internal,
+        "Failed to grow session %" PRIu64,
+        session.id);
+    if (running_.size() == 1) {
+      // The session has all the blocks to itself.
+      ET_LOG(
+          Info,
+          "KV cache is full, ending session %" PRIu64 " at %" PRId64
+          " tokens",
+          session.id,
+          session.pos);
+      session.done = true;
+      break;
+    }
+    preempt_last();
+  }
+  sweep();
+  if (running_.empty()) {
+    return Error::Ok;
+  }
+
+  const int32_t batch_size = running_.size();
+  const int32_t max_blocks = kv_cache_.max_blocks_per_sequence();
+  token_data_.resize(batch_size);
+  start_pos_data_.resize(batch_size);
+  block_table_data_.resize(batch_size * max_blocks);
+  for (int32_t b = 0; b < batch_size; ++b) {
+    const Session& session = running_[b];
+    token_data_[b] = session.tokens.back();
+    start_pos_data_[b] = session.pos;
+    kv_cache_.fill_block_table(
+        session.sequence, block_table_data_.data() + b * max_blocks);
+  }
+
+  auto logits_res = forward(batch_size, 1);
+  ET_CHECK_OK_OR_RETURN_ERROR(logits_res.error());
+  for (int32_t b = 0; b < batch_size; ++b) {
+    Session& session = running_[b];
+    session.pos++;
+    ET_CHECK_OK_OR_RETURN_ERROR(emit(session, sample(logits_res.get(), b)));
+  }
+  sweep();
+  return Error::Ok;
+}
+
+void BatchedTextGenerator::preempt_last() {
+  Session session = std::move(running_.back());
+  running_.pop_back();
+  ET_LOG(
+      Info,
+      "KV cache is full, preempting session %" PRIu64 " at %" PRId64 " tokens",
+      session.id,
+      session.pos);
+  kv_cache_.remove_sequence(session.sequence);
+  session.pos = 0;
+  waiting_.push_front(std::move(session));
+}
+
+void BatchedTextGenerator::sweep() {
+  auto done = std::stable_partition(
+      running_.begin(), running_.end(), [](const Session& session) {
+        return !session.done;
+      });
+  for (auto it = done; it != running_.end(); ++it) {
+    kv_cache_.remove_sequence(it->sequence);
+  }
+  running_.erase(done, running_.end());
+}
+
+Error BatchedTextGenerator::emit(Session& session, uint64_t token) {
+  const uint64_t prev_token = session.tokens.back();
+  session.tokens.push_back(token);
+  num_generated_tokens_++;
+
+  // print the token as string, decode it with the Tokenizer object
+  if (session.token_callback) {
+    session.token_callback(ET_UNWRAP(tokenizer_->decode(prev_token, token)));
+  }
+
+  // data-dependent terminating condition: we have n_eos_ number of EOS
+  if (eos_ids_->find(token) != eos_ids_->end() ||
+      session.tokens.size() >= static_cast<size_t>(session.seq_len)) {
+    session.done = true;
+  }
+  return Error::Ok;
+}
+
+int32_t BatchedTextGenerator::sample(
+    const exec_aten::Tensor& logits_tensor,
+    int64_t row) {
+  // If the logits tensor rank is 3, the shape is [batch, seq_length,
+  // vocab_size], sample from the last logits of the row. Else the model
+  // outputs the last logits of each row.
+  const int64_t vocab_size = logits_tensor.size(logits_tensor.dim() - 1);
+  int64_t offset = row * vocab_size;
+  if (logits_tensor.dim() == 3) {
+    const int64_t num_tokens = logits_tensor.size(1);
+    offset = (row * num_tokens + num_tokens - 1) * vocab_size;
+  }
+  int32_t token = 0;
+  stats_->on_sampling_begin();
+  switch (logits_tensor.scalar_type()) {
+    case exec_aten::ScalarType::Float:
+      token = sampler_->sample(logits_tensor.mutable_data_ptr<float>() + offset);
+      break;
+    case exec_aten::ScalarType::Half:
+      token = sampler_->sample(
+          logits_tensor.mutable_data_ptr<exec_aten::Half>() + offset);
+      break;
+    case exec_aten::ScalarType::BFloat16:
+      token = sampler_->sample(
+          logits_tensor.mutable_data_ptr<exec_aten::BFloat16>() + offset);
+      break;
+    default:
+      ET_CHECK_MSG(
+          false,
+          "Unsupported dtype output %hhd",
+          static_cast<int8_t>(logits_tensor.scalar_type()));
+  }
+  stats_->on_sampling_end();
+  return token;
+}
+
+Result<exec_aten::Tensor> BatchedTextGenerator::forward(
+    int32_t batch_size,
+    int32_t seq_len) {
+  auto tokens = from_blob(
+      token_data_.data(), {batch_size, seq_len}, exec_aten::ScalarType::Long);
+  auto start_pos = from_blob(
+      start_pos_data_.data(), {batch_size}, exec_aten::ScalarType::Long);
+  auto block_tables = from_blob(
+      block_table_data_.data(),
+      {batch_size, kv_cache_.max_blocks_per_sequence()},
+      exec_aten::ScalarType::Long);
+  return run_forward(tokens, start_pos, block_tables);
+}
+
+Result<exec_aten::Tensor> BatchedTextGenerator::run_forward(
+    TensorPtr& tokens,
+    TensorPtr& start_pos,
+    TensorPtr& block_tables) {
+  if (!module_->is_method_loaded("forward")) {
+    ET_CHECK_OK_OR_RETURN_ERROR(module_->load_method("forward"));
+  }
+  auto outputs_res = module_->forward({*tokens, *start_pos, *block_tables});
+  ET_CHECK_OK_OR_RETURN_ERROR(outputs_res.error());
+  ET_CHECK_MSG(
+      outputs_res.get().size() == 1,
+      "More then one output returned from executing LLM.");
+  ET_CHECK_MSG(
+      outputs_res.get()[0].isTensor(),
+      "Non Tensor Output returned from executing LLM");
+
+  // Return the logits tensor
+  return outputs_res.get()[0].toTensor();
+}
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Generate tokens for many concurrent sessions, decoding them together on a
+// model with a paged KV cache.
+#pragma once
+
+#include <executorch/extension/llm/runner/paged_kv_cache.h>
+#include <executorch/extension/llm/runner/stats.h>
+#include <executorch/extension/llm/sampler/sampler.h>
+#include <executorch/extension/llm/tokenizer/tokenizer.h>
+#include <executorch/extension/module/module.h>
+#include <executorch/extension/tensor/tensor.h>
+// patternlint-disable-next-line executorch-cpp-nostdinc
+#include <cinttypes>
+// patternlint-disable-next-line executorch-cpp-nostdinc
+#include <deque>
+// patternlint-disable-next-line executorch-cpp-nostdinc
+#include <functional>
+// patternlint-disable-next-line executorch-cpp-nostdinc
+#include <unordered_set>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/**
+ * Interleaves the generation of many sessions on one model.
+ *
+ * The model keeps its KV cache in blocks shared by all the sessions (see
+ * PagedKVCache), and its forward method takes:
+ *   - tokens, [batch size, seq_len]
+ *   - start_pos, [batch size]: the position of the first token of each row
+ *   - block_tables, [batch size, max blocks per sequence]
+ * and returns logits, [batch size, seq_len, vocab size] or
+ * [batch size, vocab size]. All are Long tensors, except the logits. Such a
+ * model is built with llama::sdpa_with_paged_kv_cache as its attention.
+ *
+ * Each step() prefills the sessions that were added since the last step, one
+ * at a time, then decodes one token of every running session in a single
+ * batch. Sessions take KV cache blocks as they grow. When the cache runs out
+ * of blocks, the most recently started sessions are preempted: their blocks
+ * are freed, and they are prefilled again with their prompt and the tokens
+ * generated so far once blocks are available.
+ */
+class BatchedTextGenerator {
+ public:
+  /**
+   * @param module The model.
+   * @param tokenizer The tokenizer.
+   * @param vocab_size The vocabulary size of the model.
+   * @param temperature The sampling temperature.
+   * @param num_kv_blocks The number of blocks in the model's KV cache.
+   * @param kv_block_size The number of tokens in a block.
+   * @param max_seq_len The max sequence length of the model, which sets the
+   * width of the block tables.
+   * @param max_batch_size The max number of sessions decoded together.
+   * @param eos_ids The tokens that end a session.
+   * @param stats Where to record the prompt and generated tokens of all
+   * sessions, and the sampling time.
+   */
+  BatchedTextGenerator(
+      Module* module,
+      Tokenizer* tokenizer,
+      int32_t vocab_size,
+      float temperature,
+      int32_t num_kv_blocks,
+      int32_t kv_block_size,
+      int32_t max_seq_len,
+      int32_t max_batch_size,
+      std::unique_ptr<std::unordered_set<uint64_t>>&& eos_ids,
+      Stats* stats);
+
+  virtual ~BatchedTextGenerator() = default;
+
+  /**
+   * Queue a session. It starts at the next step() with room for it.
+   * @param prompt_tokens The tokens of the prompt.
+   * @param seq_len The total sequence length, including the prompt tokens.
+   * @param token_callback What to do after a token of this session is
+   * generated.
+   * @return The id of the session.
+   */
+  ::executorch::runtime::Result<uint64_t> add_session(
+      std::vector<uint64_t> prompt_tokens,
+      int32_t seq_len,
+      std::function<void(const std::string&)> token_callback);
+
+  /**
+   * Start the queued sessions that fit, then generate one token for every
+   * running session.
+   * @return The number of sessions that are not done yet.
+   */
+  ::executorch::runtime::Result<size_t> step();
+
+  /**
+   * Call step() until all the sessions are done, or stop() is called.
+   * @return The error code.
+   */
+  ::executorch::runtime::Error generate();
+
+  /**
+   * Stop the generation loop.
+   */
+  inline void stop() {
+    should_stop_ = true;
+  }
+
+ protected:
+  /**
+   * Run the forward method of the model, loading it if needed.
+   * @param tokens The tokens, [batch size, seq_len].
+   * @param start_pos The position of the first token of each row,
+   * [batch size].
+   * @param block_tables The block table of each row,
+   * [batch size, max blocks per sequence].
+   * @return The logits.
+   */
+  virtual ::executorch::runtime::Result<exec_aten::Tensor> run_forward(
+      TensorPtr& tokens,
+      TensorPtr& start_pos,
+      TensorPtr& block_tables);
+
+ private:
+  struct Session {
+    uint64_t id;
+    // The prompt, then the generated tokens.
+    std::vector<uint64_t> tokens;
+    int64_t num_prompt_tokens;
+    // The number of tokens in the KV cache.
+    int64_t pos;
+    int32_t seq_len;
+    PagedKVCache::SequenceId sequence;
+    std::function<void(const std::string&)> token_callback;
+    bool done = false;
+  };
+
+  ::executorch::runtime::Error prefill(Session& session);
+  ::executorch::runtime::Error decode();
+  // Moves the most recently started session back to the front of the queue.
+  void preempt_last();
+  // Ends the running sessions that are done.
+  void sweep();
+  ::executorch::runtime::Error emit(Session& session, uint64_t token);
+  int32_t sample(const exec_aten::Tensor& logits, int64_t row);
+  ::executorch::runtime::Result<exec_aten::Tensor> forward(
+      int32_t batch_size,
+      int32_t seq_len);
+
+  Module* module_;
+  Tokenizer* tokenizer_;
+  std::unique_ptr<Sampler> sampler_;
+  PagedKVCache kv_cache_;
+  int32_t max_seq_len_;
+  int32_t max_batch_size_;
+  std::unique_ptr<std::unordered_set<uint64_t>> eos_ids_;
+  Stats* stats_;
+
+  uint64_t next_session_id_ = 0;
+  int64_t num_generated_tokens_ = 0;
+  std::deque<Session> waiting_;
+  // In the order they started.
+  std::vector<Session> running_;
+
+  // Inputs of the model.
+  std::vector<int64_t> token_data_;
+  std::vector<int64_t> start_pos_data_;
+  std::vector<int64_t> block_table_data_;
+
+  // state machine
+  bool should_stop_ = false;
+};
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Block allocator and block tables of a paged KV cache.
+
+#include <executorch/extension/llm/runner/paged_kv_cache.h>
+
+#include <algorithm>
+#include <cinttypes>
+
+#include <executorch/runtime/platform/assert.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+using ::executorch::runtime::Error;
+
+PagedKVCache::PagedKVCache(
+    int32_t num_blocks,
+    int32_t block_size,
+    int32_t max_blocks_per_sequence)
+    : block_size_(block_size),
+      max_blocks_per_sequence_(max_blocks_per_sequence) {
+  ET_CHECK_MSG(
+      num_blocks > 0 && block_size > 0 && max_blocks_per_sequence > 0,
+      "Invalid paged KV cache: %" PRId32 " blocks of %" PRId32
+      " tokens, %" PRId32 " blocks per sequence",
+      num_blocks,
+      block_size,
+      max_blocks_per_sequence);
+  free_blocks_.reserve(num_blocks);
+  // Hand out block 0 first.
+  for (int32_t block = num_blocks - 1; block >= 0; --block) {
+    free_blocks_.push_back(block);
+  }
+}
+
+PagedKVCache::SequenceId PagedKVCache::add_sequence() {
+  SequenceId id;
+  if (!free_sequence_ids_.empty()) {
+    id = free_sequence_ids_.back();
+    free_sequence_ids_.pop_back();
+  } else {
+    id = sequence_blocks_.size();
+    sequence_blocks_.emplace_back();
+    sequence_in_use_.push_back(false);
+  }
+  sequence_blocks_[id].reserve(max_blocks_per_sequence_);
+  sequence_in_use_[id] = true;
+  return id;
+}
+
+Error PagedKVCache::reserve(SequenceId id, int64_t num_tokens) {
+  ET_CHECK_MSG(
+      id < sequence_in_use_.size() && sequence_in_use_[id],
+      "Unknown sequence %zu",
+      id);
+  ET_CHECK_OR_RETURN_ERROR(
+      num_tokens <= static_cast<int64_t>(max_blocks_per_sequence_) * block_size_,
+      InvalidArgument,
+      "%" PRId64 " tokens don't fit in %" PRId32 " blocks of %" PRId32,
+      num_tokens,
+      max_blocks_per_sequence_,
+      block_size_);
+  std::vector<int64_t>& blocks = sequence_blocks_[id];
+  const size_t num_blocks = (num_tokens + block_size_ - 1) / block_size_;
+  if (num_blocks <= blocks.size()) {
+    return Error::Ok;
+  }
+  const size_t num_new_blocks = num_blocks - blocks.size();
+  if (num_new_blocks > free_blocks_.size()) {
+    return Error::MemoryAllocationFailed;
+  }
+  for (size_t i = 0; i < num_new_blocks; ++i) {
+    blocks.push_back(free_blocks_.back());
+    free_blocks_.pop_back();
+  }
+  return Error::Ok;
+}
+
+void PagedKVCache::remove_sequence(SequenceId id) {
+  ET_CHECK_MSG(
+      id < sequence_in_use_.size() && sequence_in_use_[id],
+      "Unknown sequence %zu",
+      id);
+  std::vector<int64_t>& blocks = sequence_blocks_[id];
+  // Push in reverse so the sequence's first block is reused first.
+  free_blocks_.insert(free_blocks_.end(), blocks.rbegin(), blocks.rend());
+  blocks.clear();
+  sequence_in_use_[id] = false;
+  free_sequence_ids_.push_back(id);
+}
+
+void PagedKVCache::fill_block_table(SequenceId id, int64_t* row) const {
+  ET_CHECK_MSG(
+      id < sequence_in_use_.size() && sequence_in_use_[id],
+      "Unknown sequence %zu",
+      id);
+  const std::vector<int64_t>& blocks = sequence_blocks_[id];
+  std::copy(blocks.begin(), blocks.end(), row);
+  std::fill(row + blocks.size(), row + max_blocks_per_sequence_, 0);
+}
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
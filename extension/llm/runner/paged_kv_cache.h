@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Block allocator and block tables of a paged KV cache.
+#pragma once
+
+#include <executorch/runtime/core/error.h>
+// patternlint-disable-next-line executorch-cpp-nostdinc
+#include <vector>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/**
+ * Tracks which blocks of a paged KV cache belong to which sequence.
+ *
+ * The cache itself lives in the model, as one
+ * [num_blocks, block_size, num heads, head dim] pool per layer for keys and
+ * for values (see llama::sdpa_with_paged_kv_cache). Sequences take blocks
+ * from the pool as they grow and give them back when they end, so memory is
+ * only spent on the tokens of the live sequences, rather than on max_seq_len
+ * tokens for each of them.
+ *
+ * The block table of a sequence lists its blocks in order: position p is at
+ * offset p % block_size of the block at index p / block_size.
+ */
+class PagedKVCache {
+ public:
+  using SequenceId = size_t;
+
+  /**
+   * @param num_blocks The number of blocks in the pool.
+   * @param block_size The number of tokens in a block.
+   * @param max_blocks_per_sequence The width of a block table, i.e. the max
+   * sequence length divided by block_size, rounded up.
+   */
+  PagedKVCache(
+      int32_t num_blocks,
+      int32_t block_size,
+      int32_t max_blocks_per_sequence);
+
+  int32_t block_size() const {
+    return block_size_;
+  }
+
+  int32_t max_blocks_per_sequence() const {
+    return max_blocks_per_sequence_;
+  }
+
+  int32_t num_free_blocks() const {
+    return static_cast<int32_t>(free_blocks_.size());
+  }
+
+  /**
+   * Starts a sequence that holds no blocks yet.
+   * @return The id of the sequence.
+   */
+  SequenceId add_sequence();
+
+  /**
+   * Makes sure that a sequence holds blocks for positions [0, num_tokens).
+   * The sequence is left unchanged if that fails.
+   * @param id The sequence.
+   * @param num_tokens The number of positions that the sequence needs.
+   * @retval Error::Ok The sequence holds enough blocks.
+   * @retval Error::InvalidArgument num_tokens doesn't fit in a block table.
+   * @retval Error::MemoryAllocationFailed Not enough free blocks.
+   */
+  ::executorch::runtime::Error reserve(SequenceId id, int64_t num_tokens);
+
+  /**
+   * Ends a sequence and frees its blocks.
+   * @param id The sequence.
+   */
+  void remove_sequence(SequenceId id);
+
+  /**
+   * Writes the block table of a sequence.
+   * @param id The sequence.
+   * @param row Where to write max_blocks_per_sequence() entries. Entries past
+   * the blocks of the sequence are set to 0.
+   */
+  void fill_block_table(SequenceId id, int64_t* row) const;
+
+ private:
+  const int32_t block_size_;
+  const int32_t max_blocks_per_sequence_;
+  // Used as a stack, so recently freed blocks, which are likely to still be
+  // in the CPU caches, are reused first.
+  std::vector<int64_t> free_blocks_;
+  // The blocks of each sequence, indexed by SequenceId.
+  std::vector<std::vector<int64_t>> sequence_blocks_;
+  std::vector<bool> sequence_in_use_;
+  std::vector<SequenceId> free_sequence_ids_;
+};
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
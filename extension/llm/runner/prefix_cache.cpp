@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Snapshots of the KV cache of a LLM after prefilling a prefix, so that prompts
+// that share the prefix don't prefill it again.
+
+#include <executorch/extension/llm/runner/prefix_cache.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+using ::executorch::runtime::Error;
+using ::executorch::runtime::Result;
+using ::executorch::runtime::Span;
+
+PrefixCache::PrefixCache(Module* module, size_t max_bytes)
+    : module_(module), max_bytes_(max_bytes) {}
+
+Result<int64_t> PrefixCache::restore(
+    const std::vector<uint64_t>& tokens,
+    int64_t max_tokens) {
+  const int64_t num_tokens =
+      std::min<int64_t>(max_tokens, static_cast<int64_t>(tokens.size()));
+  Node* node = &root_;
+  Node* deepest = nullptr;
+  int64_t deepest_length = 0;
+  for (int64_t i = 0; i < num_tokens; ++i) {
+    auto it = node->children.find(tokens[i]);
+    if (it == node->children.end()) {
+      break;
+    }
+    node = it->second.get();
+    if (node->has_snapshot) {
+      deepest = node;
+      deepest_length = i + 1;
+    }
+  }
+  if (deepest == nullptr) {
+    return 0;
+  }
+
+  auto buffers = ET_UNWRAP(module_->planned_buffers("forward"));
+  const Snapshot& snapshot = *deepest->snapshot;
+  ET_CHECK_OR_RETURN_ERROR(
+      buffers.size() == snapshot.buffers.size(),
+      InvalidState,
+      "Snapshot has %zu buffers, the model has %zu",
+      snapshot.buffers.size(),
+      buffers.size());
+  for (size_t i = 0; i < buffers.size(); ++i) {
+    ET_CHECK_OR_RETURN_ERROR(
+        buffers[i].size() == snapshot.buffers[i].size(),
+        InvalidState,
+        "Snapshot buffer %zu has %zu bytes, the model's has %zu",
+        i,
+        snapshot.buffers[i].size(),
+        buffers[i].size());
+  }
+  for (size_t i = 0; i < buffers.size(); ++i) {
+    std::memcpy(
+        buffers[i].data(), snapshot.buffers[i].data(), buffers[i].size());
+  }
+  snapshots_.splice(snapshots_.begin(), snapshots_, deepest->snapshot);
+  return deepest_length;
+}
+
+int64_t PrefixCache::shared_prefix_length(
+    const std::vector<uint64_t>& tokens) const {
+  const Node* node = &root_;
+  int64_t length = 0;
+  for (uint64_t token : tokens) {
+    auto it = node->children.find(token);
+    if (it == node->children.end()) {
+      break;
+    }
+    node = it->second.get();
+    length++;
+  }
+  return length;
+}
+
+Error PrefixCache::save(
+    const std::vector<uint64_t>& tokens,
+    int64_t num_tokens) {
+  ET_CHECK_OR_RETURN_ERROR(
+      num_tokens > 0 && num_tokens <= static_cast<int64_t>(tokens.size()),
+      InvalidArgument,
+      "num_tokens %" PRId64 " out of range for %zu tokens",
+      num_tokens,
+      tokens.size());
+  auto buffers = ET_UNWRAP(module_->planned_buffers("forward"));
+  size_t size_bytes = 0;
+  for (const Span<uint8_t>& buffer : buffers) {
+    size_bytes += buffer.size();
+  }
+  if (size_bytes > max_bytes_) {
+    ET_LOG(
+        Info,
+        "Snapshot of %zu bytes exceeds the prefix cache size %zu, not saving",
+        size_bytes,
+        max_bytes_);
+    return Error::Ok;
+  }
+
+  Node* node = find(tokens, num_tokens);
+  if (node != nullptr && node->has_snapshot) {
+    // Replace it with the current state.
+    size_bytes_ -= node->snapshot->size_bytes;
+    snapshots_.erase(node->snapshot);
+    node->has_snapshot = false;
+  }
+  // Evict before copying, so the memory use never exceeds max_bytes_, and
+  // before walking the path of tokens, since pruning the evicted snapshots
+  // may remove its nodes.
+  evict(max_bytes_ - size_bytes);
+
+  node = &root_;
+  for (int64_t i = 0; i < num_tokens; ++i) {
+    std::unique_ptr<Node>& child = node->children[tokens[i]];
+    if (!child) {
+      child = std::make_unique<Node>();
+      child->parent = node;
+      child->token = tokens[i];
+    }
+    node = child.get();
+  }
+
+  Snapshot snapshot;
+  snapshot.node = node;
+  snapshot.size_bytes = size_bytes;
+  snapshot.buffers.reserve(buffers.size());
+  for (const Span<uint8_t>& buffer : buffers) {
+    snapshot.buffers.emplace_back(buffer.begin(), buffer.end());
+  }
+  snapshots_.push_front(std::move(snapshot));
+  node->snapshot = snapshots_.begin();
+  node->has_snapshot = true;
+  size_bytes_ += size_bytes;
+  return Error::Ok;
+}
+
+PrefixCache::Node* PrefixCache::find(
+    const std::vector<uint64_t>& tokens,
+    int64_t num_tokens) {
+  Node* node = &root_;
+  for (int64_t i = 0; i < num_tokens; ++i) {
+    auto it = node->children.find(tokens[i]);
+    if (it == node->children.end()) {
+      return nullptr;
+    }
+    node = it->second.get();
+  }
+  return node;
+}
+
+void PrefixCache::evict(size_t max_bytes) {
+  while (size_bytes_ > max_bytes && !snapshots_.empty()) {
+    Snapshot& snapshot = snapshots_.back();
+    Node* node = snapshot.node;
+    size_bytes_ -= snapshot.size_bytes;
+    node->has_snapshot = false;
+    snapshots_.pop_back();
+    prune(node);
+  }
+}
+
+void PrefixCache::prune(Node* node) {
+  while (node != &root_ && !node->has_snapshot && node->children.empty()) {
+    Node* parent = node->parent;
+    // Destroys node.
+    parent->children.erase(node->token);
+    node = parent;
+  }
+}
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
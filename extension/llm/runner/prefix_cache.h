@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Snapshots of the KV cache of a LLM after prefilling a prefix, so that prompts
+// that share the prefix don't prefill it again.
+#pragma once
+
+#include <executorch/extension/module/module.h>
+// patternlint-disable-next-line executorch-cpp-nostdinc
+#include <list>
+// patternlint-disable-next-line executorch-cpp-nostdinc
+#include <memory>
+// patternlint-disable-next-line executorch-cpp-nostdinc
+#include <unordered_map>
+// patternlint-disable-next-line executorch-cpp-nostdinc
+#include <vector>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/**
+ * Caches the state of a model for the token sequences it prefilled.
+ *
+ * A snapshot is a copy of the planned memory of the model's forward method,
+ * where its KV cache lives between executions (see Module::planned_buffers).
+ * Restoring the snapshot of a prefix of a prompt, then prefilling the rest of
+ * the prompt from the end of the prefix, gives the same KV cache as
+ * prefilling the whole prompt: positions past the prefix are masked until
+ * they are overwritten. This needs a model whose KV cache is memory planned,
+ * which is the default for exported LLMs.
+ *
+ * The sequences are kept in a trie of token ids, and their snapshots are
+ * evicted in least recently used order once their total size exceeds
+ * max_bytes.
+ */
+class PrefixCache {
+ public:
+  /**
+   * @param module The model. Its forward method holds the KV cache.
+   * @param max_bytes The max total size of the snapshots.
+   */
+  PrefixCache(Module* module, size_t max_bytes);
+
+  /**
+   * Restore the snapshot of the longest cached prefix of tokens.
+   * @param tokens The tokens to prefill.
+   * @param max_tokens The length of the longest prefix to restore. Keep at
+   * least one token to prefill, to get the logits that follow the prompt.
+   * @return The length of the restored prefix, i.e. the position to prefill
+   * the rest of tokens from, or 0 if no prefix of tokens is cached.
+   */
+  ::executorch::runtime::Result<int64_t> restore(
+      const std::vector<uint64_t>& tokens,
+      int64_t max_tokens);
+
+  /**
+   * Get the length of the longest prefix that tokens shares with a cached
+   * sequence, whether that prefix has a snapshot or not. Saving a snapshot
+   * there lets later prompts that share the prefix, e.g. a system prompt,
+   * skip its prefill.
+   * @param tokens The tokens to prefill.
+   * @return The length of the shared prefix.
+   */
+  int64_t shared_prefix_length(const std::vector<uint64_t>& tokens) const;
+
+  /**
+   * Save a snapshot of the model, which has prefilled a prefix of tokens.
+   * @param tokens The tokens being prefilled.
+   * @param num_tokens The length of the prefilled prefix of tokens.
+   * @return The error code.
+   */
+  ::executorch::runtime::Error save(
+      const std::vector<uint64_t>& tokens,
+      int64_t num_tokens);
+
+  size_t size_bytes() const {
+    return size_bytes_;
+  }
+
+  size_t num_snapshots() const {
+    return snapshots_.size();
+  }
+
+ private:
+  struct Node;
+
+  struct Snapshot {
+    Node* node;
+    std::vector<std::vector<uint8_t>> buffers;
+    size_t size_bytes;
+  };
+
+  struct Node {
+    Node* parent = nullptr;
+    uint64_t token = 0;
+    std::unordered_map<uint64_t, std::unique_ptr<Node>> children;
+    bool has_snapshot = false;
+    // Valid if has_snapshot.
+    std::list<Snapshot>::iterator snapshot;
+  };
+
+  // Returns the node of the first num_tokens tokens, or nullptr if there is
+  // none.
+  Node* find(const std::vector<uint64_t>& tokens, int64_t num_tokens);
+  void evict(size_t max_bytes);
+  // Removes node and its ancestors while they hold nothing.
+  void prune(Node* node);
+
+  Module* module_;
+  const size_t max_bytes_;
+  Node root_;
+  // Most recently used first.
+  std::list<Snapshot> snapshots_;
+  size_t size_bytes_ = 0;
+};
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
+
+namespace torch {
+namespace executor {
+// TODO(T197294990): Remove these deprecated aliases once all users have moved
+// to the new `::executorch` namespaces.
+using ::executorch::extension::llm::PrefixCache;
+} // namespace executor
+} // namespace torch
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Generate tokens in a loop, using a draft model to propose tokens that the
+// target model verifies in batches.
+
+#include <executorch/extension/llm/runner/speculative_token_generator.h>
+
+#include <algorithm>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+SpeculativeTokenGenerator::SpeculativeTokenGenerator(
+    Tokenizer* tokenizer,
+    TextDecoderRunner* text_decoder_runner,
+    TextDecoderRunner* draft_decoder_runner,
+    int32_t num_draft_tokens,
+    bool use_kv_cache,
+    std::unique_ptr<std::unordered_set<uint64_t>>&& eos_ids,
+    Stats* stats)
+    : tokenizer_(tokenizer),
+      text_decoder_runner_(text_decoder_runner),
+      draft_decoder_runner_(draft_decoder_runner),
+      num_draft_tokens_(num_draft_tokens),
+      eos_ids_(std::move(eos_ids)),
+      use_kv_cache_(use_kv_cache),
+      stats_(stats) {}
+
+::executorch::runtime::Result<int64_t> SpeculativeTokenGenerator::generate(
+    std::vector<uint64_t> tokens,
+    int64_t start_pos,
+    int32_t seq_len,
+    std::function<void(const std::string&)> token_callback) {
+  ET_CHECK_MSG(
+      !tokens.empty(), "Token generation loop shouldn't take empty tokens");
+  ET_CHECK_OR_RETURN_ERROR(
+      use_kv_cache_,
+      NotSupported,
+      "Speculative decoding requires a model with a KV cache");
+  ET_CHECK_OR_RETURN_ERROR(
+      num_draft_tokens_ > 0,
+      InvalidArgument,
+      "num_draft_tokens must be positive, got %" PRId32,
+      num_draft_tokens_);
+
+  int64_t pos = start_pos; // position in the sequence
+  int64_t draft_pos = start_pos; // position in the draft model's sequence
+
+  // Token after prefill
+  uint64_t cur_token = tokens.back();
+  uint64_t prev_token;
+
+  // The input of the target model: the current token and the proposals.
+  std::vector<uint64_t> verify_data(num_draft_tokens_ + 1);
+  uint64_t draft_token = cur_token;
+  std::vector<uint64_t> proposals(num_draft_tokens_);
+
+  // initialize tensor wrappers
+  auto verify_tokens = from_blob(
+      verify_data.data(),
+      {1, num_draft_tokens_ + 1},
+      exec_aten::ScalarType::Long,
+      exec_aten::TensorShapeDynamism::DYNAMIC_BOUND);
+  auto start_pos_managed = from_blob(&pos, {1}, exec_aten::ScalarType::Long);
+  auto draft_tokens =
+      from_blob(&draft_token, {1, 1}, exec_aten::ScalarType::Long);
+  auto draft_start_pos =
+      from_blob(&draft_pos, {1}, exec_aten::ScalarType::Long);
+
+  int64_t num_proposed = 0;
+  int64_t num_accepted = 0;
+  bool done = false;
+
+  while (!done && pos < seq_len - 1) {
+    // Leave room for the token that the target model adds after the
+    // proposals.
+    const int32_t num_proposals = static_cast<int32_t>(
+        std::min<int64_t>(num_draft_tokens_, seq_len - 2 - pos));
+
+    // Let the draft model propose tokens, after catching up on the last
+    // proposal of the previous round if needed.
+    if (num_proposals > 0 && draft_pos < pos) {
+      ET_CHECK_OK_OR_RETURN_ERROR(
+          draft_decoder_runner_->step(draft_tokens, draft_start_pos).error());
+      draft_pos++;
+    }
+    draft_token = cur_token;
+    for (int32_t i = 0; i < num_proposals; ++i) {
+      auto logits_res =
+          draft_decoder_runner_->step(draft_tokens, draft_start_pos);
+      ET_CHECK_OK_OR_RETURN_ERROR(logits_res.error());
+
+      stats_->on_sampling_begin();
+      proposals[i] = draft_decoder_runner_->logits_to_token(logits_res.get());
+      stats_->on_sampling_end();
+
+      draft_token = proposals[i];
+      draft_pos++;
+    }
+    num_proposed += num_proposals;
+
+    // Run the target model over the current token and all the proposals at
+    // once.
+    verify_data[0] = cur_token;
+    std::copy(
+        proposals.begin(),
+        proposals.begin() + num_proposals,
+        verify_data.begin() + 1);
+    ET_CHECK_OK_OR_RETURN_ERROR(
+        resize_tensor_ptr(verify_tokens, {1, num_proposals + 1}));
+    auto logits_res =
+        text_decoder_runner_->step(verify_tokens, start_pos_managed);
+    ET_CHECK_OK_OR_RETURN_ERROR(logits_res.error());
+    exec_aten::Tensor& logits_tensor = logits_res.get();
+    ET_CHECK_OR_RETURN_ERROR(
+        num_proposals == 0 ||
+            (logits_tensor.dim() == 3 &&
+             logits_tensor.size(1) == num_proposals + 1),
+        InvalidArgument,
+        "Speculative decoding requires the logits of every input position");
+
+    // Emit the target model's tokens for as long as they match the proposals.
+    for (int32_t i = 0; i <= num_proposals; ++i) {
+      prev_token = cur_token;
+
+      stats_->on_sampling_begin();
+      cur_token = num_proposals == 0
+          ? text_decoder_runner_->logits_to_token(logits_tensor)
+          : text_decoder_runner_->logits_to_token(logits_tensor, i);
+      stats_->on_sampling_end();
+
+      pos++;
+
+      // print the token as string, decode it with the Tokenizer object
+      token_callback(ET_UNWRAP(tokenizer_->decode(prev_token, cur_token)));
+
+      if (should_stop_) {
+        done = true;
+        break;
+      }
+
+      // data-dependent terminating condition: we have n_eos_ number of EOS
+      if (eos_ids_->find(cur_token) != eos_ids_->end()) {
+        printf("\n");
+        ET_LOG(Info, "\nReached to the end of generation");
+        done = true;
+        break;
+      }
+
+      if (i == num_proposals || cur_token != proposals[i]) {
+        break;
+      }
+      num_accepted++;
+    }
+    // The KV cache entries from `pos` on hold rejected proposals, which the
+    // next steps mask out and overwrite. Roll the draft model back the same
+    // way. If all the proposals were accepted instead, the draft model is one
+    // token behind.
+    if (draft_pos > pos) {
+      draft_pos = pos;
+    } else if (draft_pos < pos && num_proposals > 0) {
+      draft_token = proposals[num_proposals - 1];
+    }
+  }
+
+  stats_->num_draft_tokens = num_proposed;
+  stats_->num_accepted_draft_tokens = num_accepted;
+  return pos - start_pos;
+}
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Generate tokens in a loop, using a draft model to propose tokens that the
+// target model verifies in batches.
+#pragma once
+
+#include <executorch/extension/llm/runner/stats.h>
+#include <executorch/extension/llm/runner/text_decoder_runner.h>
+#include <executorch/extension/llm/tokenizer/tokenizer.h>
+#include <executorch/extension/tensor/tensor.h>
+// patternlint-disable-next-line executorch-cpp-nostdinc
+#include <functional>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/**
+ * A drop-in replacement for TextTokenGenerator that does speculative decoding.
+ *
+ * Each round, the draft model proposes up to `num_draft_tokens` tokens one at
+ * a time. The target model then runs once over the current token and all the
+ * proposals, like parallel prefill does, and samples a token from the logits
+ * of every position. Proposals are accepted for as long as they match the
+ * tokens sampled by the target model; the target's token at the first
+ * mismatch (or after the last proposal, if all match) is emitted as well. The
+ * emitted tokens are therefore always samples of the target model, so the
+ * output follows the target's distribution whatever the draft proposes; a
+ * better draft only emits more tokens per target step.
+ *
+ * Both models must use a KV cache, and the target model must accept a
+ * [1, num_draft_tokens + 1] token input and output the logits of every
+ * position, i.e. [1, seq_length, vocab_size]. Rejected proposals are rolled
+ * back by moving the KV cache position back: the stale cache entries beyond
+ * it are masked out by the position of the next step and overwritten by it.
+ *
+ * Before generate() is called, the draft model must hold the prompt in its KV
+ * cache at the same positions as the target model, e.g. by prefilling it with
+ * a TextPrefiller of its own.
+ */
+class SpeculativeTokenGenerator {
+ public:
+  SpeculativeTokenGenerator(
+      Tokenizer* tokenizer,
+      TextDecoderRunner* text_decoder_runner,
+      TextDecoderRunner* draft_decoder_runner,
+      int32_t num_draft_tokens,
+      bool use_kv_cache,
+      std::unique_ptr<std::unordered_set<uint64_t>>&& eos_ids,
+      Stats* stats);
+
+  /**
+   * Token generation loop.
+   * @param tokens prompt tokens as well as the first token generated by
+   * prefill.
+   * @param start_pos the start position of the new tokens, based on how many
+   * prompt tokens is prefilled.
+   * @param seq_len the total sequence length, including the prompt tokens, next
+   * token from prefill and new tokens.
+   * @param token_callback what to do after a token is generated.
+   * @return how many tokens are generated.
+   */
+  ::executorch::runtime::Result<int64_t> generate(
+      std::vector<uint64_t> tokens,
+      int64_t start_pos,
+      int32_t seq_len,
+      std::function<void(const std::string&)> token_callback);
+
+  /**
+   * Stop the generation loop.
+   */
+  inline void stop() {
+    should_stop_ = true;
+  }
+
+ private:
+  Tokenizer* tokenizer_;
+  TextDecoderRunner* text_decoder_runner_;
+  TextDecoderRunner* draft_decoder_runner_;
+  int32_t num_draft_tokens_;
+  std::unique_ptr<std::unordered_set<uint64_t>> eos_ids_;
+  bool use_kv_cache_;
+
+  // state machine
+  bool should_stop_ = false;
+
+  // stats
+  Stats* stats_;
+};
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
+
+namespace torch {
+namespace executor {
+// TODO(T197294990): Remove these deprecated aliases once all users have moved
+// to the new `::executorch` namespaces.
+using ::executorch::extension::llm::SpeculativeTokenGenerator;
+} // namespace executor
+} // namespace torch
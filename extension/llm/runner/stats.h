@@ -43,6 +43,12 @@ struct Stats {
   int64_t num_prompt_tokens;
   // Token count from generated (total - prompt)
   int64_t num_generated_tokens;
+  // Tokens proposed by the draft model, when decoding speculatively.
+  int64_t num_draft_tokens = 0;
+  // Draft tokens accepted by the target model.
+  int64_t num_accepted_draft_tokens = 0;
+  // Prompt tokens restored from a prefix cache instead of prefilled.
+  int64_t num_cached_prompt_tokens = 0;
   inline void on_sampling_begin() {
     aggregate_sampling_timer_start_timestamp = time_in_ms();
   }
@@ -62,6 +68,9 @@ inline std::string stats_to_json_string(const Stats& stats) {
   std::stringstream ss;
   ss << "{\"prompt_tokens\":" << stats.num_prompt_tokens << ","
      << "\"generated_tokens\":" << stats.num_generated_tokens << ","
+     << "\"draft_tokens\":" << stats.num_draft_tokens << ","
+     << "\"accepted_draft_tokens\":" << stats.num_accepted_draft_tokens << ","
+     << "\"cached_prompt_tokens\":" << stats.num_cached_prompt_tokens << ","
      << "\"model_load_start_ms\":" << stats.model_load_start_ms << ","
      << "\"model_load_end_ms\":" << stats.model_load_end_ms << ","
      << "\"inference_start_ms\":" << stats.inference_start_ms << ","
@@ -82,6 +91,12 @@ inline void print_report(const Stats& stats) {
       "\tPrompt Tokens: %" PRIu64 "    Generated Tokens: %" PRIu64,
       stats.num_prompt_tokens,
       stats.num_generated_tokens);
+  if (stats.num_cached_prompt_tokens > 0) {
+    ET_LOG(
+        Info,
+        "\tPrompt Tokens restored from the prefix cache: %" PRIu64,
+        stats.num_cached_prompt_tokens);
+  }
 
   ET_LOG(
       Info,
@@ -118,6 +133,18 @@ inline void print_report(const Stats& stats) {
       stats.num_generated_tokens / eval_time *
           stats.SCALING_FACTOR_UNITS_PER_SECOND);
 
+  if (stats.num_draft_tokens > 0) {
+    ET_LOG(
+        Info,
+        "\tSpeculative decoding: accepted %" PRIu64 " of %" PRIu64
+        " draft tokens (%f%%)\t\t Effective rate: \t%f (tokens/second)",
+        stats.num_accepted_draft_tokens,
+        stats.num_draft_tokens,
+        100.0 * stats.num_accepted_draft_tokens / stats.num_draft_tokens,
+        stats.num_generated_tokens / eval_time *
+            stats.SCALING_FACTOR_UNITS_PER_SECOND);
+  }
+
   // Time to first token is measured from the start of inference, excluding
   // model load time.
   ET_LOG(
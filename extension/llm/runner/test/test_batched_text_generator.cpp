@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/runner/batched_text_generator.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace ::testing;
+using ::executorch::extension::from_blob;
+using ::executorch::extension::TensorPtr;
+using ::executorch::extension::llm::BatchedTextGenerator;
+using ::executorch::extension::llm::Stats;
+using ::executorch::extension::llm::Tokenizer;
+using ::executorch::runtime::Error;
+using ::executorch::runtime::Result;
+
+namespace {
+
+constexpr int32_t kVocabSize = 32;
+constexpr int32_t kBlockSize = 2;
+constexpr int32_t kMaxSeqLen = 16;
+
+class FakeTokenizer : public Tokenizer {
+ public:
+  Error load(const std::string&) override {
+    return Error::Ok;
+  }
+
+  Result<std::vector<uint64_t>> encode(const std::string&, int8_t, int8_t)
+      const override {
+    return Error::NotSupported;
+  }
+
+  Result<std::string> decode(uint64_t, uint64_t token) const override {
+    return std::to_string(token);
+  }
+};
+
+// Stands in for a model with a paged KV cache. It writes the tokens to the
+// blocks in their block table, and the next token of a sequence is a hash of
+// all the tokens it reads back from its blocks, so the generated tokens only
+// match those of an unconstrained run if every session's cache is intact.
+class FakePagedGenerator : public BatchedTextGenerator {
+ public:
+  FakePagedGenerator(int32_t num_kv_blocks, Tokenizer* tokenizer, Stats* stats)
+      : BatchedTextGenerator(
+            /*module=*/nullptr,
+            tokenizer,
+            kVocabSize,
+            /*temperature=*/0.0f,
+            num_kv_blocks,
+            kBlockSize,
+            kMaxSeqLen,
+            /*max_batch_size=*/4,
+            std::make_unique<std::unordered_set<uint64_t>>(),
+            stats),
+        cache_(num_kv_blocks * kBlockSize, -1) {}
+
+  int num_prefills() const {
+    return num_prefills_;
+  }
+
+ protected:
+  Result<exec_aten::Tensor> run_forward(
+      TensorPtr& tokens,
+      TensorPtr& start_pos,
+      TensorPtr& block_tables) override {
+    const int64_t batch_size = tokens->size(0);
+    const int64_t seq_len = tokens->size(1);
+    const int64_t max_blocks = block_tables->size(1);
+    const int64_t* token_data = tokens->const_data_ptr<int64_t>();
+    const int64_t* start_pos_data = start_pos->const_data_ptr<int64_t>();
+    const int64_t* block_table_data = block_tables->const_data_ptr<int64_t>();
+
+    logits_.assign(batch_size * seq_len * kVocabSize, 0.0f);
+    for (int64_t b = 0; b < batch_size; ++b) {
+      if (start_pos_data[b] == 0) {
+        num_prefills_++;
+      }
+      const int64_t* block_table = block_table_data + b * max_blocks;
+      auto slot = [&](int64_t pos) {
+        return block_table[pos / kBlockSize] * kBlockSize + pos % kBlockSize;
+      };
+      for (int64_t i = 0; i < seq_len; ++i) {
+        cache_[slot(start_pos_data[b] + i)] = token_data[b * seq_len + i];
+      }
+      for (int64_t i = 0; i < seq_len; ++i) {
+        uint64_t hash = 0;
+        for (int64_t pos = 0; pos <= start_pos_data[b] + i; ++pos) {
+          hash = (hash ^ static_cast<uint64_t>(cache_[slot(pos)] + 1)) *
+              0x9e3779b97f4a7c15;
+        }
+        const uint64_t token = (hash >> 32) % kVocabSize;
+        logits_[(b * seq_len + i) * kVocabSize + token] = 1.0f;
+      }
+    }
+    logits_tensor_ = from_blob(
+        logits_.data(),
+        {static_cast<int32_t>(batch_size),
+         static_cast<int32_t>(seq_len),
+         kVocabSize});
+    return *logits_tensor_;
+  }
+
+ private:
+  std::vector<int64_t> cache_;
+  std::vector<float> logits_;
+  TensorPtr logits_tensor_;
+  int num_prefills_ = 0;
+};
+
+// Runs sessions with 3 token prompts to 12 tokens, and returns the tokens
+// each one generated.
+std::map<uint64_t, std::vector<std::string>> generate(
+    FakePagedGenerator& generator,
+    int num_sessions) {
+  std::map<uint64_t, std::vector<std::string>> outputs;
+  for (int s = 0; s < num_sessions; ++s) {
+    std::vector<uint64_t> prompt = {
+        static_cast<uint64_t>(s + 1), 7, static_cast<uint64_t>(3 * s)};
+    auto id_res = generator.add_session(
+        prompt, /*seq_len=*/12, [&outputs, s](const std::string& piece) {
+          outputs[s].push_back(piece);
+        });
+    EXPECT_EQ(id_res.error(), Error::Ok);
+  }
+  EXPECT_EQ(generator.generate(), Error::Ok);
+  return outputs;
+}
+
+} // namespace
+
+class BatchedTextGeneratorTest : public Test {
+ protected:
+  static void SetUpTestSuite() {
+    ::executorch::runtime::runtime_init();
+  }
+
+  FakeTokenizer tokenizer_;
+  Stats stats_;
+};
+
+TEST_F(BatchedTextGeneratorTest, GeneratesAllSessions) {
+  FakePagedGenerator generator(/*num_kv_blocks=*/64, &tokenizer_, &stats_);
+  auto outputs = generate(generator, 3);
+
+  ASSERT_EQ(outputs.size(), 3);
+  for (const auto& output : outputs) {
+    EXPECT_EQ(output.second.size(), 9);
+  }
+  // The cache holds all the sessions: each is prefilled once.
+  EXPECT_EQ(generator.num_prefills(), 3);
+  EXPECT_EQ(stats_.num_prompt_tokens, 9);
+  EXPECT_EQ(stats_.num_generated_tokens, 27);
+}
+
+TEST_F(BatchedTextGeneratorTest, PreemptedSessionsMatchUnconstrainedRun) {
+  FakePagedGenerator reference(/*num_kv_blocks=*/64, &tokenizer_, &stats_);
+  auto expected = generate(reference, 3);
+
+  // Each session needs 6 blocks, and only 8 are shared by all of them.
+  Stats stats;
+  FakePagedGenerator generator(/*num_kv_blocks=*/8, &tokenizer_, &stats);
+  auto outputs = generate(generator, 3);
+
+  // Sessions were preempted and prefilled again with the tokens they had
+  // generated, without changing what they generate.
+  EXPECT_GT(generator.num_prefills(), 3);
+  EXPECT_EQ(outputs, expected);
+  EXPECT_EQ(stats.num_generated_tokens, 27);
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/runner/paged_kv_cache.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+using namespace ::testing;
+using ::executorch::extension::llm::PagedKVCache;
+using ::executorch::runtime::Error;
+
+namespace {
+
+std::vector<int64_t> block_table(
+    const PagedKVCache& cache,
+    PagedKVCache::SequenceId id) {
+  std::vector<int64_t> row(cache.max_blocks_per_sequence(), -1);
+  cache.fill_block_table(id, row.data());
+  return row;
+}
+
+} // namespace
+
+class PagedKVCacheTest : public Test {
+ protected:
+  static void SetUpTestSuite() {
+    ::executorch::runtime::runtime_init();
+  }
+};
+
+TEST_F(PagedKVCacheTest, AllocatesBlocksAsSequencesGrow) {
+  PagedKVCache cache(
+      /*num_blocks=*/8, /*block_size=*/4, /*max_blocks_per_sequence=*/4);
+  EXPECT_EQ(cache.num_free_blocks(), 8);
+
+  const auto a = cache.add_sequence();
+  const auto b = cache.add_sequence();
+  EXPECT_NE(a, b);
+  // A new sequence holds no blocks: its table is all zeros.
+  EXPECT_EQ(block_table(cache, a), std::vector<int64_t>({0, 0, 0, 0}));
+
+  // 5 tokens take 2 blocks of 4.
+  EXPECT_EQ(cache.reserve(a, 5), Error::Ok);
+  EXPECT_EQ(cache.num_free_blocks(), 6);
+  EXPECT_EQ(block_table(cache, a), std::vector<int64_t>({0, 1, 0, 0}));
+
+  EXPECT_EQ(cache.reserve(b, 1), Error::Ok);
+  EXPECT_EQ(block_table(cache, b), std::vector<int64_t>({2, 0, 0, 0}));
+
+  // Positions that already have a block take no new one.
+  EXPECT_EQ(cache.reserve(a, 8), Error::Ok);
+  EXPECT_EQ(cache.num_free_blocks(), 5);
+  EXPECT_EQ(cache.reserve(a, 9), Error::Ok);
+  EXPECT_EQ(block_table(cache, a), std::vector<int64_t>({0, 1, 3, 0}));
+  EXPECT_EQ(cache.num_free_blocks(), 4);
+}
+
+TEST_F(PagedKVCacheTest, ReusesBlocksOfRemovedSequences) {
+  PagedKVCache cache(
+      /*num_blocks=*/4, /*block_size=*/2, /*max_blocks_per_sequence=*/4);
+  const auto a = cache.add_sequence();
+  const auto b = cache.add_sequence();
+  EXPECT_EQ(cache.reserve(a, 4), Error::Ok);
+  EXPECT_EQ(cache.reserve(b, 4), Error::Ok);
+  EXPECT_EQ(block_table(cache, a), std::vector<int64_t>({0, 1, 0, 0}));
+  EXPECT_EQ(block_table(cache, b), std::vector<int64_t>({2, 3, 0, 0}));
+  EXPECT_EQ(cache.num_free_blocks(), 0);
+
+  cache.remove_sequence(a);
+  EXPECT_EQ(cache.num_free_blocks(), 2);
+
+  // The id and the blocks of the removed sequence are reused, first block
+  // first.
+  const auto c = cache.add_sequence();
+  EXPECT_EQ(c, a);
+  EXPECT_EQ(block_table(cache, c), std::vector<int64_t>({0, 0, 0, 0}));
+  EXPECT_EQ(cache.reserve(c, 3), Error::Ok);
+  EXPECT_EQ(block_table(cache, c), std::vector<int64_t>({0, 1, 0, 0}));
+  EXPECT_EQ(cache.num_free_blocks(), 0);
+}
+
+TEST_F(PagedKVCacheTest, ReserveFailsWithoutEnoughFreeBlocks) {
+  PagedKVCache cache(
+      /*num_blocks=*/3, /*block_size=*/2, /*max_blocks_per_sequence=*/4);
+  const auto a = cache.add_sequence();
+  const auto b = cache.add_sequence();
+  EXPECT_EQ(cache.reserve(a, 4), Error::Ok);
+  EXPECT_EQ(cache.reserve(b, 2), Error::Ok);
+
+  // b needs 2 more blocks, and none are free.
+  EXPECT_EQ(cache.reserve(b, 6), Error::MemoryAllocationFailed);
+  // The sequence is left unchanged.
+  EXPECT_EQ(block_table(cache, b), std::vector<int64_t>({2, 0, 0, 0}));
+  EXPECT_EQ(cache.num_free_blocks(), 0);
+
+  // Once a's blocks are freed, b can grow.
+  cache.remove_sequence(a);
+  EXPECT_EQ(cache.reserve(b, 6), Error::Ok);
+  EXPECT_EQ(block_table(cache, b), std::vector<int64_t>({2, 0, 1, 0}));
+  EXPECT_EQ(cache.num_free_blocks(), 0);
+}
+
+TEST_F(PagedKVCacheTest, ReserveFailsPastTheBlockTable) {
+  PagedKVCache cache(
+      /*num_blocks=*/16, /*block_size=*/2, /*max_blocks_per_sequence=*/3);
+  const auto a = cache.add_sequence();
+  EXPECT_EQ(cache.reserve(a, 6), Error::Ok);
+  EXPECT_EQ(cache.reserve(a, 7), Error::InvalidArgument);
+  EXPECT_EQ(cache.num_free_blocks(), 13);
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/runner/prefix_cache.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace ::testing;
+using ::executorch::extension::Module;
+using ::executorch::extension::llm::PrefixCache;
+using ::executorch::runtime::Error;
+using ::executorch::runtime::Span;
+
+class PrefixCacheTest : public Test {
+ protected:
+  void SetUp() override {
+    // Any model with planned memory will do: the cache only copies it.
+    module_ = std::make_unique<Module>(
+        std::getenv("RESOURCES_PATH") + std::string("/add.pte"));
+    auto buffers = module_->planned_buffers("forward");
+    ASSERT_EQ(buffers.error(), Error::Ok);
+    buffers_ = *buffers;
+    snapshot_size_ = 0;
+    for (const Span<uint8_t>& buffer : buffers_) {
+      snapshot_size_ += buffer.size();
+    }
+    ASSERT_GT(snapshot_size_, 0);
+  }
+
+  // Sets the state of the model, as if it had prefilled some tokens.
+  void set_state(uint8_t value) {
+    for (Span<uint8_t>& buffer : buffers_) {
+      std::fill(buffer.begin(), buffer.end(), value);
+    }
+  }
+
+  void expect_state(uint8_t value) {
+    for (const Span<uint8_t>& buffer : buffers_) {
+      for (uint8_t byte : buffer) {
+        ASSERT_EQ(byte, value);
+      }
+    }
+  }
+
+  std::unique_ptr<Module> module_;
+  std::vector<Span<uint8_t>> buffers_;
+  size_t snapshot_size_;
+};
+
+TEST_F(PrefixCacheTest, RestoresLongestCachedPrefix) {
+  PrefixCache cache(module_.get(), 4 * snapshot_size_);
+  const std::vector<uint64_t> prompt{1, 2, 3, 4, 5, 6};
+
+  EXPECT_EQ(cache.restore(prompt, prompt.size()).get(), 0);
+  set_state(1);
+  EXPECT_EQ(cache.save(prompt, 2), Error::Ok);
+  set_state(2);
+  EXPECT_EQ(cache.save(prompt, 4), Error::Ok);
+  EXPECT_EQ(cache.num_snapshots(), 2);
+  EXPECT_EQ(cache.size_bytes(), 2 * snapshot_size_);
+
+  set_state(0);
+  EXPECT_EQ(cache.restore(prompt, prompt.size()).get(), 4);
+  expect_state(2);
+
+  // The longest prefix is bounded by max_tokens.
+  set_state(0);
+  EXPECT_EQ(cache.restore(prompt, 3).get(), 2);
+  expect_state(1);
+
+  // A prompt that branches off between the two snapshots gets the shorter.
+  const std::vector<uint64_t> branch{1, 2, 3, 9};
+  set_state(0);
+  EXPECT_EQ(cache.restore(branch, branch.size()).get(), 2);
+  expect_state(1);
+  EXPECT_EQ(cache.shared_prefix_length(branch), 3);
+
+  // Nothing is restored for an unrelated prompt.
+  set_state(0);
+  EXPECT_EQ(cache.restore({7, 8}, 2).get(), 0);
+  expect_state(0);
+  EXPECT_EQ(cache.shared_prefix_length({7, 8}), 0);
+}
+
+TEST_F(PrefixCacheTest, ReplacesSnapshotOfSamePrefix) {
+  PrefixCache cache(module_.get(), 4 * snapshot_size_);
+  const std::vector<uint64_t> prompt{1, 2, 3};
+
+  set_state(1);
+  EXPECT_EQ(cache.save(prompt, 3), Error::Ok);
+  set_state(2);
+  EXPECT_EQ(cache.save(prompt, 3), Error::Ok);
+  EXPECT_EQ(cache.num_snapshots(), 1);
+  EXPECT_EQ(cache.size_bytes(), snapshot_size_);
+
+  set_state(0);
+  EXPECT_EQ(cache.restore(prompt, 3).get(), 3);
+  expect_state(2);
+}
+
+TEST_F(PrefixCacheTest, EvictsLeastRecentlyUsed) {
+  PrefixCache cache(module_.get(), 2 * snapshot_size_);
+  const std::vector<uint64_t> a{1, 2};
+  const std::vector<uint64_t> b{3, 4};
+  const std::vector<uint64_t> c{5, 6};
+
+  set_state(1);
+  EXPECT_EQ(cache.save(a, 2), Error::Ok);
+  set_state(2);
+  EXPECT_EQ(cache.save(b, 2), Error::Ok);
+  // Restoring a makes b the least recently used.
+  EXPECT_EQ(cache.restore(a, 2).get(), 2);
+  set_state(3);
+  EXPECT_EQ(cache.save(c, 2), Error::Ok);
+  EXPECT_EQ(cache.num_snapshots(), 2);
+  EXPECT_EQ(cache.size_bytes(), 2 * snapshot_size_);
+
+  set_state(0);
+  EXPECT_EQ(cache.restore(b, 2).get(), 0);
+  // The evicted sequence is removed from the trie too.
+  EXPECT_EQ(cache.shared_prefix_length(b), 0);
+  EXPECT_EQ(cache.restore(a, 2).get(), 2);
+  expect_state(1);
+  EXPECT_EQ(cache.restore(c, 2).get(), 2);
+  expect_state(3);
+}
+
+TEST_F(PrefixCacheTest, SavesPrefixOfEvictedSnapshot) {
+  // Room for a single snapshot, so saving a prefix of the cached sequence
+  // evicts the sequence, whose nodes include the ones of the prefix.
+  PrefixCache cache(module_.get(), snapshot_size_);
+  const std::vector<uint64_t> prompt{1, 2, 3, 4, 5};
+
+  set_state(1);
+  EXPECT_EQ(cache.save(prompt, 5), Error::Ok);
+  set_state(2);
+  EXPECT_EQ(cache.save(prompt, 3), Error::Ok);
+  EXPECT_EQ(cache.num_snapshots(), 1);
+  EXPECT_EQ(cache.size_bytes(), snapshot_size_);
+  EXPECT_EQ(cache.shared_prefix_length(prompt), 3);
+
+  set_state(0);
+  EXPECT_EQ(cache.restore(prompt, prompt.size()).get(), 3);
+  expect_state(2);
+}
+
+TEST_F(PrefixCacheTest, SkipsSnapshotsLargerThanCache) {
+  PrefixCache cache(module_.get(), snapshot_size_ - 1);
+  const std::vector<uint64_t> prompt{1, 2, 3};
+
+  EXPECT_EQ(cache.save(prompt, 3), Error::Ok);
+  EXPECT_EQ(cache.num_snapshots(), 0);
+  EXPECT_EQ(cache.size_bytes(), 0);
+  EXPECT_NE(cache.save(prompt, 4), Error::Ok);
+}
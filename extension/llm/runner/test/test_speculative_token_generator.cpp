@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/runner/speculative_token_generator.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace ::testing;
+using ::executorch::extension::from_blob;
+using ::executorch::extension::TensorPtr;
+using ::executorch::extension::llm::SpeculativeTokenGenerator;
+using ::executorch::extension::llm::Stats;
+using ::executorch::extension::llm::TextDecoderRunner;
+using ::executorch::extension::llm::Tokenizer;
+using ::executorch::runtime::Error;
+using ::executorch::runtime::Result;
+
+namespace {
+
+constexpr int32_t kVocabSize = 32;
+constexpr int32_t kMaxSeqLen = 64;
+
+// The token that the target model generates after `tokens`.
+uint64_t next_token(const int64_t* tokens, int64_t num_tokens) {
+  uint64_t hash = 0;
+  for (int64_t i = 0; i < num_tokens; ++i) {
+    hash = (hash ^ static_cast<uint64_t>(tokens[i] + 1)) * 0x9e3779b97f4a7c15;
+  }
+  return (hash >> 32) % kVocabSize;
+}
+
+class FakeTokenizer : public Tokenizer {
+ public:
+  Error load(const std::string&) override {
+    return Error::Ok;
+  }
+
+  Result<std::vector<uint64_t>> encode(const std::string&, int8_t, int8_t)
+      const override {
+    return Error::NotSupported;
+  }
+
+  Result<std::string> decode(uint64_t, uint64_t token) const override {
+    return std::to_string(token);
+  }
+};
+
+// Stands in for a model with a KV cache. It writes its input tokens to the
+// cache at their positions, and the logits of each position pick the token
+// that next_token() gives for the cache up to that position, so the tokens
+// only match a sequential run if the positions are rolled back correctly.
+// At the positions in `wrong_positions`, it picks another token instead.
+class FakeTextDecoderRunner : public TextDecoderRunner {
+ public:
+  struct Step {
+    int64_t start_pos;
+    int64_t num_tokens;
+  };
+
+  FakeTextDecoderRunner(
+      const std::vector<uint64_t>& prompt,
+      std::set<int64_t> wrong_positions = {})
+      : TextDecoderRunner(
+            /*module=*/nullptr,
+            /*use_kv_cache=*/true,
+            kVocabSize,
+            /*temperature=*/0.0f),
+        cache_(kMaxSeqLen, -1),
+        wrong_positions_(std::move(wrong_positions)) {
+    std::copy(prompt.begin(), prompt.end(), cache_.begin());
+  }
+
+  Result<exec_aten::Tensor> step(TensorPtr& input, TensorPtr& start_pos)
+      override {
+    const int64_t num_tokens = input->size(1);
+    const int64_t pos = *start_pos->const_data_ptr<int64_t>();
+    steps.push_back({pos, num_tokens});
+
+    const int64_t* tokens = input->const_data_ptr<int64_t>();
+    std::copy(tokens, tokens + num_tokens, cache_.begin() + pos);
+    logits_.assign(num_tokens * kVocabSize, 0.0f);
+    for (int64_t i = 0; i < num_tokens; ++i) {
+      uint64_t token = next_token(cache_.data(), pos + i + 1);
+      if (wrong_positions_.count(pos + i) > 0) {
+        token = (token + 1) % kVocabSize;
+      }
+      logits_[i * kVocabSize + token] = 1.0f;
+    }
+    logits_tensor_ = from_blob(
+        logits_.data(), {1, static_cast<int32_t>(num_tokens), kVocabSize});
+    return *logits_tensor_;
+  }
+
+  Error load() override {
+    return Error::Ok;
+  }
+
+  bool is_method_loaded() override {
+    return true;
+  }
+
+  std::vector<Step> steps;
+
+ private:
+  std::vector<int64_t> cache_;
+  std::set<int64_t> wrong_positions_;
+  std::vector<float> logits_;
+  TensorPtr logits_tensor_;
+};
+
+} // namespace
+
+class SpeculativeTokenGeneratorTest : public Test {
+ protected:
+  static void SetUpTestSuite() {
+    ::executorch::runtime::runtime_init();
+  }
+
+  void SetUp() override {
+    prompt_ = {1, 2, 3};
+    // The tokens of a sequential run: the prompt, then the tokens the target
+    // model generates one at a time.
+    expected_.assign(prompt_.begin(), prompt_.end());
+    while (expected_.size() < kMaxSeqLen) {
+      expected_.push_back(next_token(expected_.data(), expected_.size()));
+    }
+  }
+
+  // Generates from the prompt and the token that prefill sampled, and
+  // returns the generated tokens.
+  std::vector<int64_t> generate(
+      FakeTextDecoderRunner& target,
+      FakeTextDecoderRunner& draft,
+      int32_t num_draft_tokens,
+      int32_t seq_len,
+      std::unordered_set<uint64_t> eos_ids = {}) {
+    SpeculativeTokenGenerator generator(
+        &tokenizer_,
+        &target,
+        &draft,
+        num_draft_tokens,
+        /*use_kv_cache=*/true,
+        std::make_unique<std::unordered_set<uint64_t>>(std::move(eos_ids)),
+        &stats_);
+    std::vector<uint64_t> tokens(prompt_.begin(), prompt_.end());
+    tokens.push_back(expected_[prompt_.size()]);
+    std::vector<int64_t> generated;
+    auto num_generated = generator.generate(
+        tokens, prompt_.size(), seq_len, [&](const std::string& piece) {
+          generated.push_back(std::stoll(piece));
+        });
+    EXPECT_EQ(num_generated.error(), Error::Ok);
+    if (num_generated.ok()) {
+      EXPECT_EQ(num_generated.get(), static_cast<int64_t>(generated.size()));
+    }
+    return generated;
+  }
+
+  // The tokens of a sequential run from position `begin` to `end`.
+  std::vector<int64_t> expected(size_t begin, size_t end) const {
+    return std::vector<int64_t>(
+        expected_.begin() + begin, expected_.begin() + end);
+  }
+
+  std::vector<uint64_t> prompt_;
+  std::vector<int64_t> expected_;
+  FakeTokenizer tokenizer_;
+  Stats stats_;
+};
+
+TEST_F(SpeculativeTokenGeneratorTest, AcceptsAllMatchingProposals) {
+  FakeTextDecoderRunner target(prompt_);
+  FakeTextDecoderRunner draft(prompt_);
+
+  // Positions 3 to 11: prefill's token is at 3, and 8 tokens follow.
+  auto generated = generate(target, draft, /*num_draft_tokens=*/3, 12);
+  EXPECT_EQ(generated, expected(4, 12));
+
+  // Each target step verifies 3 proposals and adds a token.
+  ASSERT_EQ(target.steps.size(), 2);
+  EXPECT_EQ(target.steps[0].start_pos, 3);
+  EXPECT_EQ(target.steps[0].num_tokens, 4);
+  EXPECT_EQ(target.steps[1].start_pos, 7);
+  EXPECT_EQ(target.steps[1].num_tokens, 4);
+  EXPECT_EQ(stats_.num_draft_tokens, 6);
+  EXPECT_EQ(stats_.num_accepted_draft_tokens, 6);
+}
+
+TEST_F(SpeculativeTokenGeneratorTest, RollsBackToRejectedProposal) {
+  FakeTextDecoderRunner target(prompt_);
+  // The draft's second proposal, for position 5, is wrong.
+  FakeTextDecoderRunner draft(prompt_, /*wrong_positions=*/{4});
+
+  auto generated = generate(target, draft, /*num_draft_tokens=*/3, 14);
+  EXPECT_EQ(generated, expected(4, 14));
+
+  // The first target step accepts 1 proposal and replaces the second, so the
+  // next one starts at the rejected position, over its stale cache entries.
+  ASSERT_GE(target.steps.size(), 2);
+  EXPECT_EQ(target.steps[0].start_pos, 3);
+  EXPECT_EQ(target.steps[0].num_tokens, 4);
+  EXPECT_EQ(target.steps[1].start_pos, 5);
+  // The draft model, which had run up to position 5, restarts there too.
+  ASSERT_GE(draft.steps.size(), 4);
+  EXPECT_EQ(draft.steps[2].start_pos, 5);
+  EXPECT_EQ(draft.steps[3].start_pos, 5);
+  EXPECT_EQ(stats_.num_accepted_draft_tokens, stats_.num_draft_tokens - 2);
+}
+
+TEST_F(SpeculativeTokenGeneratorTest, StopsAtEosInAcceptedProposals) {
+  FakeTextDecoderRunner target(prompt_);
+  FakeTextDecoderRunner draft(prompt_);
+
+  // Make the second generated token, the middle of the first round's accepted
+  // proposals, an EOS.
+  const uint64_t eos = expected_[5];
+  ASSERT_NE(expected_[4], eos);
+  auto generated =
+      generate(target, draft, /*num_draft_tokens=*/3, kMaxSeqLen, {eos});
+  EXPECT_EQ(generated, expected(4, 6));
+  EXPECT_EQ(target.steps.size(), 1);
+}
+
+TEST_F(SpeculativeTokenGeneratorTest, StopsAtSeqLenMidDraft) {
+  FakeTextDecoderRunner target(prompt_);
+  FakeTextDecoderRunner draft(prompt_);
+
+  // After the first round ends at position 7, there is only room for one
+  // proposal and the target's token.
+  auto generated = generate(target, draft, /*num_draft_tokens=*/3, 10);
+  EXPECT_EQ(generated, expected(4, 10));
+
+  ASSERT_EQ(target.steps.size(), 2);
+  EXPECT_EQ(target.steps[1].start_pos, 7);
+  EXPECT_EQ(target.steps[1].num_tokens, 2);
+  EXPECT_EQ(stats_.num_draft_tokens, 4);
+  EXPECT_EQ(stats_.num_accepted_draft_tokens, 4);
+  // The draft model catches up on its last accepted proposal before
+  // proposing again.
+  ASSERT_EQ(draft.steps.size(), 5);
+  for (size_t i = 0; i < draft.steps.size(); ++i) {
+    EXPECT_EQ(draft.steps[i].start_pos, 3 + static_cast<int64_t>(i));
+  }
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/runner/text_prefiller.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+using namespace ::testing;
+using ::executorch::extension::from_blob;
+using ::executorch::extension::TensorPtr;
+using ::executorch::extension::llm::TextDecoderRunner;
+using ::executorch::extension::llm::TextPrefiller;
+using ::executorch::runtime::Error;
+using ::executorch::runtime::Result;
+
+namespace {
+
+constexpr int32_t kVocabSize = 32;
+
+// Records the steps it runs. The logits of each position pick the token at
+// that position plus one, so the sampled token tells which chunk it comes
+// from.
+class FakeTextDecoderRunner : public TextDecoderRunner {
+ public:
+  struct Step {
+    int64_t start_pos;
+    std::vector<int64_t> tokens;
+  };
+
+  explicit FakeTextDecoderRunner(int64_t max_seq_len_per_step)
+      : TextDecoderRunner(
+            /*module=*/nullptr,
+            /*use_kv_cache=*/true,
+            kVocabSize,
+            /*temperature=*/0.0f),
+        max_seq_len_per_step_(max_seq_len_per_step) {}
+
+  Result<exec_aten::Tensor> step(TensorPtr& input, TensorPtr& start_pos)
+      override {
+    const int32_t num_tokens = input->size(1);
+    const int64_t* tokens = input->const_data_ptr<int64_t>();
+    steps.push_back(
+        {*start_pos->const_data_ptr<int64_t>(),
+         std::vector<int64_t>(tokens, tokens + num_tokens)});
+
+    logits_.assign(num_tokens * kVocabSize, 0.0f);
+    for (int32_t i = 0; i < num_tokens; ++i) {
+      logits_[i * kVocabSize + (tokens[i] + 1) % kVocabSize] = 1.0f;
+    }
+    logits_tensor_ = from_blob(logits_.data(), {1, num_tokens, kVocabSize});
+    return *logits_tensor_;
+  }
+
+  Error load() override {
+    return Error::Ok;
+  }
+
+  bool is_method_loaded() override {
+    return true;
+  }
+
+  Result<int64_t> max_seq_len_per_step() override {
+    num_max_seq_len_queries++;
+    return max_seq_len_per_step_;
+  }
+
+  std::vector<Step> steps;
+  int num_max_seq_len_queries = 0;
+
+ private:
+  int64_t max_seq_len_per_step_;
+  std::vector<float> logits_;
+  TensorPtr logits_tensor_;
+};
+
+} // namespace
+
+class TextPrefillerTest : public Test {
+ protected:
+  static void SetUpTestSuite() {
+    ::executorch::runtime::runtime_init();
+  }
+
+  std::vector<uint64_t> prompt_ = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+};
+
+TEST_F(TextPrefillerTest, ChunksToMaxSeqLenPerStep) {
+  FakeTextDecoderRunner runner(/*max_seq_len_per_step=*/4);
+  TextPrefiller prefiller(
+      &runner, /*use_kv_cache=*/true, /*enable_parallel_prefill=*/true);
+
+  int64_t start_pos = 5;
+  auto token = prefiller.prefill(prompt_, start_pos);
+  ASSERT_EQ(token.error(), Error::Ok);
+  // The token follows the last prompt token, from the last chunk's logits.
+  EXPECT_EQ(token.get(), 11);
+  EXPECT_EQ(start_pos, 5 + prompt_.size());
+
+  ASSERT_EQ(runner.steps.size(), 3);
+  EXPECT_EQ(runner.steps[0].start_pos, 5);
+  EXPECT_EQ(runner.steps[0].tokens, std::vector<int64_t>({1, 2, 3, 4}));
+  EXPECT_EQ(runner.steps[1].start_pos, 9);
+  EXPECT_EQ(runner.steps[1].tokens, std::vector<int64_t>({5, 6, 7, 8}));
+  EXPECT_EQ(runner.steps[2].start_pos, 13);
+  EXPECT_EQ(runner.steps[2].tokens, std::vector<int64_t>({9, 10}));
+
+  // The bound is looked up once.
+  start_pos = 0;
+  ASSERT_EQ(prefiller.prefill(prompt_, start_pos).error(), Error::Ok);
+  EXPECT_EQ(start_pos, prompt_.size());
+  EXPECT_EQ(runner.steps.size(), 6);
+  EXPECT_EQ(runner.num_max_seq_len_queries, 1);
+}
+
+TEST_F(TextPrefillerTest, ExplicitMaxChunkSizeOverridesMaxSeqLenPerStep) {
+  FakeTextDecoderRunner runner(/*max_seq_len_per_step=*/4);
+  TextPrefiller prefiller(
+      &runner,
+      /*use_kv_cache=*/true,
+      /*enable_parallel_prefill=*/true,
+      /*max_chunk_size=*/3);
+
+  int64_t start_pos = 0;
+  auto token = prefiller.prefill(prompt_, start_pos);
+  ASSERT_EQ(token.error(), Error::Ok);
+  EXPECT_EQ(token.get(), 11);
+  EXPECT_EQ(start_pos, prompt_.size());
+
+  ASSERT_EQ(runner.steps.size(), 4);
+  for (size_t i = 0; i < runner.steps.size(); ++i) {
+    EXPECT_EQ(runner.steps[i].start_pos, 3 * i);
+  }
+  EXPECT_EQ(runner.steps[3].tokens, std::vector<int64_t>({10}));
+  EXPECT_EQ(runner.num_max_seq_len_queries, 0);
+}
+
+TEST_F(TextPrefillerTest, PromptWithinBoundIsOneStep) {
+  FakeTextDecoderRunner runner(/*max_seq_len_per_step=*/16);
+  TextPrefiller prefiller(
+      &runner, /*use_kv_cache=*/true, /*enable_parallel_prefill=*/true);
+
+  int64_t start_pos = 0;
+  auto token = prefiller.prefill(prompt_, start_pos);
+  ASSERT_EQ(token.error(), Error::Ok);
+  EXPECT_EQ(token.get(), 11);
+  EXPECT_EQ(start_pos, prompt_.size());
+  ASSERT_EQ(runner.steps.size(), 1);
+  EXPECT_EQ(runner.steps[0].tokens.size(), prompt_.size());
+}
+
+TEST_F(TextPrefillerTest, WithoutKVCacheFeedsWholePrompt) {
+  FakeTextDecoderRunner runner(/*max_seq_len_per_step=*/4);
+  TextPrefiller prefiller(
+      &runner,
+      /*use_kv_cache=*/false,
+      /*enable_parallel_prefill=*/true,
+      /*max_chunk_size=*/3);
+
+  int64_t start_pos = 0;
+  auto token = prefiller.prefill(prompt_, start_pos);
+  ASSERT_EQ(token.error(), Error::Ok);
+  EXPECT_EQ(token.get(), 11);
+  ASSERT_EQ(runner.steps.size(), 1);
+  EXPECT_EQ(runner.steps[0].tokens.size(), prompt_.size());
+  EXPECT_EQ(runner.num_max_seq_len_queries, 0);
+}
@@ -70,6 +70,19 @@ TextDecoderRunner::TextDecoderRunner(
   }
 }
 
+::executorch::runtime::Result<int64_t>
+TextDecoderRunner::max_seq_len_per_step() {
+  auto method_meta = ET_UNWRAP(module_->method_meta("forward"));
+  // The tokens are the first input, of shape [batch, seq_len].
+  auto tokens_meta = ET_UNWRAP(method_meta.input_tensor_meta(0));
+  ET_CHECK_OR_RETURN_ERROR(
+      tokens_meta.sizes().size() == 2,
+      InvalidProgram,
+      "Expected tokens of rank 2, got rank %zu",
+      tokens_meta.sizes().size());
+  return tokens_meta.sizes()[1];
+}
+
 } // namespace llm
 } // namespace extension
 } // namespace executorch
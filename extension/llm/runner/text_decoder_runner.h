@@ -57,6 +57,14 @@ class TextDecoderRunner {
     return module_->is_method_loaded("forward");
   }
 
+  /**
+   * Get the max number of tokens that step() takes at once. A Module that
+   * takes a dynamic number of tokens is memory planned for the upper bound of
+   * its tokens input, which its MethodMeta reports.
+   * @return The max number of tokens per step.
+   */
+  virtual ::executorch::runtime::Result<int64_t> max_seq_len_per_step();
+
   inline void stop() {
     should_stop_ = true;
   }
@@ -67,33 +75,35 @@ class TextDecoderRunner {
    * @return The next token.
    */
   inline int32_t logits_to_token(const exec_aten::Tensor& logits_tensor) {
+    // If the logit_tensor rank is 3, the shape is [batch, seq_length,
+    // vocab_size], sample from the last logits. Else the model outputs the
+    // last logit, directly sample from it.
+    return logits_to_token(
+        logits_tensor,
+        logits_tensor.dim() == 3 ? logits_tensor.size(1) - 1 : 0);
+  }
+
+  /**
+   * Sample a token from the logits of one position of the logits tensor.
+   * @param logits_tensor The logits tensor, of shape [batch, seq_length,
+   * vocab_size], or [batch, vocab_size] if the model only outputs the last
+   * logits.
+   * @param position The position in seq_length to sample from. Must be 0 if
+   * the model only outputs the last logits.
+   * @return The token that follows the input token at `position`.
+   */
+  inline int32_t logits_to_token(
+      const exec_aten::Tensor& logits_tensor,
+      int64_t position) {
     switch (logits_tensor.scalar_type()) {
-      // If the logit_tensor rank is 3, the shape is [batch, seq_length,
-      // vocab_size], get the last logits, sample and return. Else the model
-      // outputs the last logit, directly sample and return.
-      case exec_aten::ScalarType::Float: {
-        float* logits = logits_tensor.mutable_data_ptr<float>();
-        if (logits_tensor.dim() == 3) {
-          auto num_tokens = logits_tensor.size(1);
-          auto vocab_size = logits_tensor.size(2);
-          float* logits_last = logits;
-          logits_last += (num_tokens - 1) * vocab_size;
-          return sampler_->sample(logits_last);
-        }
-        return sampler_->sample(logits);
-      }
-      case exec_aten::ScalarType::Half: {
-        exec_aten::Half* logits =
-            logits_tensor.mutable_data_ptr<exec_aten::Half>();
-        if (logits_tensor.dim() == 3) {
-          auto num_tokens = logits_tensor.size(1);
-          auto vocab_size = logits_tensor.size(2);
-          exec_aten::Half* logits_last = logits;
-          logits_last += (num_tokens - 1) * vocab_size;
-          return sampler_->sample(logits_last);
-        }
-        return sampler_->sample(logits);
-      }
+      case exec_aten::ScalarType::Float:
+        return sampler_->sample(logits_at<float>(logits_tensor, position));
+      case exec_aten::ScalarType::Half:
+        return sampler_->sample(
+            logits_at<exec_aten::Half>(logits_tensor, position));
+      case exec_aten::ScalarType::BFloat16:
+        return sampler_->sample(
+            logits_at<exec_aten::BFloat16>(logits_tensor, position));
       default:
         ET_CHECK_MSG(
             false,
@@ -108,6 +118,23 @@ class TextDecoderRunner {
   std::unique_ptr<Sampler> sampler_;
   bool use_kv_cache_;
   bool should_stop_{false};
+
+ private:
+  template <typename T>
+  static T* logits_at(
+      const exec_aten::Tensor& logits_tensor,
+      int64_t position) {
+    T* logits = logits_tensor.mutable_data_ptr<T>();
+    if (logits_tensor.dim() == 3) {
+      ET_CHECK_MSG(
+          position >= 0 && position < logits_tensor.size(1),
+          "Position %" PRId64 " out of range of %" PRId64 " logits",
+          position,
+          static_cast<int64_t>(logits_tensor.size(1)));
+      logits += position * logits_tensor.size(2);
+    }
+    return logits;
+  }
 };
 
 } // namespace llm
@@ -11,6 +11,9 @@
 
 #include <executorch/extension/llm/runner/text_prefiller.h>
 
+#include <algorithm>
+#include <cinttypes>
+
 namespace executorch {
 namespace extension {
 namespace llm {
@@ -18,10 +21,12 @@ namespace llm {
 TextPrefiller::TextPrefiller(
     TextDecoderRunner* text_decoder_runner,
     bool use_kv_cache,
-    bool enable_parallel_prefill)
+    bool enable_parallel_prefill,
+    int64_t max_chunk_size)
     : text_decoder_runner_(text_decoder_runner),
       use_kv_cache_(use_kv_cache),
-      enable_parallel_prefill_(enable_parallel_prefill) {}
+      enable_parallel_prefill_(enable_parallel_prefill),
+      max_chunk_size_(max_chunk_size) {}
 
 ::executorch::runtime::Result<uint64_t> TextPrefiller::prefill(
     std::vector<uint64_t>& prompt_tokens,
@@ -35,25 +40,46 @@ TextPrefiller::TextPrefiller(
   int32_t num_prompt_tokens = prompt_tokens.size();
 
   // store the token
-  uint64_t cur_token;
+  uint64_t cur_token = 0;
   if (enable_parallel_prefill_ || !use_kv_cache_) {
-    // initialize tensor wrappers
-    auto tokens = from_blob(
-        prompt_tokens.data(),
-        {1, num_prompt_tokens},
-        exec_aten::ScalarType::Long);
+    // Without a kv cache the model sees the whole prompt at once. With one,
+    // feed the prompt in chunks that fit the model's shape bound, so that its
+    // activations are planned for the chunk rather than the longest prompt.
+    int32_t chunk_size = num_prompt_tokens;
+    if (use_kv_cache_) {
+      if (max_chunk_size_ <= 0) {
+        max_chunk_size_ =
+            ET_UNWRAP(text_decoder_runner_->max_seq_len_per_step());
+        ET_LOG(Info, "Prefill chunk size: %" PRId64, max_chunk_size_);
+      }
+      chunk_size = std::min<int64_t>(chunk_size, max_chunk_size_);
+    }
 
     auto start_pos_tensor =
         from_blob(&start_pos, {1}, exec_aten::ScalarType::Long);
 
-    auto outputs_res = text_decoder_runner_->step(tokens, start_pos_tensor);
-
-    ET_CHECK_OK_OR_RETURN_ERROR(outputs_res.error());
-    ET_LOG(
-        Info, "Prefill token result numel(): %zu", outputs_res.get().numel());
-
-    start_pos += num_prompt_tokens;
-    cur_token = text_decoder_runner_->logits_to_token(outputs_res.get());
+    for (int32_t offset = 0; offset < num_prompt_tokens; offset += chunk_size) {
+      const int32_t num_tokens =
+          std::min(chunk_size, num_prompt_tokens - offset);
+      // initialize tensor wrappers
+      auto tokens = from_blob(
+          prompt_tokens.data() + offset,
+          {1, num_tokens},
+          exec_aten::ScalarType::Long);
+
+      auto outputs_res = text_decoder_runner_->step(tokens, start_pos_tensor);
+
+      ET_CHECK_OK_OR_RETURN_ERROR(outputs_res.error());
+      ET_LOG(
+          Info, "Prefill token result numel(): %zu", outputs_res.get().numel());
+
+      // start_pos_tensor points at start_pos, so the next chunk follows this
+      // one.
+      start_pos += num_tokens;
+      if (offset + num_tokens == num_prompt_tokens) {
+        cur_token = text_decoder_runner_->logits_to_token(outputs_res.get());
+      }
+    }
   } else { // sequential prefill
     int64_t pos = 0; // position in the sequence
     // NOLINTNEXTLINE(facebook-hte-ParameterUncheckedArrayBounds)
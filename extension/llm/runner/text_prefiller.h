@@ -22,10 +22,20 @@ namespace llm {
 
 class TextPrefiller {
  public:
+  /**
+   * @param text_decoder_runner The runner of the LLM Module.
+   * @param use_kv_cache Whether the LLM Module has a KV cache.
+   * @param enable_parallel_prefill Whether to feed many prompt tokens per
+   * step, rather than one at a time.
+   * @param max_chunk_size With parallel prefill and a KV cache, the max number
+   * of prompt tokens per step. Longer prompts are fed in chunks. If not
+   * positive, the shape bound of the LLM Module's tokens input is used.
+   */
   TextPrefiller(
       TextDecoderRunner* text_decoder_runner,
       bool use_kv_cache_,
-      bool enable_parallel_prefill);
+      bool enable_parallel_prefill,
+      int64_t max_chunk_size = 0);
   /**
    * Prefill an LLM Module with the given text input.
    * @param prompt_tokens The text prompt tokens to the LLM Module. Encoded by
@@ -42,6 +52,7 @@ class TextPrefiller {
   TextDecoderRunner* text_decoder_runner_;
   bool use_kv_cache_;
   bool enable_parallel_prefill_;
+  int64_t max_chunk_size_;
 };
 
 } // namespace llm
@@ -33,12 +33,76 @@
  */
 
 #include <executorch/extension/llm/sampler/sampler.h>
+#include <executorch/kernels/optimized/vec/functional.h>
+#include <executorch/kernels/optimized/vec/vec.h>
 #include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace executorch {
 namespace extension {
 namespace llm {
 
+namespace {
+
+// Loops over the vocabulary keep kLanes independent accumulators, so that the
+// compiler can vectorize them without reassociating floating point math.
+constexpr int kLanes = 8;
+
+// The number of candidates top-p sampling sorts first. That is usually enough
+// to reach topp; if not, the next batch, twice as large, is sorted.
+constexpr size_t kToppInitialSortSize = 64;
+
+// Writes logits * scale to out and returns the largest of them.
+template <typename T>
+float scale_and_max(const T* logits, float scale, float* out, int size) {
+  float lane_max[kLanes];
+  std::fill(
+      lane_max, lane_max + kLanes, -std::numeric_limits<float>::infinity());
+  int i = 0;
+  for (; i + kLanes <= size; i += kLanes) {
+    for (int j = 0; j < kLanes; j++) {
+      const float x = static_cast<float>(logits[i + j]) * scale;
+      out[i + j] = x;
+      lane_max[j] = x > lane_max[j] ? x : lane_max[j];
+    }
+  }
+  float max_val = *std::max_element(lane_max, lane_max + kLanes);
+  for (; i < size; i++) {
+    out[i] = static_cast<float>(logits[i]) * scale;
+    max_val = out[i] > max_val ? out[i] : max_val;
+  }
+  return max_val;
+}
+
+// Replaces each x with exp(x - max_val) and returns their sum. Like the
+// softmax in op_sdpa, this uses the vectorized exp of the vec library.
+float exp_and_sum(float* x, float max_val, int size) {
+  using Vec = ::executorch::vec::Vectorized<float>;
+  const int vec_size = Vec::size();
+  const Vec vec_max(max_val);
+  Vec vec_sum(0.0f);
+  int i = 0;
+  for (; i + vec_size <= size; i += vec_size) {
+    const Vec e = (Vec::loadu(x + i) - vec_max).exp();
+    e.store(x + i);
+    vec_sum += e;
+  }
+  float sum = ::executorch::vec::vec_reduce_all<float>(
+      [](Vec& a, Vec& b) { return a + b; }, vec_sum);
+  for (; i < size; i++) {
+    x[i] = std::exp(x[i] - max_val);
+    sum += x[i];
+  }
+  return sum;
+}
+
+bool compare_prob_desc(const ProbIndex<float>& a, const ProbIndex<float>& b) {
+  return a.prob > b.prob;
+}
+
+} // namespace
+
 // sampler stuff
 template <typename T>
 int32_t Sampler::sample_argmax(T* probabilities) {
@@ -54,100 +118,155 @@ int32_t Sampler::sample_argmax(T* probabilities) {
   return max_i;
 }
 
-template <typename T>
-int32_t Sampler::sample_mult(T* probabilities, float coin) {
-  // sample index from probabilities (they must sum to 1!)
-  // coin is a random number in [0, 1), usually from random_f32()
-  T cdf = 0.0;
+int32_t Sampler::sample_mult(float sum, float coin) {
+  // sample index from the unnormalized probabilities in weights_, which add
+  // up to sum. coin is a random number in [0, 1), usually from random_f32()
+  const float r = coin * sum;
+  float cdf = 0;
   for (int i = 0; i < vocab_size_; i++) {
-    cdf += probabilities[i];
-    if (coin < cdf) {
+    cdf += weights_[i];
+    if (r < cdf) {
       return i;
     }
   }
   return vocab_size_ - 1; // in case of rounding errors
 }
 
-template <typename T>
-int32_t Sampler::sample_topp(T* probabilities, float coin) {
-  // top-p sampling (or "nucleus sampling") samples from the smallest set of
-  // tokens that exceed probability topp. This way we never sample tokens that
-  // have very low probabilities and are less likely to go "off the rails".
+int32_t Sampler::sample_candidates(float sum, float coin) {
+  // Samples from the tokens left by top-k, then top-p, then min-p filtering
+  // of the unnormalized probabilities in weights_, which add up to sum.
   // coin is a random number in [0, 1), usually from random_f32()
-  int n = vocab_size_;
-  int n0 = 0;
-  // quicksort indices in descending order of probabilities
-  // values smaller than (1 - topp) / (n - 1) cannot be part of the result
-  // so for efficiency we crop these out as candidates before sorting
-  std::unique_ptr<ProbIndex<T>[]> probindex =
-      std::make_unique<ProbIndex<T>[]>(vocab_size_);
-
-  const float cutoff = (1.0f - topp_) / (n - 1);
+  const int n = vocab_size_;
+  const bool use_topk = topk_ > 0 && topk_ < n;
+  const bool use_topp = topp_ > 0 && topp_ < 1;
+
+  // The most likely token has weight exp(0) = 1, so min-p is a cutoff on the
+  // weights themselves.
+  float cutoff = min_p_ > 0 ? min_p_ : 0;
+  if (use_topp && !use_topk && n > 1) {
+    // values smaller than (1 - topp) / (n - 1) cannot be part of the top-p
+    // set, so for efficiency we crop these out as candidates before sorting
+    cutoff = std::max(cutoff, (1.0f - topp_) / (n - 1) * sum);
+  }
+  candidates_.clear();
   for (int i = 0; i < n; i++) {
-    if (probabilities[i] >= cutoff) {
-      probindex[n0].index = i;
-      probindex[n0].prob = probabilities[i];
-      n0++;
+    if (weights_[i] >= cutoff) {
+      candidates_.push_back({weights_[i], i});
     }
   }
+  if (candidates_.empty()) {
+    return sample_argmax(weights_.data());
+  }
+  ProbIndex<float>* candidates = candidates_.data();
+  size_t num_candidates = candidates_.size();
 
-  auto compare = [](const ProbIndex<T>& a, const ProbIndex<T>& b) {
-    return a.prob > b.prob;
-  };
-  std::sort(probindex.get(), probindex.get() + n0, compare);
+  if (use_topk && static_cast<size_t>(topk_) < num_candidates) {
+    // quickselect the topk most likely tokens, without sorting them
+    std::nth_element(
+        candidates,
+        candidates + topk_ - 1,
+        candidates + num_candidates,
+        compare_prob_desc);
+    num_candidates = topk_;
+  }
 
-  // truncate the list where cumulative probability exceeds topp
-  T cumulative_prob = 0;
-  int last_idx = n0 - 1; // in case of rounding errors consider all elements
-  for (int i = 0; i < n0; i++) {
-    cumulative_prob += probindex[i].prob;
-    if (cumulative_prob > topp_) {
-      last_idx = i;
-      break; // we've exceeded topp by including last_idx
+  float mass = 0;
+  if (use_topp) {
+    // top-p is relative to the probabilities left by top-k, if any
+    float total = sum;
+    if (use_topk) {
+      total = 0;
+      for (size_t i = 0; i < num_candidates; i++) {
+        total += candidates[i].prob;
+      }
+    }
+    const float threshold = topp_ * total;
+    // Sort only as many of the most likely tokens as it takes for their
+    // cumulative probability to exceed topp, in batches of growing size.
+    size_t num_sorted = 0;
+    size_t num_kept = num_candidates; // in case of rounding errors keep all
+    bool found = false;
+    for (size_t batch = kToppInitialSortSize;
+         !found && num_sorted < num_candidates;
+         batch *= 2) {
+      const size_t batch_end = std::min(num_candidates, num_sorted + batch);
+      std::partial_sort(
+          candidates + num_sorted,
+          candidates + batch_end,
+          candidates + num_candidates,
+          compare_prob_desc);
+      for (; num_sorted < batch_end; num_sorted++) {
+        mass += candidates[num_sorted].prob;
+        if (mass > threshold) {
+          num_kept = num_sorted + 1;
+          found = true;
+          break; // we've exceeded topp by including this token
+        }
+      }
+    }
+    num_candidates = num_kept;
+  } else {
+    for (size_t i = 0; i < num_candidates; i++) {
+      mass += candidates[i].prob;
     }
   }
 
   // sample from the truncated list
-  const T& r = coin * cumulative_prob;
-  T cdf = 0;
-  for (int i = 0; i <= last_idx; i++) {
-    cdf += probindex[i].prob;
+  const float r = coin * mass;
+  float cdf = 0;
+  for (size_t i = 0; i < num_candidates; i++) {
+    cdf += candidates[i].prob;
     if (r < cdf) {
-      return probindex[i].index;
+      return candidates[i].index;
     }
   }
-  return probindex[last_idx].index; // in case of rounding errors
+  return candidates[num_candidates - 1].index; // in case of rounding errors
+}
+
+void Sampler::apply_repetition_penalty(
+    exec_aten::ArrayRef<uint64_t> recent_tokens,
+    float& max_logit) {
+  // penalize each distinct token once, however often it was repeated
+  penalized_tokens_.clear();
+  for (uint64_t token : recent_tokens) {
+    if (token < static_cast<uint64_t>(vocab_size_)) {
+      penalized_tokens_.push_back(static_cast<int32_t>(token));
+    }
+  }
+  std::sort(penalized_tokens_.begin(), penalized_tokens_.end());
+  penalized_tokens_.erase(
+      std::unique(penalized_tokens_.begin(), penalized_tokens_.end()),
+      penalized_tokens_.end());
+
+  bool max_penalized = false;
+  for (int32_t token : penalized_tokens_) {
+    float& logit = weights_[token];
+    max_penalized |= logit == max_logit;
+    logit = logit > 0 ? logit / repetition_penalty_
+                      : logit * repetition_penalty_;
+  }
+  if (max_penalized) {
+    max_logit = *std::max_element(weights_.begin(), weights_.end());
+  }
 }
 
 Sampler::Sampler(
     int vocab_size,
     float temperature,
     float topp,
-    unsigned long long rng_seed)
+    unsigned long long rng_seed,
+    int32_t topk,
+    float min_p,
+    float repetition_penalty)
     : vocab_size_(vocab_size),
       inv_temperature_(static_cast<bool>(temperature) ? 1.0f / temperature : 0),
       topp_(topp),
-      rng_state_(rng_seed) {}
-
-template <typename T>
-static void softmax(T* x, int size) {
-  // find max value (for numerical stability)
-  T max_val = x[0];
-  for (int i = 1; i < size; i++) {
-    if (x[i] > max_val) {
-      max_val = x[i];
-    }
-  }
-  // exp and sum
-  T sum = 0;
-  for (int i = 0; i < size; i++) {
-    x[i] = expf(x[i] - max_val);
-    sum += x[i];
-  }
-  // normalize
-  for (int i = 0; i < size; i++) {
-    x[i] /= sum;
-  }
+      topk_(topk),
+      min_p_(min_p),
+      repetition_penalty_(repetition_penalty),
+      rng_state_(rng_seed) {
+  weights_.resize(vocab_size_);
+  candidates_.reserve(vocab_size_);
 }
 
 static unsigned int random_u32(unsigned long long* state) {
@@ -164,34 +283,55 @@ static float random_f32(unsigned long long* state) { // random float32 in [0,1)
 
 template <typename T>
 int32_t Sampler::sample(T* logits) {
+  return sample(logits, {});
+}
+
+template <typename T>
+int32_t Sampler::sample(
+    T* logits,
+    exec_aten::ArrayRef<uint64_t> recent_tokens) {
   // sample the token given the logits and some hyperparameters
-  int next;
-  if (inv_temperature_ == 0.0f) {
+  const bool penalize = repetition_penalty_ != 1.0f && !recent_tokens.empty();
+  if (inv_temperature_ == 0.0f && !penalize) {
     // greedy argmax sampling: take the token with the highest probability
-    next = sample_argmax(logits);
-  } else {
-    // apply the temperature to the logits
-    for (int q = 0; q < vocab_size_; q++) {
-      logits[q] *= inv_temperature_;
-    }
-    // apply softmax to the logits to get the probabilities for next token
-    softmax(logits, vocab_size_);
-    // flip a (float) coin (this is our source of entropy for sampling)
-    float coin = random_f32(&rng_state_);
-    // we sample from this distribution to get the next token
-    if (topp_ <= 0 || topp_ >= 1) {
-      // simply sample from the predicted probability distribution
-      next = sample_mult(logits, coin);
-    } else {
-      // top-p (nucleus) sampling, clamping the least likely tokens to zero
-      next = sample_topp(logits, coin);
-    }
+    return sample_argmax(logits);
+  }
+  // apply the temperature to the logits, converting them to float
+  const float scale = inv_temperature_ == 0.0f ? 1.0f : inv_temperature_;
+  float max_logit = scale_and_max(logits, scale, weights_.data(), vocab_size_);
+  if (penalize) {
+    apply_repetition_penalty(recent_tokens, max_logit);
+  }
+  if (inv_temperature_ == 0.0f) {
+    return sample_argmax(weights_.data());
+  }
+  // apply softmax to the logits to get the probabilities for next token. They
+  // are left unnormalized; sampling scales the coin by their sum instead.
+  const float sum = exp_and_sum(weights_.data(), max_logit, vocab_size_);
+  // flip a (float) coin (this is our source of entropy for sampling)
+  const float coin = random_f32(&rng_state_);
+  // we sample from this distribution to get the next token
+  if ((topp_ <= 0 || topp_ >= 1) && topk_ <= 0 && min_p_ <= 0) {
+    // simply sample from the predicted probability distribution
+    return sample_mult(sum, coin);
   }
-  return next;
+  // sample from the most likely tokens only
+  return sample_candidates(sum, coin);
 }
 
 template int32_t Sampler::sample<float>(float* logits);
 template int32_t Sampler::sample<exec_aten::Half>(exec_aten::Half* logits);
+template int32_t Sampler::sample<exec_aten::BFloat16>(
+    exec_aten::BFloat16* logits);
+template int32_t Sampler::sample<float>(
+    float* logits,
+    exec_aten::ArrayRef<uint64_t> recent_tokens);
+template int32_t Sampler::sample<exec_aten::Half>(
+    exec_aten::Half* logits,
+    exec_aten::ArrayRef<uint64_t> recent_tokens);
+template int32_t Sampler::sample<exec_aten::BFloat16>(
+    exec_aten::BFloat16* logits,
+    exec_aten::ArrayRef<uint64_t> recent_tokens);
 
 } // namespace llm
 } // namespace extension
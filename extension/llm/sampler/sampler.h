@@ -14,6 +14,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <memory>
+#include <vector>
 #ifdef USE_ATEN_LIB
 #include <torch/torch.h>
 #endif
@@ -33,29 +34,67 @@ struct ProbIndex {
 
 class Sampler {
  public:
+  /**
+   * @param[in] vocab_size The number of logits passed to sample().
+   * @param[in] temperature Logits are divided by it before the softmax. Zero
+   *     picks the most likely token.
+   * @param[in] topp Samples from the smallest set of most likely tokens whose
+   *     probabilities add up to more than topp. Ignored unless in (0, 1).
+   * @param[in] rng_seed The seed of the random number generator.
+   * @param[in] topk Samples from the topk most likely tokens. Ignored if zero.
+   * @param[in] min_p Drops tokens less likely than min_p times the
+   *     probability of the most likely token. Ignored if zero.
+   * @param[in] repetition_penalty Makes tokens passed as recent_tokens to
+   *     sample() less likely: their positive logits are divided by it, and
+   *     their negative logits multiplied by it. Ignored if one.
+   */
   Sampler(
       int32_t vocab_size,
       float temperature,
       float topp,
-      unsigned long long rng_seed);
+      unsigned long long rng_seed,
+      int32_t topk = 0,
+      float min_p = 0.0f,
+      float repetition_penalty = 1.0f);
 
+  /**
+   * Samples a token from the logits. Supports float, Half and BFloat16
+   * logits, which are left unchanged.
+   */
   template <typename T>
   int32_t sample(T* logits);
 
- private:
-  template <typename T>
-  int32_t sample_topp(T* probabilities, float coin);
+  /**
+   * Same as sample(T*), applying the repetition penalty to recent_tokens.
+   */
   template <typename T>
-  int32_t sample_mult(T* probabilities, float coin);
+  int32_t sample(T* logits, exec_aten::ArrayRef<uint64_t> recent_tokens);
+
+ private:
+  int32_t sample_mult(float sum, float coin);
+  int32_t sample_candidates(float sum, float coin);
   template <typename T>
   int32_t sample_argmax(T* probabilities);
+  void apply_repetition_penalty(
+      exec_aten::ArrayRef<uint64_t> recent_tokens,
+      float& max_logit);
 
  private:
   int32_t vocab_size_;
   // reciprocal of temperature, or 0 if temperature == 0.
   float inv_temperature_;
   float topp_;
+  int32_t topk_;
+  float min_p_;
+  float repetition_penalty_;
   unsigned long long rng_state_;
+  // Scratch space reused across calls: the scaled logits, then their
+  // unnormalized probabilities.
+  std::vector<float> weights_;
+  // Scratch space for the tokens left by top-k, top-p and min-p filtering.
+  std::vector<ProbIndex<float>> candidates_;
+  // Scratch space for the distinct tokens to apply the repetition penalty to.
+  std::vector<int32_t> penalized_tokens_;
 };
 
 } // namespace llm
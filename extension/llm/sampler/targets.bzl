@@ -1,4 +1,9 @@
 load("@fbsource//xplat/executorch/build:runtime_wrapper.bzl", "runtime")
+load(
+    "@fbsource//xplat/executorch/kernels/optimized:lib_defs.bzl",
+    "get_vec_android_preprocessor_flags",
+    "get_vec_cxx_preprocessor_flags",
+)
 
 def define_common_targets():
     for aten in (True, False):
@@ -15,12 +20,18 @@ def define_common_targets():
             srcs = [
                 "sampler.cpp",
             ],
+            # The softmax uses the vectorized exp of libvec.
+            cxx_platform_preprocessor_flags = get_vec_cxx_preprocessor_flags(),
+            fbandroid_platform_preprocessor_flags = get_vec_android_preprocessor_flags(),
             visibility = [
                 "@EXECUTORCH_CLIENTS",
             ],
             external_deps = [
                 "libtorch",
             ] if aten else [],
+            deps = [
+                "//executorch/kernels/optimized:libvec",
+            ],
             exported_deps = [
                 "//executorch/runtime/core/exec_aten:lib" + aten_suffix,
             ],
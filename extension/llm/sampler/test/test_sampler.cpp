@@ -11,6 +11,8 @@
 #include <gtest/gtest.h>
 #include <torch/torch.h>
 
+#include <vector>
+
 using namespace ::testing;
 using ::executorch::extension::llm::Sampler;
 
@@ -39,3 +41,89 @@ TEST(SamplerTest, TestArgMaxWithFP16) {
   input[0][0][396] = 1.0f;
   EXPECT_EQ(sampler.sample(input.data_ptr<c10::Half>()), 396);
 }
+
+TEST(SamplerTest, TestArgMaxWithBF16) {
+  Sampler sampler{
+      /*vocab_size*/ 32000,
+      /*temperature*/ 0.0f,
+      /*topp*/ 0.9f,
+      /*rng_seed*/ 0};
+  torch::Tensor input = torch::rand({1, 1, 32000}, at::kBFloat16);
+  input[0][0][396] = 1.0f;
+  EXPECT_EQ(sampler.sample(input.data_ptr<c10::BFloat16>()), 396);
+}
+
+TEST(SamplerTest, TestTopK) {
+  Sampler sampler{
+      /*vocab_size*/ 32000,
+      /*temperature*/ 1.0f,
+      /*topp*/ 1.0f,
+      /*rng_seed*/ 42,
+      /*topk*/ 2};
+  torch::Tensor input = torch::zeros({32000}, at::kFloat);
+  input[5] = 2.0f;
+  input[9] = 2.0f;
+  torch::Tensor original = input.clone();
+  bool sampled[2] = {false, false};
+  for (int i = 0; i < 100; ++i) {
+    int32_t token = sampler.sample(input.data_ptr<float>());
+    ASSERT_TRUE(token == 5 || token == 9);
+    sampled[token == 9] = true;
+  }
+  EXPECT_TRUE(sampled[0] && sampled[1]);
+  // The logits are left unchanged.
+  EXPECT_TRUE(torch::equal(input, original));
+}
+
+TEST(SamplerTest, TestTopP) {
+  Sampler sampler{
+      /*vocab_size*/ 32000,
+      /*temperature*/ 1.0f,
+      /*topp*/ 0.5f,
+      /*rng_seed*/ 42};
+  // Token 7 alone holds more than half the probability.
+  torch::Tensor input = torch::zeros({32000}, at::kHalf);
+  input[7] = 12.0f;
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(sampler.sample(input.data_ptr<c10::Half>()), 7);
+  }
+}
+
+TEST(SamplerTest, TestMinP) {
+  Sampler sampler{
+      /*vocab_size*/ 32000,
+      /*temperature*/ 1.0f,
+      /*topp*/ 1.0f,
+      /*rng_seed*/ 42,
+      /*topk*/ 0,
+      /*min_p*/ 0.1f};
+  // Token 4 is e^-1 times as likely as token 3, and the others e^-5 times,
+  // which is less than min_p.
+  torch::Tensor input = torch::zeros({32000}, at::kFloat);
+  input[3] = 5.0f;
+  input[4] = 4.0f;
+  for (int i = 0; i < 100; ++i) {
+    int32_t token = sampler.sample(input.data_ptr<float>());
+    EXPECT_TRUE(token == 3 || token == 4);
+  }
+}
+
+TEST(SamplerTest, TestRepetitionPenalty) {
+  Sampler sampler{
+      /*vocab_size*/ 32000,
+      /*temperature*/ 0.0f,
+      /*topp*/ 0.9f,
+      /*rng_seed*/ 0,
+      /*topk*/ 0,
+      /*min_p*/ 0.0f,
+      /*repetition_penalty*/ 2.0f};
+  torch::Tensor input = torch::zeros({32000}, at::kFloat);
+  input[396] = 1.0f;
+  input[12] = 0.8f;
+  float* logits = input.data_ptr<float>();
+  EXPECT_EQ(sampler.sample(logits), 396);
+  std::vector<uint64_t> recent_tokens = {396, 396, 40000};
+  EXPECT_EQ(
+      sampler.sample(logits, {recent_tokens.data(), recent_tokens.size()}), 12);
+  EXPECT_EQ(logits[396], 1.0f);
+}
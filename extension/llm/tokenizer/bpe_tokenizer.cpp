@@ -8,7 +8,15 @@
 
 #include <executorch/extension/llm/tokenizer/bpe_tokenizer.h>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <cstring>
+#include <string>
+#include <vector>
 
 using ::executorch::runtime::Error;
 using ::executorch::runtime::Result;
@@ -17,16 +25,236 @@ namespace executorch {
 namespace extension {
 namespace llm {
 
-static int compare_tokens(const void* a, const void* b) {
-  if (((TokenIndex*)a)->str == nullptr) {
-    return -1;
+namespace {
+
+// The compiled form of a tokenizer is a CompiledHeader followed by these
+// sections, each starting at a multiple of kSectionAlignment:
+//   float vocab_scores[vocab_size]
+//   uint32_t string_offsets[vocab_size + 1]
+//   int32_t vocab_index[vocab_index_capacity]
+//   int32_t canonical_ids[vocab_size]
+//   int32_t pair_index[pair_index_capacity * 3]
+//   char strings[strings_size]
+constexpr char kCompiledMagic[8] = {'E', 'T', 'B', 'P', 'E', '0', '0', '1'};
+constexpr size_t kSectionAlignment = 8;
+
+struct CompiledHeader {
+  char magic[8];
+  int32_t vocab_size;
+  int32_t bos_tok;
+  int32_t eos_tok;
+  uint32_t max_token_length;
+  uint32_t vocab_index_capacity;
+  uint32_t pair_index_capacity;
+  uint64_t strings_size;
+};
+
+// Offsets of the sections of a compiled tokenizer.
+struct Layout {
+  size_t vocab_scores;
+  size_t string_offsets;
+  size_t vocab_index;
+  size_t canonical_ids;
+  size_t pair_index;
+  size_t strings;
+  size_t size;
+};
+
+size_t align_section(size_t offset) {
+  return (offset + kSectionAlignment - 1) / kSectionAlignment *
+      kSectionAlignment;
+}
+
+Layout compute_layout(const CompiledHeader& header) {
+  const size_t vocab_size = static_cast<size_t>(header.vocab_size);
+  Layout layout;
+  layout.vocab_scores = align_section(sizeof(CompiledHeader));
+  layout.string_offsets =
+      align_section(layout.vocab_scores + vocab_size * sizeof(float));
+  layout.vocab_index = align_section(
+      layout.string_offsets + (vocab_size + 1) * sizeof(uint32_t));
+  layout.canonical_ids = align_section(
+      layout.vocab_index +
+      size_t(header.vocab_index_capacity) * sizeof(int32_t));
+  layout.pair_index =
+      align_section(layout.canonical_ids + vocab_size * sizeof(int32_t));
+  layout.strings = align_section(
+      layout.pair_index +
+      size_t(header.pair_index_capacity) * 3 * sizeof(int32_t));
+  layout.size = layout.strings + header.strings_size;
+  return layout;
+}
+
+// Returns a power of two large enough to keep a hash table of num_entries
+// at most half full.
+uint32_t table_capacity(size_t num_entries) {
+  uint32_t capacity = 2;
+  while (capacity < num_entries * 2) {
+    capacity *= 2;
+  }
+  return capacity;
+}
+
+// FNV-1a
+uint32_t hash_string(const char* str, size_t len) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < len; i++) {
+    hash = (hash ^ static_cast<unsigned char>(str[i])) * 16777619u;
+  }
+  return hash;
+}
+
+uint32_t hash_pair(int32_t left, int32_t right) {
+  uint64_t key = (uint64_t(uint32_t(left)) << 32) | uint32_t(right);
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdull;
+  key ^= key >> 33;
+  return static_cast<uint32_t>(key);
+}
+
+int32_t find_string(
+    const int32_t* vocab_index,
+    uint32_t mask,
+    const uint32_t* string_offsets,
+    const char* strings,
+    const char* str,
+    size_t len) {
+  for (uint32_t i = hash_string(str, len) & mask;; i = (i + 1) & mask) {
+    const int32_t id = vocab_index[i];
+    if (id == -1) {
+      return -1;
+    }
+    const uint32_t offset = string_offsets[id];
+    if (string_offsets[id + 1] - offset - 1 == len &&
+        memcmp(strings + offset, str, len) == 0) {
+      return id;
+    }
+  }
+}
+
+/**
+ * Builds the compiled form of a tokenizer. The hash tables are filled here,
+ * once, so that loading the compiled form only has to map it.
+ */
+std::unique_ptr<uint8_t[]> compile_tables(
+    const std::vector<std::string>& vocab,
+    const std::vector<float>& vocab_scores,
+    int32_t bos_tok,
+    int32_t eos_tok,
+    uint32_t max_token_length,
+    size_t* size) {
+  const int32_t vocab_size = static_cast<int32_t>(vocab.size());
+  std::vector<uint32_t> string_offsets(vocab_size + 1);
+  std::string strings;
+  for (int32_t i = 0; i < vocab_size; i++) {
+    string_offsets[i] = static_cast<uint32_t>(strings.size());
+    strings.append(vocab[i].c_str(), vocab[i].size() + 1);
+  }
+  string_offsets[vocab_size] = static_cast<uint32_t>(strings.size());
+
+  // Tokens with the same string share the id of the first of them.
+  const uint32_t vocab_index_capacity = table_capacity(vocab_size);
+  const uint32_t vocab_mask = vocab_index_capacity - 1;
+  std::vector<int32_t> vocab_index(vocab_index_capacity, -1);
+  std::vector<int32_t> canonical_ids(vocab_size);
+  for (int32_t i = 0; i < vocab_size; i++) {
+    const std::string& str = vocab[i];
+    uint32_t slot = hash_string(str.data(), str.size()) & vocab_mask;
+    canonical_ids[i] = i;
+    for (; vocab_index[slot] != -1; slot = (slot + 1) & vocab_mask) {
+      if (vocab[vocab_index[slot]] == str) {
+        canonical_ids[i] = vocab_index[slot];
+        break;
+      }
+    }
+    if (canonical_ids[i] == i) {
+      vocab_index[slot] = i;
+    }
+  }
+
+  // Every way to split a token into two tokens is a pair that merges into
+  // it. Since the split determines the concatenation, each pair is unique.
+  std::vector<int32_t> pairs;
+  for (int32_t i = 0; i < vocab_size; i++) {
+    if (canonical_ids[i] != i) {
+      continue;
+    }
+    const std::string& str = vocab[i];
+    for (size_t split = 1; split < str.size(); split++) {
+      const int32_t left = find_string(
+          vocab_index.data(),
+          vocab_mask,
+          string_offsets.data(),
+          strings.data(),
+          str.data(),
+          split);
+      if (left == -1) {
+        continue;
+      }
+      const int32_t right = find_string(
+          vocab_index.data(),
+          vocab_mask,
+          string_offsets.data(),
+          strings.data(),
+          str.data() + split,
+          str.size() - split);
+      if (right != -1) {
+        pairs.insert(pairs.end(), {left, right, i});
+      }
+    }
   }
-  if (((TokenIndex*)b)->str == nullptr) {
-    return 1;
+  const uint32_t pair_index_capacity = table_capacity(pairs.size() / 3);
+  const uint32_t pair_mask = pair_index_capacity - 1;
+  std::vector<int32_t> pair_index(size_t(pair_index_capacity) * 3, -1);
+  for (size_t i = 0; i < pairs.size(); i += 3) {
+    uint32_t slot = hash_pair(pairs[i], pairs[i + 1]) & pair_mask;
+    while (pair_index[slot * 3] != -1) {
+      slot = (slot + 1) & pair_mask;
+    }
+    std::copy(&pairs[i], &pairs[i] + 3, &pair_index[slot * 3]);
   }
-  return strcmp(((TokenIndex*)a)->str, ((TokenIndex*)b)->str);
+
+  CompiledHeader header;
+  memcpy(header.magic, kCompiledMagic, sizeof(kCompiledMagic));
+  header.vocab_size = vocab_size;
+  header.bos_tok = bos_tok;
+  header.eos_tok = eos_tok;
+  header.max_token_length = max_token_length;
+  header.vocab_index_capacity = vocab_index_capacity;
+  header.pair_index_capacity = pair_index_capacity;
+  header.strings_size = strings.size();
+  const Layout layout = compute_layout(header);
+
+  auto tables = std::make_unique<uint8_t[]>(layout.size);
+  uint8_t* data = tables.get();
+  memcpy(data, &header, sizeof(header));
+  std::copy(
+      vocab_scores.begin(),
+      vocab_scores.end(),
+      reinterpret_cast<float*>(data + layout.vocab_scores));
+  std::copy(
+      string_offsets.begin(),
+      string_offsets.end(),
+      reinterpret_cast<uint32_t*>(data + layout.string_offsets));
+  std::copy(
+      vocab_index.begin(),
+      vocab_index.end(),
+      reinterpret_cast<int32_t*>(data + layout.vocab_index));
+  std::copy(
+      canonical_ids.begin(),
+      canonical_ids.end(),
+      reinterpret_cast<int32_t*>(data + layout.canonical_ids));
+  std::copy(
+      pair_index.begin(),
+      pair_index.end(),
+      reinterpret_cast<int32_t*>(data + layout.pair_index));
+  std::copy(strings.begin(), strings.end(), data + layout.strings);
+  *size = layout.size;
+  return tables;
 }
 
+} // namespace
+
 BPETokenizer::BPETokenizer() : Tokenizer() {
   for (int i = 0; i < 256; i++) {
     byte_pieces_[i * 2] = (unsigned char)i;
@@ -38,8 +266,11 @@ BPETokenizer::BPETokenizer() : Tokenizer() {
  * @brief Load the tokenizer from a file. The tokenizer file contains the
  * vocabulary and scores. The format is: the first integer is the maximum
  * token length, followed by a list of (word_len, word) pairs. Here we
- * are reading all the vocabulary into memory and keep it sorted for fast
- * lookup.
+ * are reading all the vocabulary into memory and build hash tables of it for
+ * fast lookup.
+ *
+ * The file may also be a tokenizer compiled by save(), whose hash tables are
+ * already built. It is mapped into memory rather than read.
  *
  * @param tokenizer_path The path to the tokenizer file.
  * @return Error
@@ -55,6 +286,14 @@ Error BPETokenizer::load(const std::string& tokenizer_path) {
     ET_LOG(Error, "couldn't load %s", tokenizer_path.c_str());
     return Error::InvalidArgument;
   }
+  char magic[sizeof(kCompiledMagic)];
+  if (fread(magic, sizeof(magic), 1, file) == 1 &&
+      memcmp(magic, kCompiledMagic, sizeof(magic)) == 0) {
+    fclose(file);
+    return load_compiled(tokenizer_path);
+  }
+  rewind(file);
+
   int32_t metadata[4];
   for (int i = 0; i < 4; i++) {
     if (fread(metadata + i, sizeof(int32_t), 1, file) != 1) {
@@ -62,6 +301,7 @@ Error BPETokenizer::load(const std::string& tokenizer_path) {
           Error,
           "Failed to read the metadata at position %d, the tokenizer file is not valid!",
           i);
+      fclose(file);
       return Error::InvalidArgument;
     }
   }
@@ -69,57 +309,222 @@ Error BPETokenizer::load(const std::string& tokenizer_path) {
   // now we have two vocab_sizes one from the model and another from the
   // tokenizer file.
   int32_t tokenizer_vocab_size = metadata[0];
-  vocab_size_ = tokenizer_vocab_size;
-  bos_tok_ = metadata[1];
-  eos_tok_ = metadata[2];
-  max_token_length_ = metadata[3];
-
-  // allocate space for the vocabulary
-  vocab_ = std::make_unique<char*[]>(vocab_size_);
-  vocab_scores_ = std::make_unique<float[]>(vocab_size_);
-  sorted_vocab_ = std::make_unique<TokenIndex[]>(vocab_size_);
+  if (tokenizer_vocab_size < 0) {
+    ET_LOG(Error, "Invalid vocab size %d", tokenizer_vocab_size);
+    fclose(file);
+    return Error::InvalidArgument;
+  }
 
   // read in the vocabulary
-  for (int i = 0; i < vocab_size_; i++) {
-    if (fread(vocab_scores_.get() + i, sizeof(float), 1, file) != 1) {
+  std::vector<std::string> vocab(tokenizer_vocab_size);
+  std::vector<float> vocab_scores(tokenizer_vocab_size);
+  for (int i = 0; i < tokenizer_vocab_size; i++) {
+    if (fread(&vocab_scores[i], sizeof(float), 1, file) != 1) {
       // This is allowed, we just pad the rest of the vocab with <pad> strings
-      std::string padding = "<pad>";
-      vocab_[i] = new char[padding.length() + 1];
-      strcpy(vocab_[i], padding.c_str());
-      vocab_[i][padding.length()] = '\0';
+      vocab[i] = "<pad>";
       continue;
     }
     int32_t len;
-    if (fread(&len, sizeof(int32_t), 1, file) != 1) {
+    if (fread(&len, sizeof(int32_t), 1, file) != 1 || len < 0) {
       ET_LOG(Error, "Failed to read the length of the word at index %d", i);
+      fclose(file);
       return Error::InvalidArgument;
     }
-    vocab_[i] = new char[len + 1];
-    if (fread(vocab_[i], len, 1, file) != 1) {
+    vocab[i].resize(len);
+    if (len > 0 && fread(&vocab[i][0], len, 1, file) != 1) {
       ET_LOG(
           Error,
           "Failed to read the word, total length %d, index %d\n",
           len,
           i);
+      fclose(file);
       return Error::InvalidArgument;
     }
-    vocab_[i][len] = '\0'; // add the string terminating token
+    // stop at an embedded terminator, like the C strings this used to keep
+    vocab[i].resize(strlen(vocab[i].c_str()));
   }
   fclose(file);
 
-  for (int32_t i = 0; i < vocab_size_; i++) {
-    sorted_vocab_[i].str = vocab_[i];
-    sorted_vocab_[i].id = i;
+  owned_tables_ = compile_tables(
+      vocab,
+      vocab_scores,
+      /*bos_tok=*/metadata[1],
+      /*eos_tok=*/metadata[2],
+      /*max_token_length=*/metadata[3],
+      &tables_size_);
+  Error err = bind_tables(owned_tables_.get(), tables_size_);
+  if (err != Error::Ok) {
+    owned_tables_.reset();
+    return err;
   }
-  qsort(sorted_vocab_.get(), vocab_size_, sizeof(TokenIndex), compare_tokens);
+  initialized_ = true;
+  return Error::Ok;
+}
 
+Error BPETokenizer::load_compiled(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    ET_LOG(Error, "couldn't load %s", path.c_str());
+    return Error::InvalidArgument;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    ET_LOG(Error, "couldn't stat %s", path.c_str());
+    close(fd);
+    return Error::AccessFailed;
+  }
+  const size_t size = st.st_size;
+  void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    ET_LOG(Error, "couldn't map %s", path.c_str());
+    return Error::AccessFailed;
+  }
+  Error err = bind_tables(static_cast<const uint8_t*>(data), size);
+  if (err != Error::Ok) {
+    munmap(data, size);
+    return err;
+  }
+  mapping_ = data;
+  mapping_size_ = size;
   initialized_ = true;
   return Error::Ok;
 }
 
+/**
+ * @brief Checks that data holds a well-formed compiled tokenizer, so that
+ * lookups stay in bounds, and points the tokenizer at its sections.
+ */
+Error BPETokenizer::bind_tables(const uint8_t* data, size_t size) {
+  CompiledHeader header;
+  if (size < sizeof(header)) {
+    ET_LOG(Error, "Compiled tokenizer too small: %zu bytes", size);
+    return Error::InvalidArgument;
+  }
+  memcpy(&header, data, sizeof(header));
+  const uint32_t vocab_capacity = header.vocab_index_capacity;
+  const uint32_t pair_capacity = header.pair_index_capacity;
+  if (memcmp(header.magic, kCompiledMagic, sizeof(kCompiledMagic)) != 0 ||
+      header.vocab_size < 0 || vocab_capacity < 2 ||
+      (vocab_capacity & (vocab_capacity - 1)) != 0 || pair_capacity < 2 ||
+      (pair_capacity & (pair_capacity - 1)) != 0 ||
+      header.strings_size > UINT32_MAX) {
+    ET_LOG(Error, "Invalid compiled tokenizer header");
+    return Error::InvalidArgument;
+  }
+  const Layout layout = compute_layout(header);
+  if (layout.size != size) {
+    ET_LOG(
+        Error,
+        "Compiled tokenizer is %zu bytes, expected %zu",
+        size,
+        layout.size);
+    return Error::InvalidArgument;
+  }
+
+  const int32_t vocab_size = header.vocab_size;
+  const auto* string_offsets =
+      reinterpret_cast<const uint32_t*>(data + layout.string_offsets);
+  const auto* strings = reinterpret_cast<const char*>(data + layout.strings);
+  if (string_offsets[0] != 0 ||
+      string_offsets[vocab_size] != header.strings_size) {
+    ET_LOG(Error, "Invalid compiled tokenizer strings");
+    return Error::InvalidArgument;
+  }
+  for (int32_t i = 0; i < vocab_size; i++) {
+    if (string_offsets[i + 1] <= string_offsets[i] ||
+        string_offsets[i + 1] > header.strings_size ||
+        strings[string_offsets[i + 1] - 1] != '\0') {
+      ET_LOG(Error, "Invalid compiled tokenizer string %d", i);
+      return Error::InvalidArgument;
+    }
+  }
+  auto is_id = [vocab_size](int32_t id) { return id >= 0 && id < vocab_size; };
+  const auto* vocab_index =
+      reinterpret_cast<const int32_t*>(data + layout.vocab_index);
+  const auto* canonical_ids =
+      reinterpret_cast<const int32_t*>(data + layout.canonical_ids);
+  const auto* pair_index =
+      reinterpret_cast<const int32_t*>(data + layout.pair_index);
+  // Lookups end at an empty entry, so each table needs one.
+  bool has_empty_entry = false;
+  for (uint32_t i = 0; i < vocab_capacity; i++) {
+    has_empty_entry |= vocab_index[i] == -1;
+    if (vocab_index[i] != -1 && !is_id(vocab_index[i])) {
+      ET_LOG(Error, "Invalid compiled tokenizer vocab index");
+      return Error::InvalidArgument;
+    }
+  }
+  for (int32_t i = 0; i < vocab_size; i++) {
+    if (!is_id(canonical_ids[i])) {
+      ET_LOG(Error, "Invalid compiled tokenizer canonical ids");
+      return Error::InvalidArgument;
+    }
+  }
+  if (!has_empty_entry) {
+    ET_LOG(Error, "Compiled tokenizer vocab index is full");
+    return Error::InvalidArgument;
+  }
+  has_empty_entry = false;
+  for (uint32_t i = 0; i < pair_capacity; i++) {
+    const int32_t* entry = pair_index + i * 3;
+    has_empty_entry |= entry[0] == -1;
+    if (entry[0] != -1 &&
+        !(is_id(entry[0]) && is_id(entry[1]) && is_id(entry[2]))) {
+      ET_LOG(Error, "Invalid compiled tokenizer pair index");
+      return Error::InvalidArgument;
+    }
+  }
+  if (!has_empty_entry) {
+    ET_LOG(Error, "Compiled tokenizer pair index is full");
+    return Error::InvalidArgument;
+  }
+
+  tables_ = data;
+  tables_size_ = size;
+  vocab_scores_ = reinterpret_cast<const float*>(data + layout.vocab_scores);
+  string_offsets_ = string_offsets;
+  strings_ = strings;
+  vocab_index_ = vocab_index;
+  vocab_index_mask_ = vocab_capacity - 1;
+  canonical_ids_ = canonical_ids;
+  pair_index_ = pair_index;
+  pair_index_mask_ = pair_capacity - 1;
+  vocab_size_ = vocab_size;
+  bos_tok_ = header.bos_tok;
+  eos_tok_ = header.eos_tok;
+  max_token_length_ = header.max_token_length;
+  return Error::Ok;
+}
+
+/**
+ * @brief Write the compiled form of the tokenizer, which load() maps instead
+ * of parsing.
+ *
+ * @param path The path of the file to write.
+ * @return Error
+ */
+Error BPETokenizer::save(const std::string& path) const {
+  if (!initialized_) {
+    ET_LOG(Error, "Tokenizer not initialized");
+    return Error::NotSupported;
+  }
+  FILE* file = fopen(path.c_str(), "wb");
+  if (!file) {
+    ET_LOG(Error, "couldn't open %s", path.c_str());
+    return Error::AccessFailed;
+  }
+  const bool written = fwrite(tables_, tables_size_, 1, file) == 1;
+  if (fclose(file) != 0 || !written) {
+    ET_LOG(Error, "couldn't write %s", path.c_str());
+    return Error::AccessFailed;
+  }
+  return Error::Ok;
+}
+
 BPETokenizer::~BPETokenizer() {
-  for (int i = 0; i < vocab_size_; i++) {
-    delete[] vocab_[i];
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
   }
 }
 
@@ -134,7 +539,7 @@ BPETokenizer::~BPETokenizer() {
 Result<std::string> BPETokenizer::decode(uint64_t prev_token, uint64_t token)
     const {
   ET_CHECK_OK_OR_RETURN_ERROR(Tokenizer::decode_verify(token));
-  const char* piece = vocab_[token];
+  const char* piece = strings_ + string_offsets_[token];
   // following BOS token, sentencepiece decoder strips any leading
   // whitespace
   if (prev_token == bos_tok_ && piece[0] == ' ') {
@@ -150,14 +555,27 @@ Result<std::string> BPETokenizer::decode(uint64_t prev_token, uint64_t token)
   return res;
 }
 
-static int32_t
-str_lookup(const char* str, TokenIndex* sorted_vocab, int32_t vocab_size) {
-  // efficiently find the perfect match for str in vocab, return its index or -1
-  // if not found
-  TokenIndex tok = {.str = str}; // acts as the key to search for
-  TokenIndex* res = (TokenIndex*)bsearch(
-      &tok, sorted_vocab, vocab_size, sizeof(TokenIndex), compare_tokens);
-  return res != nullptr ? res->id : -1;
+int32_t BPETokenizer::lookup(const char* str, size_t len) const {
+  // find the perfect match for str in vocab, return its index or -1 if not
+  // found
+  return find_string(
+      vocab_index_, vocab_index_mask_, string_offsets_, strings_, str, len);
+}
+
+int32_t BPETokenizer::lookup_pair(int32_t left, int32_t right) const {
+  // find the token that the pair of canonical ids merges into, or -1 if none
+  const int32_t left_id = canonical_ids_[left];
+  const int32_t right_id = canonical_ids_[right];
+  for (uint32_t i = hash_pair(left_id, right_id) & pair_index_mask_;;
+       i = (i + 1) & pair_index_mask_) {
+    const int32_t* entry = pair_index_ + i * 3;
+    if (entry[0] == -1) {
+      return -1;
+    }
+    if (entry[0] == left_id && entry[1] == right_id) {
+      return entry[2];
+    }
+  }
 }
 
 /**
@@ -184,10 +602,8 @@ BPETokenizer::encode(const std::string& text, int8_t bos, int8_t eos) const {
     return Error::InvalidArgument;
   }
 
-  // create a temporary buffer that will store merge candidates of always two
-  // consecutive tokens *2 for concat, +1 for null terminator +2 for UTF8 (in
-  // case max_token_length is 1)
-  char* str_buffer = new char[max_token_length_ * 2 + 1 + 2];
+  // a buffer for the bytes of one UTF-8 codepoint, of at most 4 bytes
+  char str_buffer[8];
   size_t str_len = 0;
 
   // start at 0 tokens
@@ -208,10 +624,11 @@ BPETokenizer::encode(const std::string& text, int8_t bos, int8_t eos) const {
   // TODO: pretty sure this isn't correct in the general case but I don't have
   // the energy to read more of the sentencepiece code to figure out what it's
   // doing
-  const char* space = " ";
   if (text[0] != '\0') {
-    int dummy_prefix = str_lookup(space, sorted_vocab_.get(), vocab_size_);
-    tokens.push_back(dummy_prefix);
+    int dummy_prefix = lookup(" ", 1);
+    if (dummy_prefix != -1) {
+      tokens.push_back(dummy_prefix);
+    }
   }
 
   // Okay UTF-8 time. This will get messy. Here is the reference from Wikipedia:
@@ -239,7 +656,6 @@ BPETokenizer::encode(const std::string& text, int8_t bos, int8_t eos) const {
     // append the current byte to the buffer
     str_buffer[str_len++] =
         *c; // ++ is post-increment, incremented after this line
-    str_buffer[str_len] = '\0';
 
     // while the next character is a continuation byte, continue appending
     // but if there are too many of them, just stop to avoid overruning
@@ -249,7 +665,7 @@ BPETokenizer::encode(const std::string& text, int8_t bos, int8_t eos) const {
     }
 
     // ok c+1 is not a continuation byte, so we've read in a full codepoint
-    int id = str_lookup(str_buffer, sorted_vocab_.get(), vocab_size_);
+    int id = lookup(str_buffer, str_len);
     if (id != -1) {
       // we found this codepoint in vocab, add it as a token
       tokens.push_back(id);
@@ -257,7 +673,7 @@ BPETokenizer::encode(const std::string& text, int8_t bos, int8_t eos) const {
       // byte_fallback encoding: just encode each byte as a token
       // +3 is here because the first 3 vocab elements are <unk>, <s>, </s>
       // so the individual bytes only start at index 3
-      for (int i = 0; i < str_len; i++) {
+      for (size_t i = 0; i < str_len; i++) {
         tokens.push_back((unsigned char)str_buffer[i] + 3);
       }
     }
@@ -265,41 +681,72 @@ BPETokenizer::encode(const std::string& text, int8_t bos, int8_t eos) const {
   }
 
   // merge the best consecutive pair each iteration, according the scores in
-  // vocab_scores
-  while (1) {
-    float best_score = -1e10;
-    int best_id = -1;
-    int best_idx = -1;
-
-    for (int i = 0; i < tokens.size() - 1; i++) {
-      // check if we can merge the pair (tokens[i], tokens[i+1])
-      snprintf(
-          str_buffer,
-          max_token_length_ * 2 + 3,
-          "%s%s",
-          vocab_[tokens[i]],
-          vocab_[tokens[i + 1]]);
-      int id = str_lookup(str_buffer, sorted_vocab_.get(), vocab_size_);
-      if (id != -1 && vocab_scores_[id] > best_score) {
-        // this merge pair exists in vocab! record its score and position
-        best_score = vocab_scores_[id];
-        best_id = id;
-        best_idx = i;
-      }
+  // vocab_scores, the leftmost one among equal scores. The tokens form a
+  // linked list, and candidate merges a max-heap: a merge only changes the
+  // pairs on either side of it, so this takes O(n log n) work.
+  struct Merge {
+    float score;
+    int32_t pos;
+    int32_t id;
+    uint32_t version;
+  };
+  auto worse = [](const Merge& a, const Merge& b) {
+    return a.score < b.score || (a.score == b.score && a.pos > b.pos);
+  };
+  const int32_t n = static_cast<int32_t>(tokens.size());
+  std::vector<int32_t> next(n);
+  std::vector<int32_t> prev(n);
+  // Bumped when the pair starting at a position changes, which makes the
+  // merges queued for it stale.
+  std::vector<uint32_t> versions(n, 0);
+  std::vector<Merge> merges;
+  auto queue_merge = [&](int32_t pos) {
+    const uint32_t version = ++versions[pos];
+    const int32_t right = next[pos];
+    const uint64_t vocab_size = vocab_size_;
+    if (right >= n || tokens[pos] >= vocab_size ||
+        tokens[right] >= vocab_size) {
+      return;
     }
-
-    if (best_idx == -1) {
-      break; // we couldn't find any more pairs to merge, so we're done
+    const int32_t id = lookup_pair(tokens[pos], tokens[right]);
+    if (id != -1 && vocab_scores_[id] > -1e10) {
+      // this merge pair exists in vocab! record its score and position
+      merges.push_back({vocab_scores_[id], pos, id, version});
+      std::push_heap(merges.begin(), merges.end(), worse);
     }
-
-    // merge the consecutive pair (best_idx, best_idx+1) into new token best_id
-    tokens[best_idx] = best_id;
-    // delete token at position best_idx+1, shift the entire sequence back 1
-    for (int i = best_idx + 1; i < tokens.size() - 1; i++) {
-      tokens[i] = tokens[i + 1];
+  };
+  for (int32_t i = 0; i < n; i++) {
+    next[i] = i + 1;
+    prev[i] = i - 1;
+  }
+  for (int32_t i = 0; i + 1 < n; i++) {
+    queue_merge(i);
+  }
+  while (!merges.empty()) {
+    std::pop_heap(merges.begin(), merges.end(), worse);
+    const Merge merge = merges.back();
+    merges.pop_back();
+    if (merge.version != versions[merge.pos]) {
+      continue;
     }
-    tokens.pop_back(); // token length decreased
+    // merge the consecutive pair (pos, next[pos]) into new token id
+    const int32_t removed = next[merge.pos];
+    tokens[merge.pos] = merge.id;
+    next[merge.pos] = next[removed];
+    if (next[removed] < n) {
+      prev[next[removed]] = merge.pos;
+    }
+    versions[removed]++;
+    queue_merge(merge.pos);
+    if (prev[merge.pos] >= 0) {
+      queue_merge(prev[merge.pos]);
+    }
+  }
+  size_t num_tokens = 0;
+  for (int32_t i = 0; i < n; i = next[i]) {
+    tokens[num_tokens++] = tokens[i];
   }
+  tokens.resize(num_tokens);
 
   // add optional EOS (=2) token, if desired
   if (eos >= 0) {
@@ -311,7 +758,6 @@ BPETokenizer::encode(const std::string& text, int8_t bos, int8_t eos) const {
     return Error::InvalidArgument;
   }
 
-  delete[] str_buffer;
   return Result(tokens);
 }
 
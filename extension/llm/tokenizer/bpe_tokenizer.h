@@ -9,6 +9,7 @@
 #pragma once
 
 #include <executorch/extension/llm/tokenizer/tokenizer.h>
+#include <cstdint>
 #include <memory>
 
 namespace executorch {
@@ -22,6 +23,10 @@ struct TokenIndex {
 
 // A simple Byte Pair Encoding (BPE) Tokenizer. Note that the current C++ code
 // won't work with this class, it needs to go through tokenizer.py first.
+//
+// load() also accepts the compiled form of a tokenizer written by save(),
+// which holds the lookup tables built at load time and is mmapped instead of
+// parsed.
 class BPETokenizer : public Tokenizer {
  public:
   explicit BPETokenizer();
@@ -36,10 +41,47 @@ class BPETokenizer : public Tokenizer {
       uint64_t prev_token,
       uint64_t token) const override;
 
+  /**
+   * Writes the compiled form of the loaded tokenizer to a file, for load() to
+   * map later.
+   *
+   * @param[in] path The path of the file to write.
+   * @return Error::Ok on success, Error::NotSupported if the tokenizer is not
+   * loaded, or Error::AccessFailed if the file can't be written.
+   */
+  ::executorch::runtime::Error save(const std::string& path) const;
+
  private:
-  std::unique_ptr<char*[]> vocab_ = nullptr;
-  std::unique_ptr<float[]> vocab_scores_ = nullptr;
-  std::unique_ptr<TokenIndex[]> sorted_vocab_ = nullptr;
+  ::executorch::runtime::Error load_compiled(const std::string& path);
+  ::executorch::runtime::Error bind_tables(const uint8_t* data, size_t size);
+  int32_t lookup(const char* str, size_t len) const;
+  int32_t lookup_pair(int32_t left, int32_t right) const;
+
+  // The compiled tokenizer: either owned_tables_, or a mapping of the file.
+  const uint8_t* tables_ = nullptr;
+  size_t tables_size_ = 0;
+  std::unique_ptr<uint8_t[]> owned_tables_ = nullptr;
+  void* mapping_ = nullptr;
+  size_t mapping_size_ = 0;
+
+  // Views of the sections of tables_.
+  const float* vocab_scores_ = nullptr;
+  // Token i is the NUL-terminated string at strings_ + string_offsets_[i].
+  // string_offsets_[vocab_size_] is the size of strings_.
+  const uint32_t* string_offsets_ = nullptr;
+  const char* strings_ = nullptr;
+  // Open-addressing hash table from strings to the ids of tokens, -1 if
+  // empty. When several tokens have the same string, one of them is the
+  // canonical id of all of them.
+  const int32_t* vocab_index_ = nullptr;
+  uint32_t vocab_index_mask_ = 0;
+  const int32_t* canonical_ids_ = nullptr;
+  // Open-addressing hash table from pairs of canonical ids to the canonical
+  // id of their concatenation, if it is a token. Each entry is the triple
+  // (left, right, merged), left being -1 if the entry is empty.
+  const int32_t* pair_index_ = nullptr;
+  uint32_t pair_index_mask_ = 0;
+
   unsigned int max_token_length_ = 0;
   unsigned char byte_pieces_[512]; // stores all single-byte strings
 };
@@ -9,6 +9,9 @@
 #include <executorch/extension/llm/tokenizer/bpe_tokenizer.h>
 #include <executorch/runtime/platform/runtime.h>
 #include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
 #include <vector>
 
 using namespace ::testing;
@@ -67,3 +70,95 @@ TEST_F(TokenizerExtensionTest, SafeToDestruct) {
   tokenizer_ = std::make_unique<BPETokenizer>();
   tokenizer_.reset();
 }
+
+namespace {
+// Writes a tokenizer with the bytes, " ", "a", "b", "c", "ab", "bc", "abc" and
+// " a", in the format produced by tokenizer.py.
+std::string write_test_tokenizer() {
+  std::vector<std::pair<std::string, float>> vocab = {
+      {"<unk>", 0}, {"<s>", 0}, {"</s>", 0}};
+  for (int i = 0; i < 256; i++) {
+    char byte_token[8];
+    snprintf(byte_token, sizeof(byte_token), "<0x%02X>", i);
+    vocab.emplace_back(byte_token, 0);
+  }
+  vocab.insert(
+      vocab.end(),
+      {{" ", -1},
+       {"a", -2},
+       {"b", -3},
+       {"c", -4},
+       {"ab", -5},
+       {"bc", -0.5},
+       {"abc", -6},
+       {" a", -10}});
+
+  std::string path = ::testing::TempDir() + "test_bpe_tokenizer_vocab.bin";
+  std::ofstream file(path, std::ios::binary);
+  int32_t metadata[4] = {static_cast<int32_t>(vocab.size()), 1, 2, 6};
+  file.write(reinterpret_cast<const char*>(metadata), sizeof(metadata));
+  for (const auto& [token, score] : vocab) {
+    int32_t len = token.size();
+    file.write(reinterpret_cast<const char*>(&score), sizeof(score));
+    file.write(reinterpret_cast<const char*>(&len), sizeof(len));
+    file.write(token.data(), len);
+  }
+  return path;
+}
+} // namespace
+
+TEST_F(TokenizerExtensionTest, EncodeMergesHighestScoringPairsFirst) {
+  Error res = tokenizer_->load(write_test_tokenizer());
+  EXPECT_EQ(res, Error::Ok);
+  // " " "a" "b" "c" merges "bc" first, then "abc"; " a" is never a candidate.
+  Result<std::vector<uint64_t>> out = tokenizer_->encode("abc", 1, 1);
+  EXPECT_EQ(out.error(), Error::Ok);
+  EXPECT_EQ(out.get(), (std::vector<uint64_t>{1, 259, 265, 2}));
+
+  // Codepoints missing from the vocab fall back to byte tokens.
+  Result<std::vector<uint64_t>> fallback_out = tokenizer_->encode("ax", 0, 0);
+  EXPECT_EQ(fallback_out.error(), Error::Ok);
+  EXPECT_EQ(fallback_out.get(), (std::vector<uint64_t>{266, 'x' + 3}));
+  EXPECT_EQ(tokenizer_->decode(266, 'x' + 3).get(), "x");
+}
+
+TEST_F(TokenizerExtensionTest, SaveAndLoadCompiledTokenizer) {
+  BPETokenizer tokenizer;
+  EXPECT_EQ(tokenizer.save(::testing::TempDir() + "unused"), Error::NotSupported);
+  EXPECT_EQ(tokenizer.load(write_test_tokenizer()), Error::Ok);
+  const std::string compiled_path =
+      ::testing::TempDir() + "test_bpe_tokenizer_compiled.bin";
+  EXPECT_EQ(tokenizer.save(compiled_path), Error::Ok);
+
+  EXPECT_EQ(tokenizer_->load(compiled_path), Error::Ok);
+  EXPECT_EQ(tokenizer_->vocab_size(), tokenizer.vocab_size());
+  EXPECT_EQ(tokenizer_->bos_tok(), 1);
+  EXPECT_EQ(tokenizer_->eos_tok(), 2);
+  for (const char* text : {"abc", "cab ab", "abcé"}) {
+    EXPECT_EQ(
+        tokenizer_->encode(text, 1, 0).get(), tokenizer.encode(text, 1, 0).get());
+  }
+  for (uint64_t token = 0; token < tokenizer.vocab_size(); token++) {
+    EXPECT_EQ(
+        tokenizer_->decode(0, token).get(), tokenizer.decode(0, token).get());
+  }
+}
+
+TEST_F(TokenizerExtensionTest, LoadTruncatedCompiledTokenizerFails) {
+  BPETokenizer tokenizer;
+  EXPECT_EQ(tokenizer.load(write_test_tokenizer()), Error::Ok);
+  const std::string compiled_path =
+      ::testing::TempDir() + "test_bpe_tokenizer_truncated.bin";
+  EXPECT_EQ(tokenizer.save(compiled_path), Error::Ok);
+
+  std::string contents;
+  {
+    std::ifstream file(compiled_path, std::ios::binary);
+    contents.assign(std::istreambuf_iterator<char>(file), {});
+  }
+  {
+    std::ofstream file(compiled_path, std::ios::binary | std::ios::trunc);
+    file.write(contents.data(), contents.size() - 1);
+  }
+  EXPECT_EQ(tokenizer_->load(compiled_path), Error::InvalidArgument);
+}
@@ -186,3 +186,51 @@ TEST_F(TiktokenExtensionTest, LoadTiktokenFileWithBPEFile) {
 
   EXPECT_EQ(res, Error::InvalidArgument);
 }
+
+TEST_F(TiktokenExtensionTest, TokenizerEncodeWithPieceCache) {
+  Error res = tokenizer_->load(modelPath_.c_str());
+  EXPECT_EQ(res, Error::Ok);
+  Tiktoken uncached_tokenizer(
+      _get_special_tokens(),
+      kBOSTokenIndex,
+      kEOSTokenIndex,
+      /*piece_cache_size=*/0);
+  EXPECT_EQ(uncached_tokenizer.load(modelPath_.c_str()), Error::Ok);
+
+  // Made-up words are not tokens themselves, so they are byte pair merged.
+  const std::string text = "zyxwvut qwertyuiopasdf zyxwvut";
+  Result<std::vector<uint64_t>> expected = uncached_tokenizer.encode(text, 0, 0);
+  EXPECT_EQ(expected.error(), Error::Ok);
+  EXPECT_GT(expected.get().size(), 3);
+  for (int i = 0; i < 2; i++) {
+    // The second time, the tokens of the pieces come from the cache.
+    Result<std::vector<uint64_t>> out = tokenizer_->encode(text, 0, 0);
+    EXPECT_EQ(out.error(), Error::Ok);
+    EXPECT_EQ(out.get(), expected.get());
+  }
+
+  std::string decoded;
+  for (uint64_t token : expected.get()) {
+    decoded += tokenizer_->decode(0, token).get();
+  }
+  EXPECT_EQ(decoded, text);
+}
+
+TEST_F(TiktokenExtensionTest, TokenizerEncodeLongInput) {
+  Error res = tokenizer_->load(modelPath_.c_str());
+  EXPECT_EQ(res, Error::Ok);
+  // Long enough to be encoded by several threads, if there are several cores.
+  std::string text;
+  for (int i = 0; i < 5000; i++) {
+    text += "hello world zyxwvut" + std::to_string(i) + "\n";
+  }
+  Result<std::vector<uint64_t>> out = tokenizer_->encode(text, 1, 0);
+  EXPECT_EQ(out.error(), Error::Ok);
+  EXPECT_EQ(out.get()[0], 128000);
+
+  std::string decoded;
+  for (size_t i = 1; i < out.get().size(); i++) {
+    decoded += tokenizer_->decode(0, out.get()[i]).get();
+  }
+  EXPECT_EQ(decoded, text);
+}
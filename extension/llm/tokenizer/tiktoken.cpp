@@ -28,8 +28,12 @@
 #include <executorch/extension/llm/tokenizer/base64.h>
 #include <executorch/extension/llm/tokenizer/tiktoken.h>
 #include <executorch/runtime/core/result.h>
+#include <algorithm>
 #include <fstream>
 #include <limits>
+#include <list>
+#include <mutex>
+#include <thread>
 
 using ::executorch::runtime::Error;
 using ::executorch::runtime::Result;
@@ -124,139 +128,175 @@ static Result<Decoder> _build_decoder(const Encoder& encoder) {
   return decoder;
 }
 
-static std::vector<uint64_t> _byte_pair_merge(
-    const std::string& piece,
-    const std::unordered_map<std::string, uint64_t>& ranks,
-    std::function<uint64_t(uint64_t, uint64_t)> func) {
-  // This is a vector of (start, rank).
-  // The rank is of the byte pair starting at position start.
-  // The rank of the last item in the vector is not a valid value.
-  std::vector<std::pair<uint64_t, uint64_t>> parts;
-  parts.reserve(piece.size() + 1);
-  for (auto idx = 0U; idx < piece.size() + 1; ++idx) {
-    parts.emplace_back(idx, _max_size());
+namespace {
+
+// Scratch space of _byte_pair_merge, reused across calls on the same thread.
+struct MergeScratch {
+  // For each part, indexed by its start: the start of the next and previous
+  // parts, and the rank of the pair it starts.
+  std::vector<uint32_t> next;
+  std::vector<uint32_t> prev;
+  std::vector<uint64_t> ranks;
+  // Min-heap of (rank, start) of pairs. Entries whose rank no longer matches
+  // `ranks` are stale and skipped.
+  std::vector<std::pair<uint64_t, uint32_t>> heap;
+};
+
+} // namespace
+
+static void _byte_pair_merge(
+    std::string_view piece,
+    const std::unordered_map<std::string_view, uint64_t>& ranks,
+    std::vector<uint64_t>& out) {
+  // Parts form a linked list over the piece, initially one part per byte.
+  // Pairs of adjacent parts are merged in the order of their rank, the
+  // leftmost pair first among equal ranks. Merging only updates the ranks of
+  // the pairs on either side, so n parts and m merges take O((n + m) log n)
+  // work, without allocating once the scratch space is large enough.
+  static thread_local MergeScratch scratch;
+  const auto n = static_cast<uint32_t>(piece.size());
+  auto& next = scratch.next;
+  auto& prev = scratch.prev;
+  auto& part_ranks = scratch.ranks;
+  auto& heap = scratch.heap;
+  next.resize(n + 1);
+  prev.resize(n + 1);
+  part_ranks.resize(n + 1);
+  heap.clear();
+  for (uint32_t i = 0; i <= n; ++i) {
+    next[i] = i + 1;
+    prev[i] = i - 1;
   }
 
-  auto get_rank = [&piece, &ranks](
-                      const std::vector<std::pair<uint64_t, uint64_t>>& parts,
-                      uint64_t start_idx,
-                      uint64_t skip) -> std::optional<uint64_t> {
-    if (start_idx + skip + 2 < parts.size()) {
-      auto s = parts[start_idx].first;
-      auto e = parts[start_idx + skip + 2].first;
-      auto key = piece.substr(s, e - s);
-      auto iter = ranks.find(key);
-      if (iter != ranks.end()) {
-        return iter->second;
-      }
+  auto get_rank = [&](uint32_t start) -> uint64_t {
+    const uint32_t mid = next[start];
+    if (mid >= n) {
+      return _max_size();
+    }
+    const uint32_t end = next[mid];
+    auto iter = ranks.find(piece.substr(start, end - start));
+    return iter != ranks.end() ? iter->second : _max_size();
+  };
+  auto update_rank = [&](uint32_t start) {
+    part_ranks[start] = get_rank(start);
+    if (part_ranks[start] != _max_size()) {
+      heap.emplace_back(part_ranks[start], start);
+      std::push_heap(heap.begin(), heap.end(), std::greater<>());
     }
-    return std::nullopt;
   };
 
-  // We look up the ranks once in the beginning and iteratively update
-  // them during each merge, which reduces the number of rank lookups.
-  for (auto i = 0U; i < parts.size() - 2; ++i) {
-    auto rank = get_rank(parts, i, 0);
-    if (rank) {
-      // usize::MAX is a sentinel value and cannot be a valid rank
-      ET_CHECK_MSG(*rank != _max_size(), "rank is too large");
-      parts[i].second = *rank;
+  // usize::MAX is a sentinel value and cannot be a valid rank
+  for (uint32_t i = 0; i < n; ++i) {
+    part_ranks[i] = get_rank(i);
+    if (part_ranks[i] != _max_size()) {
+      heap.emplace_back(part_ranks[i], i);
     }
   }
-
-  // If you have n parts and m merges, this does O(mn) work.
-  // We could do something with a heap and do O(m log n) work.
-  // It is important to consider that n is often small (<100), and as such
-  // the cache-locality benefits outweigh the algorithmic complexity downsides
-  // of the `parts` vector data structure above.
+  std::make_heap(heap.begin(), heap.end(), std::greater<>());
 
   // Note that we hash bytes, not token pairs. As long as we train BPE the way
   // we currently do, this is equivalent. An easy way to break this would be
   // to decouple merge priority from token index or to prevent specific token
   // merges.
-  while (true) {
-    if (parts.size() == 1) {
-      break;
-    }
-
-    // usize::MAX is a sentinel rank value allowing us to
-    // take the min more quickly
-    auto min_rank = std::make_pair<uint64_t, uint64_t>(_max_size(), 0);
-    for (auto i = 0U; i < parts.size() - 1; ++i) {
-      auto rank = parts[i].second;
-      if (rank < min_rank.first) {
-        min_rank.first = rank;
-        min_rank.second = i;
-      }
+  while (!heap.empty()) {
+    std::pop_heap(heap.begin(), heap.end(), std::greater<>());
+    const auto [rank, start] = heap.back();
+    heap.pop_back();
+    // A pair only ever grows, so its rank never returns to an earlier value.
+    if (part_ranks[start] != rank) {
+      continue;
     }
-
-    if (min_rank.first != _max_size()) {
-      auto i = min_rank.second;
-
-      // NOTE: We are about to remove parts[i + 1]. We do not do it
-      // yet because there are cache-locality benefits to updating
-      // parts[i] and parts[i-1] before removing, which could thrash
-      // the cache. Thus, we update the rank calculation by skipping over
-      // parts[i + 1], by invoking `get_rank!` with `skip = 1`.
-      auto rank = get_rank(parts, i, 1);
-      if (rank) {
-        parts[i].second = *rank;
-      } else {
-        parts[i].second = _max_size();
-      }
-      if (i > 0) {
-        rank = get_rank(parts, i - 1, 1);
-        if (rank) {
-          parts[i - 1].second = *rank;
-        } else {
-          parts[i - 1].second = _max_size();
-        }
-      }
-
-      parts.erase(parts.begin() + (i + 1));
-    } else {
-      break;
+    const uint32_t removed = next[start];
+    next[start] = next[removed];
+    prev[next[start]] = start;
+    part_ranks[removed] = _max_size();
+    update_rank(start);
+    if (start > 0) {
+      update_rank(prev[start]);
     }
   }
-  std::vector<uint64_t> out;
-  out.reserve(parts.size() - 1);
-  for (auto i = 0U; i < parts.size() - 1; ++i) {
-    auto s = parts[i].first;
-    auto e = parts[i + 1].first;
-    out.push_back(func(s, e));
+
+  for (uint32_t start = 0; start < n; start = next[start]) {
+    auto iter = ranks.find(piece.substr(start, next[start] - start));
+    // TODO: what if key does not exist? Should we return `unknown`?
+    out.push_back(iter != ranks.end() ? iter->second : 0);
   }
-  return out;
 }
 
-static std::vector<uint64_t> _byte_pair_encode(
-    const std::string& piece,
-    const Encoder& encoder) {
+static void _byte_pair_encode(
+    std::string_view piece,
+    const std::unordered_map<std::string_view, uint64_t>& encoder,
+    std::vector<uint64_t>& out) {
   if (piece.size() == 1) {
     auto iter = encoder.find(piece);
     if (iter != encoder.end()) {
-      return std::vector<uint64_t>({iter->second});
-    } else {
-      // TODO: is it possible?
-      return {};
+      out.push_back(iter->second);
     }
+    // TODO: is it possible not to find it?
+    return;
   }
 
-  return _byte_pair_merge(
-      piece, encoder, [&piece, &encoder](uint64_t start, uint64_t stop) {
-        std::string key = piece.substr(start, stop - start);
-        auto iter = encoder.find(key);
-        if (iter != encoder.end()) {
-          return iter->second;
-        } else {
-          // TODO: what if key does not exist? Should we return `unknown`?
-          // assert(false); // ??
-          return uint64_t(0);
-        }
-      });
+  _byte_pair_merge(piece, encoder, out);
 }
+
+// Pieces are only encoded in parallel when each thread gets at least this
+// many of them; below that, starting threads costs more than it saves.
+static constexpr size_t kMinPiecesPerThread = 1024;
+
 // ------------------------------Util end------------------------------------
 // -------------------------private method start-------------------------------
 
+// LRU cache of the tokens of pieces, shared by the threads encoding them.
+class Tiktoken::PieceCache {
+ public:
+  explicit PieceCache(size_t capacity) : capacity_(capacity) {
+    index_.reserve(capacity);
+  }
+
+  // Appends the tokens of piece to out and returns true if it is cached.
+  bool lookup(std::string_view piece, std::vector<uint64_t>& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = index_.find(piece);
+    if (iter == index_.end()) {
+      return false;
+    }
+    entries_.splice(entries_.begin(), entries_, iter->second);
+    const auto& tokens = iter->second->second;
+    out.insert(out.end(), tokens.begin(), tokens.end());
+    return true;
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    index_.clear();
+    entries_.clear();
+  }
+
+  void insert(std::string_view piece, const uint64_t* tokens, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index_.count(piece) > 0) {
+      return; // another thread got there first
+    }
+    if (entries_.size() == capacity_) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+    entries_.emplace_front(
+        std::string(piece), std::vector<uint64_t>(tokens, tokens + size));
+    // Keyed by a view of the string in the list node, which never moves.
+    index_.emplace(entries_.front().first, entries_.begin());
+  }
+
+ private:
+  using Entry = std::pair<std::string, std::vector<uint64_t>>;
+
+  const size_t capacity_;
+  std::mutex mutex_;
+  // Most recently used first.
+  std::list<Entry> entries_;
+  std::unordered_map<std::string_view, std::list<Entry>::iterator> index_;
+};
+
 template <typename T>
 std::pair<std::optional<std::string>, re2::StringPiece>
 Tiktoken::_split_with_allowed_special_token(
@@ -295,23 +335,76 @@ Tiktoken::_split_with_allowed_special_token(
   return std::make_pair(std::nullopt, input);
 }
 
+void Tiktoken::_encode_piece(
+    std::string_view piece,
+    std::vector<uint64_t>& ret) const {
+  auto iter = _encoder_lookup.find(piece);
+  if (iter != _encoder_lookup.end()) {
+    ret.push_back(iter->second);
+    return;
+  }
+  if (_piece_cache && _piece_cache->lookup(piece, ret)) {
+    return;
+  }
+  const size_t begin = ret.size();
+  _byte_pair_encode(piece, _encoder_lookup, ret);
+  if (_piece_cache) {
+    _piece_cache->insert(piece, ret.data() + begin, ret.size() - begin);
+  }
+}
+
 void Tiktoken::_encode(
     re2::StringPiece& input,
     std::vector<uint64_t>& ret,
     uint64_t& last_piece_token_len) const {
-  std::string piece;
   assert(_regex);
+  // Split the input first: the pieces are encoded independently, so long
+  // inputs can be encoded by several threads.
+  std::vector<std::string_view> pieces;
+  re2::StringPiece piece;
   while (re2::RE2::FindAndConsume(&input, *_regex, &piece)) {
-    auto iter = _encoder.find(piece);
-    if (iter != _encoder.end()) {
-      last_piece_token_len = 1;
-      ret.push_back(iter->second);
-      continue;
+    pieces.emplace_back(piece.data(), piece.size());
+  }
+  if (pieces.empty()) {
+    return;
+  }
+
+  const size_t num_threads = std::min<size_t>(
+      std::max(1u, std::thread::hardware_concurrency()),
+      pieces.size() / kMinPiecesPerThread);
+  if (num_threads <= 1) {
+    for (size_t i = 0; i + 1 < pieces.size(); ++i) {
+      _encode_piece(pieces[i], ret);
+    }
+  } else {
+    // Each thread encodes a contiguous range of all but the last piece.
+    const size_t num_pieces = pieces.size() - 1;
+    std::vector<std::vector<uint64_t>> results(num_threads);
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    auto encode_range = [&](size_t index) {
+      const size_t begin = num_pieces * index / num_threads;
+      const size_t end = num_pieces * (index + 1) / num_threads;
+      results[index].reserve(end - begin);
+      for (size_t i = begin; i < end; ++i) {
+        _encode_piece(pieces[i], results[index]);
+      }
+    };
+    for (size_t i = 1; i < num_threads; ++i) {
+      threads.emplace_back(encode_range, i);
+    }
+    encode_range(0);
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    for (const auto& result : results) {
+      ret.insert(ret.end(), result.begin(), result.end());
     }
-    auto tokens = _byte_pair_encode(piece, _encoder);
-    last_piece_token_len = tokens.size();
-    ret.insert(ret.end(), tokens.begin(), tokens.end());
   }
+
+  const size_t size_before_last_piece = ret.size();
+  _encode_piece(pieces.back(), ret);
+  last_piece_token_len = ret.size() - size_before_last_piece;
 }
 
 template <typename T>
@@ -364,11 +457,15 @@ Encoder Tiktoken::_build_special_token_encoder(ssize_t num_base_tokens) const {
 Tiktoken::Tiktoken(
     std::unique_ptr<std::vector<std::string>> special_tokens,
     size_t bos_token_index,
-    size_t eos_token_index)
+    size_t eos_token_index,
+    size_t piece_cache_size)
     : Tokenizer(),
       _special_tokens(std::move(special_tokens)),
       _bos_token_index(bos_token_index),
-      _eos_token_index(eos_token_index) {
+      _eos_token_index(eos_token_index),
+      _piece_cache(
+          piece_cache_size > 0 ? std::make_unique<PieceCache>(piece_cache_size)
+                               : nullptr) {
   ET_CHECK_MSG(
       _bos_token_index < _special_tokens->size(),
       "invalid bos_token_index %zu",
@@ -379,8 +476,18 @@ Tiktoken::Tiktoken(
       _eos_token_index);
 }
 
+Tiktoken::~Tiktoken() = default;
+
 Error Tiktoken::load(const std::string& path) {
   _encoder = ET_UNWRAP(_load_encoder(path));
+  _encoder_lookup.clear();
+  _encoder_lookup.reserve(_encoder.size());
+  for (const auto& [token, rank] : _encoder) {
+    _encoder_lookup.emplace(token, rank);
+  }
+  if (_piece_cache) {
+    _piece_cache->clear();
+  }
   _special_token_encoder = _build_special_token_encoder(_encoder.size());
 
   _decoder = ET_UNWRAP(_build_decoder(_encoder));
@@ -12,6 +12,7 @@
 #include <re2/re2.h>
 #include <memory>
 #include <optional>
+#include <string_view>
 #include <unordered_map>
 
 namespace executorch {
@@ -24,15 +25,23 @@ using Re2UPtr = std::unique_ptr<re2::RE2>;
 
 class Tiktoken : public Tokenizer {
  public:
+  /// The default number of pieces whose tokens are cached.
+  static constexpr size_t kDefaultPieceCacheSize = 4096;
+
   /**
    * @param[in] special_tokens List of special tokens including bos, eos;
    * @param[in] bos_token_index Index of the bos token in special_tokens;
-   * @param[in] eos_token_index Index of the eos token in special_tokens.
+   * @param[in] eos_token_index Index of the eos token in special_tokens;
+   * @param[in] piece_cache_size How many of the most recently used pieces
+   * that are not tokens themselves to keep the tokens of, so that they skip
+   * byte pair merging when seen again. Zero disables the cache.
    */
   explicit Tiktoken(
       std::unique_ptr<std::vector<std::string>> special_tokens,
       size_t bos_token_index,
-      size_t eos_token_index);
+      size_t eos_token_index,
+      size_t piece_cache_size = kDefaultPieceCacheSize);
+  ~Tiktoken() override;
 
   ::executorch::runtime::Error load(const std::string& tokenizer_path) override;
 
@@ -44,6 +53,8 @@ class Tiktoken : public Tokenizer {
       uint64_t token) const override;
 
  private:
+  class PieceCache;
+
   template <typename T>
   std::pair<std::optional<std::string>, re2::StringPiece>
   _split_with_allowed_special_token(
@@ -55,6 +66,9 @@ class Tiktoken : public Tokenizer {
       std::vector<uint64_t>& ret,
       uint64_t& last_piece_token_len) const;
 
+  void _encode_piece(std::string_view piece, std::vector<uint64_t>& ret)
+      const;
+
   template <typename T>
   std::pair<std::vector<uint64_t>, uint64_t> _encode_with_special_token(
       const std::string& text,
@@ -69,12 +83,17 @@ class Tiktoken : public Tokenizer {
   const std::string _pattern =
       R"((?i:'s|'t|'re|'ve|'m|'ll|'d)|[^\r\n\p{L}\p{N}]?\p{L}+|\p{N}{1,3}| ?[^\s\p{L}\p{N}]+[\r\n]*|\s*[\r\n]+|\s+)";
   Encoder _encoder;
+  // Same as _encoder, keyed by views of its keys, so that substrings can be
+  // looked up without copying them.
+  std::unordered_map<std::string_view, uint64_t> _encoder_lookup;
   Encoder _special_token_encoder;
   Decoder _decoder;
   Decoder _special_token_decoder;
 
   Re2UPtr _regex;
   Re2UPtr _special_token_regex;
+
+  std::unique_ptr<PieceCache> _piece_cache;
 };
 
 } // namespace llm
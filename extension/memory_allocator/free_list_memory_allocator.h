@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <executorch/runtime/core/memory_allocator.h>
+#include <executorch/runtime/platform/log.h>
+
+namespace executorch {
+namespace extension {
+
+/**
+ * Allocates memory from a caller-provided buffer, like MemoryAllocator, but
+ * also supports freeing individual allocations in any order.
+ *
+ * Allocations are rounded up to power-of-two size classes. Freed blocks go on
+ * a per-class free list and are reused by later allocations of the same
+ * class. When the untouched part of the buffer runs out, a free block of a
+ * larger class is split in half until it fits. Blocks are not coalesced
+ * again until reset().
+ *
+ * This is useful as a temp allocator for kernels whose scratch size varies
+ * from call to call, since the buffer only needs to hold the peak live set
+ * rather than the sum of every allocation between resets.
+ */
+class FreeListMemoryAllocator : public executorch::runtime::MemoryAllocator {
+ public:
+  /**
+   * Constructs a new allocator over the `size` bytes at `base_address`.
+   *
+   * @param[in] size The size in bytes of the buffer at `base_address`.
+   * @param[in] base_address The buffer to allocate from. Does not take
+   *     ownership of this buffer, so it must be valid for the lifetime of
+   *     the FreeListMemoryAllocator.
+   */
+  FreeListMemoryAllocator(uint32_t size, uint8_t* base_address)
+      : MemoryAllocator(size, base_address),
+        arena_begin_(alignPointer(base_address, kBlockAlignment)),
+        arena_end_(base_address + size),
+        cur_(arena_begin_),
+        free_lists_(),
+        used_size_(0),
+        peak_used_size_(0) {
+    if (arena_begin_ > arena_end_) {
+      // Too small to hold even the alignment padding.
+      arena_begin_ = arena_end_;
+      cur_ = arena_end_;
+    }
+  }
+
+  /**
+   * Allocates `size` bytes of memory.
+   *
+   * @param[in] size Number of bytes to allocate.
+   * @param[in] alignment Minimum alignment for the returned pointer. Must be a
+   *     power of 2.
+   *
+   * @returns Aligned pointer to the allocated memory on success.
+   * @retval nullptr Not enough memory, or `alignment` was not a power of 2.
+   */
+  void* allocate(size_t size, size_t alignment = kDefaultAlignment) override {
+    if (!isPowerOf2(alignment)) {
+      ET_LOG(Error, "Alignment %zu is not a power of 2", alignment);
+      return nullptr;
+    }
+
+    // The payload is preceded by a header, and may need to be pushed further
+    // into the block to satisfy the alignment.
+    const size_t padding =
+        alignment > sizeof(BlockHeader) ? alignment : sizeof(BlockHeader);
+    size_t size_class = size_class_for(size + padding);
+    if (size_class >= kNumSizeClasses) {
+      ET_LOG(Error, "Allocation of %zu bytes is too large", size);
+      return nullptr;
+    }
+
+    uint8_t* block = take_block(size_class);
+    if (block == nullptr) {
+      ET_LOG(
+          Error,
+          "Memory allocation failed: %zuB requested, %zuB in use",
+          size,
+          used_size_);
+      return nullptr;
+    }
+    EXECUTORCH_TRACK_ALLOCATION(prof_id(), block_size(size_class));
+
+    used_size_ += block_size(size_class);
+    if (used_size_ > peak_used_size_) {
+      peak_used_size_ = used_size_;
+    }
+
+    uint8_t* payload = alignPointer(block + sizeof(BlockHeader), alignment);
+    BlockHeader* header = reinterpret_cast<BlockHeader*>(payload) - 1;
+    header->size_class = static_cast<uint32_t>(size_class);
+    header->payload_offset = static_cast<uint32_t>(payload - block);
+    return payload;
+  }
+
+  /**
+   * Returns an allocation to the allocator so that its memory can be reused.
+   * Allocations may be freed in any order. Does nothing if `ptr` is null.
+   *
+   * @param[in] ptr A pointer returned by allocate() on this allocator, which
+   *     has not been freed since, and which was returned since the most recent
+   *     reset().
+   */
+  void deallocate(void* ptr) override {
+    if (ptr == nullptr) {
+      return;
+    }
+    uint8_t* payload = static_cast<uint8_t*>(ptr);
+    if (payload < arena_begin_ || payload >= cur_) {
+      ET_LOG(Error, "Pointer %p was not allocated by this allocator", ptr);
+      return;
+    }
+    const BlockHeader* header = reinterpret_cast<const BlockHeader*>(ptr) - 1;
+    const size_t size_class = header->size_class;
+    uint8_t* block = payload - header->payload_offset;
+    used_size_ -= block_size(size_class);
+    push_block(size_class, block);
+  }
+
+  /**
+   * Frees all allocations at once, returning the whole buffer to the
+   * untouched state. Does not reset peak_used_size().
+   */
+  void reset() override {
+    MemoryAllocator::reset();
+    cur_ = arena_begin_;
+    for (size_t i = 0; i < kNumSizeClasses; ++i) {
+      free_lists_[i] = nullptr;
+    }
+    used_size_ = 0;
+  }
+
+  /// Returns the number of bytes in blocks that are currently allocated.
+  size_t used_size() const {
+    return used_size_;
+  }
+
+  /// Returns the largest value of used_size() since construction.
+  size_t peak_used_size() const {
+    return peak_used_size_;
+  }
+
+  /**
+   * Returns the number of bytes of the buffer that have ever been carved into
+   * blocks since the last reset(). This is the high-water mark of the buffer
+   * itself, and is at least peak_used_size() rounded to block boundaries.
+   */
+  size_t carved_size() const {
+    return static_cast<size_t>(cur_ - arena_begin_);
+  }
+
+ private:
+  /// Stored immediately before every returned pointer.
+  struct BlockHeader {
+    uint32_t size_class;
+    /// Distance from the start of the block to the returned pointer.
+    uint32_t payload_offset;
+  };
+
+  /// Overlays the start of a block while it is on a free list.
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  /// Alignment of every block. Blocks are carved at multiples of this.
+  static constexpr size_t kBlockAlignment = alignof(std::max_align_t);
+  /// Size of the smallest class. Must hold a header plus a small payload.
+  static constexpr size_t kMinBlockSize = 32;
+  static constexpr size_t kNumSizeClasses = 27; // Up to 2 GiB blocks.
+
+  static_assert(
+      kMinBlockSize % kBlockAlignment == 0,
+      "Blocks must stay aligned when carved back to back");
+  static_assert(
+      kMinBlockSize >= sizeof(FreeBlock) &&
+          kMinBlockSize > sizeof(BlockHeader),
+      "Smallest block must hold the bookkeeping structs");
+
+  static constexpr size_t block_size(size_t size_class) {
+    return kMinBlockSize << size_class;
+  }
+
+  static size_t size_class_for(size_t size) {
+    size_t size_class = 0;
+    while (size_class < kNumSizeClasses && block_size(size_class) < size) {
+      size_class++;
+    }
+    return size_class;
+  }
+
+  void push_block(size_t size_class, uint8_t* block) {
+    FreeBlock* free_block = reinterpret_cast<FreeBlock*>(block);
+    free_block->next = free_lists_[size_class];
+    free_lists_[size_class] = free_block;
+  }
+
+  uint8_t* pop_block(size_t size_class) {
+    FreeBlock* free_block = free_lists_[size_class];
+    if (free_block == nullptr) {
+      return nullptr;
+    }
+    free_lists_[size_class] = free_block->next;
+    return reinterpret_cast<uint8_t*>(free_block);
+  }
+
+  /// Returns an unused block of the given class, or nullptr if none is left.
+  uint8_t* take_block(size_t size_class) {
+    // 1. Reuse a freed block of the same class.
+    uint8_t* block = pop_block(size_class);
+    if (block != nullptr) {
+      return block;
+    }
+
+    // 2. Carve a new block from the untouched part of the buffer.
+    const size_t size = block_size(size_class);
+    if (static_cast<size_t>(arena_end_ - cur_) >= size) {
+      block = cur_;
+      cur_ += size;
+      return block;
+    }
+
+    // 3. Split the smallest larger free block, keeping the upper halves.
+    for (size_t larger = size_class + 1; larger < kNumSizeClasses; ++larger) {
+      block = pop_block(larger);
+      if (block == nullptr) {
+        continue;
+      }
+      while (larger > size_class) {
+        larger--;
+        push_block(larger, block + block_size(larger));
+      }
+      return block;
+    }
+    return nullptr;
+  }
+
+  uint8_t* arena_begin_;
+  uint8_t* const arena_end_;
+  /// Start of the part of the buffer that has never been handed out.
+  uint8_t* cur_;
+  FreeBlock* free_lists_[kNumSizeClasses];
+  size_t used_size_;
+  size_t peak_used_size_;
+};
+
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/memory_allocator/free_list_memory_allocator.h>
+#include <executorch/runtime/kernel/kernel_runtime_context.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using executorch::extension::FreeListMemoryAllocator;
+using executorch::runtime::KernelRuntimeContext;
+using executorch::runtime::MemoryAllocator;
+
+class FreeListMemoryAllocatorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // Since these tests cause ET_LOG to be called, the PAL must be initialized
+    // first.
+    executorch::runtime::runtime_init();
+  }
+};
+
+namespace {
+bool is_aligned(const void* ptr, size_t alignment) {
+  uintptr_t addr = reinterpret_cast<uintptr_t>(ptr);
+  return addr % alignment == 0;
+}
+} // namespace
+
+TEST_F(FreeListMemoryAllocatorTest, AllocationsAreAlignedAndDisjoint) {
+  std::vector<uint8_t> buffer(4096);
+  FreeListMemoryAllocator allocator(buffer.size(), buffer.data());
+
+  std::vector<std::pair<uint8_t*, size_t>> allocations;
+  for (size_t alignment : {1, 2, 4, 8, 16, 32, 64, 128}) {
+    size_t size = 3 * alignment + 1;
+    auto* p = static_cast<uint8_t*>(allocator.allocate(size, alignment));
+    ASSERT_NE(p, nullptr);
+    EXPECT_TRUE(is_aligned(p, alignment));
+    EXPECT_GE(p, buffer.data());
+    EXPECT_LE(p + size, buffer.data() + buffer.size());
+    memset(p, static_cast<int>(alignment), size);
+    allocations.emplace_back(p, size);
+  }
+
+  // Nothing stomped on anything else.
+  for (const auto& allocation : allocations) {
+    uint8_t expected = allocation.first[0];
+    for (size_t i = 0; i < allocation.second; ++i) {
+      EXPECT_EQ(allocation.first[i], expected);
+    }
+  }
+}
+
+TEST_F(FreeListMemoryAllocatorTest, InvalidAlignmentFails) {
+  std::vector<uint8_t> buffer(1024);
+  FreeListMemoryAllocator allocator(buffer.size(), buffer.data());
+  EXPECT_EQ(allocator.allocate(16, 3), nullptr);
+  EXPECT_EQ(allocator.allocate(16, 0), nullptr);
+}
+
+TEST_F(FreeListMemoryAllocatorTest, FreedBlocksAreReused) {
+  std::vector<uint8_t> buffer(1024);
+  FreeListMemoryAllocator allocator(buffer.size(), buffer.data());
+
+  void* a = allocator.allocate(100);
+  ASSERT_NE(a, nullptr);
+  size_t carved = allocator.carved_size();
+  allocator.deallocate(a);
+  EXPECT_EQ(allocator.used_size(), 0);
+
+  // Same size class; should come back without touching new memory.
+  void* b = allocator.allocate(90);
+  EXPECT_EQ(b, a);
+  EXPECT_EQ(allocator.carved_size(), carved);
+}
+
+TEST_F(FreeListMemoryAllocatorTest, OutOfOrderFrees) {
+  std::vector<uint8_t> buffer(1024);
+  FreeListMemoryAllocator allocator(buffer.size(), buffer.data());
+
+  // Repeatedly allocate and free in a different order. A bump allocator would
+  // run out of space after a few iterations.
+  for (int i = 0; i < 100; ++i) {
+    void* a = allocator.allocate(100);
+    void* b = allocator.allocate(200);
+    void* c = allocator.allocate(50);
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+    ASSERT_NE(c, nullptr);
+    allocator.deallocate(b);
+    allocator.deallocate(a);
+    allocator.deallocate(c);
+  }
+  EXPECT_EQ(allocator.used_size(), 0);
+  EXPECT_LE(allocator.carved_size(), buffer.size());
+}
+
+TEST_F(FreeListMemoryAllocatorTest, SplitsLargerFreeBlocks) {
+  std::vector<uint8_t> buffer(1024);
+  FreeListMemoryAllocator allocator(buffer.size(), buffer.data());
+
+  // Use up the whole buffer with one block, then free it.
+  void* big = allocator.allocate(500);
+  ASSERT_NE(big, nullptr);
+  allocator.deallocate(big);
+
+  // Smaller allocations are served by splitting the freed block.
+  void* small_1 = allocator.allocate(10);
+  void* small_2 = allocator.allocate(10);
+  EXPECT_NE(small_1, nullptr);
+  EXPECT_NE(small_2, nullptr);
+  EXPECT_NE(small_1, small_2);
+}
+
+TEST_F(FreeListMemoryAllocatorTest, FailsWhenFull) {
+  std::vector<uint8_t> buffer(256);
+  FreeListMemoryAllocator allocator(buffer.size(), buffer.data());
+
+  EXPECT_EQ(allocator.allocate(1024), nullptr);
+
+  std::vector<void*> allocations;
+  void* p;
+  while ((p = allocator.allocate(8)) != nullptr) {
+    allocations.push_back(p);
+  }
+  EXPECT_GT(allocations.size(), 0);
+
+  // Freeing one makes room for one more.
+  allocator.deallocate(allocations.back());
+  EXPECT_NE(allocator.allocate(8), nullptr);
+}
+
+TEST_F(FreeListMemoryAllocatorTest, TracksPeakUsage) {
+  std::vector<uint8_t> buffer(4096);
+  FreeListMemoryAllocator allocator(buffer.size(), buffer.data());
+
+  void* a = allocator.allocate(100);
+  void* b = allocator.allocate(100);
+  size_t two_live = allocator.used_size();
+  EXPECT_GT(two_live, 0);
+  allocator.deallocate(a);
+  allocator.deallocate(b);
+  EXPECT_EQ(allocator.used_size(), 0);
+  EXPECT_EQ(allocator.peak_used_size(), two_live);
+
+  // Reset forgets the allocations but not the peak.
+  allocator.allocate(100);
+  allocator.reset();
+  EXPECT_EQ(allocator.used_size(), 0);
+  EXPECT_EQ(allocator.carved_size(), 0);
+  EXPECT_EQ(allocator.peak_used_size(), two_live);
+}
+
+TEST_F(FreeListMemoryAllocatorTest, FreeIgnoresForeignPointers) {
+  std::vector<uint8_t> buffer(1024);
+  FreeListMemoryAllocator allocator(buffer.size(), buffer.data());
+
+  allocator.deallocate(nullptr);
+  int not_ours = 0;
+  allocator.deallocate(&not_ours);
+  EXPECT_EQ(allocator.used_size(), 0);
+}
+
+TEST_F(FreeListMemoryAllocatorTest, FreeThroughBaseClass) {
+  std::vector<uint8_t> buffer(1024);
+  FreeListMemoryAllocator allocator(buffer.size(), buffer.data());
+  MemoryAllocator* base = &allocator;
+
+  void* a = base->allocate(100);
+  ASSERT_NE(a, nullptr);
+  size_t carved = allocator.carved_size();
+  base->deallocate(a);
+  EXPECT_EQ(allocator.used_size(), 0);
+
+  void* b = base->allocate(100);
+  EXPECT_EQ(b, a);
+  EXPECT_EQ(allocator.carved_size(), carved);
+}
+
+TEST_F(FreeListMemoryAllocatorTest, FreeTempThroughKernelRuntimeContext) {
+  std::vector<uint8_t> buffer(1024);
+  FreeListMemoryAllocator allocator(buffer.size(), buffer.data());
+  KernelRuntimeContext context(/*event_tracer=*/nullptr, &allocator);
+
+  // Each iteration needs 512 bytes of the 1024 byte buffer, so it only fits
+  // repeatedly if the temp memory is returned.
+  for (int i = 0; i < 8; ++i) {
+    auto temp = context.allocate_temp(400);
+    ASSERT_TRUE(temp.ok());
+    context.free_temp(temp.get());
+  }
+  EXPECT_EQ(allocator.used_size(), 0);
+  EXPECT_EQ(allocator.peak_used_size(), 512);
+}
+
+TEST_F(FreeListMemoryAllocatorTest, BaseClassFreeIsANoOp) {
+  std::vector<uint8_t> buffer(256);
+  MemoryAllocator allocator(buffer.size(), buffer.data());
+  KernelRuntimeContext context(/*event_tracer=*/nullptr, &allocator);
+
+  auto temp = context.allocate_temp(64);
+  ASSERT_TRUE(temp.ok());
+  context.free_temp(temp.get());
+  // The bump allocator only reclaims memory on reset().
+  void* next = allocator.allocate(64);
+  EXPECT_NE(next, temp.get());
+
+  // Without a temp allocator, freeing does nothing.
+  KernelRuntimeContext no_allocator_context;
+  no_allocator_context.free_temp(nullptr);
+}
@@ -15,3 +15,14 @@ def define_common_targets():
             "//executorch/extension/memory_allocator:malloc_memory_allocator",
         ],
     )
+
+    runtime.cxx_test(
+        name = "free_list_memory_allocator_test",
+        srcs = [
+            "free_list_memory_allocator_test.cpp",
+        ],
+        deps = [
+            "//executorch/extension/memory_allocator:free_list_memory_allocator",
+            "//executorch/runtime/kernel:kernel_runtime_context",
+        ],
+    )
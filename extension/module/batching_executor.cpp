@@ -0,0 +1,350 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/module/batching_executor.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+namespace executorch {
+namespace extension {
+
+namespace {
+
+bool is_contiguous(const exec_aten::Tensor& tensor) {
+  const auto sizes = tensor.sizes();
+  const auto strides = tensor.strides();
+  int64_t expected_stride = 1;
+  for (ssize_t i = tensor.dim() - 1; i >= 0; --i) {
+    if (sizes[i] != 1 && strides[i] != expected_stride) {
+      return false;
+    }
+    expected_stride *= sizes[i];
+  }
+  return true;
+}
+
+/// Returns the batch size shared by all inputs.
+runtime::Result<size_t> batch_size(const std::vector<runtime::EValue>& inputs) {
+  ET_CHECK_OR_RETURN_ERROR(!inputs.empty(), InvalidArgument, "No inputs");
+  size_t rows = 0;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    ET_CHECK_OR_RETURN_ERROR(
+        inputs[i].isTensor(), InvalidArgument, "Input %zu is not a tensor", i);
+    const auto& tensor = inputs[i].toTensor();
+    ET_CHECK_OR_RETURN_ERROR(
+        tensor.dim() > 0 && tensor.size(0) > 0,
+        InvalidArgument,
+        "Input %zu has no batch dimension",
+        i);
+    ET_CHECK_OR_RETURN_ERROR(
+        is_contiguous(tensor),
+        InvalidArgument,
+        "Input %zu is not contiguous",
+        i);
+    if (i == 0) {
+      rows = tensor.size(0);
+    }
+    ET_CHECK_OR_RETURN_ERROR(
+        static_cast<size_t>(tensor.size(0)) == rows,
+        InvalidArgument,
+        "Input %zu has batch size %zu, expected %zu",
+        i,
+        static_cast<size_t>(tensor.size(0)),
+        rows);
+  }
+  return rows;
+}
+
+/// Whether the inputs only differ in their batch size.
+bool can_batch(
+    const std::vector<runtime::EValue>& a,
+    const std::vector<runtime::EValue>& b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); ++i) {
+    const auto& x = a[i].toTensor();
+    const auto& y = b[i].toTensor();
+    if (x.scalar_type() != y.scalar_type() || x.dim() != y.dim()) {
+      return false;
+    }
+    for (ssize_t d = 1; d < x.dim(); ++d) {
+      if (x.size(d) != y.size(d)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/// Copies `rows` rows of `tensor`, starting at `first_row`, into a new tensor.
+TensorPtr copy_rows(
+    const exec_aten::Tensor& tensor,
+    size_t first_row,
+    size_t rows,
+    size_t row_bytes) {
+  std::vector<exec_aten::SizesType> sizes(
+      tensor.sizes().begin(), tensor.sizes().end());
+  sizes[0] = rows;
+  std::vector<uint8_t> data(rows * row_bytes);
+  std::memcpy(
+      data.data(),
+      static_cast<const uint8_t*>(tensor.const_data_ptr()) +
+          first_row * row_bytes,
+      data.size());
+  const auto data_ptr = data.data();
+  return make_tensor_ptr(
+      tensor.scalar_type(),
+      std::move(sizes),
+      data_ptr,
+      {},
+      {},
+      exec_aten::TensorShapeDynamism::STATIC,
+      [data = std::move(data)](void*) {});
+}
+
+} // namespace
+
+BatchingExecutor::BatchingExecutor(
+    Module& module,
+    std::string method_name,
+    Config config)
+    : module_(module),
+      method_name_(std::move(method_name)),
+      config_(config),
+      thread_(&BatchingExecutor::run, this) {}
+
+BatchingExecutor::~BatchingExecutor() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  request_queued_.notify_one();
+  thread_.join();
+}
+
+void BatchingExecutor::submit(
+    std::vector<runtime::EValue> inputs,
+    Callback callback) {
+  auto rows = batch_size(inputs);
+  if (!rows.ok()) {
+    callback(rows.error());
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(Request{
+        std::move(inputs),
+        *rows,
+        std::move(callback),
+        std::chrono::steady_clock::now()});
+  }
+  request_queued_.notify_one();
+}
+
+std::future<runtime::Result<BatchingExecutor::Outputs>> BatchingExecutor::
+    submit(std::vector<runtime::EValue> inputs) {
+  auto promise = std::make_shared<std::promise<runtime::Result<Outputs>>>();
+  auto future = promise->get_future();
+  submit(std::move(inputs), [promise](runtime::Result<Outputs> outputs) {
+    promise->set_value(std::move(outputs));
+  });
+  return future;
+}
+
+size_t BatchingExecutor::num_executions() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_executions_;
+}
+
+runtime::Error BatchingExecutor::load_batch_limit() {
+  const auto meta = module_.method_meta(method_name_);
+  if (!meta.ok()) {
+    return meta.error();
+  }
+  size_t limit = std::max<size_t>(config_.max_batch_size, 1);
+  for (size_t i = 0; i < meta->num_inputs(); ++i) {
+    const auto tag = meta->input_tag(i);
+    if (!tag.ok() || *tag != runtime::Tag::Tensor) {
+      continue;
+    }
+    const auto info = meta->input_tensor_meta(i);
+    if (!info.ok()) {
+      return info.error();
+    }
+    // For inputs with a dynamic shape, the serialized sizes are the upper
+    // bounds.
+    if (info->sizes().size() > 0) {
+      limit = std::min<size_t>(limit, std::max(info->sizes()[0], 1));
+    }
+  }
+  max_rows_ = limit;
+  return runtime::Error::Ok;
+}
+
+void BatchingExecutor::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    request_queued_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      return;
+    }
+    if (max_rows_ == 0) {
+      lock.unlock();
+      const auto error = load_batch_limit();
+      lock.lock();
+      if (error != runtime::Error::Ok) {
+        // Fail everything queued so far; later requests try again.
+        std::deque<Request> failed;
+        failed.swap(queue_);
+        lock.unlock();
+        for (auto& request : failed) {
+          request.callback(error);
+        }
+        lock.lock();
+        continue;
+      }
+    }
+    // Only this thread removes requests, so the oldest one stays put.
+    request_queued_.wait_until(
+        lock, queue_.front().queued_at + config_.max_delay, [this]() {
+          return stopping_ || batch_is_full();
+        });
+    auto batch = take_batch();
+    lock.unlock();
+    execute(batch);
+    lock.lock();
+  }
+}
+
+bool BatchingExecutor::batch_is_full() const {
+  const auto& first = queue_.front();
+  size_t rows = 0;
+  for (const auto& request : queue_) {
+    if (!can_batch(first.inputs, request.inputs)) {
+      // Requests are batched in order, so nothing after this one can join.
+      return true;
+    }
+    rows += request.rows;
+    if (rows >= max_rows_) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<BatchingExecutor::Request> BatchingExecutor::take_batch() {
+  std::vector<Request> batch;
+  size_t rows = queue_.front().rows;
+  batch.push_back(std::move(queue_.front()));
+  queue_.pop_front();
+  while (!queue_.empty() && rows + queue_.front().rows <= max_rows_ &&
+         can_batch(batch.front().inputs, queue_.front().inputs)) {
+    rows += queue_.front().rows;
+    batch.push_back(std::move(queue_.front()));
+    queue_.pop_front();
+  }
+  return batch;
+}
+
+void BatchingExecutor::execute(std::vector<Request>& batch) {
+  auto outputs = execute_batch(batch);
+  if (!outputs.ok()) {
+    for (auto& request : batch) {
+      request.callback(outputs.error());
+    }
+    return;
+  }
+  for (size_t i = 0; i < batch.size(); ++i) {
+    batch[i].callback(std::move(outputs.get()[i]));
+  }
+}
+
+runtime::Result<std::vector<BatchingExecutor::Outputs>>
+BatchingExecutor::execute_batch(const std::vector<Request>& batch) {
+  size_t rows = 0;
+  for (const auto& request : batch) {
+    rows += request.rows;
+  }
+  // A single request larger than the limit is passed through unchanged, and
+  // left to the method to reject.
+  const size_t batch_rows =
+      config_.pad_to_max_batch_size ? std::max(rows, max_rows_) : rows;
+
+  std::vector<runtime::EValue> inputs;
+  std::vector<TensorPtr> batched_inputs;
+  if (batch.size() == 1 && batch_rows == rows) {
+    inputs = batch.front().inputs;
+  } else {
+    const auto& first = batch.front();
+    for (size_t i = 0; i < first.inputs.size(); ++i) {
+      const auto& tensor = first.inputs[i].toTensor();
+      const size_t row_bytes = tensor.nbytes() / first.rows;
+      std::vector<exec_aten::SizesType> sizes(
+          tensor.sizes().begin(), tensor.sizes().end());
+      sizes[0] = batch_rows;
+      // Zero-initialized, so that padding rows are zeros.
+      std::vector<uint8_t> data(batch_rows * row_bytes);
+      uint8_t* dst = data.data();
+      for (const auto& request : batch) {
+        const size_t size = request.rows * row_bytes;
+        std::memcpy(dst, request.inputs[i].toTensor().const_data_ptr(), size);
+        dst += size;
+      }
+      const auto data_ptr = data.data();
+      batched_inputs.push_back(make_tensor_ptr(
+          tensor.scalar_type(),
+          std::move(sizes),
+          data_ptr,
+          {},
+          {},
+          exec_aten::TensorShapeDynamism::STATIC,
+          [data = std::move(data)](void*) {}));
+      inputs.emplace_back(*batched_inputs.back());
+    }
+  }
+
+  auto result = module_.execute(method_name_, inputs);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    num_executions_++;
+  }
+  if (!result.ok()) {
+    return result.error();
+  }
+
+  // The outputs live in the method's memory, so copy each request's rows out
+  // before the next execution overwrites them.
+  std::vector<Outputs> outputs(batch.size());
+  for (size_t i = 0; i < result->size(); ++i) {
+    const auto& output = result->at(i);
+    ET_CHECK_OR_RETURN_ERROR(
+        output.isTensor(), NotSupported, "Output %zu is not a tensor", i);
+    const auto& tensor = output.toTensor();
+    ET_CHECK_OR_RETURN_ERROR(
+        tensor.dim() > 0 &&
+            static_cast<size_t>(tensor.size(0)) == batch_rows,
+        NotSupported,
+        "Output %zu has no batch dimension of size %zu",
+        i,
+        batch_rows);
+    const size_t row_bytes = tensor.nbytes() / batch_rows;
+    size_t first_row = 0;
+    for (size_t j = 0; j < batch.size(); ++j) {
+      outputs[j].push_back(
+          copy_rows(tensor, first_row, batch[j].rows, row_bytes));
+      first_row += batch[j].rows;
+    }
+  }
+  return outputs;
+}
+
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <executorch/extension/module/module.h>
+#include <executorch/extension/tensor/tensor_ptr.h>
+
+namespace executorch {
+namespace extension {
+
+/**
+ * Coalesces concurrent requests to one method of a Module into batched
+ * executions.
+ *
+ * Every input of a request must be a contiguous tensor whose first dimension
+ * is the batch dimension, with the same batch size across inputs. Queued
+ * requests whose inputs agree in dtype and non-batch sizes are concatenated
+ * along the batch dimension, executed once, and every output is split back
+ * along its first dimension.
+ *
+ * A batch is executed once it reaches `max_batch_size` rows, or once the
+ * oldest queued request has waited `max_delay`. The batch size is also capped
+ * by the method's upper bound for the batch dimension of each input, as
+ * recorded in its MethodMeta.
+ *
+ * The executor runs the Module on its own thread, so the Module must not be
+ * used by anything else while the executor exists.
+ *
+ * Example:
+ * @code
+ *   Module module("classifier.pte");
+ *   BatchingExecutor::Config config;
+ *   config.max_batch_size = 16;
+ *   BatchingExecutor batcher(module, "forward", config);
+ *   // On any thread:
+ *   auto outputs = batcher.submit({input}).get();
+ * @endcode
+ */
+class BatchingExecutor final {
+ public:
+  struct Config {
+    /// The largest number of rows to execute at once.
+    size_t max_batch_size = 8;
+    /// How long the oldest queued request may wait for others to join it.
+    std::chrono::microseconds max_delay{1000};
+    /**
+     * Pad every batch with zero rows up to the maximum batch size. Needed
+     * for methods exported with a static batch dimension, which only accept
+     * inputs of exactly that size.
+     */
+    bool pad_to_max_batch_size = false;
+  };
+
+  /// The outputs of one request, owning their data.
+  using Outputs = std::vector<TensorPtr>;
+  using Callback = std::function<void(runtime::Result<Outputs>)>;
+
+  /**
+   * Starts an executor for a method.
+   *
+   * @param[in] module The Module to execute. Must outlive the executor.
+   * @param[in] method_name The method to execute.
+   * @param[in] config How to form batches.
+   */
+  BatchingExecutor(Module& module, std::string method_name, Config config);
+  BatchingExecutor(Module& module, std::string method_name)
+      : BatchingExecutor(module, std::move(method_name), Config()) {}
+
+  /// Executes the requests still queued, then stops.
+  ~BatchingExecutor();
+
+  BatchingExecutor(const BatchingExecutor&) = delete;
+  BatchingExecutor& operator=(const BatchingExecutor&) = delete;
+  BatchingExecutor(BatchingExecutor&&) = delete;
+  BatchingExecutor& operator=(BatchingExecutor&&) = delete;
+
+  /**
+   * Queues a request. Thread-safe.
+   *
+   * @param[in] inputs The method inputs. The tensor data is not copied, so it
+   *     must stay valid until the callback runs.
+   * @param[in] callback Called on the executor thread with the request's
+   *     outputs, or with an error if the execution failed. Invalid requests
+   *     are rejected by calling it before submit() returns.
+   */
+  void submit(std::vector<runtime::EValue> inputs, Callback callback);
+
+  /**
+   * Queues a request. Thread-safe.
+   *
+   * @param[in] inputs The method inputs. The tensor data is not copied, so it
+   *     must stay valid until the future is ready.
+   *
+   * @returns A future for the request's outputs.
+   */
+  std::future<runtime::Result<Outputs>> submit(
+      std::vector<runtime::EValue> inputs);
+
+  /// Returns the number of times the method has been executed so far.
+  size_t num_executions() const;
+
+ private:
+  struct Request {
+    std::vector<runtime::EValue> inputs;
+    size_t rows;
+    Callback callback;
+    std::chrono::steady_clock::time_point queued_at;
+  };
+
+  void run();
+  bool batch_is_full() const;
+  std::vector<Request> take_batch();
+  void execute(std::vector<Request>& batch);
+  runtime::Result<std::vector<Outputs>> execute_batch(
+      const std::vector<Request>& batch);
+  runtime::Error load_batch_limit();
+
+  Module& module_;
+  const std::string method_name_;
+  const Config config_;
+  // The batch size limit after applying the method's upper bounds. Only
+  // touched by the executor thread.
+  size_t max_rows_ = 0;
+
+  mutable std::mutex mutex_;
+  std::condition_variable request_queued_;
+  std::deque<Request> queue_;
+  size_t num_executions_ = 0;
+  bool stopping_ = false;
+
+  std::thread thread_;
+};
+
+} // namespace extension
+} // namespace executorch
@@ -8,9 +8,13 @@
 
 #include <executorch/extension/module/module.h>
 
+#include <algorithm>
+
 #include <executorch/extension/data_loader/file_data_loader.h>
 #include <executorch/extension/data_loader/mmap_data_loader.h>
+#include <executorch/extension/data_loader/prefetching_data_loader.h>
 #include <executorch/extension/memory_allocator/malloc_memory_allocator.h>
+#include <executorch/extension/tensor/tensor_ptr.h>
 #include <executorch/runtime/platform/runtime.h>
 
 /**
@@ -35,16 +39,47 @@
 
 namespace executorch {
 namespace extension {
+namespace {
+
+/**
+ * Copies the data of a tensor into a new one that owns it.
+ */
+TensorPtr copy_tensor(const exec_aten::Tensor& tensor) {
+  const auto* begin = static_cast<const uint8_t*>(tensor.const_data_ptr());
+  auto data =
+      std::make_shared<std::vector<uint8_t>>(begin, begin + tensor.nbytes());
+  std::vector<exec_aten::StridesType> strides(
+      tensor.strides().begin(), tensor.strides().end());
+#ifndef USE_ATEN_LIB
+  std::vector<exec_aten::DimOrderType> dim_order(
+      tensor.dim_order().begin(), tensor.dim_order().end());
+#else
+  std::vector<exec_aten::DimOrderType> dim_order;
+#endif // USE_ATEN_LIB
+  return make_tensor_ptr(
+      tensor.scalar_type(),
+      std::vector<exec_aten::SizesType>(
+          tensor.sizes().begin(), tensor.sizes().end()),
+      data->data(),
+      std::move(dim_order),
+      std::move(strides),
+      exec_aten::TensorShapeDynamism::STATIC,
+      [data](void*) {});
+}
+
+} // namespace
 
 Module::Module(
     const std::string& file_path,
     const LoadMode load_mode,
-    std::unique_ptr<runtime::EventTracer> event_tracer)
+    std::unique_ptr<runtime::EventTracer> event_tracer,
+    const bool share_memory_arenas)
     : file_path_(file_path),
       load_mode_(load_mode),
       memory_allocator_(std::make_unique<MallocMemoryAllocator>()),
       temp_allocator_(std::make_unique<MallocMemoryAllocator>()),
-      event_tracer_(std::move(event_tracer)) {
+      event_tracer_(std::move(event_tracer)),
+      share_memory_arenas_(share_memory_arenas) {
   runtime::runtime_init();
 }
 
@@ -52,7 +87,8 @@ Module::Module(
     std::unique_ptr<runtime::DataLoader> data_loader,
     std::unique_ptr<runtime::MemoryAllocator> memory_allocator,
     std::unique_ptr<runtime::MemoryAllocator> temp_allocator,
-    std::unique_ptr<runtime::EventTracer> event_tracer)
+    std::unique_ptr<runtime::EventTracer> event_tracer,
+    const bool share_memory_arenas)
     : data_loader_(std::move(data_loader)),
       memory_allocator_(
           memory_allocator ? std::move(memory_allocator)
@@ -60,7 +96,8 @@ Module::Module(
       temp_allocator_(
           temp_allocator ? std::move(temp_allocator)
                          : std::make_unique<MallocMemoryAllocator>()),
-      event_tracer_(std::move(event_tracer)) {
+      event_tracer_(std::move(event_tracer)),
+      share_memory_arenas_(share_memory_arenas) {
   runtime::runtime_init();
 }
 
@@ -68,7 +105,8 @@ Module::Module(
     std::shared_ptr<runtime::Program> program,
     std::unique_ptr<runtime::MemoryAllocator> memory_allocator,
     std::unique_ptr<runtime::MemoryAllocator> temp_allocator,
-    std::unique_ptr<runtime::EventTracer> event_tracer)
+    std::unique_ptr<runtime::EventTracer> event_tracer,
+    const bool share_memory_arenas)
     : program_(std::move(program)),
       memory_allocator_(
           memory_allocator ? std::move(memory_allocator)
@@ -76,7 +114,8 @@ Module::Module(
       temp_allocator_(
           temp_allocator ? std::move(temp_allocator)
                          : std::make_unique<MallocMemoryAllocator>()),
-      event_tracer_(std::move(event_tracer)) {
+      event_tracer_(std::move(event_tracer)),
+      share_memory_arenas_(share_memory_arenas) {
   runtime::runtime_init();
 }
 
@@ -101,6 +140,10 @@ runtime::Error Module::load(const runtime::Program::Verification verification) {
               file_path_.c_str(),
               MmapDataLoader::MlockConfig::UseMlockIgnoreErrors));
           break;
+        case LoadMode::FilePrefetch:
+          data_loader_ = ET_UNWRAP_UNIQUE(
+              PrefetchingDataLoader::from(file_path_.c_str()));
+          break;
       }
     };
     auto program = ET_UNWRAP_UNIQUE(
@@ -135,9 +178,17 @@ runtime::Error Module::load_method(const std::string& method_name) {
     method_holder.planned_buffers.reserve(planned_buffersCount);
     method_holder.planned_spans.reserve(planned_buffersCount);
 
+    if (share_memory_arenas_) {
+      ET_CHECK_OK_OR_RETURN_ERROR(load_shared_arenas());
+    }
     for (auto index = 0; index < planned_buffersCount; ++index) {
       const auto buffer_size =
           method_metadata.memory_planned_buffer_size(index).get();
+      if (share_memory_arenas_) {
+        method_holder.planned_spans.emplace_back(
+            shared_arenas_[index].data(), buffer_size);
+        continue;
+      }
       method_holder.planned_buffers.emplace_back(buffer_size);
       method_holder.planned_spans.emplace_back(
           method_holder.planned_buffers.back().data(), buffer_size);
@@ -159,6 +210,79 @@ runtime::Error Module::load_method(const std::string& method_name) {
   return runtime::Error::Ok;
 }
 
+runtime::Error Module::load_shared_arenas() {
+  if (!shared_arenas_.empty()) {
+    return runtime::Error::Ok;
+  }
+  // Size each arena for the largest buffer with its memory ID across all
+  // methods, so that methods loaded later fit too.
+  std::vector<size_t> arena_sizes;
+  size_t unshared_size = 0;
+  const auto method_count = program_->num_methods();
+  for (size_t index = 0; index < method_count; ++index) {
+    const auto method_name = ET_UNWRAP(program_->get_method_name(index));
+    const auto method_metadata = ET_UNWRAP(program_->method_meta(method_name));
+    const auto planned_buffersCount =
+        method_metadata.num_memory_planned_buffers();
+    if (arena_sizes.size() < planned_buffersCount) {
+      arena_sizes.resize(planned_buffersCount, 0);
+    }
+    for (size_t id = 0; id < planned_buffersCount; ++id) {
+      const auto buffer_size = static_cast<size_t>(
+          ET_UNWRAP(method_metadata.memory_planned_buffer_size(id)));
+      arena_sizes[id] = std::max(arena_sizes[id], buffer_size);
+      unshared_size += buffer_size;
+    }
+  }
+  size_t shared_size = 0;
+  shared_arenas_.reserve(arena_sizes.size());
+  for (const auto arena_size : arena_sizes) {
+    shared_arenas_.emplace_back(arena_size);
+    shared_size += arena_size;
+  }
+  ET_LOG(
+      Info,
+      "Sharing %zu bytes of planned memory across %zu methods, saving %zu "
+      "bytes once all are loaded",
+      shared_size,
+      method_count,
+      unshared_size - shared_size);
+  return runtime::Error::Ok;
+}
+
+bool Module::is_in_shared_arenas(const exec_aten::Tensor& tensor) const {
+  const auto* begin = static_cast<const uint8_t*>(tensor.const_data_ptr());
+  const auto* end = begin + tensor.nbytes();
+  for (const auto& arena : shared_arenas_) {
+    if (begin < arena.data() + arena.size() && arena.data() < end) {
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t Module::planned_memory_size() const {
+  size_t size = 0;
+  if (share_memory_arenas_) {
+    for (const auto& arena : shared_arenas_) {
+      size += arena.size();
+    }
+    return size;
+  }
+  for (const auto& [name, method_holder] : methods_) {
+    for (const auto& buffer : method_holder.planned_buffers) {
+      size += buffer.size();
+    }
+  }
+  return size;
+}
+
+runtime::Result<std::vector<runtime::Span<uint8_t>>> Module::planned_buffers(
+    const std::string& method_name) {
+  ET_CHECK_OK_OR_RETURN_ERROR(load_method(method_name));
+  return methods_.at(method_name).planned_spans;
+}
+
 runtime::Result<runtime::MethodMeta> Module::method_meta(
     const std::string& method_name) {
   ET_CHECK_OK_OR_RETURN_ERROR(load_method(method_name));
@@ -171,8 +295,45 @@ runtime::Result<std::vector<runtime::EValue>> Module::execute(
   ET_CHECK_OK_OR_RETURN_ERROR(load_method(method_name));
   auto& method = methods_.at(method_name).method;
 
+  // With shared arenas, a method running inside another one, e.g. from a
+  // delegate or a custom op, would overwrite the outer method's memory.
+  ET_CHECK_OR_RETURN_ERROR(
+      !share_memory_arenas_ || !executing_,
+      InvalidState,
+      "Cannot execute %s while another method that shares its planned memory "
+      "is executing",
+      method_name.c_str());
+  executing_ = true;
+  struct ExecutingGuard {
+    bool& executing;
+    ~ExecutingGuard() {
+      executing = false;
+    }
+  } executing_guard{executing_};
+
+  // With shared arenas, an input may live in the planned memory of any
+  // method, e.g. be the output of another method, and setting the inputs or
+  // executing would overwrite it. Copy such inputs out first.
+  std::vector<runtime::EValue> copied_input;
+  std::vector<TensorPtr> input_copies;
+  if (share_memory_arenas_) {
+    for (size_t index = 0; index < input.size(); ++index) {
+      if (!input[index].isTensor() ||
+          !is_in_shared_arenas(input[index].toTensor())) {
+        continue;
+      }
+      if (copied_input.empty()) {
+        copied_input = input;
+      }
+      input_copies.emplace_back(copy_tensor(input[index].toTensor()));
+      copied_input[index] = *input_copies.back();
+    }
+  }
+  const auto& method_input = copied_input.empty() ? input : copied_input;
+
   ET_CHECK_OK_OR_RETURN_ERROR(method->set_inputs(
-      exec_aten::ArrayRef<runtime::EValue>(input.data(), input.size())));
+      exec_aten::ArrayRef<runtime::EValue>(
+          method_input.data(), method_input.size())));
   ET_CHECK_OK_OR_RETURN_ERROR(method->execute());
 
   const auto outputs_size = method->outputs_size();
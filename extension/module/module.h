@@ -36,6 +36,8 @@ class Module {
     MmapUseMlock,
     /// Use memory locking and ignore errors.
     MmapUseMlockIgnoreErrors,
+    /// Load segments as buffers, reading them concurrently in the background.
+    FilePrefetch,
   };
 
   /**
@@ -44,11 +46,15 @@ class Module {
    *
    * @param[in] file_path The path to the ExecuTorch program file to load.
    * @param[in] load_mode The loading mode to use.
+   * @param[in] event_tracer A EventTracer used for tracking and logging events.
+   * @param[in] share_memory_arenas Whether methods share planned memory. See
+   * share_memory_arenas().
    */
   explicit Module(
       const std::string& file_path,
       const LoadMode load_mode = LoadMode::MmapUseMlock,
-      std::unique_ptr<runtime::EventTracer> event_tracer = nullptr);
+      std::unique_ptr<runtime::EventTracer> event_tracer = nullptr,
+      const bool share_memory_arenas = false);
 
   /**
    * Constructs an instance with the provided data loader and memory allocator.
@@ -58,12 +64,15 @@ class Module {
    * @param[in] temp_allocator A MemoryAllocator to use when allocating
    * temporary data during kernel or delegate execution.
    * @param[in] event_tracer A EventTracer used for tracking and logging events.
+   * @param[in] share_memory_arenas Whether methods share planned memory. See
+   * share_memory_arenas().
    */
   explicit Module(
       std::unique_ptr<runtime::DataLoader> data_loader,
       std::unique_ptr<runtime::MemoryAllocator> memory_allocator = nullptr,
       std::unique_ptr<runtime::MemoryAllocator> temp_allocator = nullptr,
-      std::unique_ptr<runtime::EventTracer> event_tracer = nullptr);
+      std::unique_ptr<runtime::EventTracer> event_tracer = nullptr,
+      const bool share_memory_arenas = false);
 
   /**
    * Constructs an instance using an existing shared program.
@@ -74,12 +83,15 @@ class Module {
    * @param[in] temp_allocator A MemoryAllocator to use when allocating
    * temporary data.
    * @param[in] event_tracer A EventTracer used for tracking and logging events.
+   * @param[in] share_memory_arenas Whether methods share planned memory. See
+   * share_memory_arenas().
    */
   explicit Module(
       std::shared_ptr<runtime::Program> program,
       std::unique_ptr<runtime::MemoryAllocator> memory_allocator = nullptr,
       std::unique_ptr<runtime::MemoryAllocator> temp_allocator = nullptr,
-      std::unique_ptr<runtime::EventTracer> event_tracer = nullptr);
+      std::unique_ptr<runtime::EventTracer> event_tracer = nullptr,
+      const bool share_memory_arenas = false);
 
   Module(const Module&) = delete;
   Module& operator=(const Module&) = delete;
@@ -308,6 +320,56 @@ class Module {
     return event_tracer_.get();
   }
 
+  /**
+   * Checks if the methods of this Module share planned memory.
+   *
+   * When enabled, all methods use one arena per memory ID, sized to the
+   * largest planned buffer with that ID across the program's methods, instead
+   * of each method allocating its own. This suits programs whose methods run
+   * one after another, like the prefill and decode methods of an LLM, or an
+   * encoder and a decoder.
+   *
+   * Executing a method overwrites the planned memory of every other method,
+   * so outputs of a method are only valid until any method of this Module
+   * executes again, and methods must not keep state in planned memory
+   * between executions, e.g. a mutable buffer that was memory planned.
+   * Inputs that live in the shared memory, e.g. outputs of another method,
+   * are copied before the method executes, so they can be passed as is.
+   * Executing a method while another one is running fails with
+   * Error::InvalidState.
+   *
+   * @returns true if the methods share planned memory, false otherwise.
+   */
+  inline bool share_memory_arenas() const {
+    return share_memory_arenas_;
+  }
+
+  /**
+   * Get the number of bytes allocated for the planned memory of the loaded
+   * methods. With share_memory_arenas(), this is the size of the shared
+   * arenas, whatever the number of loaded methods.
+   *
+   * @returns The number of bytes of planned memory.
+   */
+  size_t planned_memory_size() const;
+
+  /**
+   * Get the planned memory of a method, one span per memory ID.
+   * Loads the program and method if needed.
+   *
+   * Mutable buffers that were memory planned, like the KV cache of an LLM,
+   * live in this memory between executions, so copying it out and back saves
+   * and restores the state of the method. With share_memory_arenas(), the
+   * spans are the shared arenas.
+   *
+   * @param[in] method_name The name of the method.
+   *
+   * @returns The spans of the planned memory, valid while the Module is alive,
+   * or an error if the program or method failed to load.
+   */
+  runtime::Result<std::vector<runtime::Span<uint8_t>>> planned_buffers(
+      const std::string& method_name);
+
   /**
    * Set output data pointer for forward method.
    *
@@ -329,6 +391,9 @@ class Module {
     std::unique_ptr<runtime::Method> method;
   };
 
+  runtime::Error load_shared_arenas();
+  bool is_in_shared_arenas(const exec_aten::Tensor& tensor) const;
+
  private:
   std::string file_path_;
   LoadMode load_mode_{LoadMode::MmapUseMlock};
@@ -337,6 +402,10 @@ class Module {
   std::unique_ptr<runtime::MemoryAllocator> memory_allocator_;
   std::unique_ptr<runtime::MemoryAllocator> temp_allocator_;
   std::unique_ptr<runtime::EventTracer> event_tracer_;
+  bool share_memory_arenas_{false};
+  // One arena per memory ID when methods share planned memory.
+  std::vector<std::vector<uint8_t>> shared_arenas_;
+  bool executing_{false};
 
  protected:
   std::unordered_map<std::string, MethodHolder> methods_;
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/module/module_pool.h>
+
+#include <algorithm>
+
+#include <executorch/runtime/platform/runtime.h>
+
+namespace executorch {
+namespace extension {
+
+ModulePool::ModulePool(
+    const std::string& file_path,
+    size_t max_modules,
+    Module::LoadMode load_mode)
+    : max_modules_(std::max<size_t>(max_modules, 1)),
+      loader_module_(std::make_unique<Module>(file_path, load_mode)) {
+  idle_modules_.reserve(max_modules_);
+}
+
+ModulePool::ModulePool(
+    std::shared_ptr<runtime::Program> program,
+    size_t max_modules)
+    : max_modules_(std::max<size_t>(max_modules, 1)),
+      program_(std::move(program)) {
+  runtime::runtime_init();
+  idle_modules_.reserve(max_modules_);
+}
+
+runtime::Error ModulePool::load(
+    const runtime::Program::Verification verification) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (program_ != nullptr) {
+    return runtime::Error::Ok;
+  }
+  ET_CHECK_OR_RETURN_ERROR(
+      loader_module_ != nullptr, InvalidState, "No program to load");
+  ET_CHECK_OK_OR_RETURN_ERROR(loader_module_->load(verification));
+  program_ = loader_module_->program();
+  return runtime::Error::Ok;
+}
+
+runtime::Result<ModulePool::Lease> ModulePool::acquire() {
+  return acquire(/*wait=*/true);
+}
+
+runtime::Result<ModulePool::Lease> ModulePool::try_acquire() {
+  return acquire(/*wait=*/false);
+}
+
+runtime::Result<ModulePool::Lease> ModulePool::acquire(bool wait) {
+  ET_CHECK_OK_OR_RETURN_ERROR(load());
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    if (!idle_modules_.empty()) {
+      // Reuse the most recently released Module; its memory is most likely
+      // to still be in cache.
+      std::unique_ptr<Module> module = std::move(idle_modules_.back());
+      idle_modules_.pop_back();
+      return Lease(this, std::move(module));
+    }
+    if (num_modules_ < max_modules_) {
+      num_modules_++;
+      std::shared_ptr<runtime::Program> program = program_;
+      lock.unlock();
+      return Lease(this, std::make_unique<Module>(std::move(program)));
+    }
+    if (!wait) {
+      return runtime::Error::NotFound;
+    }
+    module_released_.wait(lock);
+  }
+}
+
+void ModulePool::release(std::unique_ptr<Module> module) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_modules_.push_back(std::move(module));
+  }
+  module_released_.notify_one();
+}
+
+runtime::Error ModulePool::load_method(
+    const std::string& method_name,
+    size_t count) {
+  count = std::min(count, max_modules_);
+  // Hold every lease until the end, so that each one is a different Module.
+  std::vector<Lease> leases;
+  leases.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    auto lease = acquire();
+    if (!lease.ok()) {
+      return lease.error();
+    }
+    leases.push_back(std::move(lease.get()));
+    ET_CHECK_OK_OR_RETURN_ERROR(leases.back()->load_method(method_name));
+  }
+  return runtime::Error::Ok;
+}
+
+size_t ModulePool::num_modules() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_modules_;
+}
+
+std::shared_ptr<runtime::Program> ModulePool::program() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return program_;
+}
+
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <executorch/extension/module/module.h>
+
+namespace executorch {
+namespace extension {
+
+/**
+ * A bounded pool of Modules that share one Program, for running the same
+ * model from several threads at once.
+ *
+ * The Program, and the constant data it owns, is loaded once and shared by
+ * every Module in the pool. Each Module has its own loaded Methods, planned
+ * memory and temporary allocator, so a Module leased from the pool can run
+ * without coordinating with the others.
+ *
+ * Modules are created on demand, up to `max_modules`. When every Module is
+ * leased out, acquire() blocks until one is returned.
+ *
+ * Example:
+ * @code
+ *   ModulePool pool("model.pte", std::thread::hardware_concurrency());
+ *   // On any thread:
+ *   auto lease = pool.acquire();
+ *   auto outputs = lease->forward(inputs);
+ *   // Use outputs before `lease` goes out of scope.
+ * @endcode
+ */
+class ModulePool final {
+ public:
+  /**
+   * A Module leased from a ModulePool. The Module goes back to the pool when
+   * the lease is destroyed, so outputs returned by its methods are only
+   * valid while the lease is alive.
+   */
+  class Lease final {
+   public:
+    Lease(Lease&& other) noexcept
+        : pool_(other.pool_), module_(std::move(other.module_)) {
+      other.pool_ = nullptr;
+    }
+    ~Lease() {
+      if (pool_ != nullptr && module_ != nullptr) {
+        pool_->release(std::move(module_));
+      }
+    }
+
+    Module& operator*() const {
+      return *module_;
+    }
+    Module* operator->() const {
+      return module_.get();
+    }
+    Module* get() const {
+      return module_.get();
+    }
+
+   private:
+    friend class ModulePool;
+
+    Lease(ModulePool* pool, std::unique_ptr<Module> module)
+        : pool_(pool), module_(std::move(module)) {}
+
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+    Lease& operator=(Lease&&) = delete;
+
+    ModulePool* pool_;
+    std::unique_ptr<Module> module_;
+  };
+
+  /**
+   * Constructs a pool that loads its Program from a file.
+   *
+   * @param[in] file_path The path to the ExecuTorch program file to load.
+   * @param[in] max_modules The maximum number of Modules, and so of
+   *     concurrent executions. Values below 1 are treated as 1.
+   * @param[in] load_mode The loading mode to use.
+   */
+  ModulePool(
+      const std::string& file_path,
+      size_t max_modules,
+      Module::LoadMode load_mode = Module::LoadMode::MmapUseMlock);
+
+  /**
+   * Constructs a pool around an already loaded Program.
+   *
+   * @param[in] program The shared program to use. It's required the data loader
+   * the program uses is valid for the lifetime of the program.
+   * @param[in] max_modules The maximum number of Modules, and so of
+   *     concurrent executions. Values below 1 are treated as 1.
+   */
+  ModulePool(std::shared_ptr<runtime::Program> program, size_t max_modules);
+
+  /// The pool must outlive its leases.
+  ~ModulePool() = default;
+
+  ModulePool(const ModulePool&) = delete;
+  ModulePool& operator=(const ModulePool&) = delete;
+  ModulePool(ModulePool&&) = delete;
+  ModulePool& operator=(ModulePool&&) = delete;
+
+  /**
+   * Loads the program if needed. Thread-safe.
+   *
+   * @param[in] verification The type of verification to do before returning
+   * success.
+   *
+   * @returns An Error to indicate success or failure of the loading process.
+   */
+  ET_NODISCARD
+  runtime::Error load(
+      const runtime::Program::Verification verification =
+          runtime::Program::Verification::Minimal);
+
+  /**
+   * Leases a Module, loading the program first if needed. Blocks while all
+   * `max_modules` Modules are leased out.
+   *
+   * @returns A Lease for a Module that no other thread is using, or an error
+   * if the program failed to load.
+   */
+  runtime::Result<Lease> acquire();
+
+  /**
+   * Like acquire(), but returns Error::NotFound instead of blocking when all
+   * Modules are leased out.
+   */
+  runtime::Result<Lease> try_acquire();
+
+  /**
+   * Leases Modules until `count` of them (at most `max_modules`) have loaded
+   * `method_name`, so that the first executions do not pay for loading it.
+   *
+   * @returns An Error to indicate success or failure.
+   */
+  ET_NODISCARD
+  runtime::Error load_method(const std::string& method_name, size_t count);
+
+  /// Returns the maximum number of Modules in the pool.
+  size_t max_modules() const {
+    return max_modules_;
+  }
+
+  /// Returns the number of Modules created so far.
+  size_t num_modules() const;
+
+  /// Returns the shared program, or nullptr if it's not yet loaded.
+  std::shared_ptr<runtime::Program> program() const;
+
+ private:
+  runtime::Result<Lease> acquire(bool wait);
+  void release(std::unique_ptr<Module> module);
+
+  const size_t max_modules_;
+  // Loads the program and keeps its data loader alive. Never executed.
+  std::unique_ptr<Module> loader_module_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable module_released_;
+  std::shared_ptr<runtime::Program> program_;
+  // Modules not currently leased out; most recently released last.
+  std::vector<std::unique_ptr<Module>> idle_modules_;
+  size_t num_modules_ = 0;
+};
+
+} // namespace extension
+} // namespace executorch
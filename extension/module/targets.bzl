@@ -25,8 +25,43 @@ def define_common_targets():
                 "//executorch/extension/memory_allocator:malloc_memory_allocator",
                 "//executorch/extension/data_loader:file_data_loader",
                 "//executorch/extension/data_loader:mmap_data_loader",
+                "//executorch/extension/data_loader:prefetching_data_loader",
+                "//executorch/extension/tensor:tensor" + aten_suffix,
             ],
             exported_deps = [
                 "//executorch/runtime/executor:program" + aten_suffix,
             ],
         )
+
+        runtime.cxx_library(
+            name = "module_pool" + aten_suffix,
+            srcs = [
+                "module_pool.cpp",
+            ],
+            exported_headers = [
+                "module_pool.h",
+            ],
+            visibility = [
+                "@EXECUTORCH_CLIENTS",
+            ],
+            exported_deps = [
+                ":module" + aten_suffix,
+            ],
+        )
+
+        runtime.cxx_library(
+            name = "batching_executor" + aten_suffix,
+            srcs = [
+                "batching_executor.cpp",
+            ],
+            exported_headers = [
+                "batching_executor.h",
+            ],
+            visibility = [
+                "@EXECUTORCH_CLIENTS",
+            ],
+            exported_deps = [
+                ":module" + aten_suffix,
+                "//executorch/extension/tensor:tensor" + aten_suffix,
+            ],
+        )
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/module/batching_executor.h>
+
+#include <array>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+
+namespace torch::executor {
+
+using ::executorch::extension::BatchingExecutor;
+using ::executorch::extension::Module;
+
+// ModuleAddDynamicBatch adds two [batch, 3] float tensors, with batches of up
+// to 8 rows.
+class BatchingExecutorDynamicBatchTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    model_path_ = std::getenv("ET_MODULE_ADD_DYNAMIC_BATCH_PATH");
+  }
+
+  // A request of `rows` rows, whose row r holds
+  // x = {id, r, 1} and y = {10 * id, 0, r}.
+  struct Request {
+    Request(int id, int rows) : sizes{rows, 3} {
+      for (int r = 0; r < rows; ++r) {
+        x.insert(x.end(), {float(id), float(r), 1});
+        y.insert(y.end(), {float(10 * id), 0, float(r)});
+      }
+      x_tensor = std::make_unique<TensorImpl>(
+          ScalarType::Float, sizes.size(), sizes.data(), x.data());
+      y_tensor = std::make_unique<TensorImpl>(
+          ScalarType::Float, sizes.size(), sizes.data(), y.data());
+    }
+
+    std::vector<EValue> inputs() {
+      return {Tensor(x_tensor.get()), Tensor(y_tensor.get())};
+    }
+
+    void expect_outputs(const Result<BatchingExecutor::Outputs>& outputs) {
+      ASSERT_TRUE(outputs.ok());
+      ASSERT_EQ(outputs->size(), 1);
+      const auto& output = outputs->at(0);
+      ASSERT_EQ(output->dim(), 2);
+      EXPECT_EQ(output->size(0), sizes[0]);
+      EXPECT_EQ(output->size(1), 3);
+      for (size_t i = 0; i < x.size(); ++i) {
+        EXPECT_NEAR(output->const_data_ptr<float>()[i], x[i] + y[i], 1e-5);
+      }
+    }
+
+    std::array<int32_t, 2> sizes;
+    std::vector<float> x;
+    std::vector<float> y;
+    std::unique_ptr<TensorImpl> x_tensor;
+    std::unique_ptr<TensorImpl> y_tensor;
+  };
+
+  static std::string model_path_;
+};
+
+std::string BatchingExecutorDynamicBatchTest::model_path_;
+
+TEST_F(BatchingExecutorDynamicBatchTest, TestConcurrentRequestsShareExecution) {
+  Module module(model_path_);
+  BatchingExecutor::Config config;
+  // The requests below add up to a full batch, which runs at once; the delay
+  // is long enough that nothing runs before all of them are queued.
+  config.max_batch_size = 6;
+  config.max_delay = std::chrono::seconds(60);
+  BatchingExecutor batcher(module, "forward", config);
+
+  const std::array<int, 4> rows{1, 2, 1, 2};
+  std::vector<std::thread> threads;
+  for (int id = 0; id < int(rows.size()); ++id) {
+    threads.emplace_back([&, id]() {
+      Request request(id, rows[id]);
+      request.expect_outputs(batcher.submit(request.inputs()).get());
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(batcher.num_executions(), 1);
+}
+
+TEST_F(BatchingExecutorDynamicBatchTest, TestBatchSplitAtMaxBatchSize) {
+  Module module(model_path_);
+  BatchingExecutor::Config config;
+  config.max_batch_size = 4;
+  config.max_delay = std::chrono::milliseconds(100);
+
+  // Three requests of 2 rows don't fit in one batch: the first two run
+  // together, and the third on its own.
+  std::vector<std::unique_ptr<Request>> requests;
+  std::vector<std::future<Result<BatchingExecutor::Outputs>>> futures;
+  BatchingExecutor batcher(module, "forward", config);
+  for (int id = 0; id < 3; ++id) {
+    requests.push_back(std::make_unique<Request>(id, 2));
+    futures.push_back(batcher.submit(requests.back()->inputs()));
+  }
+  for (int id = 0; id < 3; ++id) {
+    requests[id]->expect_outputs(futures[id].get());
+  }
+  EXPECT_EQ(batcher.num_executions(), 2);
+}
+
+TEST_F(BatchingExecutorDynamicBatchTest, TestPadToMaxBatchSize) {
+  Module module(model_path_);
+  BatchingExecutor::Config config;
+  config.max_batch_size = 4;
+  config.max_delay = std::chrono::milliseconds(100);
+  config.pad_to_max_batch_size = true;
+  BatchingExecutor batcher(module, "forward", config);
+
+  // The batch is padded to 4 rows, and only the request's rows come back.
+  Request first(1, 1);
+  Request second(2, 2);
+  auto first_outputs = batcher.submit(first.inputs());
+  auto second_outputs = batcher.submit(second.inputs());
+  first.expect_outputs(first_outputs.get());
+  second.expect_outputs(second_outputs.get());
+  EXPECT_EQ(batcher.num_executions(), 1);
+}
+
+} // namespace torch::executor
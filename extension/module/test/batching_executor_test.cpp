@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/module/batching_executor.h>
+
+#include <array>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+
+namespace torch::executor {
+
+using ::executorch::extension::BatchingExecutor;
+using ::executorch::extension::Module;
+
+class BatchingExecutorTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    model_path_ = std::getenv("RESOURCES_PATH") + std::string("/add.pte");
+  }
+
+  static std::string model_path_;
+};
+
+std::string BatchingExecutorTest::model_path_;
+
+TEST_F(BatchingExecutorTest, TestSubmit) {
+  Module module(model_path_);
+  BatchingExecutor batcher(module, "forward");
+
+  std::array<float, 1> input{2};
+  std::array<int32_t, 1> sizes{1};
+  TensorImpl tensor(
+      ScalarType::Float, sizes.size(), sizes.data(), input.data());
+
+  auto outputs = batcher.submit({Tensor(&tensor), Tensor(&tensor)}).get();
+  ASSERT_TRUE(outputs.ok());
+  ASSERT_EQ(outputs->size(), 1);
+  EXPECT_EQ(outputs->at(0)->size(0), 1);
+  EXPECT_NEAR(outputs->at(0)->const_data_ptr<float>()[0], 4, 1e-5);
+}
+
+TEST_F(BatchingExecutorTest, TestSubmitWithCallback) {
+  Module module(model_path_);
+  std::promise<float> result;
+  {
+    BatchingExecutor batcher(module, "forward");
+
+    std::array<float, 1> input{5};
+    std::array<int32_t, 1> sizes{1};
+    TensorImpl tensor(
+        ScalarType::Float, sizes.size(), sizes.data(), input.data());
+
+    batcher.submit(
+        {Tensor(&tensor), Tensor(&tensor)},
+        [&](Result<BatchingExecutor::Outputs> outputs) {
+          ASSERT_TRUE(outputs.ok());
+          result.set_value(outputs->at(0)->const_data_ptr<float>()[0]);
+        });
+    // Wait before the input goes out of scope.
+    EXPECT_NEAR(result.get_future().get(), 10, 1e-5);
+  }
+}
+
+TEST_F(BatchingExecutorTest, TestBatchSizeLimitedByMethod) {
+  // add.pte only accepts a batch of one, so every request runs on its own
+  // however large the configured batch.
+  Module module(model_path_);
+  BatchingExecutor::Config config;
+  config.max_batch_size = 8;
+  config.max_delay = std::chrono::milliseconds(10);
+  BatchingExecutor batcher(module, "forward", config);
+
+  constexpr int kNumRequests = 4;
+  std::array<float, kNumRequests> inputs{1, 2, 3, 4};
+  std::array<int32_t, 1> sizes{1};
+  std::vector<std::unique_ptr<TensorImpl>> tensors;
+  std::vector<std::future<Result<BatchingExecutor::Outputs>>> futures;
+  for (int i = 0; i < kNumRequests; ++i) {
+    tensors.push_back(std::make_unique<TensorImpl>(
+        ScalarType::Float, sizes.size(), sizes.data(), &inputs[i]));
+    futures.push_back(batcher.submit(
+        {Tensor(tensors.back().get()), Tensor(tensors.back().get())}));
+  }
+  for (int i = 0; i < kNumRequests; ++i) {
+    auto outputs = futures[i].get();
+    ASSERT_TRUE(outputs.ok());
+    EXPECT_NEAR(outputs->at(0)->const_data_ptr<float>()[0], inputs[i] * 2, 1e-5);
+  }
+  EXPECT_EQ(batcher.num_executions(), kNumRequests);
+}
+
+TEST_F(BatchingExecutorTest, TestConcurrentSubmit) {
+  Module module(model_path_);
+  BatchingExecutor batcher(module, "forward");
+
+  auto run = [&](float value) {
+    for (int i = 0; i < 10; ++i) {
+      std::array<float, 1> input{value};
+      std::array<int32_t, 1> sizes{1};
+      TensorImpl tensor(
+          ScalarType::Float, sizes.size(), sizes.data(), input.data());
+      auto outputs =
+          batcher.submit({Tensor(&tensor), Tensor(&tensor)}).get();
+      ASSERT_TRUE(outputs.ok());
+      EXPECT_NEAR(
+          outputs->at(0)->const_data_ptr<float>()[0], value * 2, 1e-5);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back(run, static_cast<float>(i));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(batcher.num_executions(), 40);
+}
+
+TEST_F(BatchingExecutorTest, TestInvalidInputs) {
+  Module module(model_path_);
+  BatchingExecutor batcher(module, "forward");
+
+  std::array<float, 2> input{1, 2};
+  std::array<int32_t, 1> sizes1{1};
+  std::array<int32_t, 1> sizes2{2};
+  TensorImpl tensor1(
+      ScalarType::Float, sizes1.size(), sizes1.data(), input.data());
+  TensorImpl tensor2(
+      ScalarType::Float, sizes2.size(), sizes2.data(), input.data());
+
+  // Not a tensor.
+  EXPECT_EQ(
+      batcher.submit({Tensor(&tensor1), EValue(1.0)}).get().error(),
+      Error::InvalidArgument);
+  // Batch sizes disagree.
+  EXPECT_EQ(
+      batcher.submit({Tensor(&tensor1), Tensor(&tensor2)}).get().error(),
+      Error::InvalidArgument);
+  EXPECT_EQ(batcher.num_executions(), 0);
+}
+
+TEST_F(BatchingExecutorTest, TestNonExistentMethod) {
+  Module module(model_path_);
+  BatchingExecutor batcher(module, "backward");
+
+  std::array<float, 1> input{1};
+  std::array<int32_t, 1> sizes{1};
+  TensorImpl tensor(
+      ScalarType::Float, sizes.size(), sizes.data(), input.data());
+
+  EXPECT_FALSE(
+      batcher.submit({Tensor(&tensor), Tensor(&tensor)}).get().ok());
+}
+
+TEST_F(BatchingExecutorTest, TestDestructionRunsQueuedRequests) {
+  Module module(model_path_);
+  BatchingExecutor::Config config;
+  config.max_delay = std::chrono::seconds(60);
+
+  std::array<float, 1> input{3};
+  std::array<int32_t, 1> sizes{1};
+  TensorImpl tensor(
+      ScalarType::Float, sizes.size(), sizes.data(), input.data());
+
+  std::future<Result<BatchingExecutor::Outputs>> future;
+  {
+    BatchingExecutor batcher(module, "forward", config);
+    future = batcher.submit({Tensor(&tensor), Tensor(&tensor)});
+  }
+  auto outputs = future.get();
+  ASSERT_TRUE(outputs.ok());
+  EXPECT_NEAR(outputs->at(0)->const_data_ptr<float>()[0], 6, 1e-5);
+}
+
+} // namespace torch::executor
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/module/module.h>
+
+#include <array>
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+
+namespace torch::executor {
+
+// ModuleMultipleEntry has two methods on a 2x2 float tensor:
+// forward(x) = x + 3 and forward2(x) = x + 5.
+class ModuleMultipleEntryTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    model_path_ = std::getenv("ET_MODULE_MULTI_ENTRY_PATH");
+  }
+
+  static void expect_data(
+      const EValue& value,
+      const std::array<float, 4>& expected) {
+    ASSERT_TRUE(value.isTensor());
+    const auto& tensor = value.toTensor();
+    ASSERT_EQ(tensor.numel(), expected.size());
+    const auto data = tensor.const_data_ptr<float>();
+    for (size_t i = 0; i < expected.size(); ++i) {
+      EXPECT_NEAR(data[i], expected[i], 1e-5);
+    }
+  }
+
+  static std::string model_path_;
+  std::array<float, 4> input_{1, 2, 3, 4};
+  std::array<int32_t, 2> sizes_{2, 2};
+};
+
+std::string ModuleMultipleEntryTest::model_path_;
+
+TEST_F(ModuleMultipleEntryTest, TestShareMemoryArenasRunsMethodsInTurn) {
+  Module module(
+      model_path_,
+      Module::LoadMode::MmapUseMlock,
+      /*event_tracer=*/nullptr,
+      /*share_memory_arenas=*/true);
+  TensorImpl tensor(
+      ScalarType::Float, sizes_.size(), sizes_.data(), input_.data());
+
+  const auto result = module.execute("forward", Tensor(&tensor));
+  ASSERT_TRUE(result.ok());
+  expect_data(result->at(0), {4, 5, 6, 7});
+
+  const auto result2 = module.execute("forward2", Tensor(&tensor));
+  ASSERT_TRUE(result2.ok());
+  expect_data(result2->at(0), {6, 7, 8, 9});
+
+  // Running forward2 reused the memory of forward, which still works.
+  const auto result3 = module.execute("forward", Tensor(&tensor));
+  ASSERT_TRUE(result3.ok());
+  expect_data(result3->at(0), {4, 5, 6, 7});
+
+  // The arenas hold the largest buffers of either method, not the sum.
+  Module unshared_module(module.program());
+  EXPECT_EQ(unshared_module.load_method("forward"), Error::Ok);
+  EXPECT_EQ(unshared_module.load_method("forward2"), Error::Ok);
+  EXPECT_GT(module.planned_memory_size(), 0);
+  EXPECT_LE(
+      module.planned_memory_size(), unshared_module.planned_memory_size());
+}
+
+TEST_F(ModuleMultipleEntryTest, TestShareMemoryArenasPassesOutputsAsInputs) {
+  Module module(
+      model_path_,
+      Module::LoadMode::MmapUseMlock,
+      /*event_tracer=*/nullptr,
+      /*share_memory_arenas=*/true);
+  TensorImpl tensor(
+      ScalarType::Float, sizes_.size(), sizes_.data(), input_.data());
+
+  const auto result = module.execute("forward", Tensor(&tensor));
+  ASSERT_TRUE(result.ok());
+  expect_data(result->at(0), {4, 5, 6, 7});
+
+  // The output of forward lives in the memory that forward2 reuses.
+  const auto result2 = module.execute("forward2", result->at(0));
+  ASSERT_TRUE(result2.ok());
+  expect_data(result2->at(0), {9, 10, 11, 12});
+
+  // And the output of a method may be passed back to the same method.
+  const auto result3 = module.execute("forward2", result2->at(0));
+  ASSERT_TRUE(result3.ok());
+  expect_data(result3->at(0), {14, 15, 16, 17});
+}
+
+TEST_F(ModuleMultipleEntryTest, TestUnsharedPassesOutputsAsInputs) {
+  Module module(model_path_);
+  TensorImpl tensor(
+      ScalarType::Float, sizes_.size(), sizes_.data(), input_.data());
+
+  const auto result = module.execute("forward", Tensor(&tensor));
+  ASSERT_TRUE(result.ok());
+  const auto result2 = module.execute("forward2", result->at(0));
+  ASSERT_TRUE(result2.ok());
+  expect_data(result2->at(0), {9, 10, 11, 12});
+}
+
+} // namespace torch::executor
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/module/module_pool.h>
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+
+namespace torch::executor {
+
+using ::executorch::extension::ModulePool;
+
+class ModulePoolTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    model_path_ = std::getenv("RESOURCES_PATH") + std::string("/add.pte");
+  }
+
+  static std::string model_path_;
+};
+
+std::string ModulePoolTest::model_path_;
+
+TEST_F(ModulePoolTest, TestAcquireAndExecute) {
+  ModulePool pool(model_path_, 2);
+  EXPECT_EQ(pool.program(), nullptr);
+
+  auto lease = pool.acquire();
+  ASSERT_TRUE(lease.ok());
+  EXPECT_NE(pool.program(), nullptr);
+  EXPECT_EQ((*lease)->program(), pool.program());
+
+  std::array<float, 1> input{3};
+  std::array<int32_t, 1> sizes{1};
+  TensorImpl tensor(
+      ScalarType::Float, sizes.size(), sizes.data(), input.data());
+  const auto result = (*lease)->forward({Tensor(&tensor), Tensor(&tensor)});
+  ASSERT_TRUE(result.ok());
+  EXPECT_NEAR(result->at(0).toTensor().const_data_ptr<float>()[0], 6, 1e-5);
+}
+
+TEST_F(ModulePoolTest, TestLoadNonExistent) {
+  ModulePool pool("/path/to/nonexistent/file.pte", 2);
+  EXPECT_NE(pool.load(), Error::Ok);
+  EXPECT_FALSE(pool.acquire().ok());
+  EXPECT_EQ(pool.num_modules(), 0);
+}
+
+TEST_F(ModulePoolTest, TestPoolIsBounded) {
+  ModulePool pool(model_path_, 2);
+
+  auto lease1 = pool.try_acquire();
+  ASSERT_TRUE(lease1.ok());
+  auto lease2 = pool.try_acquire();
+  ASSERT_TRUE(lease2.ok());
+  EXPECT_NE(lease1->get(), lease2->get());
+
+  // Both Modules are leased out.
+  auto lease3 = pool.try_acquire();
+  EXPECT_EQ(lease3.error(), Error::NotFound);
+  EXPECT_EQ(pool.num_modules(), 2);
+
+  // Returning a lease makes its Module available again.
+  Module* module1 = lease1->get();
+  { ModulePool::Lease returned = std::move(lease1.get()); }
+  auto lease4 = pool.try_acquire();
+  ASSERT_TRUE(lease4.ok());
+  EXPECT_EQ(lease4->get(), module1);
+  EXPECT_EQ(pool.num_modules(), 2);
+}
+
+TEST_F(ModulePoolTest, TestLoadMethod) {
+  ModulePool pool(model_path_, 3);
+  EXPECT_EQ(pool.load_method("forward", 5), Error::Ok);
+  EXPECT_EQ(pool.num_modules(), 3);
+
+  // Hold every lease, so that each iteration gets a different Module.
+  std::vector<ModulePool::Lease> leases;
+  for (int i = 0; i < 3; ++i) {
+    auto lease = pool.try_acquire();
+    ASSERT_TRUE(lease.ok());
+    EXPECT_TRUE((*lease)->is_method_loaded("forward"));
+    leases.push_back(std::move(lease.get()));
+  }
+}
+
+TEST_F(ModulePoolTest, TestConcurrentExecution) {
+  constexpr size_t kMaxModules = 2;
+  constexpr int kNumThreads = 6;
+  constexpr int kRunsPerThread = 20;
+  ModulePool pool(model_path_, kMaxModules);
+
+  std::atomic<int> active{0};
+  std::atomic<int> max_active{0};
+  auto run = [&](float value) {
+    for (int i = 0; i < kRunsPerThread; ++i) {
+      auto lease = pool.acquire();
+      ASSERT_TRUE(lease.ok());
+      const int now_active = ++active;
+      int seen = max_active.load();
+      while (now_active > seen &&
+             !max_active.compare_exchange_weak(seen, now_active)) {
+      }
+
+      std::array<float, 1> input{value};
+      std::array<int32_t, 1> sizes{1};
+      TensorImpl tensor(
+          ScalarType::Float, sizes.size(), sizes.data(), input.data());
+      const auto result =
+          (*lease)->forward({Tensor(&tensor), Tensor(&tensor)});
+      ASSERT_TRUE(result.ok());
+      EXPECT_NEAR(
+          result->at(0).toTensor().const_data_ptr<float>()[0],
+          value * 2,
+          1e-5);
+      --active;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back(run, static_cast<float>(i + 1));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_LE(max_active.load(), kMaxModules);
+  EXPECT_LE(pool.num_modules(), kMaxModules);
+}
+
+} // namespace torch::executor
@@ -269,6 +269,52 @@ TEST_F(ModuleTest, TestForwardWithInvalidInputs) {
   EXPECT_FALSE(result.ok());
 }
 
+TEST_F(ModuleTest, TestShareMemoryArenas) {
+  Module module(
+      model_path_,
+      Module::LoadMode::MmapUseMlock,
+      /*event_tracer=*/nullptr,
+      /*share_memory_arenas=*/true);
+  EXPECT_TRUE(module.share_memory_arenas());
+  EXPECT_EQ(module.planned_memory_size(), 0);
+
+  std::array<float, 1> input{3};
+  std::array<int32_t, 1> sizes{1};
+  TensorImpl tensor(
+      ScalarType::Float, sizes.size(), sizes.data(), input.data());
+
+  const auto result = module.forward({Tensor(&tensor), Tensor(&tensor)});
+  EXPECT_TRUE(result.ok());
+
+  const auto data = result->at(0).toTensor().const_data_ptr<float>();
+  EXPECT_NEAR(data[0], 6, 1e-5);
+
+  // With a single method, the arenas are as large as its own buffers.
+  Module unshared_module(module.program());
+  EXPECT_FALSE(unshared_module.share_memory_arenas());
+  EXPECT_EQ(unshared_module.load_method("forward"), Error::Ok);
+  EXPECT_GT(module.planned_memory_size(), 0);
+  EXPECT_EQ(
+      module.planned_memory_size(), unshared_module.planned_memory_size());
+}
+
+TEST_F(ModuleTest, TestPlannedBuffers) {
+  Module module(model_path_);
+
+  const auto buffers = module.planned_buffers("forward");
+  EXPECT_TRUE(buffers.ok());
+  EXPECT_TRUE(module.is_method_loaded("forward"));
+
+  size_t size = 0;
+  for (const auto& buffer : *buffers) {
+    EXPECT_NE(buffer.data(), nullptr);
+    size += buffer.size();
+  }
+  EXPECT_EQ(size, module.planned_memory_size());
+
+  EXPECT_FALSE(module.planned_buffers("backward").ok());
+}
+
 TEST_F(ModuleTest, TestProgramSharingBetweenModules) {
   Module module1(model_path_);
   EXPECT_FALSE(module1.is_loaded());
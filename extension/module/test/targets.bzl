@@ -1,6 +1,6 @@
 load("@fbsource//xplat/executorch/build:runtime_wrapper.bzl", "runtime")
 
-def define_common_targets():
+def define_common_targets(is_fbcode = False):
     """Defines targets that should be shared between fbcode and xplat.
 
     The directory containing this targets.bzl file should also contain both
@@ -10,21 +10,60 @@ def define_common_targets():
     runtime.cxx_test(
         name = "test",
         srcs = [
+            "batching_executor_test.cpp",
+            "module_pool_test.cpp",
             "module_test.cpp",
         ],
         deps = [
             "//executorch/kernels/portable:generated_lib",
             "//executorch/extension/data_loader:file_data_loader",
+            "//executorch/extension/module:batching_executor",
             "//executorch/extension/module:module",
+            "//executorch/extension/module:module_pool",
         ],
         env = {
             "RESOURCES_PATH": "$(location :resources)/resources",
         },
     )
 
+    # The multi-method and dynamic batch test models are exported by the
+    # fbcode-only test/models:exported_programs target.
+    if not runtime.is_oss and is_fbcode:
+        runtime.cxx_test(
+            name = "module_multiple_entry_test",
+            srcs = [
+                "module_multiple_entry_test.cpp",
+            ],
+            deps = [
+                "//executorch/kernels/portable:generated_lib",
+                "//executorch/extension/module:module",
+            ],
+            env = {
+                "ET_MODULE_MULTI_ENTRY_PATH": "$(location fbcode//executorch/test/models:exported_programs[ModuleMultipleEntry.pte])",
+            },
+        )
+
+        runtime.cxx_test(
+            name = "batching_executor_dynamic_batch_test",
+            srcs = [
+                "batching_executor_dynamic_batch_test.cpp",
+            ],
+            deps = [
+                "//executorch/kernels/portable:generated_lib",
+                "//executorch/extension/module:batching_executor",
+                "//executorch/extension/module:module",
+            ],
+            env = {
+                "ET_MODULE_ADD_DYNAMIC_BATCH_PATH": "$(location fbcode//executorch/test/models:exported_programs[ModuleAddDynamicBatch.pte])",
+            },
+        )
+
     runtime.filegroup(
         name = "resources",
         srcs = native.glob([
             "resources/**",
         ]),
+        visibility = [
+            "//executorch/extension/llm/runner/test/...",
+        ],
     )
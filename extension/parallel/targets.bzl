@@ -14,9 +14,11 @@ def define_common_targets():
             name = "thread_parallel" + aten_suffix,
             srcs = [
                 "thread_parallel.cpp",
+                "work_stealing_thread_pool.cpp",
             ],
             exported_headers = [
                 "thread_parallel.h",
+                "work_stealing_thread_pool.h",
             ],
             visibility = [
                 "//executorch/...",
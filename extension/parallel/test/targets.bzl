@@ -17,3 +17,14 @@ def define_common_targets():
             "//executorch/runtime/platform:platform",
         ],
     )
+
+    runtime.cxx_test(
+        name = "work_stealing_thread_pool_test",
+        srcs = [
+            "work_stealing_thread_pool_test.cpp",
+        ],
+        deps = [
+            "//executorch/extension/parallel:thread_parallel",
+            "//executorch/runtime/platform:platform",
+        ],
+    )
@@ -9,7 +9,10 @@
 #include <gtest/gtest.h>
 
 #include <array>
+#include <atomic>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 #include <executorch/extension/parallel/thread_parallel.h>
 #include <executorch/runtime/platform/platform.h>
@@ -191,3 +194,45 @@ TEST_F(ParallelTest, TestChunkSizeTooLarge) {
     EXPECT_EQ(data_[i], i);
   }
 }
+
+TEST_F(ParallelTest, TestNestedParallelFor) {
+  std::array<std::atomic<int>, 10> counts;
+  for (auto& c : counts) {
+    c.store(0);
+  }
+  EXPECT_TRUE(parallel_for(0, 10, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      EXPECT_TRUE(parallel_for(0, 10, 1, [&](int64_t b, int64_t e) {
+        for (int64_t j = b; j < e; ++j) {
+          counts[j]++;
+        }
+      }));
+    }
+  }));
+
+  for (int64_t i = 0; i < 10; ++i) {
+    EXPECT_EQ(counts[i].load(), 10);
+  }
+}
+
+TEST_F(ParallelTest, TestConcurrentCallers) {
+  std::array<std::atomic<int64_t>, 4> sums;
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < sums.size(); ++t) {
+    sums[t].store(0);
+    threads.emplace_back([&sums, t]() {
+      EXPECT_TRUE(parallel_for(0, 1000, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          sums[t] += i;
+        }
+      }));
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (const auto& sum : sums) {
+    EXPECT_EQ(sum.load(), 1000 * 999 / 2);
+  }
+}
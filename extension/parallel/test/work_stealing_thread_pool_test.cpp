@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <executorch/extension/parallel/thread_parallel.h>
+#include <executorch/extension/parallel/work_stealing_thread_pool.h>
+#include <executorch/runtime/platform/platform.h>
+
+using namespace ::testing;
+using ::executorch::extension::get_thread_num;
+using ::executorch::extension::WorkStealingThreadPool;
+
+class WorkStealingThreadPoolTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    et_pal_init();
+  }
+
+  // Runs [0, size) on `pool` and checks that every item was visited exactly
+  // once. `cost(i)` is the number of microseconds to spend on item i.
+  template <typename Cost>
+  void RunAndCheck(
+      WorkStealingThreadPool& pool,
+      int64_t size,
+      int64_t grain_size,
+      size_t max_threads,
+      Cost cost) {
+    std::vector<std::atomic<int>> visits(size);
+    for (auto& v : visits) {
+      v.store(0);
+    }
+    pool.run(
+        0, size, grain_size, max_threads, [&](int64_t begin, int64_t end) {
+          EXPECT_LT(begin, end);
+          EXPECT_GE(get_thread_num(), 0);
+          EXPECT_LT(get_thread_num(), static_cast<int64_t>(max_threads));
+          for (int64_t i = begin; i < end; ++i) {
+            visits[i]++;
+            int64_t us = cost(i);
+            if (us > 0) {
+              std::this_thread::sleep_for(std::chrono::microseconds(us));
+            }
+          }
+        });
+    for (int64_t i = 0; i < size; ++i) {
+      EXPECT_EQ(visits[i].load(), 1) << "item " << i;
+    }
+  }
+};
+
+TEST_F(WorkStealingThreadPoolTest, ThreadCount) {
+  WorkStealingThreadPool pool(4);
+  EXPECT_EQ(pool.get_thread_count(), 4);
+
+  WorkStealingThreadPool single(1);
+  EXPECT_EQ(single.get_thread_count(), 1);
+
+  WorkStealingThreadPool zero(0);
+  EXPECT_EQ(zero.get_thread_count(), 1);
+}
+
+TEST_F(WorkStealingThreadPoolTest, BalancedWorkload) {
+  WorkStealingThreadPool pool(4);
+  RunAndCheck(pool, 10000, 1, 4, [](int64_t) { return 0; });
+}
+
+TEST_F(WorkStealingThreadPoolTest, SkewedWorkload) {
+  WorkStealingThreadPool pool(4);
+  // All of the expensive items are at the front of the range, so the thread
+  // that starts there has to have most of its share stolen.
+  RunAndCheck(pool, 256, 1, 4, [](int64_t i) { return i < 32 ? 200 : 0; });
+}
+
+TEST_F(WorkStealingThreadPoolTest, GrainSizeIsRespected) {
+  WorkStealingThreadPool pool(4);
+  std::atomic<int> short_chunks{0};
+  pool.run(0, 1000, 100, 4, [&](int64_t begin, int64_t end) {
+    if (end - begin < 100 && end != 1000) {
+      short_chunks++;
+    }
+  });
+  EXPECT_EQ(short_chunks.load(), 0);
+}
+
+TEST_F(WorkStealingThreadPoolTest, MaxThreadsLimitsThreadNum) {
+  WorkStealingThreadPool pool(8);
+  RunAndCheck(pool, 1000, 1, 2, [](int64_t i) { return i % 50 == 0 ? 10 : 0; });
+  RunAndCheck(pool, 1000, 1, 1, [](int64_t) { return 0; });
+}
+
+TEST_F(WorkStealingThreadPoolTest, EmptyRangeDoesNotCallFunction) {
+  WorkStealingThreadPool pool(4);
+  bool called = false;
+  pool.run(5, 5, 1, 4, [&](int64_t, int64_t) { called = true; });
+  EXPECT_FALSE(called);
+}
+
+TEST_F(WorkStealingThreadPoolTest, NestedRunExecutesInline) {
+  WorkStealingThreadPool pool(4);
+  std::atomic<int64_t> total{0};
+  pool.run(0, 16, 1, 4, [&](int64_t begin, int64_t end) {
+    EXPECT_TRUE(WorkStealingThreadPool::in_parallel_region());
+    for (int64_t i = begin; i < end; ++i) {
+      const std::thread::id outer = std::this_thread::get_id();
+      const int64_t outer_thread_num = get_thread_num();
+      pool.run(0, 100, 1, 4, [&](int64_t b, int64_t e) {
+        EXPECT_EQ(std::this_thread::get_id(), outer);
+        EXPECT_EQ(get_thread_num(), outer_thread_num);
+        total += e - b;
+      });
+    }
+  });
+  EXPECT_EQ(total.load(), 16 * 100);
+  EXPECT_FALSE(WorkStealingThreadPool::in_parallel_region());
+}
+
+TEST_F(WorkStealingThreadPoolTest, ConcurrentCallersShareThePool) {
+  WorkStealingThreadPool pool(4);
+  constexpr int kNumCallers = 4;
+  constexpr int64_t kSize = 2000;
+  std::vector<std::atomic<int64_t>> sums(kNumCallers);
+  std::vector<std::thread> callers;
+  for (int c = 0; c < kNumCallers; ++c) {
+    sums[c].store(0);
+    callers.emplace_back([&, c]() {
+      for (int iter = 0; iter < 20; ++iter) {
+        pool.run(0, kSize, 1, 4, [&](int64_t begin, int64_t end) {
+          int64_t local = 0;
+          for (int64_t i = begin; i < end; ++i) {
+            local += i;
+          }
+          sums[c] += local;
+        });
+      }
+    });
+  }
+  for (auto& t : callers) {
+    t.join();
+  }
+  for (int c = 0; c < kNumCallers; ++c) {
+    EXPECT_EQ(sums[c].load(), 20 * (kSize * (kSize - 1) / 2));
+  }
+}
@@ -26,6 +26,12 @@ namespace extension {
  *   void f(int64_t begin, int64_t end)
  * Returns true if all work items are processed successfully, false otherwise
  *
+ * The range is split into chunks that are scheduled dynamically on a
+ * work-stealing pool (see work_stealing_thread_pool.h), so f may be called
+ * several times per thread. Concurrent callers on different threads share the
+ * pool without serializing on each other. Calling parallel_for from inside f
+ * runs the nested range inline on the current thread.
+ *
  * Warning: parallel_for does NOT copy thread local states from the current
  * thread to the worker threads. Users need to protect the access to captured
  * data if they mutate them in f.
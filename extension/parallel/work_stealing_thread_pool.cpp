@@ -0,0 +1,344 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/parallel/work_stealing_thread_pool.h>
+
+#include <algorithm>
+#include <cinttypes>
+
+#include <executorch/extension/parallel/thread_parallel.h>
+#include <executorch/extension/threadpool/threadpool.h>
+#include <executorch/runtime/platform/assert.h>
+
+#if !(defined(WIN32))
+#include <pthread.h>
+#endif
+
+namespace executorch {
+namespace extension {
+
+namespace {
+
+thread_local bool in_parallel_region_ = false;
+
+/// Each participant starts with about this many chunks, so that threads that
+/// finish early have something left to steal.
+constexpr int64_t kChunksPerThread = 8;
+
+/// Chunk ranges are packed into one word as `(hi << 32) | lo` so that the
+/// owner and thieves can update them with a single compare-and-swap.
+uint64_t pack_range(uint32_t lo, uint32_t hi) {
+  return (static_cast<uint64_t>(hi) << 32) | lo;
+}
+
+uint32_t range_lo(uint64_t range) {
+  return static_cast<uint32_t>(range);
+}
+
+uint32_t range_hi(uint64_t range) {
+  return static_cast<uint32_t>(range >> 32);
+}
+
+/// Marks the current thread as working on a range, and gives it a thread
+/// number, for the lifetime of the guard.
+class ParallelRegionGuard final {
+ public:
+  explicit ParallelRegionGuard(int64_t thread_num)
+      : prev_thread_num_(get_thread_num()) {
+    in_parallel_region_ = true;
+    set_thread_num(thread_num);
+  }
+  ~ParallelRegionGuard() {
+    set_thread_num(prev_thread_num_);
+    in_parallel_region_ = false;
+  }
+
+ private:
+  const int64_t prev_thread_num_;
+};
+
+} // namespace
+
+/// One call to run(). Lives on the caller's stack; the caller does not return
+/// until `refs` drops to zero, so workers may use it until they release it.
+struct WorkStealingThreadPool::Job {
+  const std::function<void(int64_t, int64_t)>* fn;
+  int64_t begin;
+  int64_t end;
+  int64_t chunk_size;
+  size_t num_participants;
+
+  /// Participant slots handed out so far. The caller always takes slot 0.
+  std::atomic<size_t> next_participant;
+  /// Queue entries plus workers currently holding a pointer to this job.
+  std::atomic<size_t> refs;
+  /// Chunk indices `[lo, hi)` not yet claimed by each participant slot.
+  std::atomic<uint64_t> ranges[kMaxParticipants];
+
+  /// Claims the next chunk from the front of `slot`'s own range.
+  bool pop(size_t slot, uint32_t* chunk) {
+    uint64_t range = ranges[slot].load(std::memory_order_relaxed);
+    while (range_lo(range) < range_hi(range)) {
+      if (ranges[slot].compare_exchange_weak(
+              range,
+              pack_range(range_lo(range) + 1, range_hi(range)),
+              std::memory_order_acq_rel)) {
+        *chunk = range_lo(range);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// Moves the back half of some other slot's range into `slot`, which must
+  /// be empty. Returns false if there was nothing left to steal.
+  bool steal(size_t slot) {
+    for (size_t i = 1; i < num_participants; ++i) {
+      size_t victim = (slot + i) % num_participants;
+      uint64_t range = ranges[victim].load(std::memory_order_relaxed);
+      while (range_lo(range) < range_hi(range)) {
+        uint32_t lo = range_lo(range);
+        uint32_t hi = range_hi(range);
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (ranges[victim].compare_exchange_weak(
+                range, pack_range(lo, mid), std::memory_order_acq_rel)) {
+          // Nobody steals from an empty range, so a plain store is safe.
+          ranges[slot].store(pack_range(mid, hi), std::memory_order_release);
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  /// Runs chunks as participant `slot` until none are left anywhere.
+  void execute(size_t slot) {
+    ParallelRegionGuard guard(static_cast<int64_t>(slot));
+    uint32_t chunk = 0;
+    while (true) {
+      if (!pop(slot, &chunk)) {
+        if (!steal(slot)) {
+          return;
+        }
+        continue;
+      }
+      int64_t chunk_begin = begin + static_cast<int64_t>(chunk) * chunk_size;
+      int64_t chunk_end = std::min(end, chunk_begin + chunk_size);
+      (*fn)(chunk_begin, chunk_end);
+    }
+  }
+
+  void release() {
+    refs.fetch_sub(1, std::memory_order_release);
+  }
+};
+
+WorkStealingThreadPool::WorkStealingThreadPool(size_t thread_count)
+    : next_worker_(0), epoch_(0), stop_(false) {
+  size_t num_workers =
+      std::min(std::max(thread_count, size_t{1}), kMaxParticipants) - 1;
+  workers_.reserve(num_workers);
+  for (size_t i = 0; i < num_workers; ++i) {
+    workers_.emplace_back(new Worker());
+  }
+  // Start threads only once every worker exists, since they steal from each
+  // other.
+  for (size_t i = 0; i < num_workers; ++i) {
+    workers_[i]->thread = std::thread([this, i]() { worker_loop(i); });
+  }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (auto& worker : workers_) {
+    worker->thread.join();
+  }
+}
+
+size_t WorkStealingThreadPool::get_thread_count() const {
+  return workers_.size() + 1;
+}
+
+bool WorkStealingThreadPool::in_parallel_region() {
+  return in_parallel_region_;
+}
+
+void WorkStealingThreadPool::run(
+    int64_t begin,
+    int64_t end,
+    int64_t grain_size,
+    size_t max_threads,
+    const std::function<void(int64_t, int64_t)>& fn) {
+  if (end <= begin) {
+    return;
+  }
+  const int64_t size = end - begin;
+  const size_t num_participants =
+      std::min({max_threads, get_thread_count(), kMaxParticipants});
+
+  if (in_parallel_region_) {
+    // Nested range: the other threads are already busy with the outer one,
+    // and waiting for them here could deadlock.
+    fn(begin, end);
+    return;
+  }
+  if (size <= grain_size || num_participants <= 1) {
+    ParallelRegionGuard guard(0);
+    fn(begin, end);
+    return;
+  }
+
+  Job job;
+  job.fn = &fn;
+  job.begin = begin;
+  job.end = end;
+  job.chunk_size = std::max(
+      grain_size,
+      (size + static_cast<int64_t>(num_participants) * kChunksPerThread - 1) /
+          (static_cast<int64_t>(num_participants) * kChunksPerThread));
+  job.num_participants = num_participants;
+  job.next_participant.store(1, std::memory_order_relaxed);
+  const int64_t num_chunks = (size + job.chunk_size - 1) / job.chunk_size;
+  ET_CHECK_MSG(
+      num_chunks <= UINT32_MAX, "Too many chunks: %" PRId64, num_chunks);
+  const uint64_t total = static_cast<uint64_t>(num_chunks);
+  for (size_t slot = 0; slot < kMaxParticipants; ++slot) {
+    uint32_t lo = 0;
+    uint32_t hi = 0;
+    if (slot < num_participants) {
+      lo = static_cast<uint32_t>(total * slot / num_participants);
+      hi = static_cast<uint32_t>(total * (slot + 1) / num_participants);
+    }
+    job.ranges[slot].store(pack_range(lo, hi), std::memory_order_relaxed);
+  }
+
+  // Offer the job to as many workers as could help with it.
+  const size_t num_helpers = std::min(
+      {workers_.size(), num_participants - 1, static_cast<size_t>(total) - 1});
+  const size_t first_worker = next_worker_.fetch_add(num_helpers);
+  job.refs.store(num_helpers, std::memory_order_relaxed);
+  for (size_t i = 0; i < num_helpers; ++i) {
+    Worker& worker = *workers_[(first_worker + i) % workers_.size()];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.jobs.push_back(&job);
+  }
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    epoch_++;
+  }
+  wake_.notify_all();
+
+  job.execute(0);
+
+  // Withdraw the offers nobody picked up, then wait for the workers that did
+  // to finish their last chunk.
+  for (size_t i = 0; i < num_helpers; ++i) {
+    Worker& worker = *workers_[(first_worker + i) % workers_.size()];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    auto it = std::find(worker.jobs.begin(), worker.jobs.end(), &job);
+    if (it != worker.jobs.end()) {
+      worker.jobs.erase(it);
+      job.release();
+    }
+  }
+  while (job.refs.load(std::memory_order_acquire) != 0) {
+    std::this_thread::yield();
+  }
+}
+
+WorkStealingThreadPool::Job* WorkStealingThreadPool::take_job(
+    size_t worker_index) {
+  // Own queue first, oldest job first.
+  {
+    Worker& self = *workers_[worker_index];
+    std::lock_guard<std::mutex> lock(self.mutex);
+    if (!self.jobs.empty()) {
+      Job* job = self.jobs.front();
+      self.jobs.pop_front();
+      return job;
+    }
+  }
+  // Otherwise steal the newest job from another worker's queue.
+  for (size_t i = 1; i < workers_.size(); ++i) {
+    Worker& victim = *workers_[(worker_index + i) % workers_.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.jobs.empty()) {
+      Job* job = victim.jobs.back();
+      victim.jobs.pop_back();
+      return job;
+    }
+  }
+  return nullptr;
+}
+
+void WorkStealingThreadPool::worker_loop(size_t worker_index) {
+  while (true) {
+    uint64_t seen_epoch = 0;
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      if (stop_) {
+        return;
+      }
+      seen_epoch = epoch_;
+    }
+
+    Job* job = take_job(worker_index);
+    if (job != nullptr) {
+      size_t slot =
+          job->next_participant.fetch_add(1, std::memory_order_relaxed);
+      if (slot < job->num_participants) {
+        job->execute(slot);
+      }
+      job->release();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    wake_.wait(lock, [&]() { return stop_ || epoch_ != seen_epoch; });
+  }
+}
+
+#if !(defined(WIN32))
+namespace {
+// See the comment in threadpool.cpp: after fork the worker threads are gone,
+// so the pool is leaked instead of destroyed.
+bool leak_corrupted_pool = false;
+
+void child_atfork() {
+  leak_corrupted_pool = true;
+}
+} // namespace
+#endif
+
+WorkStealingThreadPool* get_work_stealing_thread_pool() {
+  static auto pool = std::make_unique<WorkStealingThreadPool>(
+      torch::executorch::threadpool::get_threadpool()->get_thread_count());
+
+#if !(defined(WIN32))
+  // @lint-ignore CLANGTIDY facebook-hte-std::once_flag
+  static std::once_flag flag;
+  // @lint-ignore CLANGTIDY facebook-hte-std::call_once
+  std::call_once(
+      flag, []() { pthread_atfork(nullptr, nullptr, child_atfork); });
+  if ET_UNLIKELY (leak_corrupted_pool) {
+    leak_corrupted_pool = false;
+    if (auto leaked = pool.release()) {
+      pool = std::make_unique<WorkStealingThreadPool>(
+          leaked->get_thread_count());
+    }
+  }
+#endif
+  return pool.get();
+}
+
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// @nolint PATTERNLINT Ok to use stdlib for this optional library
+#include <atomic>
+// @nolint PATTERNLINT Ok to use stdlib for this optional library
+#include <condition_variable>
+// @nolint PATTERNLINT Ok to use stdlib for this optional library
+#include <deque>
+// @nolint PATTERNLINT Ok to use stdlib for this optional library
+#include <functional>
+// @nolint PATTERNLINT Ok to use stdlib for this optional library
+#include <memory>
+// @nolint PATTERNLINT Ok to use stdlib for this optional library
+#include <mutex>
+// @nolint PATTERNLINT Ok to use stdlib for this optional library
+#include <thread>
+// @nolint PATTERNLINT Ok to use stdlib for this optional library
+#include <vector>
+
+namespace executorch {
+namespace extension {
+
+/**
+ * A thread pool that schedules parallel_for() ranges by work stealing.
+ *
+ * Each call to run() splits its range into chunks, hands every participating
+ * thread an equal share of them, and lets threads that run out steal half of
+ * another thread's remaining chunks. The calling thread always participates,
+ * so a range completes even when every worker is busy with other callers.
+ *
+ * Unlike ThreadPool::run(), run() does not hold a lock while the range
+ * executes: any number of threads may call run() concurrently and their ranges
+ * share the workers. Each worker has its own queue of ranges to join; idle
+ * workers steal queued ranges from busy workers.
+ *
+ * Calling run() from inside a range that is already running on this pool
+ * executes the nested range inline on the current thread.
+ */
+class WorkStealingThreadPool final {
+ public:
+  /// Upper bound on the number of threads, including the caller, that can
+  /// work on a single range.
+  static constexpr size_t kMaxParticipants = 64;
+
+  /**
+   * Creates a pool whose ranges run on up to `thread_count` threads: the
+   * caller of run() plus `thread_count - 1` worker threads owned by the pool.
+   */
+  explicit WorkStealingThreadPool(size_t thread_count);
+  ~WorkStealingThreadPool();
+
+  WorkStealingThreadPool(const WorkStealingThreadPool&) = delete;
+  WorkStealingThreadPool& operator=(const WorkStealingThreadPool&) = delete;
+  WorkStealingThreadPool(WorkStealingThreadPool&&) = delete;
+  WorkStealingThreadPool& operator=(WorkStealingThreadPool&&) = delete;
+
+  /// Returns the maximum number of threads that can work on one range.
+  size_t get_thread_count() const;
+
+  /**
+   * Calls `fn(chunk_begin, chunk_end)` over disjoint chunks that together
+   * cover `[begin, end)`. Each chunk holds at least `grain_size` items, except
+   * possibly the last. Blocks until every chunk has completed.
+   *
+   * At most `max_threads` threads work on the range. While a thread runs a
+   * chunk, get_thread_num() returns an index in `[0, max_threads)` that no
+   * other thread working on the same range is using, so callers can use it to
+   * index per-thread scratch space sized by `max_threads`.
+   */
+  void run(
+      int64_t begin,
+      int64_t end,
+      int64_t grain_size,
+      size_t max_threads,
+      const std::function<void(int64_t, int64_t)>& fn);
+
+  /// Returns true if the current thread is running a chunk of some range.
+  static bool in_parallel_region();
+
+ private:
+  struct Job;
+
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Job*> jobs;
+    std::thread thread;
+  };
+
+  void worker_loop(size_t worker_index);
+  Job* take_job(size_t worker_index);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  /// Spreads successive callers across the workers' queues.
+  std::atomic<size_t> next_worker_;
+
+  /// Only guards sleeping and waking workers; never held while a range runs.
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  uint64_t epoch_;
+  bool stop_;
+};
+
+/**
+ * Returns the process-wide WorkStealingThreadPool used by parallel_for(). It
+ * has as many threads as the ThreadPool returned by get_threadpool() had when
+ * it was first created.
+ */
+WorkStealingThreadPool* get_work_stealing_thread_pool();
+
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <executorch/extension/threadpool/threadpool.h>
+#include <executorch/runtime/executor/task_runner.h>
+#include <executorch/runtime/platform/assert.h>
+
+namespace torch {
+namespace executorch {
+namespace threadpool {
+
+/**
+ * A TaskRunner that runs tasks on a ThreadPool, for use with
+ * Method::execute_parallel().
+ *
+ * The ThreadPool should be dedicated to this runner rather than the global
+ * one returned by get_threadpool(): kernels call into the global pool from
+ * inside their tasks, and ThreadPool::run() is not reentrant.
+ */
+class ThreadPoolTaskRunner final : public ::executorch::runtime::TaskRunner {
+ public:
+  /// Does not take ownership of `threadpool`, which must outlive this object.
+  explicit ThreadPoolTaskRunner(ThreadPool* threadpool)
+      : threadpool_(threadpool) {
+    ET_CHECK_MSG(threadpool_ != nullptr, "Null threadpool");
+  }
+
+  void run(TaskFunction task, void* context, size_t num_tasks) override {
+    threadpool_->run(
+        [task, context](size_t index) { task(context, index); }, num_tasks);
+  }
+
+ private:
+  ThreadPool* threadpool_;
+};
+
+} // namespace threadpool
+} // namespace executorch
+} // namespace torch
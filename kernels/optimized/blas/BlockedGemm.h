@@ -0,0 +1,458 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include <executorch/kernels/optimized/utils/math_utils.h>
+#include <executorch/kernels/optimized/utils/unroll.h>
+#include <executorch/kernels/optimized/vec/vec.h>
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+
+#ifdef ET_USE_THREADPOOL
+#include <executorch/extension/parallel/thread_parallel.h>
+#endif // ET_USE_THREADPOOL
+
+// Cache-blocked GEMM for the non-BLAS build, following the usual
+// Goto/BLIS structure:
+//
+//   for each NC-wide panel of columns of op(B) and C:
+//     for each KC-deep slice of the inner dimension:
+//       pack the KC x NC panel of op(B) into NR-wide slivers
+//       for each (MC-tall block of op(A), group of B slivers), in parallel:
+//         pack the MC x KC block of alpha * op(A) into MR-tall slivers
+//         for each MR x NR tile of C: run the micro-kernel over KC
+//
+// Packing turns every transpose case into the same contiguous access pattern,
+// so one micro-kernel serves all four. Inputs are widened to float as they are
+// packed, which lets Half and BFloat16 share the float micro-kernel and
+// accumulate in float. As in the rest of cpublas, all matrices are
+// column-major.
+
+namespace executorch {
+namespace cpublas {
+
+template <typename scalar_t>
+struct is_blocked_gemm_type : std::false_type {};
+template <>
+struct is_blocked_gemm_type<float> : std::true_type {};
+template <>
+struct is_blocked_gemm_type<torch::executor::Half> : std::true_type {};
+template <>
+struct is_blocked_gemm_type<torch::executor::BFloat16> : std::true_type {};
+
+namespace internal {
+
+using GemmVec = vec::Vectorized<float>;
+
+/// Vector registers per micro-tile column.
+constexpr int64_t kGemmMRVecs = 2;
+/// Rows of C computed by one micro-kernel call.
+constexpr int64_t kGemmMR = kGemmMRVecs * GemmVec::size();
+/// Columns of C computed by one micro-kernel call. MR x NR accumulators plus
+/// the A loads must fit in the register file.
+constexpr int64_t kGemmNR = 4;
+/// Depth of packed panels: an MR x KC sliver of A plus an NR x KC sliver of B
+/// stay resident in L1.
+constexpr int64_t kGemmKC = 256;
+/// Rows of A packed at once: an MC x KC block of A stays resident in L2.
+constexpr int64_t kGemmMC = 128;
+/// Columns of B packed at once; the packed KC x NC panel is shared by every
+/// thread.
+constexpr int64_t kGemmNC = 1024;
+/// Columns of a packed B panel handled by one parallel task.
+constexpr int64_t kGemmNCTask = 16 * kGemmNR;
+
+static_assert(kGemmMC % kGemmMR == 0, "MC must be a multiple of MR");
+static_assert(kGemmNC % kGemmNCTask == 0, "NC must be split evenly");
+static_assert(kGemmNCTask % kGemmNR == 0, "Tasks must hold whole slivers");
+
+/// Below this many multiply-adds, packing costs more than it saves.
+constexpr int64_t kBlockedGemmMinWork = 32 * 32 * 32;
+
+/// The micro-kernel is only fast when Vectorized<float> maps onto SIMD
+/// registers. Elsewhere the unblocked kernels, which compilers can
+/// auto-vectorize, are at least as fast.
+#if (defined(CPU_CAPABILITY_AVX2) && !defined(_MSC_VER)) || \
+    defined(__aarch64__)
+constexpr bool kBlockedGemmHasSimd = true;
+#else
+constexpr bool kBlockedGemmHasSimd = false;
+#endif
+
+/**
+ * Calls `fn(chunk_begin, chunk_end)` over chunks of `[begin, end)`, spread
+ * across threads when built with ET_USE_THREADPOOL.
+ */
+template <typename Func>
+void gemm_parallel_for(int64_t begin, int64_t end, const Func& fn) {
+  if (begin >= end) {
+    return;
+  }
+#ifdef ET_USE_THREADPOOL
+  if (end - begin > 1 &&
+      ::executorch::extension::parallel_for(begin, end, 1, fn)) {
+    return;
+  }
+#endif // ET_USE_THREADPOOL
+  fn(begin, end);
+}
+
+/**
+ * Packs rows `[i0, i0 + mc)` and columns `[l0, l0 + kc)` of alpha * op(A)
+ * into MR-tall slivers: element (r, p) of sliver s lands at
+ * `dst[s * MR * kc + p * MR + r]`. Rows past `mc` are zero-filled so the
+ * micro-kernel never needs a remainder path.
+ */
+template <typename scalar_t>
+void pack_a_(
+    bool trans_a,
+    int64_t i0,
+    int64_t mc,
+    int64_t l0,
+    int64_t kc,
+    float alpha,
+    const scalar_t* a,
+    int64_t lda,
+    float* dst) {
+  for (int64_t ir = 0; ir < mc; ir += kGemmMR) {
+    const int64_t mr = std::min(kGemmMR, mc - ir);
+    float* sliver = dst + ir * kc;
+    if (!trans_a) {
+      // op(A)(i, l) = a[l * lda + i]: rows are contiguous.
+      for (int64_t p = 0; p < kc; ++p) {
+        const scalar_t* src = a + (l0 + p) * lda + i0 + ir;
+        float* out = sliver + p * kGemmMR;
+        for (int64_t r = 0; r < mr; ++r) {
+          out[r] = alpha * static_cast<float>(src[r]);
+        }
+        for (int64_t r = mr; r < kGemmMR; ++r) {
+          out[r] = 0;
+        }
+      }
+    } else {
+      // op(A)(i, l) = a[i * lda + l]: the inner dimension is contiguous.
+      for (int64_t r = 0; r < kGemmMR; ++r) {
+        float* out = sliver + r;
+        if (r >= mr) {
+          for (int64_t p = 0; p < kc; ++p) {
+            out[p * kGemmMR] = 0;
+          }
+          continue;
+        }
+        const scalar_t* src = a + (i0 + ir + r) * lda + l0;
+        for (int64_t p = 0; p < kc; ++p) {
+          out[p * kGemmMR] = alpha * static_cast<float>(src[p]);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Packs NR-wide slivers `[s_begin, s_end)` of rows `[l0, l0 + kc)` and
+ * columns `[j0, j0 + nc)` of op(B): element (p, c) of sliver s lands at
+ * `dst[s * NR * kc + p * NR + c]`. Columns past `nc` are zero-filled.
+ */
+template <typename scalar_t>
+void pack_b_(
+    bool trans_b,
+    int64_t l0,
+    int64_t kc,
+    int64_t j0,
+    int64_t nc,
+    int64_t s_begin,
+    int64_t s_end,
+    const scalar_t* b,
+    int64_t ldb,
+    float* dst) {
+  for (int64_t s = s_begin; s < s_end; ++s) {
+    const int64_t jr = s * kGemmNR;
+    const int64_t nr = std::min(kGemmNR, nc - jr);
+    float* sliver = dst + jr * kc;
+    if (!trans_b) {
+      // op(B)(l, j) = b[j * ldb + l]: the inner dimension is contiguous.
+      for (int64_t col = 0; col < kGemmNR; ++col) {
+        float* out = sliver + col;
+        if (col >= nr) {
+          for (int64_t p = 0; p < kc; ++p) {
+            out[p * kGemmNR] = 0;
+          }
+          continue;
+        }
+        const scalar_t* src = b + (j0 + jr + col) * ldb + l0;
+        for (int64_t p = 0; p < kc; ++p) {
+          out[p * kGemmNR] = static_cast<float>(src[p]);
+        }
+      }
+    } else {
+      // op(B)(l, j) = b[l * ldb + j]: columns are contiguous.
+      for (int64_t p = 0; p < kc; ++p) {
+        const scalar_t* src = b + (l0 + p) * ldb + j0 + jr;
+        float* out = sliver + p * kGemmNR;
+        for (int64_t col = 0; col < nr; ++col) {
+          out[col] = static_cast<float>(src[col]);
+        }
+        for (int64_t col = nr; col < kGemmNR; ++col) {
+          out[col] = 0;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Computes the MR x NR product of a packed A sliver and a packed B sliver
+ * over depth `kc`, and stores it column-major into `tile`.
+ */
+inline void gemm_micro_kernel_(
+    int64_t kc,
+    const float* a,
+    const float* b,
+    float* tile) {
+  GemmVec acc[kGemmNR][kGemmMRVecs];
+  utils::ForcedUnroll<kGemmNR>{}([&acc](int j) {
+    utils::ForcedUnroll<kGemmMRVecs>{}(
+        [&acc, j](int v) { acc[j][v] = GemmVec(0.0f); });
+  });
+  for (int64_t p = 0; p < kc; ++p) {
+    GemmVec a_vecs[kGemmMRVecs];
+    utils::ForcedUnroll<kGemmMRVecs>{}([&a_vecs, a](int v) {
+      a_vecs[v] = GemmVec::loadu(a + v * GemmVec::size());
+    });
+    utils::ForcedUnroll<kGemmNR>{}([&acc, &a_vecs, b](int j) {
+      const GemmVec b_vec(b[j]);
+      utils::ForcedUnroll<kGemmMRVecs>{}([&acc, &a_vecs, &b_vec, j](int v) {
+        acc[j][v] = vec::fmadd(a_vecs[v], b_vec, acc[j][v]);
+      });
+    });
+    a += kGemmMR;
+    b += kGemmNR;
+  }
+  utils::ForcedUnroll<kGemmNR>{}([&acc, tile](int j) {
+    utils::ForcedUnroll<kGemmMRVecs>{}([&acc, tile, j](int v) {
+      acc[j][v].store(tile + j * kGemmMR + v * GemmVec::size());
+    });
+  });
+}
+
+/**
+ * Writes the top-left `mr` x `nr` corner of `tile`, whose columns are
+ * `ld_tile` apart, to C. The first slice of the inner dimension also applies
+ * beta; later slices accumulate.
+ */
+template <typename scalar_t>
+void update_c_tile_(
+    const float* tile,
+    int64_t ld_tile,
+    int64_t mr,
+    int64_t nr,
+    bool first_slice,
+    float beta,
+    scalar_t* c,
+    int64_t ldc) {
+  for (int64_t j = 0; j < nr; ++j) {
+    const float* src = tile + j * ld_tile;
+    scalar_t* dst = c + j * ldc;
+    if (!first_slice) {
+      for (int64_t i = 0; i < mr; ++i) {
+        dst[i] = static_cast<scalar_t>(static_cast<float>(dst[i]) + src[i]);
+      }
+    } else if (beta == 0.0f) {
+      // Per BLAS, C is not read when beta is zero, so NaNs in it are dropped.
+      for (int64_t i = 0; i < mr; ++i) {
+        dst[i] = static_cast<scalar_t>(src[i]);
+      }
+    } else {
+      for (int64_t i = 0; i < mr; ++i) {
+        dst[i] =
+            static_cast<scalar_t>(beta * static_cast<float>(dst[i]) + src[i]);
+      }
+    }
+  }
+}
+
+} // namespace internal
+
+/**
+ * Returns true if gemm_blocked_() should be used for a product of this shape
+ * on this target. Skinny products (matrix-vector and close to it) are left to
+ * the unblocked kernels, which stream the operands without packing them.
+ */
+inline bool use_blocked_gemm(int64_t m, int64_t n, int64_t k) {
+  return internal::kBlockedGemmHasSimd && m >= internal::kGemmMR / 2 &&
+      n >= internal::kGemmNR && k >= 8 &&
+      m * n * k >= internal::kBlockedGemmMinWork;
+}
+
+// clang-format off
+/**
+ * c = alpha * (op(a) @ op(b)) + beta * c, where op(x) is x.T if the matching
+ * `trans_*` flag is set. Accumulates in float whatever `scalar_t` is.
+ */
+template <typename scalar_t>
+void gemm_blocked_(
+    bool trans_a, bool trans_b,
+    int64_t m, int64_t n, int64_t k,
+    float alpha,
+    const scalar_t *a, int64_t lda,
+    const scalar_t *b, int64_t ldb,
+    float beta,
+    scalar_t *c, int64_t ldc) {
+  // clang-format on
+  using namespace internal;
+
+  const int64_t nc_max = std::min(kGemmNC, utils::divup(n, kGemmNR) * kGemmNR);
+  const int64_t kc_max = std::min(kGemmKC, k);
+  // Reused across calls. Worker threads only see it through packed_b_data,
+  // since naming a thread_local inside the tasks would get their own copy.
+  thread_local std::vector<float> packed_b;
+  packed_b.resize(nc_max * kc_max);
+  float* const packed_b_data = packed_b.data();
+
+  // Rounding C to Half or BFloat16 after every KC slice would lose precision
+  // as k grows, so those types sum the slices of each NC panel in a float
+  // copy of it and round once, after the last slice. It grows with m, so it
+  // is allocated per call rather than kept alive by the thread; next to the
+  // m * n * k multiply-adds that need it, the allocation is cheap.
+  const bool accumulate_in_float =
+      !std::is_same<scalar_t, float>::value && k > kGemmKC;
+  std::vector<float> c_float;
+  float* c_float_data = nullptr;
+  if (accumulate_in_float) {
+    c_float.resize(m * std::min(kGemmNC, n));
+    c_float_data = c_float.data();
+  }
+
+  for (int64_t j0 = 0; j0 < n; j0 += kGemmNC) {
+    const int64_t nc = std::min(kGemmNC, n - j0);
+    const int64_t num_slivers = utils::divup(nc, kGemmNR);
+    const int64_t num_n_tasks = utils::divup(nc, kGemmNCTask);
+    const int64_t num_m_tasks = utils::divup(m, kGemmMC);
+
+    for (int64_t l0 = 0; l0 < k; l0 += kGemmKC) {
+      const int64_t kc = std::min(kGemmKC, k - l0);
+      const bool first_slice = l0 == 0;
+      const bool last_slice = l0 + kc == k;
+
+      gemm_parallel_for(0, num_slivers, [&](int64_t begin, int64_t end) {
+        pack_b_(trans_b, l0, kc, j0, nc, begin, end, b, ldb, packed_b_data);
+      });
+
+      gemm_parallel_for(
+          0, num_m_tasks * num_n_tasks, [&](int64_t begin, int64_t end) {
+            // Reused across calls so each thread allocates it only once.
+            thread_local std::vector<float> packed_a;
+            packed_a.resize(kGemmMC * kGemmKC);
+            float tile[kGemmMR * kGemmNR];
+
+            // Consecutive tasks share a block of A, so only repack on change.
+            int64_t packed_i0 = -1;
+            for (int64_t task = begin; task < end; ++task) {
+              const int64_t i0 = (task / num_n_tasks) * kGemmMC;
+              const int64_t mc = std::min(kGemmMC, m - i0);
+              if (i0 != packed_i0) {
+                pack_a_(
+                    trans_a, i0, mc, l0, kc, alpha, a, lda, packed_a.data());
+                packed_i0 = i0;
+              }
+
+              const int64_t jt = (task % num_n_tasks) * kGemmNCTask;
+              const int64_t jt_end = std::min(jt + kGemmNCTask, nc);
+              for (int64_t jr = jt; jr < jt_end; jr += kGemmNR) {
+                const int64_t nr = std::min(kGemmNR, nc - jr);
+                const float* b_sliver = packed_b_data + jr * kc;
+                for (int64_t ir = 0; ir < mc; ir += kGemmMR) {
+                  const int64_t mr = std::min(kGemmMR, mc - ir);
+                  gemm_micro_kernel_(
+                      kc, packed_a.data() + ir * kc, b_sliver, tile);
+                  scalar_t* c_tile = c + (j0 + jr) * ldc + i0 + ir;
+                  if (c_float_data == nullptr) {
+                    update_c_tile_(
+                        tile, kGemmMR, mr, nr, first_slice, beta, c_tile, ldc);
+                    continue;
+                  }
+                  float* c_float_tile = c_float_data + jr * m + i0 + ir;
+                  update_c_tile_(
+                      tile,
+                      kGemmMR,
+                      mr,
+                      nr,
+                      first_slice,
+                      /*beta=*/0.0f,
+                      c_float_tile,
+                      m);
+                  if (last_slice) {
+                    update_c_tile_(
+                        c_float_tile,
+                        m,
+                        mr,
+                        nr,
+                        /*first_slice=*/true,
+                        beta,
+                        c_tile,
+                        ldc);
+                  }
+                }
+              }
+            }
+          });
+    }
+  }
+}
+
+// clang-format off
+/**
+ * Runs gemm_blocked_() and returns true if `scalar_t` is supported and the
+ * product is large enough to benefit; otherwise returns false without
+ * touching c.
+ */
+template <typename scalar_t, typename opmath_t>
+typename std::enable_if<is_blocked_gemm_type<scalar_t>::value, bool>::type
+try_gemm_blocked_(
+    bool trans_a, bool trans_b,
+    int64_t m, int64_t n, int64_t k,
+    opmath_t alpha,
+    const scalar_t *a, int64_t lda,
+    const scalar_t *b, int64_t ldb,
+    opmath_t beta,
+    scalar_t *c, int64_t ldc) {
+  if (!use_blocked_gemm(m, n, k)) {
+    return false;
+  }
+  gemm_blocked_(
+      trans_a, trans_b,
+      m, n, k,
+      static_cast<float>(alpha),
+      a, lda,
+      b, ldb,
+      static_cast<float>(beta),
+      c, ldc);
+  return true;
+}
+
+template <typename scalar_t, typename opmath_t>
+typename std::enable_if<!is_blocked_gemm_type<scalar_t>::value, bool>::type
+try_gemm_blocked_(
+    bool, bool,
+    int64_t, int64_t, int64_t,
+    opmath_t,
+    const scalar_t *, int64_t,
+    const scalar_t *, int64_t,
+    opmath_t,
+    scalar_t *, int64_t) {
+  return false;
+}
+// clang-format on
+
+} // namespace cpublas
+} // namespace executorch
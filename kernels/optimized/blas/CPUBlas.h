@@ -12,11 +12,13 @@
 #include <type_traits>
 
 #include <executorch/kernels/optimized/blas/BlasKernel.h>
+#include <executorch/kernels/optimized/blas/BlockedGemm.h>
 #include <executorch/runtime/core/exec_aten/exec_aten.h>
 
 namespace executorch {
 namespace cpublas {
 
+using BFloat16 = torch::executor::BFloat16;
 using Half = torch::executor::Half;
 
 enum class TransposeType {
@@ -55,6 +57,19 @@ void gemm_impl(
     const scalar_t *b, int64_t ldb,
     opmath_t beta,
     scalar_t *c, int64_t ldc) {
+  // Large float, Half and BFloat16 products go through the cache-blocked
+  // kernel, which handles every transpose combination.
+  if (try_gemm_blocked_(
+          transa != TransposeType::NoTranspose,
+          transb != TransposeType::NoTranspose,
+          m, n, k,
+          alpha,
+          a, lda,
+          b, ldb,
+          beta,
+          c, ldc)) {
+    return;
+  }
   if (transa == TransposeType::NoTranspose &&
       transb == TransposeType::NoTranspose) {
     return gemm_notrans_(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
@@ -106,6 +121,17 @@ void gemm(
     Half *c, int64_t ldc);
 // clang-format on
 
+// clang-format off
+void gemm(
+    TransposeType transa, TransposeType transb,
+    int64_t m, int64_t n, int64_t k,
+    const BFloat16 alpha,
+    const BFloat16 *a, int64_t lda,
+    const BFloat16 *b, int64_t ldb,
+    const BFloat16 beta,
+    BFloat16 *c, int64_t ldc);
+// clang-format on
+
 // clang-format off
 template <typename T,
           typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
@@ -0,0 +1,789 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+#include <executorch/kernels/optimized/blas/CPUBlas.h>
+#include <executorch/kernels/portable/cpu/util/kernel_ops_util.h>
+#include <executorch/runtime/core/exec_aten/util/dim_order_util.h>
+#include <executorch/runtime/kernel/kernel_includes.h>
+
+// Lowers convolution to cpublas::gemm.
+//
+// A (non-transposed) convolution of one group is the matrix product
+//
+//   out[oc][p] = sum_k weight[oc][k] * cols[k][p]
+//
+// where p runs over output pixels, k over (in channel, kernel y, kernel x),
+// and cols ("im2col") holds the input value each weight tap sees at each
+// output pixel. A transposed convolution is the reverse: the product
+// weight^T @ in scatters each input pixel into the output ("col2im").
+//
+// cols is staged in temp memory, in chunks of pixels (and of k, if a single
+// pixel does not fit) so that the scratch space stays bounded. Stride-1 3x3
+// float convolutions with enough channels use Winograd F(2x2, 3x3) instead,
+// which needs 16 multiplies per 2x2 output tile rather than 36.
+
+namespace torch {
+namespace executor {
+namespace native {
+
+using Tensor = exec_aten::Tensor;
+using ScalarType = exec_aten::ScalarType;
+using IntArrayRef = exec_aten::ArrayRef<int64_t>;
+using SizesArrayRef = exec_aten::ArrayRef<exec_aten::SizesType>;
+using DimOrderArrayRef = exec_aten::ArrayRef<exec_aten::DimOrderType>;
+
+namespace {
+
+/// Upper bound on the temp memory requested for one convolution.
+constexpr size_t kMaxScratchBytes = 4 * 1024 * 1024;
+
+/// Size of the on-stack scratch used when no temp memory is available.
+constexpr size_t kFallbackScratchBytes = 16 * 1024;
+
+/// Winograd only pays for its transforms with at least this many channels.
+constexpr int64_t kWinogradMinChannels = 8;
+
+/**
+ * A matrix whose element (i, j) is at `data[i * row_stride + j * col_stride]`.
+ * One of the two strides must be 1.
+ */
+template <typename T>
+struct MatrixView {
+  T* data;
+  int64_t row_stride;
+  int64_t col_stride;
+
+  MatrixView<T> transposed() const {
+    return {data, col_stride, row_stride};
+  }
+
+  /**
+   * Returns the view with any stride that does not matter, because its
+   * dimension has a single entry, replaced so that the view is a valid BLAS
+   * operand: one stride is 1 and the other covers the first dimension.
+   */
+  MatrixView<T> normalized(int64_t rows, int64_t cols) const {
+    MatrixView<T> view = *this;
+    if (cols == 1) {
+      if (view.row_stride == 1) {
+        view.col_stride = rows;
+      } else {
+        view.col_stride = 1;
+      }
+    }
+    if (rows == 1) {
+      if (view.col_stride == 1) {
+        view.row_stride = cols;
+      } else {
+        view.row_stride = 1;
+      }
+    }
+    return view;
+  }
+};
+
+/**
+ * Computes c = a @ b + beta * c for a (m x k), b (k x n) and c (m x n).
+ */
+template <typename CTYPE>
+void strided_gemm(
+    int64_t m,
+    int64_t n,
+    int64_t k,
+    MatrixView<const CTYPE> a,
+    MatrixView<const CTYPE> b,
+    CTYPE beta,
+    MatrixView<CTYPE> c) {
+  using executorch::cpublas::TransposeType;
+
+  a = a.normalized(m, k);
+  b = b.normalized(k, n);
+  c = c.normalized(m, n);
+  if (c.row_stride != 1) {
+    // gemm() writes column-major output, so compute c^T = b^T @ a^T.
+    const MatrixView<const CTYPE> a_t = b.transposed();
+    b = a.transposed();
+    a = a_t;
+    c = c.transposed();
+    std::swap(m, n);
+  }
+  ET_DCHECK(c.row_stride == 1);
+  ET_DCHECK(a.row_stride == 1 || a.col_stride == 1);
+  ET_DCHECK(b.row_stride == 1 || b.col_stride == 1);
+
+  const bool a_col_major = a.row_stride == 1;
+  const bool b_col_major = b.row_stride == 1;
+  // clang-format off
+  executorch::cpublas::gemm(
+      a_col_major ? TransposeType::NoTranspose : TransposeType::Transpose,
+      b_col_major ? TransposeType::NoTranspose : TransposeType::Transpose,
+      m, n, k,
+      static_cast<CTYPE>(1),
+      a.data, a_col_major ? a.col_stride : a.row_stride,
+      b.data, b_col_major ? b.col_stride : b.row_stride,
+      beta,
+      c.data, c.col_stride);
+  // clang-format on
+}
+
+/// Sizes and strides of a convolution, with 1D convolutions expressed as 2D.
+struct ConvGeometry {
+  int64_t batches;
+  int64_t groups;
+  int64_t in_C;
+  int64_t in_H;
+  int64_t in_W;
+  int64_t out_C;
+  int64_t out_H;
+  int64_t out_W;
+  // Weight height and width.
+  int64_t w_H;
+  int64_t w_W;
+  int64_t stride_y;
+  int64_t stride_x;
+  int64_t padding_y;
+  int64_t padding_x;
+  int64_t dilation_y;
+  int64_t dilation_x;
+  exec_aten::StridesType in_strides[4];
+  exec_aten::StridesType w_strides[4];
+  exec_aten::StridesType out_strides[4];
+
+  int64_t in_C_per_group() const {
+    return in_C / groups;
+  }
+  int64_t out_C_per_group() const {
+    return out_C / groups;
+  }
+};
+
+/**
+ * A scratch buffer of `capacity` elements: temp memory if the context has
+ * some, or a small on-stack buffer otherwise.
+ */
+template <typename CTYPE>
+struct Scratch {
+  CTYPE* data;
+  size_t capacity;
+  bool from_temp;
+};
+
+template <typename CTYPE>
+Scratch<CTYPE> get_scratch(
+    RuntimeContext& ctx,
+    size_t wanted,
+    CTYPE* fallback,
+    size_t fallback_capacity) {
+  wanted = std::min(wanted, kMaxScratchBytes / sizeof(CTYPE));
+  if (wanted > fallback_capacity) {
+    Result<void*> temp = ctx.allocate_temp(wanted * sizeof(CTYPE));
+    if (temp.ok()) {
+      return {static_cast<CTYPE*>(temp.get()), wanted, true};
+    }
+  }
+  return {fallback, fallback_capacity, false};
+}
+
+/**
+ * Fills rows `[k_begin, k_end)` and output pixels `[p_begin, p_end)` of the
+ * im2col matrix for one batch and group. Row k holds the weight tap whose
+ * offset within an output channel's weights is k, so that rows line up with
+ * the weight matrix whatever its dim order.
+ */
+template <typename CTYPE>
+void im2col(
+    const ConvGeometry& g,
+    const CTYPE* in_ptr,
+    int64_t batch,
+    int64_t group,
+    int64_t k_begin,
+    int64_t k_end,
+    int64_t p_begin,
+    int64_t p_end,
+    MatrixView<CTYPE> cols) {
+  const auto& is = g.in_strides;
+  const auto& ws = g.w_strides;
+  const CTYPE* in_group = in_ptr + batch * is[0] +
+      group * g.in_C_per_group() * static_cast<int64_t>(is[1]);
+
+  for (int64_t ic = 0; ic < g.in_C_per_group(); ++ic) {
+    for (int64_t w_y = 0; w_y < g.w_H; ++w_y) {
+      for (int64_t w_x = 0; w_x < g.w_W; ++w_x) {
+        const int64_t k = ic * ws[1] + w_y * ws[2] + w_x * ws[3];
+        if (k < k_begin || k >= k_end) {
+          continue;
+        }
+        CTYPE* row = cols.data + (k - k_begin) * cols.row_stride;
+        int64_t out_y = p_begin / g.out_W;
+        int64_t out_x = p_begin % g.out_W;
+        for (int64_t p = p_begin; p < p_end; ++p) {
+          const int64_t in_y =
+              out_y * g.stride_y + w_y * g.dilation_y - g.padding_y;
+          const int64_t in_x =
+              out_x * g.stride_x + w_x * g.dilation_x - g.padding_x;
+          CTYPE val = 0;
+          if (in_y >= 0 && in_y < g.in_H && in_x >= 0 && in_x < g.in_W) {
+            val = in_group[ic * is[1] + in_y * is[2] + in_x * is[3]];
+          }
+          row[(p - p_begin) * cols.col_stride] = val;
+          if (++out_x == g.out_W) {
+            out_x = 0;
+            ++out_y;
+          }
+        }
+      }
+    }
+  }
+}
+
+template <typename CTYPE>
+void conv2d_gemm(
+    RuntimeContext& ctx,
+    const ConvGeometry& g,
+    const CTYPE* in_ptr,
+    const CTYPE* w_ptr,
+    CTYPE* out_ptr) {
+  const auto& is = g.in_strides;
+  const auto& ws = g.w_strides;
+  const auto& os = g.out_strides;
+  const int64_t K = g.in_C_per_group() * g.w_H * g.w_W;
+  const int64_t P = g.out_H * g.out_W;
+  const int64_t out_C_per_group = g.out_C_per_group();
+
+  // A 1x1 convolution without stride or padding needs no im2col: the input
+  // already is the cols matrix.
+  const bool pointwise = g.w_H == 1 && g.w_W == 1 && g.stride_y == 1 &&
+      g.stride_x == 1 && g.padding_y == 0 && g.padding_x == 0;
+
+  CTYPE fallback[kFallbackScratchBytes / sizeof(CTYPE)];
+  Scratch<CTYPE> scratch{nullptr, 0, false};
+  if (!pointwise) {
+    scratch = get_scratch<CTYPE>(
+        ctx, K * P, fallback, sizeof(fallback) / sizeof(CTYPE));
+  }
+
+  for (int64_t batch = 0; batch < g.batches; ++batch) {
+    for (int64_t group = 0; group < g.groups; ++group) {
+      const MatrixView<const CTYPE> w_mat{
+          w_ptr + group * out_C_per_group * ws[0], ws[0], 1};
+      const MatrixView<CTYPE> out_mat{
+          out_ptr + batch * os[0] + group * out_C_per_group * os[1],
+          os[1],
+          os[3]};
+
+      if (pointwise) {
+        const MatrixView<const CTYPE> in_mat{
+            in_ptr + batch * is[0] + group * g.in_C_per_group() * is[1],
+            is[1],
+            is[3]};
+        strided_gemm<CTYPE>(
+            out_C_per_group, P, K, w_mat, in_mat, /*beta=*/1, out_mat);
+        continue;
+      }
+
+      const int64_t k_chunk =
+          std::min(K, static_cast<int64_t>(scratch.capacity));
+      const int64_t p_chunk = std::max(
+          int64_t(1),
+          std::min(P, static_cast<int64_t>(scratch.capacity) / k_chunk));
+      for (int64_t p0 = 0; p0 < P; p0 += p_chunk) {
+        const int64_t p1 = std::min(P, p0 + p_chunk);
+        for (int64_t k0 = 0; k0 < K; k0 += k_chunk) {
+          const int64_t k1 = std::min(K, k0 + k_chunk);
+          // Lay cols out the same way round as the output, so that gemm()
+          // streams both in the same direction.
+          const MatrixView<CTYPE> cols = out_mat.col_stride == 1
+              ? MatrixView<CTYPE>{scratch.data, p1 - p0, 1}
+              : MatrixView<CTYPE>{scratch.data, 1, k1 - k0};
+          im2col(g, in_ptr, batch, group, k0, k1, p0, p1, cols);
+          strided_gemm<CTYPE>(
+              out_C_per_group,
+              p1 - p0,
+              k1 - k0,
+              {w_mat.data + k0, w_mat.row_stride, w_mat.col_stride},
+              {cols.data, cols.row_stride, cols.col_stride},
+              /*beta=*/1,
+              {out_mat.data + p0 * out_mat.col_stride,
+               out_mat.row_stride,
+               out_mat.col_stride});
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Transposed convolution: for each chunk of input pixels, computes
+ * cols = weight^T @ in, whose row k holds the contribution of weight tap k,
+ * and adds each element to the output pixel it lands on.
+ */
+template <typename CTYPE>
+void conv2d_transposed_gemm(
+    RuntimeContext& ctx,
+    const ConvGeometry& g,
+    const CTYPE* in_ptr,
+    const CTYPE* w_ptr,
+    CTYPE* out_ptr) {
+  const auto& is = g.in_strides;
+  const auto& ws = g.w_strides;
+  const auto& os = g.out_strides;
+  const int64_t in_C_per_group = g.in_C_per_group();
+  const int64_t out_C_per_group = g.out_C_per_group();
+  // Weight taps feeding one input channel: (out channel, kernel y, kernel x).
+  const int64_t K = out_C_per_group * g.w_H * g.w_W;
+  const int64_t P = g.in_H * g.in_W;
+
+  CTYPE fallback[kFallbackScratchBytes / sizeof(CTYPE)];
+  const Scratch<CTYPE> scratch = get_scratch<CTYPE>(
+      ctx, K * P, fallback, sizeof(fallback) / sizeof(CTYPE));
+  const int64_t k_chunk = std::min(K, static_cast<int64_t>(scratch.capacity));
+  const int64_t p_chunk = std::max(
+      int64_t(1),
+      std::min(P, static_cast<int64_t>(scratch.capacity) / k_chunk));
+
+  for (int64_t batch = 0; batch < g.batches; ++batch) {
+    for (int64_t group = 0; group < g.groups; ++group) {
+      // Element (k, ic) of weight^T for this group.
+      const MatrixView<const CTYPE> w_t{
+          w_ptr + group * in_C_per_group * ws[0], 1, ws[0]};
+      const MatrixView<const CTYPE> in_mat{
+          in_ptr + batch * is[0] + group * in_C_per_group * is[1],
+          is[1],
+          is[3]};
+      CTYPE* out_group =
+          out_ptr + batch * os[0] + group * out_C_per_group * os[1];
+
+      for (int64_t p0 = 0; p0 < P; p0 += p_chunk) {
+        const int64_t p1 = std::min(P, p0 + p_chunk);
+        for (int64_t k0 = 0; k0 < K; k0 += k_chunk) {
+          const int64_t k1 = std::min(K, k0 + k_chunk);
+          const MatrixView<CTYPE> cols{scratch.data, 1, k1 - k0};
+          strided_gemm<CTYPE>(
+              k1 - k0,
+              p1 - p0,
+              in_C_per_group,
+              {w_t.data + k0, w_t.row_stride, w_t.col_stride},
+              {in_mat.data + p0 * in_mat.col_stride,
+               in_mat.row_stride,
+               in_mat.col_stride},
+              /*beta=*/0,
+              cols);
+
+          // col2im
+          for (int64_t p = p0; p < p1; ++p) {
+            const int64_t in_y = p / g.in_W;
+            const int64_t in_x = p % g.in_W;
+            const CTYPE* col = cols.data + (p - p0) * cols.col_stride;
+            for (int64_t oc = 0; oc < out_C_per_group; ++oc) {
+              for (int64_t w_y = 0; w_y < g.w_H; ++w_y) {
+                const int64_t out_y =
+                    in_y * g.stride_y + w_y * g.dilation_y - g.padding_y;
+                if (out_y < 0 || out_y >= g.out_H) {
+                  continue;
+                }
+                for (int64_t w_x = 0; w_x < g.w_W; ++w_x) {
+                  const int64_t k = oc * ws[1] + w_y * ws[2] + w_x * ws[3];
+                  const int64_t out_x =
+                      in_x * g.stride_x + w_x * g.dilation_x - g.padding_x;
+                  if (k < k0 || k >= k1 || out_x < 0 || out_x >= g.out_W) {
+                    continue;
+                  }
+                  out_group[oc * os[1] + out_y * os[2] + out_x * os[3]] +=
+                      col[k - k0];
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+/// Returns true if conv2d_winograd() applies to this convolution.
+template <typename CTYPE>
+bool use_winograd(const ConvGeometry& g) {
+  return std::is_same<CTYPE, float>::value && g.w_H == 3 && g.w_W == 3 &&
+      g.stride_y == 1 && g.stride_x == 1 && g.dilation_y == 1 &&
+      g.dilation_x == 1 && g.in_C_per_group() >= kWinogradMinChannels &&
+      g.out_C_per_group() >= kWinogradMinChannels;
+}
+
+/**
+ * Winograd F(2x2, 3x3): each 4x4 input tile d and 3x3 filter f are
+ * transformed to V = B^T d B and U = G f G^T, the 16 elementwise products
+ * are summed over input channels, which is 16 independent gemms, and each
+ * 4x4 result m is transformed back to the 2x2 output tile A^T m A.
+ *
+ * Returns false without touching the output if there is not enough temp
+ * memory; the caller should then fall back to conv2d_gemm().
+ */
+template <typename CTYPE>
+bool conv2d_winograd(
+    RuntimeContext& ctx,
+    const ConvGeometry& g,
+    const CTYPE* in_ptr,
+    const CTYPE* w_ptr,
+    CTYPE* out_ptr) {
+  const auto& is = g.in_strides;
+  const auto& ws = g.w_strides;
+  const auto& os = g.out_strides;
+  const int64_t in_C_per_group = g.in_C_per_group();
+  const int64_t out_C_per_group = g.out_C_per_group();
+  const int64_t tiles_H = (g.out_H + 1) / 2;
+  const int64_t tiles_W = (g.out_W + 1) / 2;
+  const int64_t num_tiles = tiles_H * tiles_W;
+
+  // U holds every transformed filter of a group. V and M hold a chunk of
+  // tiles, sized so that the whole request stays within kMaxScratchBytes.
+  const int64_t u_size = 16 * out_C_per_group * in_C_per_group;
+  const int64_t per_tile = 16 * (in_C_per_group + out_C_per_group);
+  const int64_t budget =
+      static_cast<int64_t>(kMaxScratchBytes / sizeof(CTYPE)) - u_size;
+  if (budget < per_tile) {
+    return false;
+  }
+  const int64_t tile_chunk = std::min(num_tiles, budget / per_tile);
+  Result<void*> temp = ctx.allocate_temp(
+      static_cast<size_t>(u_size + per_tile * tile_chunk) * sizeof(CTYPE));
+  if (!temp.ok()) {
+    return false;
+  }
+  CTYPE* const u = static_cast<CTYPE*>(temp.get());
+  CTYPE* const v = u + u_size;
+  CTYPE* const m = v + 16 * in_C_per_group * tile_chunk;
+
+  for (int64_t group = 0; group < g.groups; ++group) {
+    // U[xi][oc][ic] = (G f G^T)[xi]
+    for (int64_t oc = 0; oc < out_C_per_group; ++oc) {
+      for (int64_t ic = 0; ic < in_C_per_group; ++ic) {
+        const CTYPE* f = w_ptr + (group * out_C_per_group + oc) * ws[0] +
+            ic * ws[1];
+        CTYPE gf[4][3];
+        for (int j = 0; j < 3; ++j) {
+          const CTYPE f0 = f[0 * ws[2] + j * ws[3]];
+          const CTYPE f1 = f[1 * ws[2] + j * ws[3]];
+          const CTYPE f2 = f[2 * ws[2] + j * ws[3]];
+          gf[0][j] = f0;
+          gf[1][j] = (f0 + f1 + f2) * CTYPE(0.5);
+          gf[2][j] = (f0 - f1 + f2) * CTYPE(0.5);
+          gf[3][j] = f2;
+        }
+        for (int i = 0; i < 4; ++i) {
+          const CTYPE ggt[4] = {
+              gf[i][0],
+              (gf[i][0] + gf[i][1] + gf[i][2]) * CTYPE(0.5),
+              (gf[i][0] - gf[i][1] + gf[i][2]) * CTYPE(0.5),
+              gf[i][2]};
+          for (int j = 0; j < 4; ++j) {
+            u[((i * 4 + j) * out_C_per_group + oc) * in_C_per_group + ic] =
+                ggt[j];
+          }
+        }
+      }
+    }
+
+    for (int64_t batch = 0; batch < g.batches; ++batch) {
+      const CTYPE* in_group =
+          in_ptr + batch * is[0] + group * in_C_per_group * is[1];
+      CTYPE* out_group =
+          out_ptr + batch * os[0] + group * out_C_per_group * os[1];
+
+      for (int64_t t0 = 0; t0 < num_tiles; t0 += tile_chunk) {
+        const int64_t t1 = std::min(num_tiles, t0 + tile_chunk);
+        const int64_t nt = t1 - t0;
+
+        // V[xi][ic][t] = (B^T d B)[xi]
+        for (int64_t ic = 0; ic < in_C_per_group; ++ic) {
+          for (int64_t t = t0; t < t1; ++t) {
+            const int64_t y0 = (t / tiles_W) * 2 - g.padding_y;
+            const int64_t x0 = (t % tiles_W) * 2 - g.padding_x;
+            CTYPE d[4][4];
+            for (int i = 0; i < 4; ++i) {
+              for (int j = 0; j < 4; ++j) {
+                const int64_t y = y0 + i;
+                const int64_t x = x0 + j;
+                d[i][j] = (y >= 0 && y < g.in_H && x >= 0 && x < g.in_W)
+                    ? in_group[ic * is[1] + y * is[2] + x * is[3]]
+                    : CTYPE(0);
+              }
+            }
+            CTYPE btd[4][4];
+            for (int j = 0; j < 4; ++j) {
+              btd[0][j] = d[0][j] - d[2][j];
+              btd[1][j] = d[1][j] + d[2][j];
+              btd[2][j] = d[2][j] - d[1][j];
+              btd[3][j] = d[1][j] - d[3][j];
+            }
+            for (int i = 0; i < 4; ++i) {
+              const CTYPE btdb[4] = {
+                  btd[i][0] - btd[i][2],
+                  btd[i][1] + btd[i][2],
+                  btd[i][2] - btd[i][1],
+                  btd[i][1] - btd[i][3]};
+              for (int j = 0; j < 4; ++j) {
+                v[((i * 4 + j) * in_C_per_group + ic) * nt + (t - t0)] =
+                    btdb[j];
+              }
+            }
+          }
+        }
+
+        // M[xi] = U[xi] @ V[xi]
+        for (int64_t xi = 0; xi < 16; ++xi) {
+          strided_gemm<CTYPE>(
+              out_C_per_group,
+              nt,
+              in_C_per_group,
+              {u + xi * out_C_per_group * in_C_per_group, in_C_per_group, 1},
+              {v + xi * in_C_per_group * nt, nt, 1},
+              /*beta=*/0,
+              {m + xi * out_C_per_group * nt, nt, 1});
+        }
+
+        // out += A^T m A
+        for (int64_t oc = 0; oc < out_C_per_group; ++oc) {
+          for (int64_t t = t0; t < t1; ++t) {
+            CTYPE mt[4][4];
+            for (int i = 0; i < 4; ++i) {
+              for (int j = 0; j < 4; ++j) {
+                mt[i][j] = m[((i * 4 + j) * out_C_per_group + oc) * nt +
+                             (t - t0)];
+              }
+            }
+            CTYPE atm[2][4];
+            for (int j = 0; j < 4; ++j) {
+              atm[0][j] = mt[0][j] + mt[1][j] + mt[2][j];
+              atm[1][j] = mt[1][j] - mt[2][j] - mt[3][j];
+            }
+            const int64_t y0 = (t / tiles_W) * 2;
+            const int64_t x0 = (t % tiles_W) * 2;
+            for (int i = 0; i < 2 && y0 + i < g.out_H; ++i) {
+              const CTYPE y[2] = {
+                  atm[i][0] + atm[i][1] + atm[i][2],
+                  atm[i][1] - atm[i][2] - atm[i][3]};
+              for (int j = 0; j < 2 && x0 + j < g.out_W; ++j) {
+                out_group[oc * os[1] + (y0 + i) * os[2] + (x0 + j) * os[3]] +=
+                    y[j];
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+template <typename CTYPE, typename CTYPE_BIAS>
+void convolution_wrapper(
+    RuntimeContext& ctx,
+    const Tensor& in,
+    const Tensor& weight,
+    const exec_aten::optional<Tensor>& bias,
+    IntArrayRef stride,
+    IntArrayRef padding,
+    IntArrayRef dilation,
+    bool transposed,
+    int64_t groups,
+    Tensor& out) {
+  SizesArrayRef in_sizes = in.sizes();
+  SizesArrayRef weight_sizes = weight.sizes();
+  SizesArrayRef out_sizes = out.sizes();
+
+  DimOrderArrayRef in_dim_order = in.dim_order();
+  DimOrderArrayRef weight_dim_order = weight.dim_order();
+  DimOrderArrayRef out_dim_order = out.dim_order();
+
+  exec_aten::SizesType in_sizes_arr[kTensorDimensionLimit];
+  exec_aten::DimOrderType in_dim_order_arr[kTensorDimensionLimit];
+  size_t in_ndim;
+  exec_aten::SizesType weight_sizes_arr[kTensorDimensionLimit];
+  exec_aten::DimOrderType weight_dim_order_arr[kTensorDimensionLimit];
+  size_t weight_ndim;
+  exec_aten::SizesType out_sizes_arr[kTensorDimensionLimit];
+  exec_aten::DimOrderType out_dim_order_arr[kTensorDimensionLimit];
+  size_t out_ndim;
+
+  ConvGeometry g;
+  g.stride_y = val_at(stride, 0);
+  g.padding_y = val_at(padding, 0, /*default_value=*/0);
+  g.dilation_y = val_at(dilation, 0);
+  g.stride_x = val_at(stride, 1);
+  g.padding_x = val_at(padding, 1, /*default_value=*/0);
+  g.dilation_x = val_at(dilation, 1);
+
+  // As in the portable kernel, a 1D convolution is run as a 2D convolution
+  // whose height dim is 1.
+  if (in.dim() == 3) {
+    get_unsqueezed_sizes(in, 2, in_sizes_arr, in_ndim);
+    in_sizes = {in_sizes_arr, in_ndim};
+    get_unsqueezed_dim_order(in, 2, in_dim_order_arr);
+    in_dim_order = {in_dim_order_arr, in_ndim};
+
+    get_unsqueezed_sizes(weight, 2, weight_sizes_arr, weight_ndim);
+    weight_sizes = {weight_sizes_arr, weight_ndim};
+    get_unsqueezed_dim_order(weight, 2, weight_dim_order_arr);
+    weight_dim_order = {weight_dim_order_arr, weight_ndim};
+
+    get_unsqueezed_sizes(out, 2, out_sizes_arr, out_ndim);
+    out_sizes = {out_sizes_arr, out_ndim};
+    get_unsqueezed_dim_order(out, 2, out_dim_order_arr);
+    out_dim_order = {out_dim_order_arr, out_ndim};
+
+    g.stride_y = 1;
+    g.stride_x = stride[0];
+    g.padding_y = 0;
+    g.padding_x = padding[0];
+    g.dilation_y = 1;
+    g.dilation_x = dilation.size() > 0 ? dilation[0] : 1;
+  }
+
+  dim_order_to_stride_nocheck(
+      in_sizes.data(), in_dim_order.data(), in_sizes.size(), g.in_strides);
+  dim_order_to_stride_nocheck(
+      weight_sizes.data(),
+      weight_dim_order.data(),
+      weight_sizes.size(),
+      g.w_strides);
+  dim_order_to_stride_nocheck(
+      out_sizes.data(), out_dim_order.data(), out_sizes.size(), g.out_strides);
+
+  g.batches = out_sizes[0];
+  g.groups = groups;
+  g.in_C = in_sizes[1];
+  g.in_H = in_sizes[2];
+  g.in_W = in_sizes[3];
+  g.out_C = out_sizes[1];
+  g.out_H = out_sizes[2];
+  g.out_W = out_sizes[3];
+  g.w_H = weight_sizes[2];
+  g.w_W = weight_sizes[3];
+
+  CTYPE* const out_ptr = out.mutable_data_ptr<CTYPE>();
+  const CTYPE* const in_ptr = in.const_data_ptr<CTYPE>();
+  const CTYPE* const w_ptr = weight.const_data_ptr<CTYPE>();
+  const CTYPE_BIAS* const bias_ptr =
+      bias.has_value() ? bias.value().const_data_ptr<CTYPE_BIAS>() : nullptr;
+
+  // Every path below accumulates into the output, so start from the bias.
+  if (bias_ptr == nullptr) {
+    memset(out_ptr, 0, out.nbytes());
+  } else {
+    for (ssize_t out_ix = 0; out_ix < out.numel(); ++out_ix) {
+      out_ptr[out_ix] = convert<CTYPE, CTYPE_BIAS>(
+          bias_ptr[(out_ix / g.out_strides[1]) % g.out_C]);
+    }
+  }
+
+  if (transposed) {
+    conv2d_transposed_gemm(ctx, g, in_ptr, w_ptr, out_ptr);
+  } else if (
+      !use_winograd<CTYPE>(g) ||
+      !conv2d_winograd(ctx, g, in_ptr, w_ptr, out_ptr)) {
+    conv2d_gemm(ctx, g, in_ptr, w_ptr, out_ptr);
+  }
+}
+
+} // namespace
+
+Tensor& opt_convolution_out(
+    RuntimeContext& ctx,
+    const Tensor& in,
+    const Tensor& weight,
+    const exec_aten::optional<Tensor>& bias,
+    IntArrayRef stride,
+    IntArrayRef padding,
+    IntArrayRef dilation,
+    bool transposed,
+    IntArrayRef output_padding,
+    int64_t groups,
+    Tensor& out) {
+  ET_KERNEL_CHECK(
+      ctx,
+      check_convolution_args(
+          in,
+          weight,
+          bias,
+          stride,
+          padding,
+          dilation,
+          transposed,
+          output_padding,
+          groups,
+          out),
+      InvalidArgument,
+      out);
+
+  ET_KERNEL_CHECK(
+      ctx, tensors_have_same_dim_order(in, out), InvalidArgument, out);
+
+  size_t output_ndim = 0;
+  exec_aten::SizesType output_sizes[kTensorDimensionLimit];
+  get_convolution_out_target_size(
+      in,
+      weight,
+      stride,
+      padding,
+      dilation,
+      transposed,
+      output_padding,
+      groups,
+      output_sizes,
+      &output_ndim);
+
+  ET_KERNEL_CHECK(
+      ctx,
+      output_size_is_valid({output_sizes, output_ndim}, in.dim() - 2),
+      InvalidArgument,
+      out);
+
+  ET_KERNEL_CHECK(
+      ctx,
+      resize_tensor(out, {output_sizes, output_ndim}) == Error::Ok,
+      InvalidArgument,
+      out);
+
+  if (out.numel() == 0) {
+    return out;
+  }
+
+  ScalarType in_type = in.scalar_type();
+  ScalarType bias_type = in_type;
+  if (bias.has_value()) {
+    bias_type = bias.value().scalar_type();
+  }
+
+  constexpr auto name = "convolution.out";
+
+  ET_SWITCH_REALH_TYPES(in_type, ctx, name, CTYPE, [&]() {
+    ET_SWITCH_REALHB_TYPES(bias_type, ctx, name, CTYPE_BIAS, [&]() {
+      convolution_wrapper<CTYPE, CTYPE_BIAS>(
+          ctx,
+          in,
+          weight,
+          bias,
+          stride,
+          padding,
+          dilation,
+          transposed,
+          groups,
+          out);
+    });
+  });
+
+  return out;
+}
+
+} // namespace native
+} // namespace executor
+} // namespace torch
@@ -16,6 +16,13 @@ _OPTIMIZED_ATEN_OPS = (
             "//executorch/kernels/optimized:libblas",
         ],
     ),
+    op_target(
+        name = "op_convolution",
+        deps = [
+            "//executorch/kernels/optimized:libblas",
+            "//executorch/kernels/portable/cpu/util:kernel_ops_util",
+        ],
+    ),
     op_target(
         name = "op_div",
         deps = [
@@ -38,6 +38,11 @@ def get_vec_fbcode_preprocessor_flags():
     ]
     return preprocessor_flags
 
+# Splits large gemm() calls across threads when built with
+# `-c executorch.optimized_blas_use_threadpool=true`.
+def _blas_use_threadpool():
+    return native.read_config("executorch", "optimized_blas_use_threadpool", "false") == "true"
+
 # Currently, having a dependency on fbsource//third-party/sleef:sleef may cause
 # duplicate symbol errors when linking fbcode targets in opt mode that also
 # depend on ATen. This is because ATen accesses sleef via the third-party folder
@@ -129,6 +134,8 @@ def define_libs():
                 ] if not runtime.is_oss else [],
                 "DEFAULT": [],
             }),
+            # The cache-blocked gemm kernel is built on libvec.
+            cxx_platform_preprocessor_flags = get_vec_cxx_preprocessor_flags(),
             fbandroid_platform_preprocessor_flags = [
                 (
                     "^android-arm64.*$",
@@ -136,7 +143,7 @@ def define_libs():
                         "-DET_BUILD_WITH_BLAS",
                     ],
                 ),
-            ],
+            ] + get_vec_android_preprocessor_flags(),
             fbandroid_platform_deps = [
                 (
                     "^android-arm64.*$",
@@ -158,6 +165,10 @@ def define_libs():
             }),
             exported_deps = [
                 "//executorch/kernels/optimized:libutils",
+                "//executorch/kernels/optimized:libvec",
                 "//executorch/runtime/core/exec_aten:lib",
-            ],
+            ] + ([
+                "//executorch/extension/parallel:thread_parallel",
+            ] if _blas_use_threadpool() else []),
+            exported_preprocessor_flags = ["-DET_USE_THREADPOOL"] if _blas_use_threadpool() else [],
         )
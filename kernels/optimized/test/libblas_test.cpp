@@ -10,6 +10,7 @@
 
 #include <executorch/kernels/optimized/blas/CPUBlas.h>
 
+#include <cmath>
 #include <vector>
 
 #define TEST_FORALL_SUPPORTED_CTYPES(_, N) \
@@ -74,3 +75,187 @@ void test_matmul_ones() {
 TEST(BlasTest, MatmulOnes) {
   TEST_FORALL_SUPPORTED_CTYPES(test_matmul_ones, 25);
 }
+
+namespace {
+
+using executorch::cpublas::TransposeType;
+
+// Column-major op(x)(i, j) for a matrix stored with leading dimension ld.
+template <typename T>
+double
+op_at(const std::vector<T>& x, bool trans, int64_t ld, int64_t i, int64_t j) {
+  return static_cast<double>(trans ? x[i * ld + j] : x[j * ld + i]);
+}
+
+template <typename T>
+std::vector<T> make_matrix(int64_t size, int seed) {
+  std::vector<T> x(size);
+  for (int64_t i = 0; i < size; ++i) {
+    // Small integers and halves are exact in Half and BFloat16.
+    x[i] = static_cast<T>(static_cast<float>((i * 7 + seed) % 11 - 5) * 0.5f);
+  }
+  return x;
+}
+
+// Compares gemm(), or gemm_blocked_() if `blocked` is set, against a
+// double-precision reference for one shape, with padded leading dimensions.
+template <typename T>
+void check_gemm(
+    bool blocked,
+    TransposeType transa,
+    TransposeType transb,
+    int64_t m,
+    int64_t n,
+    int64_t k,
+    float alpha,
+    float beta,
+    double tolerance) {
+  const bool ta = transa != TransposeType::NoTranspose;
+  const bool tb = transb != TransposeType::NoTranspose;
+  const int64_t lda = (ta ? k : m) + 3;
+  const int64_t ldb = (tb ? n : k) + 1;
+  const int64_t ldc = m + 2;
+  const auto a = make_matrix<T>(lda * (ta ? m : k), 1);
+  const auto b = make_matrix<T>(ldb * (tb ? k : n), 2);
+  auto c = make_matrix<T>(ldc * n, 3);
+  const auto c_in = c;
+
+  if (blocked) {
+    executorch::cpublas::gemm_blocked_(
+        ta,
+        tb,
+        m,
+        n,
+        k,
+        alpha,
+        a.data(),
+        lda,
+        b.data(),
+        ldb,
+        beta,
+        c.data(),
+        ldc);
+  } else {
+    executorch::cpublas::gemm(
+        transa,
+        transb,
+        m,
+        n,
+        k,
+        static_cast<T>(alpha),
+        a.data(),
+        lda,
+        b.data(),
+        ldb,
+        static_cast<T>(beta),
+        c.data(),
+        ldc);
+  }
+
+  for (int64_t j = 0; j < n; ++j) {
+    for (int64_t i = 0; i < m; ++i) {
+      double dot = 0;
+      for (int64_t l = 0; l < k; ++l) {
+        dot += op_at(a, ta, lda, i, l) * op_at(b, tb, ldb, l, j);
+      }
+      const double expected =
+          alpha * dot + beta * static_cast<double>(c_in[j * ldc + i]);
+      const double actual = static_cast<double>(c[j * ldc + i]);
+      ASSERT_NEAR(actual, expected, tolerance * (1 + std::abs(expected)))
+          << "m=" << m << " n=" << n << " k=" << k << " i=" << i
+          << " j=" << j << " ta=" << ta << " tb=" << tb
+          << " blocked=" << blocked;
+    }
+    // Padding rows of C must be left alone.
+    for (int64_t i = m; i < ldc; ++i) {
+      ASSERT_EQ(
+          static_cast<double>(c[j * ldc + i]),
+          static_cast<double>(c_in[j * ldc + i]));
+    }
+  }
+}
+
+template <typename T>
+void check_gemm_all_transposes(
+    int64_t m,
+    int64_t n,
+    int64_t k,
+    double tolerance,
+    bool blocked_only = false) {
+  for (auto transa : {TransposeType::NoTranspose, TransposeType::Transpose}) {
+    for (auto transb : {TransposeType::NoTranspose, TransposeType::Transpose}) {
+      for (bool blocked : {false, true}) {
+        if (blocked_only && !blocked) {
+          continue;
+        }
+        check_gemm<T>(blocked, transa, transb, m, n, k, 0.5f, 2.0f, tolerance);
+        check_gemm<T>(blocked, transa, transb, m, n, k, 1.0f, 0.0f, tolerance);
+      }
+    }
+  }
+}
+
+} // namespace
+
+TEST(BlasTest, GemmFloatMatchesReference) {
+  // Shapes below, at, and across the blocking boundaries of every loop,
+  // including ragged edges in M, N and K. gemm() itself only takes the
+  // blocked path for large enough shapes on SIMD targets, so each shape is
+  // also run through gemm_blocked_() directly.
+  check_gemm_all_transposes<float>(3, 5, 7, 1e-5);
+  check_gemm_all_transposes<float>(17, 9, 33, 1e-5);
+  check_gemm_all_transposes<float>(64, 64, 64, 1e-5);
+  check_gemm_all_transposes<float>(131, 37, 45, 1e-5);
+  check_gemm_all_transposes<float>(29, 70, 300, 1e-5);
+  check_gemm_all_transposes<float>(20, 1030, 40, 1e-5);
+}
+
+TEST(BlasTest, GemmHalfMatchesReference) {
+  check_gemm_all_transposes<executorch::cpublas::Half>(33, 41, 70, 1e-2);
+}
+
+TEST(BlasTest, GemmBFloat16MatchesReference) {
+  check_gemm_all_transposes<executorch::cpublas::BFloat16>(33, 41, 70, 1e-2);
+}
+
+TEST(BlasTest, GemmHalfLongInnerDimMatchesReference) {
+  check_gemm_all_transposes<executorch::cpublas::Half>(33, 41, 700, 1e-2);
+}
+
+TEST(BlasTest, GemmBFloat16LongInnerDimMatchesReference) {
+  check_gemm_all_transposes<executorch::cpublas::BFloat16>(33, 41, 700, 1e-2);
+}
+
+TEST(BlasTest, GemmBlockedLongInnerDimRoundsOnce) {
+  // k spans several slices of the blocked kernel. The products and their sums
+  // are exact in float, so C must be within half an ulp of the reference:
+  // rounding it to Half or BFloat16 between slices adds an error per slice.
+  check_gemm_all_transposes<executorch::cpublas::Half>(
+      33, 41, 700, 1e-3, /*blocked_only=*/true);
+  check_gemm_all_transposes<executorch::cpublas::BFloat16>(
+      33, 41, 700, 4e-3, /*blocked_only=*/true);
+}
+
+TEST(BlasTest, GemmZeroBetaIgnoresNaN) {
+  const int64_t n = 48;
+  std::vector<float> a(n * n, 1.0f);
+  std::vector<float> b(n * n, 1.0f);
+  std::vector<float> c(n * n, NAN);
+
+  executorch::cpublas::gemm(
+      TransposeType::NoTranspose,
+      TransposeType::NoTranspose,
+      n,
+      n,
+      n,
+      1.0f,
+      a.data(),
+      n,
+      b.data(),
+      n,
+      0.0f,
+      c.data(),
+      n);
+
+  EXPECT_TRUE(check_all_equal_to(c, static_cast<float>(n)));
+}
@@ -43,18 +43,21 @@ Tensor& sum_dim_out(
         ET_SWITCH_REAL_TYPES_AND(
             Bool, out.scalar_type(), ctx, "sum.IntList_out", CTYPE_OUT, [&] {
               CTYPE_OUT* out_data = out.mutable_data_ptr<CTYPE_OUT>();
-              for (size_t out_ix = 0; out_ix < out.numel(); ++out_ix) {
-                CTYPE_OUT sum = 0;
-                if (in.numel() > 0) {
-                  sum = map_reduce_over_dim_list<CTYPE_IN, CTYPE_OUT>(
-                      [](CTYPE_IN v) { return static_cast<CTYPE_OUT>(v); },
-                      [](CTYPE_OUT outv, CTYPE_OUT acc) { return acc + outv; },
-                      in,
-                      dim_list,
-                      out_ix);
-                }
-                out_data[out_ix] = sum;
-              }
+              parallel_for_each_reduce_over_dim_list(
+                  in, dim_list, out, [&](const size_t out_ix) {
+                    CTYPE_OUT sum = 0;
+                    if (in.numel() > 0) {
+                      sum = map_reduce_over_dim_list<CTYPE_IN, CTYPE_OUT>(
+                          [](CTYPE_IN v) { return static_cast<CTYPE_OUT>(v); },
+                          [](CTYPE_OUT outv, CTYPE_OUT acc) {
+                            return acc + outv;
+                          },
+                          in,
+                          dim_list,
+                          out_ix);
+                    }
+                    out_data[out_ix] = sum;
+                  });
             });
       });
 
@@ -8,8 +8,10 @@
 
 #pragma once
 
+#include <executorch/kernels/portable/cpu/util/parallel_util.h>
 #include <executorch/runtime/core/exec_aten/exec_aten.h>
 #include <executorch/runtime/core/exec_aten/util/tensor_util.h>
+#include <algorithm>
 
 namespace torch {
 namespace executor {
@@ -270,43 +272,276 @@ size_t linearize_access_indexes(
 // Mapping with broadcasting
 //
 
+namespace internal {
+
 /**
- * Useful for binary elementwise operators. For each element of the inputs,
- * perform a computation and write to the corresponding element of the output.
- * Tensor broadcasting is applied wherever it is required.
+ * Walks the elements `[begin, end)` of the contiguous tensor `out` one run at
+ * a time, where a run is a stretch of the innermost dimension. For each run,
+ * calls:
+ *
+ *   fn(out_ix, n, in_ixs, in_steps)
+ *
+ * where the run covers out elements `[out_ix, out_ix + n)`, and the run's
+ * element `j` of input `k` is at flat index `in_ixs[k] + j * in_steps[k]`.
+ * `in_steps[k]` is 0 when input `k` is broadcast along the innermost
+ * dimension.
+ *
+ * Inputs with the same shape as `out` are indexed as contiguous, like
+ * `out`; broadcast inputs are indexed through their strides. Dimensions that
+ * every input walks contiguously are merged first, so same-shape and scalar
+ * inputs produce a single run, and bias-style broadcasts produce one run per
+ * row. The input indexes are updated incrementally, without a division per
+ * element.
  */
+template <size_t kNumInputs, typename Fn>
+inline void for_each_broadcast_run(
+    const Tensor& out,
+    const Tensor* const (&inputs)[kNumInputs],
+    const size_t begin,
+    const size_t end,
+    const Fn& fn) {
+  if (begin >= end) {
+    return;
+  }
+
+  // Sizes and per-input strides of the merged dimensions, innermost first.
+  size_t sizes[kTensorDimensionLimit];
+  size_t strides[kNumInputs][kTensorDimensionLimit];
+  size_t ndim = 0;
+
+  const ssize_t out_dim = out.dim();
+  size_t contiguous_stride = 1;
+  for (ssize_t d = out_dim - 1; d >= 0; --d) {
+    const size_t size = out.size(d);
+    if (size == 1) {
+      continue;
+    }
+    size_t dim_strides[kNumInputs];
+    for (size_t k = 0; k < kNumInputs; ++k) {
+      const Tensor& in = *inputs[k];
+      if (in.sizes().equals(out.sizes())) {
+        dim_strides[k] = contiguous_stride;
+        continue;
+      }
+      const ssize_t in_d = d - (out_dim - in.dim());
+      if (in_d < 0 || in.size(in_d) == 1) {
+        dim_strides[k] = 0;
+        continue;
+      }
+      ET_CHECK_MSG(
+          static_cast<size_t>(in.size(in_d)) == size,
+          "Expected dim size == 1 if broadcasted, but actual dim size is %zu",
+          static_cast<size_t>(in.size(in_d)));
+      dim_strides[k] = in.strides()[in_d];
+    }
+    bool mergeable = ndim > 0;
+    for (size_t k = 0; mergeable && k < kNumInputs; ++k) {
+      mergeable = dim_strides[k] == strides[k][ndim - 1] * sizes[ndim - 1];
+    }
+    if (mergeable) {
+      sizes[ndim - 1] *= size;
+    } else {
+      sizes[ndim] = size;
+      for (size_t k = 0; k < kNumInputs; ++k) {
+        strides[k][ndim] = dim_strides[k];
+      }
+      ndim++;
+    }
+    contiguous_stride *= size;
+  }
+  if (ndim == 0) {
+    // A single element.
+    sizes[0] = 1;
+    for (size_t k = 0; k < kNumInputs; ++k) {
+      strides[k][0] = 0;
+    }
+    ndim = 1;
+  }
+
+  // Position every index at `begin`.
+  size_t counters[kTensorDimensionLimit];
+  size_t in_ixs[kNumInputs] = {};
+  size_t remaining = begin;
+  for (size_t d = 0; d < ndim; ++d) {
+    counters[d] = remaining % sizes[d];
+    remaining /= sizes[d];
+    for (size_t k = 0; k < kNumInputs; ++k) {
+      in_ixs[k] += counters[d] * strides[k][d];
+    }
+  }
+  size_t in_steps[kNumInputs];
+  for (size_t k = 0; k < kNumInputs; ++k) {
+    in_steps[k] = strides[k][0];
+  }
+
+  size_t out_ix = begin;
+  while (true) {
+    const size_t n = std::min(sizes[0] - counters[0], end - out_ix);
+    fn(out_ix,
+       n,
+       static_cast<const size_t*>(in_ixs),
+       static_cast<const size_t*>(in_steps));
+    out_ix += n;
+    if (out_ix >= end) {
+      return;
+    }
+
+    // The run ended at the end of the innermost dimension: carry into the
+    // outer ones.
+    for (size_t k = 0; k < kNumInputs; ++k) {
+      in_ixs[k] -= counters[0] * strides[k][0];
+    }
+    counters[0] = 0;
+    for (size_t d = 1; d < ndim; ++d) {
+      counters[d]++;
+      for (size_t k = 0; k < kNumInputs; ++k) {
+        in_ixs[k] += strides[k][d];
+      }
+      if (counters[d] < sizes[d]) {
+        break;
+      }
+      for (size_t k = 0; k < kNumInputs; ++k) {
+        in_ixs[k] -= sizes[d] * strides[k][d];
+      }
+      counters[d] = 0;
+    }
+  }
+}
+
 template <typename CTYPE_A, typename CTYPE_B, typename CTYPE_OUT, typename Op>
-inline void apply_binary_elementwise_fn(
+inline void apply_binary_elementwise_fn_over_range(
     const Op& compute_fun,
     const Tensor& a,
     const Tensor& b,
-    const Tensor& out) {
-  const bool a_is_broadcasted = !out.sizes().equals(a.sizes());
-  const bool b_is_broadcasted = !out.sizes().equals(b.sizes());
-  const bool any_is_broadcasted = (a_is_broadcasted || b_is_broadcasted);
+    const Tensor& out,
+    const size_t begin,
+    const size_t end) {
+  const CTYPE_A* const data_a = a.const_data_ptr<CTYPE_A>();
+  const CTYPE_B* const data_b = b.const_data_ptr<CTYPE_B>();
+  CTYPE_OUT* const data_out = out.mutable_data_ptr<CTYPE_OUT>();
 
+  const Tensor* const inputs[2] = {&a, &b};
+  for_each_broadcast_run(
+      out,
+      inputs,
+      begin,
+      end,
+      [&](const size_t out_ix,
+          const size_t n,
+          const size_t* const in_ixs,
+          const size_t* const in_steps) {
+        const CTYPE_A* const run_a = data_a + in_ixs[0];
+        const CTYPE_B* const run_b = data_b + in_ixs[1];
+        CTYPE_OUT* const run_out = data_out + out_ix;
+        // Keep the common shapes as simple loops the compiler can vectorize.
+        if (in_steps[0] == 1 && in_steps[1] == 1) {
+          for (size_t j = 0; j < n; ++j) {
+            run_out[j] = compute_fun(run_a[j], run_b[j]);
+          }
+        } else if (in_steps[0] == 1 && in_steps[1] == 0) {
+          const CTYPE_B val_b = *run_b;
+          for (size_t j = 0; j < n; ++j) {
+            run_out[j] = compute_fun(run_a[j], val_b);
+          }
+        } else if (in_steps[0] == 0 && in_steps[1] == 1) {
+          const CTYPE_A val_a = *run_a;
+          for (size_t j = 0; j < n; ++j) {
+            run_out[j] = compute_fun(val_a, run_b[j]);
+          }
+        } else {
+          for (size_t j = 0; j < n; ++j) {
+            run_out[j] =
+                compute_fun(run_a[j * in_steps[0]], run_b[j * in_steps[1]]);
+          }
+        }
+      });
+}
+
+template <
+    typename CTYPE_A,
+    typename CTYPE_B,
+    typename CTYPE_C,
+    typename CTYPE_OUT,
+    typename Op>
+inline void apply_ternary_elementwise_fn_over_range(
+    const Op& compute_fun,
+    const Tensor& a,
+    const Tensor& b,
+    const Tensor& c,
+    const Tensor& out,
+    const size_t begin,
+    const size_t end) {
   const CTYPE_A* const data_a = a.const_data_ptr<CTYPE_A>();
   const CTYPE_B* const data_b = b.const_data_ptr<CTYPE_B>();
+  const CTYPE_C* const data_c = c.const_data_ptr<CTYPE_C>();
   CTYPE_OUT* const data_out = out.mutable_data_ptr<CTYPE_OUT>();
 
-  for (size_t i = 0; i < out.numel(); ++i) {
-    size_t a_linear_index = i;
-    size_t b_linear_index = i;
+  const Tensor* const inputs[3] = {&a, &b, &c};
+  for_each_broadcast_run(
+      out,
+      inputs,
+      begin,
+      end,
+      [&](const size_t out_ix,
+          const size_t n,
+          const size_t* const in_ixs,
+          const size_t* const in_steps) {
+        const CTYPE_A* const run_a = data_a + in_ixs[0];
+        const CTYPE_B* const run_b = data_b + in_ixs[1];
+        const CTYPE_C* const run_c = data_c + in_ixs[2];
+        CTYPE_OUT* const run_out = data_out + out_ix;
+        if (in_steps[0] == 1 && in_steps[1] == 1 && in_steps[2] == 1) {
+          for (size_t j = 0; j < n; ++j) {
+            run_out[j] = compute_fun(run_a[j], run_b[j], run_c[j]);
+          }
+        } else {
+          for (size_t j = 0; j < n; ++j) {
+            run_out[j] = compute_fun(
+                run_a[j * in_steps[0]],
+                run_b[j * in_steps[1]],
+                run_c[j * in_steps[2]]);
+          }
+        }
+      });
+}
 
-    if (any_is_broadcasted) {
-      size_t out_indexes[kTensorDimensionLimit];
-      delinearize_index(i, out, out_indexes, kTensorDimensionLimit);
+} // namespace internal
 
-      if (a_is_broadcasted) {
-        a_linear_index = linearize_access_indexes(out_indexes, out.dim(), a);
-      }
-      if (b_is_broadcasted) {
-        b_linear_index = linearize_access_indexes(out_indexes, out.dim(), b);
-      }
-    }
+/**
+ * Useful for binary elementwise operators. For each element of the inputs,
+ * perform a computation and write to the corresponding element of the output.
+ * Tensor broadcasting is applied wherever it is required.
+ */
+template <typename CTYPE_A, typename CTYPE_B, typename CTYPE_OUT, typename Op>
+inline void apply_binary_elementwise_fn(
+    const Op& compute_fun,
+    const Tensor& a,
+    const Tensor& b,
+    const Tensor& out) {
+  internal::apply_binary_elementwise_fn_over_range<CTYPE_A, CTYPE_B, CTYPE_OUT>(
+      compute_fun, a, b, out, 0, out.numel());
+}
 
-    data_out[i] = compute_fun(data_a[a_linear_index], data_b[b_linear_index]);
-  }
+/**
+ * Like apply_binary_elementwise_fn(), but may split the output across threads
+ * (see parallel_for_each_range()). `compute_fun` must be safe to call
+ * concurrently.
+ */
+template <typename CTYPE_A, typename CTYPE_B, typename CTYPE_OUT, typename Op>
+inline void parallel_apply_binary_elementwise_fn(
+    const Op& compute_fun,
+    const Tensor& a,
+    const Tensor& b,
+    const Tensor& out) {
+  parallel_for_each_range(
+      0,
+      out.numel(),
+      kParallelGrainSize,
+      [&](const int64_t begin, const int64_t end) {
+        internal::
+            apply_binary_elementwise_fn_over_range<CTYPE_A, CTYPE_B, CTYPE_OUT>(
+                compute_fun, a, b, out, begin, end);
+      });
 }
 
 /**
@@ -326,40 +561,11 @@ inline void apply_ternary_elementwise_fn(
     const Tensor& b,
     const Tensor& c,
     const Tensor& out) {
-  const bool a_is_broadcasted = !out.sizes().equals(a.sizes());
-  const bool b_is_broadcasted = !out.sizes().equals(b.sizes());
-  const bool c_is_broadcasted = !out.sizes().equals(c.sizes());
-  const bool any_is_broadcasted =
-      (a_is_broadcasted || b_is_broadcasted || c_is_broadcasted);
-
-  const CTYPE_A* const data_a = a.const_data_ptr<CTYPE_A>();
-  const CTYPE_B* const data_b = b.const_data_ptr<CTYPE_B>();
-  const CTYPE_C* const data_c = c.const_data_ptr<CTYPE_C>();
-  CTYPE_OUT* const data_out = out.mutable_data_ptr<CTYPE_OUT>();
-
-  for (size_t i = 0; i < out.numel(); ++i) {
-    size_t a_linear_index = i;
-    size_t b_linear_index = i;
-    size_t c_linear_index = i;
-
-    if (any_is_broadcasted) {
-      size_t out_indexes[kTensorDimensionLimit];
-      delinearize_index(i, out, out_indexes, kTensorDimensionLimit);
-
-      if (a_is_broadcasted) {
-        a_linear_index = linearize_access_indexes(out_indexes, out.dim(), a);
-      }
-      if (b_is_broadcasted) {
-        b_linear_index = linearize_access_indexes(out_indexes, out.dim(), b);
-      }
-      if (c_is_broadcasted) {
-        c_linear_index = linearize_access_indexes(out_indexes, out.dim(), c);
-      }
-    }
-
-    data_out[i] = compute_fun(
-        data_a[a_linear_index], data_b[b_linear_index], data_c[c_linear_index]);
-  }
+  internal::apply_ternary_elementwise_fn_over_range<
+      CTYPE_A,
+      CTYPE_B,
+      CTYPE_C,
+      CTYPE_OUT>(compute_fun, a, b, c, out, 0, out.numel());
 }
 
 } // namespace executor
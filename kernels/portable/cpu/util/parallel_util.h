@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#ifdef ET_USE_THREADPOOL
+#include <executorch/extension/parallel/thread_parallel.h>
+#endif // ET_USE_THREADPOOL
+
+namespace torch {
+namespace executor {
+
+/**
+ * Minimum number of elements a chunk of work should touch before it is worth
+ * handing to another thread. Below this, scheduling costs more than it saves.
+ */
+constexpr int64_t kParallelGrainSize = 32768;
+
+/**
+ * Returns the number of loop iterations to group into one chunk when each
+ * iteration touches about `elements_per_item` elements.
+ */
+inline int64_t parallel_grain_size(int64_t elements_per_item) {
+  if (elements_per_item <= 0) {
+    return kParallelGrainSize;
+  }
+  const int64_t grain_size = kParallelGrainSize / elements_per_item;
+  return grain_size > 0 ? grain_size : 1;
+}
+
+/**
+ * Calls `fn(chunk_begin, chunk_end)` over disjoint chunks that together cover
+ * `[begin, end)`.
+ *
+ * When the kernels are built with ET_USE_THREADPOOL and the range holds more
+ * than `grain_size` items, the chunks are spread across threads with
+ * executorch::extension::parallel_for(), so `fn` must be safe to call from
+ * several threads at once. Otherwise `fn(begin, end)` is called once on the
+ * current thread.
+ */
+template <typename Fn>
+inline void parallel_for_each_range(
+    const int64_t begin,
+    const int64_t end,
+    const int64_t grain_size,
+    const Fn& fn) {
+  if (begin >= end) {
+    return;
+  }
+#ifdef ET_USE_THREADPOOL
+  if (end - begin > grain_size &&
+      ::executorch::extension::parallel_for(begin, end, grain_size, fn)) {
+    return;
+  }
+#else // ET_USE_THREADPOOL
+  (void)grain_size;
+#endif // ET_USE_THREADPOOL
+  fn(begin, end);
+}
+
+} // namespace executor
+} // namespace torch
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <executorch/kernels/portable/cpu/util/parallel_util.h>
 #include <executorch/runtime/core/exec_aten/exec_aten.h>
 #include <executorch/runtime/core/exec_aten/util/tensor_util.h>
 #include <cstring>
@@ -232,6 +233,42 @@ void apply_over_dim(
   }
 }
 
+/**
+ * Like the apply_over_dim() above, but may call `fn` for different slices
+ * concurrently (see parallel_for_each_range()). Each call must only touch
+ * memory belonging to its own slice.
+ */
+template <typename Fn>
+void parallel_apply_over_dim(
+    const Fn& fn,
+    const exec_aten::Tensor& in,
+    const exec_aten::optional<int64_t>& dim) {
+  if (!dim.has_value() || in.dim() == 0 || in.numel() == 0) {
+    // At most one slice; nothing to split.
+    apply_over_dim(fn, in, dim);
+    return;
+  }
+
+  ET_CHECK_VALID_DIM(dim.value(), in.dim());
+  const size_t d = ET_NORMALIZE_IX(dim.value(), in.dim());
+
+  const size_t size = in.size(d);
+  const size_t stride = in.strides()[d];
+  const size_t outer_size = getLeadingDims(in, d);
+  const size_t outer_stride = size * stride;
+  parallel_for_each_range(
+      0,
+      static_cast<int64_t>(outer_size * stride),
+      parallel_grain_size(static_cast<int64_t>(size)),
+      [&](const int64_t begin, const int64_t end) {
+        for (size_t ix = begin; ix < static_cast<size_t>(end); ++ix) {
+          const size_t outer_idx = ix / stride;
+          const size_t inner_idx = ix % stride;
+          fn(size, stride, outer_idx * outer_stride + inner_idx);
+        }
+      });
+}
+
 /**
  * Useful to reduce a tensor `in` over a given dimension `dim` for the output
  * element at index `out_ix` using the reduce function `fn`, which
@@ -549,6 +586,40 @@ CTYPE reduce_over_dim_list(
       [](CTYPE v) { return v; }, reduce_fun, in, dim_list, out_ix);
 }
 
+/**
+ * Calls `fn(out_ix)` for every element of `out`, where `out` holds the result
+ * of reducing `in` over `dim_list`. Output elements may be computed
+ * concurrently (see parallel_for_each_range()), so `fn` must only write to the
+ * output element it is given.
+ *
+ * Common usage:
+ *
+ * CTYPE* out_data = out.mutable_data_ptr<CTYPE>();
+ * parallel_for_each_reduce_over_dim_list(
+ *     in, dim_list, out, [&](const size_t out_ix) {
+ *       out_data[out_ix] = reduce_over_dim_list<CTYPE>(
+ *           [](CTYPE v, CTYPE acc) { ... }, in, dim_list, out_ix);
+ *     });
+ */
+template <typename Fn>
+void parallel_for_each_reduce_over_dim_list(
+    const exec_aten::Tensor& in,
+    const exec_aten::optional<exec_aten::ArrayRef<int64_t>>& dim_list,
+    const exec_aten::Tensor& out,
+    const Fn& fn) {
+  parallel_for_each_range(
+      0,
+      out.numel(),
+      parallel_grain_size(
+          static_cast<int64_t>(get_reduced_dim_product(in, dim_list))),
+      [&](const int64_t begin, const int64_t end) {
+        for (size_t out_ix = begin; out_ix < static_cast<size_t>(end);
+             ++out_ix) {
+          fn(out_ix);
+        }
+      });
+}
+
 //
 // Compute reduced out tensor size and dim
 //
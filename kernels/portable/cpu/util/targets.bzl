@@ -1,5 +1,8 @@
 load("@fbsource//xplat/executorch/build:runtime_wrapper.bzl", "runtime")
 
+def _use_threadpool():
+    return native.read_config("executorch", "portable_use_threadpool", "false") == "true"
+
 def define_common_targets():
     """Defines targets that should be shared between fbcode and xplat.
 
@@ -30,6 +33,7 @@ def define_common_targets():
             "//executorch/kernels/portable/cpu/util:select_copy_util",
             "//executorch/kernels/portable/cpu/util:advanced_index_util",
             "//executorch/kernels/portable/cpu/util:slice_util",
+            "//executorch/kernels/portable/cpu/util:parallel_util",
         ],
         visibility = ["//executorch/...", "@EXECUTORCH_CLIENTS"],
     )
@@ -62,6 +66,20 @@ def define_common_targets():
         visibility = ["//executorch/kernels/portable/cpu/..."],
     )
 
+    # Splits large loops across threads when built with
+    # `-c executorch.portable_use_threadpool=true`; runs them inline otherwise.
+    for aten_mode in [True, False]:
+        suffix = "_aten" if aten_mode else ""
+        runtime.cxx_library(
+            name = "parallel_util{}".format(suffix),
+            exported_headers = ["parallel_util.h"],
+            exported_deps = [
+                "//executorch/extension/parallel:thread_parallel{}".format(suffix),
+            ] if _use_threadpool() else [],
+            exported_preprocessor_flags = ["-DET_USE_THREADPOOL"] if _use_threadpool() else [],
+            visibility = ["//executorch/...", "@EXECUTORCH_CLIENTS"],
+        )
+
     runtime.cxx_library(
         name = "broadcast_util",
         srcs = ["broadcast_util.cpp"],
@@ -69,6 +87,9 @@ def define_common_targets():
             "broadcast_util.h",
         ],
         compiler_flags = ["-Wno-missing-prototypes"],
+        exported_deps = [
+            ":parallel_util",
+        ],
         deps = [
             ":repeat_util",
             "//executorch/runtime/kernel:kernel_includes",
@@ -244,6 +265,9 @@ def define_common_targets():
             name = "reduce_util{}".format(suffix),
             srcs = ["reduce_util.cpp"],
             exported_headers = ["reduce_util.h"],
+            exported_deps = [
+                ":parallel_util{}".format(suffix),
+            ],
             deps = [
                 "//executorch/runtime/kernel:kernel_includes{}".format(suffix),
                 "//executorch/runtime/core/exec_aten/util:tensor_util{}".format(suffix),
@@ -17,6 +17,8 @@
 
 #include <gtest/gtest.h>
 
+#include <vector>
+
 using namespace ::testing;
 using exec_aten::ScalarType;
 using exec_aten::Tensor;
@@ -183,3 +185,181 @@ TEST(BroadcastUtilTest, LinearizeIndex) {
     EXPECT_EQ(linear_index, 2);
   }
 }
+
+TEST(BroadcastUtilTest, ParallelApplyBinaryElementwiseFnMatchesSerial) {
+  TensorFactory<ScalarType::Int> tf;
+
+  Tensor a = tf.make({2, 1, 3}, {1, 2, 3, 4, 5, 6});
+  Tensor b = tf.make({4, 1}, {10, 20, 30, 40});
+
+  Tensor expected = tf.zeros({2, 4, 3});
+  Tensor actual = tf.zeros({2, 4, 3});
+  auto add = [](const int32_t val_a, const int32_t val_b) {
+    return val_a + val_b;
+  };
+  torch::executor::apply_binary_elementwise_fn<int32_t, int32_t, int32_t>(
+      add, a, b, expected);
+  torch::executor::
+      parallel_apply_binary_elementwise_fn<int32_t, int32_t, int32_t>(
+          add, a, b, actual);
+
+  // clang-format off
+  EXPECT_TENSOR_EQ(expected, tf.make({2, 4, 3}, {
+    11, 12, 13,   21, 22, 23,   31, 32, 33,   41, 42, 43,
+
+    14, 15, 16,   24, 25, 26,   34, 35, 36,   44, 45, 46,
+  }));
+  // clang-format on
+  EXPECT_TENSOR_EQ(actual, expected);
+}
+
+TEST(BroadcastUtilTest, ParallelApplyBinaryElementwiseFnLargeOutput) {
+  TensorFactory<ScalarType::Int> tf;
+
+  // Large enough to be split into several chunks when threads are enabled.
+  constexpr int32_t kRows = 256;
+  constexpr int32_t kCols = 512;
+  std::vector<int32_t> a_data(kRows);
+  for (int32_t i = 0; i < kRows; ++i) {
+    a_data[i] = i * kCols;
+  }
+  std::vector<int32_t> b_data(kCols);
+  for (int32_t j = 0; j < kCols; ++j) {
+    b_data[j] = j;
+  }
+  Tensor a = tf.make({kRows, 1}, a_data);
+  Tensor b = tf.make({1, kCols}, b_data);
+  Tensor out = tf.zeros({kRows, kCols});
+
+  torch::executor::
+      parallel_apply_binary_elementwise_fn<int32_t, int32_t, int32_t>(
+          [](const int32_t val_a, const int32_t val_b) {
+            return val_a + val_b;
+          },
+          a,
+          b,
+          out);
+
+  const int32_t* out_data = out.const_data_ptr<int32_t>();
+  for (int32_t i = 0; i < kRows * kCols; ++i) {
+    ASSERT_EQ(out_data[i], i);
+  }
+}
+
+namespace {
+
+// Computes a * 1000 + b the slow way, via per-element delinearize and
+// linearize, to check the run-based iteration against.
+Tensor reference_binary(
+    TensorFactory<ScalarType::Int>& tf,
+    const Tensor& a,
+    const Tensor& b,
+    const Tensor& out) {
+  Tensor expected = tf.zeros_like(out);
+  int32_t* data = expected.mutable_data_ptr<int32_t>();
+  for (size_t i = 0; i < out.numel(); ++i) {
+    size_t indexes[torch::executor::kTensorDimensionLimit];
+    torch::executor::delinearize_index(
+        i, out, indexes, torch::executor::kTensorDimensionLimit);
+    size_t a_ix = torch::executor::linearize_access_indexes(
+        ArrayRef<size_t>(indexes, out.dim()), out.dim(), a);
+    size_t b_ix = torch::executor::linearize_access_indexes(
+        ArrayRef<size_t>(indexes, out.dim()), out.dim(), b);
+    data[i] = a.const_data_ptr<int32_t>()[a_ix] * 1000 +
+        b.const_data_ptr<int32_t>()[b_ix];
+  }
+  return expected;
+}
+
+Tensor make_iota(
+    TensorFactory<ScalarType::Int>& tf,
+    const std::vector<int32_t>& sizes) {
+  size_t numel = 1;
+  for (int32_t size : sizes) {
+    numel *= size;
+  }
+  std::vector<int32_t> data(numel);
+  for (size_t i = 0; i < numel; ++i) {
+    data[i] = static_cast<int32_t>(i);
+  }
+  return tf.make(sizes, data);
+}
+
+} // namespace
+
+TEST(BroadcastUtilTest, BinaryElementwiseBroadcastPatterns) {
+  TensorFactory<ScalarType::Int> tf;
+  auto fn = [](const int32_t val_a, const int32_t val_b) {
+    return val_a * 1000 + val_b;
+  };
+
+  struct Case {
+    std::vector<int32_t> a;
+    std::vector<int32_t> b;
+    std::vector<int32_t> out;
+  };
+  const std::vector<Case> cases = {
+      // Same shape.
+      {{3, 4}, {3, 4}, {3, 4}},
+      // Scalar.
+      {{3, 4}, {1}, {3, 4}},
+      {{}, {2, 3}, {2, 3}},
+      // Row (bias) broadcast.
+      {{5, 4}, {4}, {5, 4}},
+      {{2, 3, 4}, {1, 1, 4}, {2, 3, 4}},
+      // Column broadcast.
+      {{5, 4}, {5, 1}, {5, 4}},
+      // Middle dimension broadcast.
+      {{2, 3, 4}, {2, 1, 4}, {2, 3, 4}},
+      // Both inputs broadcast.
+      {{3, 1}, {1, 4}, {3, 4}},
+      {{2, 1, 4, 1}, {3, 1, 5}, {2, 3, 4, 5}},
+      // Size-1 dimensions in the output.
+      {{1, 3, 1, 4}, {1, 1, 1, 4}, {1, 3, 1, 4}},
+  };
+
+  for (const auto& c : cases) {
+    Tensor a = make_iota(tf, c.a);
+    Tensor b = make_iota(tf, c.b);
+    Tensor out = tf.zeros(c.out);
+    Tensor expected = reference_binary(tf, a, b, out);
+
+    torch::executor::apply_binary_elementwise_fn<int32_t, int32_t, int32_t>(
+        fn, a, b, out);
+    EXPECT_TENSOR_EQ(out, expected);
+
+    // Starting and stopping mid-run, as parallel chunks do, must give the
+    // same result.
+    for (size_t chunk = 1; chunk <= 7; ++chunk) {
+      Tensor chunked = tf.zeros(c.out);
+      for (size_t begin = 0; begin < chunked.numel(); begin += chunk) {
+        size_t end = std::min<size_t>(begin + chunk, chunked.numel());
+        torch::executor::internal::
+            apply_binary_elementwise_fn_over_range<int32_t, int32_t, int32_t>(
+                fn, a, b, chunked, begin, end);
+      }
+      EXPECT_TENSOR_EQ(chunked, expected);
+    }
+  }
+}
+
+TEST(BroadcastUtilTest, TernaryElementwiseBroadcast) {
+  TensorFactory<ScalarType::Int> tf;
+
+  Tensor a = tf.make({2, 1}, {1, 2});
+  Tensor b = tf.make({3}, {10, 20, 30});
+  Tensor c = tf.make({2, 3}, {100, 200, 300, 400, 500, 600});
+  Tensor out = tf.zeros({2, 3});
+
+  torch::executor::
+      apply_ternary_elementwise_fn<int32_t, int32_t, int32_t, int32_t>(
+          [](const int32_t val_a, const int32_t val_b, const int32_t val_c) {
+            return val_a + val_b + val_c;
+          },
+          a,
+          b,
+          c,
+          out);
+
+  EXPECT_TENSOR_EQ(out, tf.make({2, 3}, {111, 221, 331, 412, 522, 632}));
+}
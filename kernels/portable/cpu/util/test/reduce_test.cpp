@@ -578,3 +578,63 @@ TEST(ReduceUtilTest, ApplyOverDimListInvalid) {
   ET_EXPECT_DEATH(
       apply_over_dim_list([](size_t in_ix) { return; }, in, dim_list, 0), "");
 }
+
+TEST(ReduceUtilTest, ParallelApplyOverDimMatchesApplyOverDim) {
+  TensorFactory<ScalarType::Long> tf;
+
+  auto mark_slices = [](const Tensor& t, bool parallel, optional<int64_t> dim) {
+    int64_t* data = t.mutable_data_ptr<int64_t>();
+    auto fn = [data](size_t size, size_t stride, size_t base) {
+      for (size_t i = 0; i < size; ++i) {
+        data[base + i * stride] = base;
+      }
+    };
+    if (parallel) {
+      parallel_apply_over_dim(fn, t, dim);
+    } else {
+      apply_over_dim(fn, t, dim);
+    }
+  };
+
+  for (int64_t dim = -4; dim < 4; ++dim) {
+    Tensor expected = tf.zeros({2, 4, 5, 3});
+    Tensor actual = tf.zeros({2, 4, 5, 3});
+    mark_slices(expected, /*parallel=*/false, dim);
+    mark_slices(actual, /*parallel=*/true, dim);
+    EXPECT_TENSOR_EQ(actual, expected);
+  }
+
+  Tensor expected = tf.zeros({2, 4, 5, 3});
+  Tensor actual = tf.zeros({2, 4, 5, 3});
+  mark_slices(expected, /*parallel=*/false, exec_aten::nullopt);
+  mark_slices(actual, /*parallel=*/true, exec_aten::nullopt);
+  EXPECT_TENSOR_EQ(actual, expected);
+}
+
+TEST(ReduceUtilTest, ParallelForEachReduceOverDimList) {
+  TensorFactory<ScalarType::Long> tf;
+
+  // clang-format off
+  Tensor in = tf.make({2, 3, 2}, {
+    0, 1,   2, 3,   4, 5,
+
+    6, 7,   8, 9,  10, 11,
+  });
+  // clang-format on
+  int64_t dim_array[2] = {0, 2};
+  optional<ArrayRef<int64_t>> dim_list =
+      optional<ArrayRef<int64_t>>(ArrayRef<int64_t>{dim_array, 2});
+  Tensor out = tf.zeros({3});
+  int64_t* out_data = out.mutable_data_ptr<int64_t>();
+
+  parallel_for_each_reduce_over_dim_list(
+      in, dim_list, out, [&](const size_t out_ix) {
+        out_data[out_ix] = torch::executor::reduce_over_dim_list<int64_t>(
+            [](int64_t v, int64_t acc) { return acc + v; },
+            in,
+            dim_list,
+            out_ix);
+      });
+
+  EXPECT_TENSOR_EQ(out, tf.make({3}, {14, 22, 30}));
+}
@@ -15,6 +15,8 @@
 
 #include <gtest/gtest.h>
 
+#include <vector>
+
 using namespace ::testing;
 using exec_aten::ArrayRef;
 using exec_aten::optional;
@@ -728,3 +730,135 @@ TEST_F(OpConvCorrectnessTest, InvalidOutputPadding) {
           groups,
           out));
 }
+
+namespace {
+
+struct ConvCase {
+  int64_t N, C, H, W;
+  int64_t out_C, k_H, k_W;
+  int64_t stride, padding, dilation, groups;
+};
+
+// Direct nested-loop convolution over contiguous NCHW float data, used to
+// check the larger cases that are impractical to spell out by hand.
+std::vector<float> reference_conv2d(
+    const ConvCase& c,
+    const std::vector<float>& in,
+    const std::vector<float>& w,
+    const std::vector<float>& bias,
+    int64_t out_H,
+    int64_t out_W) {
+  const int64_t in_C_per_group = c.C / c.groups;
+  const int64_t out_C_per_group = c.out_C / c.groups;
+  std::vector<float> out(c.N * c.out_C * out_H * out_W);
+  for (int64_t n = 0; n < c.N; ++n) {
+    for (int64_t oc = 0; oc < c.out_C; ++oc) {
+      const int64_t g = oc / out_C_per_group;
+      for (int64_t oy = 0; oy < out_H; ++oy) {
+        for (int64_t ox = 0; ox < out_W; ++ox) {
+          double acc = bias[oc];
+          for (int64_t ic = 0; ic < in_C_per_group; ++ic) {
+            for (int64_t ky = 0; ky < c.k_H; ++ky) {
+              for (int64_t kx = 0; kx < c.k_W; ++kx) {
+                const int64_t iy = oy * c.stride - c.padding + ky * c.dilation;
+                const int64_t ix = ox * c.stride - c.padding + kx * c.dilation;
+                if (iy < 0 || iy >= c.H || ix < 0 || ix >= c.W) {
+                  continue;
+                }
+                const int64_t in_ix =
+                    ((n * c.C + g * in_C_per_group + ic) * c.H + iy) * c.W + ix;
+                const int64_t w_ix =
+                    ((oc * in_C_per_group + ic) * c.k_H + ky) * c.k_W + kx;
+                acc += static_cast<double>(in[in_ix]) * w[w_ix];
+              }
+            }
+          }
+          out[((n * c.out_C + oc) * out_H + oy) * out_W + ox] =
+              static_cast<float>(acc);
+        }
+      }
+    }
+  }
+  return out;
+}
+
+std::vector<float> ramp(size_t size, float scale) {
+  std::vector<float> values(size);
+  for (size_t i = 0; i < size; ++i) {
+    values[i] = scale * static_cast<float>(static_cast<int>(i % 13) - 6);
+  }
+  return values;
+}
+
+} // namespace
+
+class OpConvLargeCorrectnessTest
+    : public OpConvOutTest,
+      public ::testing::WithParamInterface<ConvCase> {
+ protected:
+  void run_case(const ConvCase& c) {
+    TensorFactory<ScalarType::Float> tf;
+    const int64_t out_H =
+        (c.H + 2 * c.padding - c.dilation * (c.k_H - 1) - 1) / c.stride + 1;
+    const int64_t out_W =
+        (c.W + 2 * c.padding - c.dilation * (c.k_W - 1) - 1) / c.stride + 1;
+
+    std::vector<float> in = ramp(c.N * c.C * c.H * c.W, 0.25f);
+    std::vector<float> w =
+        ramp(c.out_C * (c.C / c.groups) * c.k_H * c.k_W, 0.125f);
+    std::vector<float> b = ramp(c.out_C, 0.5f);
+
+    Tensor input = tf.make({c.N, c.C, c.H, c.W}, in);
+    Tensor weight = tf.make({c.out_C, c.C / c.groups, c.k_H, c.k_W}, w);
+    Tensor bias = tf.make({c.out_C}, b);
+    Tensor expected = tf.make(
+        {c.N, c.out_C, out_H, out_W},
+        reference_conv2d(c, in, w, b, out_H, out_W));
+    Tensor out = tf.zeros({c.N, c.out_C, out_H, out_W});
+
+    int64_t stride[2] = {c.stride, c.stride};
+    int64_t padding[2] = {c.padding, c.padding};
+    int64_t dilation[2] = {c.dilation, c.dilation};
+    int64_t output_padding[2] = {0, 0};
+
+    op_convolution_out(
+        input,
+        weight,
+        exec_aten::optional<Tensor>(bias),
+        exec_aten::ArrayRef<int64_t>{stride, 2},
+        exec_aten::ArrayRef<int64_t>{padding, 2},
+        exec_aten::ArrayRef<int64_t>{dilation, 2},
+        false,
+        exec_aten::ArrayRef<int64_t>{output_padding, 2},
+        c.groups,
+        out);
+    EXPECT_TENSOR_CLOSE_WITH_TOL(out, expected, 1e-4, 1e-4);
+  }
+};
+
+TEST_P(OpConvLargeCorrectnessTest, MatchesReference) {
+  run_case(GetParam());
+}
+
+TEST_P(OpConvLargeCorrectnessTest, MatchesReferenceWithTempAllocator) {
+  // With temp memory available, kernels may take paths that need more
+  // scratch space than fits on the stack.
+  static uint8_t temp_buffer[1 << 20];
+  executorch::runtime::MemoryAllocator allocator(
+      sizeof(temp_buffer), temp_buffer);
+  context_ = exec_aten::RuntimeContext(nullptr, &allocator);
+  run_case(GetParam());
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Shapes,
+    OpConvLargeCorrectnessTest,
+    ::testing::Values(
+        // N, C, H, W, out_C, k_H, k_W, stride, padding, dilation, groups
+        ConvCase{2, 16, 12, 10, 24, 3, 3, 1, 1, 1, 1},
+        ConvCase{1, 16, 9, 11, 16, 3, 3, 1, 0, 1, 2},
+        ConvCase{1, 8, 15, 13, 12, 3, 3, 2, 1, 1, 1},
+        ConvCase{1, 6, 14, 14, 9, 3, 3, 1, 2, 2, 3},
+        ConvCase{2, 32, 7, 9, 16, 1, 1, 1, 0, 1, 1},
+        ConvCase{1, 4, 40, 40, 8, 5, 3, 1, 2, 1, 1},
+        ConvCase{1, 64, 20, 20, 64, 3, 3, 1, 1, 1, 1}));
@@ -119,6 +119,31 @@ class DataLoader {
     return Error::NotImplemented;
   }
 
+  /**
+   * Hints that `load()` will soon be called with this `offset` and `size`, so
+   * that the implementation can start reading the data in the background. The
+   * default implementation does nothing.
+   *
+   * A prefetched range is only guaranteed to be reused by a later `load()`
+   * call with exactly the same `offset` and `size`.
+   *
+   * NOTE: This must be thread-safe. If this call modifies common state, the
+   * implementation must do its own locking.
+   *
+   * @param offset The byte offset in the data source to start loading from.
+   * @param size The number of bytes to load.
+   * @param segment_info Information about the segment being loaded.
+   */
+  virtual void prefetch(
+      size_t offset,
+      size_t size,
+      const SegmentInfo& segment_info) const {
+    // Stub implementation so that existing data loaders keep compiling.
+    (void)offset;
+    (void)size;
+    (void)segment_info;
+  }
+
   /**
    * Returns the length of the underlying data source, typically the file size.
    */
@@ -140,6 +140,16 @@ class MemoryAllocator {
     return static_cast<T*>(this->allocate(size * sizeof(T), alignment));
   }
 
+  /**
+   * Returns an allocation to the allocator before the next reset(). The base
+   * allocator only reclaims memory on reset(), so this does nothing;
+   * allocators that can reuse individual allocations override it.
+   *
+   * @param[in] ptr A pointer returned by allocate() on this allocator, or
+   *     null.
+   */
+  virtual void deallocate(ET_UNUSED void* ptr) {}
+
   // Returns the allocator memory's base address.
   virtual uint8_t* base_address() const {
     return begin_;
@@ -202,6 +202,46 @@ class BackendDelegate final {
   DelegateHandle* handle_;
 };
 
+/**
+ * Pre-decoded form of a serialized instruction. Built once by Method::init()
+ * so that executing an instruction does not need to walk the flatbuffer or
+ * re-validate indices.
+ */
+struct Instruction {
+  struct JumpFalse {
+    /// Index into the values table of the condition.
+    uint32_t cond_value_index;
+    /// Instruction index to continue from if the condition is false.
+    uint32_t destination_instruction;
+  };
+
+  struct Move {
+    /// Index into the values table of the value to copy.
+    uint32_t move_from;
+    /// Index into the values table of the value to overwrite.
+    uint32_t move_to;
+  };
+
+  /// The kind of instruction. Selects the active member of the union below.
+  executorch_flatbuffer::InstructionArguments type;
+
+  /// Arguments for a KernelCall or DelegateCall; empty for other types.
+  InstructionArgs args;
+
+  union {
+    /// KernelCall: the resolved kernel.
+    OpFunction kernel;
+    /// DelegateCall: index into Method::delegates_.
+    uint32_t delegate_index;
+    /// JumpFalseCall: the condition and destination.
+    JumpFalse jump_false;
+    /// MoveCall: the source and destination values.
+    Move move;
+    /// FreeCall: index into the values table of the tensor to free.
+    uint32_t free_value_index;
+  };
+};
+
 /**
  * Runtime state for a chain of instructions.
  */
@@ -209,10 +249,16 @@ struct Chain {
   /// Pointer to the associated flatbuffer chain.
   const executorch_flatbuffer::Chain* s_chain_;
 
-  /// Each entry is a list of parameters for a kernel or delegate call.
-  Span<InstructionArgs> argument_lists_;
-  /// Each instruction will have one kernel (not for delegate).
-  OpFunction* kernels_;
+  /// The pre-decoded instructions of the chain, in execution order.
+  Span<Instruction> instructions_;
+
+  /// Used by Method::execute_parallel(): instruction indices ordered by
+  /// level, where instructions in the same level do not depend on each other.
+  Span<uint32_t> parallel_order_;
+  /// parallel_order_[parallel_level_offsets_[l], parallel_level_offsets_[l+1])
+  /// holds the instructions of level l. Empty if the chain has not been
+  /// planned or must run sequentially.
+  Span<uint32_t> parallel_level_offsets_;
 };
 
 namespace {
@@ -277,6 +323,152 @@ Result<bool> parse_cond_value(const EValue& cond_value) {
   return true;
 }
 
+/// A half-open range of addresses that an instruction may read or write.
+struct AddressRange {
+  uintptr_t begin;
+  uintptr_t end;
+};
+
+bool ranges_overlap(const AddressRange& a, const AddressRange& b) {
+  return a.begin < b.end && b.begin < a.end;
+}
+
+/**
+ * Collects the AddressRanges touched by an instruction into a caller-provided
+ * buffer. If the buffer is null, only counts them, so that the caller can size
+ * the buffer with a first pass.
+ */
+class AddressRangeCollector final {
+ public:
+  AddressRangeCollector(AddressRange* ranges, HierarchicalAllocator* planned)
+      : ranges_(ranges), planned_(planned), size_(0) {}
+
+  template <typename T>
+  void add_object(const T* object) {
+    add(reinterpret_cast<uintptr_t>(object),
+        reinterpret_cast<uintptr_t>(object + 1));
+  }
+
+  void add_tensor(
+      const exec_aten::Tensor& tensor,
+      const executorch_flatbuffer::Tensor* s_tensor) {
+    // The TensorImpl covers metadata changes like resizing; the data covers
+    // other tensors that the memory plan placed in the same memory.
+    add_object(tensor.unsafeGetTensorImpl());
+    auto data = reinterpret_cast<uintptr_t>(tensor.const_data_ptr());
+    size_t nbytes = tensor.nbytes();
+    if (s_tensor != nullptr && s_tensor->sizes() != nullptr) {
+      // The serialized sizes are the upper bound of a dynamic shape, which the
+      // tensor may grow to after the plan is made.
+      nbytes = elementSize(
+          static_cast<exec_aten::ScalarType>(s_tensor->scalar_type()));
+      for (int32_t size : *s_tensor->sizes()) {
+        nbytes *= static_cast<size_t>(size);
+      }
+      // Take a memory planned tensor's region from the memory plan rather
+      // than from its data pointer.
+      const auto allocation_info = s_tensor->allocation_info();
+      if (allocation_info != nullptr && planned_ != nullptr) {
+        const uint64_t offset = allocation_info->memory_offset_low() |
+            (static_cast<uint64_t>(allocation_info->memory_offset_high())
+             << 32);
+        Result<void*> planned_data = planned_->get_offset_address(
+            allocation_info->memory_id() - 1,
+            static_cast<size_t>(offset),
+            nbytes);
+        if (planned_data.ok()) {
+          data = reinterpret_cast<uintptr_t>(planned_data.get());
+        }
+      }
+    }
+    if (data != 0 && nbytes > 0) {
+      add(data, data + nbytes);
+    }
+  }
+
+  /// Adds the ranges for the value at `index`, including list elements.
+  void add_value(
+      const executorch_flatbuffer::ExecutionPlan* plan,
+      EValue* values,
+      size_t num_values,
+      size_t index) {
+    add_value_element(plan, values, num_values, index);
+    // List elements live elsewhere in the values table, and may be written by
+    // other instructions (e.g. sym_size feeding a view's size list).
+    const auto s_value = plan->values()->Get(index);
+    switch (s_value->val_type()) {
+      case executorch_flatbuffer::KernelTypes::IntList: {
+        const auto items = s_value->val_as_IntList()->items();
+        for (size_t j = 0; items != nullptr && j < items->size(); ++j) {
+          add_value_element(plan, values, num_values, items->Get(j));
+        }
+      } break;
+      case executorch_flatbuffer::KernelTypes::TensorList: {
+        const auto items = s_value->val_as_TensorList()->items();
+        for (size_t j = 0; items != nullptr && j < items->size(); ++j) {
+          add_value_element(plan, values, num_values, items->Get(j));
+        }
+      } break;
+      case executorch_flatbuffer::KernelTypes::OptionalTensorList: {
+        const auto items = s_value->val_as_OptionalTensorList()->items();
+        for (size_t j = 0; items != nullptr && j < items->size(); ++j) {
+          add_value_element(plan, values, num_values, items->Get(j));
+        }
+      } break;
+      default:
+        break;
+    }
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+ private:
+  void add(uintptr_t begin, uintptr_t end) {
+    if (ranges_ != nullptr) {
+      ranges_[size_] = AddressRange{begin, end};
+    }
+    size_++;
+  }
+
+  void add_value_element(
+      const executorch_flatbuffer::ExecutionPlan* plan,
+      EValue* values,
+      size_t num_values,
+      int64_t index) {
+    // Negative indices mark None entries in optional lists.
+    if (index < 0 || static_cast<size_t>(index) >= num_values) {
+      return;
+    }
+    add_object(&values[index]);
+    if (values[index].isTensor()) {
+      add_tensor(
+          values[index].toTensor(),
+          plan->values()->Get(index)->val_as_Tensor());
+    }
+  }
+
+  AddressRange* ranges_;
+  HierarchicalAllocator* planned_;
+  size_t size_;
+};
+
+/// Upper bound on the number of instruction groups that
+/// Method::execute_parallel() runs concurrently.
+constexpr size_t kMaxParallelGroups = 64;
+
+/// State shared by the tasks that run one level in execute_parallel().
+struct ParallelGroupContext {
+  Method* method;
+  size_t chain_idx;
+  const uint32_t* instructions;
+  size_t num_instructions;
+  size_t num_groups;
+  MemoryAllocator** temp_allocators;
+  Error* errors;
+};
+
 } // namespace
 
 Error Method::parse_values() {
@@ -482,8 +674,7 @@ Error populate_operator_name(
 
 Error Method::resolve_operator(
     int32_t op_index,
-    OpFunction* kernels,
-    size_t kernel_index,
+    OpFunction* kernel,
     InstructionArgs args,
     size_t n_args) {
   // TODO(T153505381, T153506819) Investigate optimizing this function for both
@@ -533,8 +724,7 @@ Error Method::resolve_operator(
   }
   // search kernel
   if (hasOpsFn(operator_name, ArrayRef<TensorMeta>(meta, count))) {
-    kernels[kernel_index] =
-        getOpsFn(operator_name, ArrayRef<TensorMeta>(meta, count));
+    *kernel = getOpsFn(operator_name, ArrayRef<TensorMeta>(meta, count));
     return Error::Ok;
   } else {
     ET_LOG(Error, "Missing operator: [%d] %s", op_index, operator_name);
@@ -631,13 +821,12 @@ Error Method::init(executorch_flatbuffer::ExecutionPlan* s_plan) {
           "Missing instructions in chain %zu",
           i);
       auto num_instructions = s_instructions->size();
-      auto chain_instruction_kernels = ET_ALLOCATE_LIST_OR_RETURN_ERROR(
-          method_allocator, OpFunction, num_instructions);
-      auto chain_instruction_arg_lists = ET_ALLOCATE_LIST_OR_RETURN_ERROR(
-          method_allocator, InstructionArgs, num_instructions);
+      auto chain_instructions = ET_ALLOCATE_LIST_OR_RETURN_ERROR(
+          method_allocator, Instruction, num_instructions);
 
-      // Set up the argument lists ahead of time and store pointers to them to
-      // use when the instructions are called
+      // Decode the instructions ahead of time, resolving kernels, argument
+      // lists and value indices so that execution does not need to touch the
+      // flatbuffer again.
       for (size_t instr_idx = 0; instr_idx < s_instructions->size();
            ++instr_idx) {
         const auto instruction = s_instructions->Get(instr_idx);
@@ -648,6 +837,9 @@ Error Method::init(executorch_flatbuffer::ExecutionPlan* s_plan) {
             "Null instruction at index %zu",
             instr_idx);
 
+        Instruction& decoded = chain_instructions[instr_idx];
+        decoded.type = instruction->instr_args_type();
+        decoded.args = InstructionArgs();
         switch (instruction->instr_args_type()) {
           case executorch_flatbuffer::InstructionArguments::KernelCall: {
             const auto arg_idxs =
@@ -663,11 +855,11 @@ Error Method::init(executorch_flatbuffer::ExecutionPlan* s_plan) {
             if (!res.ok()) {
               return res.error();
             }
-            chain_instruction_arg_lists[instr_idx] = res.get();
+            decoded.args = res.get();
+            decoded.kernel = nullptr;
             auto err = resolve_operator(
                 instruction->instr_args_as_KernelCall()->op_index(),
-                chain_instruction_kernels,
-                instr_idx,
+                &decoded.kernel,
                 res.get(),
                 arg_idxs->size());
             if (err == Error::OperatorMissing) {
@@ -685,6 +877,16 @@ Error Method::init(executorch_flatbuffer::ExecutionPlan* s_plan) {
                 arg_idxs != nullptr,
                 InvalidProgram,
                 "DelegateCall args missing");
+            auto delegate_idx =
+                instruction->instr_args_as_DelegateCall()->delegate_index();
+            ET_CHECK_OR_RETURN_ERROR(
+                delegate_idx >= 0 && delegate_idx < n_delegate_,
+                InvalidProgram,
+                "DELEGATE_CALL index %d negative or >= num delegates %zu "
+                "at instruction %zu",
+                delegate_idx,
+                n_delegate_,
+                instr_idx);
             auto res = gen_instruction_arguments(
                 method_allocator,
                 n_value_,
@@ -694,30 +896,66 @@ Error Method::init(executorch_flatbuffer::ExecutionPlan* s_plan) {
             if (!res.ok()) {
               return res.error();
             }
-            chain_instruction_arg_lists[instr_idx] = res.get();
+            decoded.args = res.get();
+            decoded.delegate_index = static_cast<uint32_t>(delegate_idx);
           } break;
           case executorch_flatbuffer::InstructionArguments::JumpFalseCall: {
-            // Validate the index at load time so we can trust it during
+            // Validate the indices at load time so we can trust them during
             // execution.
-            auto index =
-                instruction->instr_args_as_JumpFalseCall()->cond_value_index();
+            auto jf_call = instruction->instr_args_as_JumpFalseCall();
+            auto index = jf_call->cond_value_index();
             ET_CHECK_OR_RETURN_ERROR(
                 index >= 0 && index < n_value_,
                 InvalidProgram,
                 "Index %d negative or >= %zu",
                 index,
                 n_value_);
-            chain_instruction_arg_lists[instr_idx] = InstructionArgs();
+            auto destination = jf_call->destination_instruction();
+            ET_CHECK_OR_RETURN_ERROR(
+                destination >= 0 && destination <= num_instructions,
+                InvalidProgram,
+                "Jump destination %d negative or > %zu",
+                destination,
+                (size_t)num_instructions);
+            decoded.jump_false = Instruction::JumpFalse{
+                static_cast<uint32_t>(index),
+                static_cast<uint32_t>(destination)};
+          } break;
+          case executorch_flatbuffer::InstructionArguments::MoveCall: {
+            auto move_call = instruction->instr_args_as_MoveCall();
+            auto move_from = move_call->move_from();
+            auto move_to = move_call->move_to();
+            ET_CHECK_OR_RETURN_ERROR(
+                move_from >= 0 && move_from < n_value_ && move_to >= 0 &&
+                    move_to < n_value_,
+                InvalidProgram,
+                "Move indices %d -> %d negative or >= %zu",
+                move_from,
+                move_to,
+                n_value_);
+            decoded.move = Instruction::Move{
+                static_cast<uint32_t>(move_from),
+                static_cast<uint32_t>(move_to)};
+          } break;
+          case executorch_flatbuffer::InstructionArguments::FreeCall: {
+            auto index = instruction->instr_args_as_FreeCall()->value_index();
+            ET_CHECK_OR_RETURN_ERROR(
+                index >= 0 && index < n_value_,
+                InvalidProgram,
+                "Index %d negative or >= %zu",
+                index,
+                n_value_);
+            decoded.free_value_index = static_cast<uint32_t>(index);
           } break;
           default: {
-            chain_instruction_arg_lists[instr_idx] = InstructionArgs();
+            // Unknown instructions are reported when they are executed.
+            decoded.kernel = nullptr;
           } break;
         }
       }
       chains_[i] = Chain{
           s_chain,
-          Span<InstructionArgs>(chain_instruction_arg_lists, num_instructions),
-          chain_instruction_kernels,
+          Span<Instruction>(chain_instructions, num_instructions),
       };
     }
     ET_CHECK_OR_RETURN_ERROR(
@@ -831,7 +1069,10 @@ Method::set_input(const EValue& input_evalue, size_t input_idx) {
     if (pre_allocated_input_) {
       error = internal::copy_tensor_data(t_dst, t_src);
     } else {
+      const void* old_data = t_dst.const_data_ptr();
       error = internal::share_tensor_data(t_dst, t_src);
+      // The parallel plan holds the address ranges of unplanned tensors.
+      parallel_plan_ready_ &= t_dst.const_data_ptr() == old_data;
     }
     ET_CHECK_OR_RETURN_ERROR(
         error == Error::Ok,
@@ -975,6 +1216,9 @@ Method::set_output_data_ptr(void* buffer, size_t size, size_t output_idx) {
       size,
       t.nbytes());
 
+  // The parallel plan holds the address ranges of unplanned tensors.
+  parallel_plan_ready_ &= t.const_data_ptr() == buffer;
+
   // Set data
   return internal::set_tensor_data(t, buffer, size);
 }
@@ -1024,21 +1268,38 @@ ET_NODISCARD Error Method::get_inputs(EValue* input_evalues, size_t length) {
 }
 
 Error Method::execute_instruction() {
-  auto& chain = chains_[step_state_.chain_idx];
-  auto instructions = chain.s_chain_->instructions();
+  size_t next_instr_idx = step_state_.instr_idx;
+  Error err = run_instruction(
+      step_state_.chain_idx,
+      step_state_.instr_idx,
+      memory_manager_->temp_allocator(),
+      &next_instr_idx);
+  if (err == Error::Ok) {
+    step_state_.instr_idx = next_instr_idx;
+  }
+  return err;
+}
+
+Error Method::run_instruction(
+    size_t chain_idx,
+    size_t instr_idx,
+    MemoryAllocator* temp_allocator,
+    size_t* next_instr_idx) {
+  auto& chain = chains_[chain_idx];
 
   ET_CHECK_OR_RETURN_ERROR(
-      step_state_.instr_idx < instructions->size(),
+      instr_idx < chain.instructions_.size(),
       Internal,
       "Instr index %zu >= chain[%zu] instr count %zu",
-      step_state_.instr_idx,
-      step_state_.chain_idx,
-      (size_t)instructions->size());
+      instr_idx,
+      chain_idx,
+      chain.instructions_.size());
 
-  auto instruction = instructions->Get(step_state_.instr_idx);
-  size_t next_instr_idx = step_state_.instr_idx + 1;
+  // All indices in the decoded instruction were validated at init time.
+  const Instruction& instruction = chain.instructions_[instr_idx];
+  *next_instr_idx = instr_idx + 1;
   Error err = Error::Ok;
-  switch (instruction->instr_args_type()) {
+  switch (instruction.type) {
     case executorch_flatbuffer::InstructionArguments::KernelCall: {
       EXECUTORCH_SCOPE_PROF("OPERATOR_CALL");
       internal::EventTracerProfileScope event_tracer_scope =
@@ -1046,22 +1307,25 @@ Error Method::execute_instruction() {
       // TODO(T147221312): Also expose tensor resizer via the context.
       // The temp_allocator passed can be null, but calling allocate_temp will
       // fail
-      KernelRuntimeContext context(
-          event_tracer_, memory_manager_->temp_allocator());
-      auto args = chain.argument_lists_[step_state_.instr_idx];
-      chain.kernels_[step_state_.instr_idx](context, args.data());
+      KernelRuntimeContext context(event_tracer_, temp_allocator);
+      auto args = instruction.args;
+      instruction.kernel(context, args.data());
       // We reset the temp_allocator after the switch statement
       err = context.failure_state();
       if (err != Error::Ok) {
-        // We know that instr_args_as_KernelCall is non-null because it was
-        // checked at init time.
-        auto op_index = instruction->instr_args_as_KernelCall()->op_index();
+        // This is a failure path, so it's fine to go back to the flatbuffer
+        // for the operator name. We know that instr_args_as_KernelCall is
+        // non-null because it was checked at init time.
+        auto op_index = chain.s_chain_->instructions()
+                            ->Get(instr_idx)
+                            ->instr_args_as_KernelCall()
+                            ->op_index();
         auto op = serialization_plan_->operators()->Get(op_index);
         ET_LOG(
             Error,
             "KernelCall failed at instruction %zu:%zu in operator %s.%s: 0x%x",
-            step_state_.chain_idx,
-            step_state_.instr_idx,
+            chain_idx,
+            instr_idx,
             op->name()->c_str(),
             op->overload()->c_str(),
             (unsigned int)err);
@@ -1081,29 +1345,16 @@ Error Method::execute_instruction() {
       EXECUTORCH_SCOPE_PROF("DELEGATE_CALL");
       internal::EventTracerProfileScope event_tracer_profile_scope =
           internal::EventTracerProfileScope(event_tracer_, "DELEGATE_CALL");
-      // We know that instr_args_as_DelegateCall is non-null because it was
-      // checked at init time.
-      auto delegate_idx =
-          instruction->instr_args_as_DelegateCall()->delegate_index();
-      ET_CHECK_OR_RETURN_ERROR(
-          delegate_idx < n_delegate_,
-          Internal,
-          "DELEGATE_CALL index %" PRIu32
-          " >= num delegates %zu at instruction %zu",
-          delegate_idx,
-          n_delegate_,
-          step_state_.instr_idx);
       BackendExecutionContext backend_execution_context(
           /*event_tracer*/ event_tracer_,
-          /*temp_allocator*/ memory_manager_->temp_allocator());
-      err = delegates_[delegate_idx].Execute(
-          backend_execution_context,
-          chain.argument_lists_[step_state_.instr_idx].data());
+          /*temp_allocator*/ temp_allocator);
+      err = delegates_[instruction.delegate_index].Execute(
+          backend_execution_context, instruction.args.data());
       if (err != Error::Ok) {
         ET_LOG(
             Error,
             "CALL_DELEGATE execute failed at instruction %zu: 0x%" PRIx32,
-            step_state_.instr_idx,
+            instr_idx,
             static_cast<uint32_t>(err));
       }
 
@@ -1113,10 +1364,8 @@ Error Method::execute_instruction() {
       // log everything. This will be changed in the future when the inputs and
       // ouputs are separate lists.
 #ifdef ET_EVENT_TRACER_ENABLED
-      for (size_t i = 0;
-           i < chain.argument_lists_[step_state_.instr_idx].size();
-           i++) {
-        EValue* arg = chain.argument_lists_[step_state_.instr_idx].data()[i];
+      for (size_t i = 0; i < instruction.args.size(); i++) {
+        EValue* arg = instruction.args[i];
         internal::event_tracer_log_evalue(event_tracer_, *arg);
       }
 #endif
@@ -1125,16 +1374,11 @@ Error Method::execute_instruction() {
       EXECUTORCH_SCOPE_PROF("JF_CALL");
       internal::EventTracerProfileScope event_tracer_profile_scope =
           internal::EventTracerProfileScope(event_tracer_, "JF_CALL");
-      // We know that instr_args_as_JumpFalseCall is non-null because it was
-      // checked at init time.
-      auto jf_call = instruction->instr_args_as_JumpFalseCall();
-      // We know that index is a valid values_ index because it was checked at
-      // init time.
-      auto index = jf_call->cond_value_index();
-      Result<bool> jf_result = parse_cond_value(values_[index]);
+      Result<bool> jf_result =
+          parse_cond_value(values_[instruction.jump_false.cond_value_index]);
       if (jf_result.ok()) {
         if (!jf_result.get()) {
-          next_instr_idx = jf_call->destination_instruction();
+          *next_instr_idx = instruction.jump_false.destination_instruction;
         }
       } else {
         err = jf_result.error();
@@ -1144,34 +1388,25 @@ Error Method::execute_instruction() {
       EXECUTORCH_SCOPE_PROF("MOVE_CALL");
       internal::EventTracerProfileScope event_tracer_profile_scope =
           internal::EventTracerProfileScope(event_tracer_, "MOVE_CALL");
-      // We know that instr_args_as_MoveCall is non-null because it was checked
-      // at init time.
-      auto move_call = instruction->instr_args_as_MoveCall();
-      mutable_value(move_call->move_to()) = get_value(move_call->move_from());
+      values_[instruction.move.move_to] = values_[instruction.move.move_from];
     } break;
     case executorch_flatbuffer::InstructionArguments::FreeCall: {
       EXECUTORCH_SCOPE_PROF("FREE_CALL");
       internal::EventTracerProfileScope event_tracer_profile_scope =
           internal::EventTracerProfileScope(event_tracer_, "FREE_CALL");
-      // We know that instr_args_as_FreeCall is non-null because it was checked
-      // at init time.
-      auto free_call = instruction->instr_args_as_FreeCall();
-      auto t = values_[free_call->value_index()].toTensor();
+      auto t = values_[instruction.free_value_index].toTensor();
       internal::reset_data_ptr(t);
     } break;
     default:
       ET_LOG(
           Error,
           "Unknown instruction: %hhu",
-          static_cast<uint8_t>(instruction->instr_args_type()));
+          static_cast<uint8_t>(instruction.type));
       err = Error::InvalidProgram;
   }
   // Reset the temp allocator for every instruction.
-  if (memory_manager_->temp_allocator() != nullptr) {
-    memory_manager_->temp_allocator()->reset();
-  }
-  if (err == Error::Ok) {
-    step_state_.instr_idx = next_instr_idx;
+  if (temp_allocator != nullptr) {
+    temp_allocator->reset();
   }
   return err;
 }
@@ -1225,8 +1460,7 @@ Error Method::step() {
     return Error::EndOfMethod;
   }
 
-  auto num_instructions =
-      chains_[step_state_.chain_idx].s_chain_->instructions()->size();
+  auto num_instructions = chains_[step_state_.chain_idx].instructions_.size();
 
   // Special case chains with no instructions. These appear for example in a
   // model that just returns the input/a constant.
@@ -1267,17 +1501,12 @@ Error Method::execute() {
   // branch and run many in parallel or out of order.
   for (step_state_.chain_idx = 0; step_state_.chain_idx < n_chains_;
        ++step_state_.chain_idx) {
-    Chain& chain = chains_[step_state_.chain_idx];
-    auto instructions = chain.s_chain_->instructions();
-    ET_CHECK_OR_RETURN_ERROR(
-        instructions != nullptr,
-        Internal,
-        "chain %zu has no instructions field",
-        step_state_.chain_idx);
+    const size_t num_instructions =
+        chains_[step_state_.chain_idx].instructions_.size();
 
     // Loop over instructions
     step_state_.instr_idx = 0;
-    while (step_state_.instr_idx < chain.s_chain_->instructions()->size()) {
+    while (step_state_.instr_idx < num_instructions) {
       EXECUTORCH_PROFILE_INSTRUCTION_SCOPE(
           static_cast<int32_t>(step_state_.chain_idx),
           static_cast<uint32_t>(step_state_.instr_idx));
@@ -1300,6 +1529,241 @@ Error Method::execute() {
   return reset_execution(); // @lint-ignore CLANGTIDY facebook-hte-Deprecated
 }
 
+Error Method::prepare_parallel_plan(MemoryAllocator* scratch_allocator) {
+  auto method_allocator = memory_manager_->method_allocator();
+  for (size_t chain_idx = 0; chain_idx < n_chains_; ++chain_idx) {
+    Chain& chain = chains_[chain_idx];
+    const size_t n = chain.instructions_.size();
+
+    // Chains with control flow must follow the program counter, so leave them
+    // unplanned and run them sequentially.
+    bool has_control_flow = false;
+    for (const auto& instruction : chain.instructions_) {
+      has_control_flow |= instruction.type ==
+          executorch_flatbuffer::InstructionArguments::JumpFalseCall;
+    }
+    if (has_control_flow || n == 0) {
+      continue;
+    }
+
+    // Collect the address ranges that each instruction may touch: a counting
+    // pass to size the buffer, then a filling pass.
+    size_t* range_offsets =
+        ET_ALLOCATE_LIST_OR_RETURN_ERROR(scratch_allocator, size_t, n + 1);
+    AddressRange* ranges = nullptr;
+    for (int pass = 0; pass < 2; ++pass) {
+      range_offsets[0] = 0;
+      for (size_t i = 0; i < n; ++i) {
+        const Instruction& instruction = chain.instructions_[i];
+        AddressRangeCollector collector(
+            ranges == nullptr ? nullptr : ranges + range_offsets[i],
+            memory_manager_->planned_memory());
+        for (EValue* arg : instruction.args) {
+          collector.add_value(
+              serialization_plan_, values_, n_value_, arg - values_);
+        }
+        if (instruction.type ==
+            executorch_flatbuffer::InstructionArguments::DelegateCall) {
+          // Don't assume that a delegate handle can be executed concurrently
+          // with itself.
+          collector.add_object(&delegates_[instruction.delegate_index]);
+        }
+        range_offsets[i + 1] = range_offsets[i] + collector.size();
+      }
+      if (ranges == nullptr) {
+        ranges = ET_ALLOCATE_LIST_OR_RETURN_ERROR(
+            scratch_allocator, AddressRange, range_offsets[n]);
+      }
+    }
+
+    // Assign each instruction the lowest level that is after every earlier
+    // instruction it overlaps with. Instructions that are neither kernel nor
+    // delegate calls (moves and frees) act as barriers.
+    uint32_t* levels =
+        ET_ALLOCATE_LIST_OR_RETURN_ERROR(scratch_allocator, uint32_t, n);
+    uint32_t num_levels = 0;
+    uint32_t min_level = 0;
+    size_t last_barrier = 0;
+    for (size_t i = 0; i < n; ++i) {
+      const auto type = chain.instructions_[i].type;
+      if (type != executorch_flatbuffer::InstructionArguments::KernelCall &&
+          type != executorch_flatbuffer::InstructionArguments::DelegateCall) {
+        levels[i] = num_levels;
+        min_level = ++num_levels;
+        last_barrier = i + 1;
+        continue;
+      }
+      uint32_t level = min_level;
+      // Instructions before the last barrier are all below min_level.
+      for (size_t j = i; j-- > last_barrier;) {
+        if (levels[j] < level) {
+          // Can't raise the level; skip the overlap check.
+          continue;
+        }
+        bool overlaps = false;
+        for (size_t a = range_offsets[i]; a < range_offsets[i + 1] && !overlaps;
+             ++a) {
+          for (size_t b = range_offsets[j]; b < range_offsets[j + 1]; ++b) {
+            if (ranges_overlap(ranges[a], ranges[b])) {
+              overlaps = true;
+              break;
+            }
+          }
+        }
+        if (overlaps) {
+          level = levels[j] + 1;
+        }
+      }
+      levels[i] = level;
+      if (level >= num_levels) {
+        num_levels = level + 1;
+      }
+    }
+
+    // Bucket the instructions by level, keeping program order within each.
+    // There are at most n levels, so a re-plan reuses the previous buffers
+    // rather than growing the method allocator.
+    uint32_t* level_offsets = chain.parallel_level_offsets_.data();
+    uint32_t* order = chain.parallel_order_.data();
+    if (order == nullptr) {
+      level_offsets = ET_ALLOCATE_LIST_OR_RETURN_ERROR(
+          method_allocator, uint32_t, n + 1);
+      order = ET_ALLOCATE_LIST_OR_RETURN_ERROR(method_allocator, uint32_t, n);
+    }
+    uint32_t* cursors =
+        ET_ALLOCATE_LIST_OR_RETURN_ERROR(scratch_allocator, uint32_t, num_levels);
+    for (size_t l = 0; l <= num_levels; ++l) {
+      level_offsets[l] = 0;
+    }
+    for (size_t i = 0; i < n; ++i) {
+      level_offsets[levels[i] + 1]++;
+    }
+    for (size_t l = 0; l < num_levels; ++l) {
+      level_offsets[l + 1] += level_offsets[l];
+      cursors[l] = level_offsets[l];
+    }
+    for (size_t i = 0; i < n; ++i) {
+      order[cursors[levels[i]]++] = static_cast<uint32_t>(i);
+    }
+    chain.parallel_order_ = Span<uint32_t>(order, n);
+    chain.parallel_level_offsets_ =
+        Span<uint32_t>(level_offsets, num_levels + 1);
+
+    scratch_allocator->reset();
+  }
+  parallel_plan_ready_ = true;
+  return Error::Ok;
+}
+
+void Method::run_parallel_group(void* context, size_t group) {
+  auto* ctx = static_cast<ParallelGroupContext*>(context);
+  const size_t begin = group * ctx->num_instructions / ctx->num_groups;
+  const size_t end = (group + 1) * ctx->num_instructions / ctx->num_groups;
+  Error err = Error::Ok;
+  for (size_t i = begin; i < end && err == Error::Ok; ++i) {
+    // Planned chains have no control flow, so the next index is unused.
+    size_t next_instr_idx;
+    err = ctx->method->run_instruction(
+        ctx->chain_idx,
+        ctx->instructions[i],
+        ctx->temp_allocators[group],
+        &next_instr_idx);
+  }
+  ctx->errors[group] = err;
+}
+
+Error Method::execute_parallel(
+    TaskRunner& runner,
+    Span<MemoryAllocator*> temp_allocators) {
+  ET_CHECK_OR_RETURN_ERROR(
+      initialized(),
+      NotSupported,
+      "Cannot execute until method has been initialized.");
+  ET_CHECK_OR_RETURN_ERROR(
+      step_state_.chain_idx == 0 && step_state_.instr_idx == 0,
+      InvalidState,
+      "Cannot execute in parallel mid step-based execution.");
+  ET_CHECK_OR_RETURN_ERROR(
+      !temp_allocators.empty(),
+      InvalidArgument,
+      "At least one temp allocator is required.");
+  for (MemoryAllocator* temp_allocator : temp_allocators) {
+    ET_CHECK_OR_RETURN_ERROR(
+        temp_allocator != nullptr, InvalidArgument, "Null temp allocator.");
+  }
+
+  if (event_tracer_ != nullptr) {
+    // EventTracer implementations are not thread-safe, so don't let
+    // instructions log to one concurrently.
+    return execute();
+  }
+
+  EXECUTORCH_SCOPE_PROF("Method::execute_parallel");
+  if (!parallel_plan_ready_) {
+    Error err = prepare_parallel_plan(temp_allocators[0]);
+    if (err != Error::Ok) {
+      return err;
+    }
+  }
+
+  const size_t max_groups = temp_allocators.size() < kMaxParallelGroups
+      ? temp_allocators.size()
+      : kMaxParallelGroups;
+  Error errors[kMaxParallelGroups];
+  for (step_state_.chain_idx = 0; step_state_.chain_idx < n_chains_;
+       ++step_state_.chain_idx) {
+    const Chain& chain = chains_[step_state_.chain_idx];
+
+    if (chain.parallel_level_offsets_.empty()) {
+      step_state_.instr_idx = 0;
+      while (step_state_.instr_idx < chain.instructions_.size()) {
+        size_t next_instr_idx = step_state_.instr_idx;
+        Error err = run_instruction(
+            step_state_.chain_idx,
+            step_state_.instr_idx,
+            temp_allocators[0],
+            &next_instr_idx);
+        if (err != Error::Ok) {
+          return err;
+        }
+        step_state_.instr_idx = next_instr_idx;
+      }
+      continue;
+    }
+
+    const size_t num_levels = chain.parallel_level_offsets_.size() - 1;
+    for (size_t level = 0; level < num_levels; ++level) {
+      const size_t begin = chain.parallel_level_offsets_[level];
+      const size_t count = chain.parallel_level_offsets_[level + 1] - begin;
+      const size_t num_groups = count < max_groups ? count : max_groups;
+      ParallelGroupContext context{
+          this,
+          step_state_.chain_idx,
+          chain.parallel_order_.data() + begin,
+          count,
+          num_groups,
+          temp_allocators.data(),
+          errors,
+      };
+      if (num_groups == 1) {
+        run_parallel_group(&context, 0);
+      } else {
+        runner.run(&Method::run_parallel_group, &context, num_groups);
+      }
+      for (size_t g = 0; g < num_groups; ++g) {
+        if (errors[g] != Error::Ok) {
+          return errors[g];
+        }
+      }
+    }
+    step_state_.instr_idx = chain.instructions_.size();
+  }
+
+  log_outputs();
+
+  return reset_execution();
+}
+
 MethodMeta Method::method_meta() const {
   auto name = serialization_plan_->name()->c_str();
   auto method_meta = program_->method_meta(name);
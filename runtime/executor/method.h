@@ -14,6 +14,7 @@
 #include <executorch/runtime/core/span.h>
 #include <executorch/runtime/executor/memory_manager.h>
 #include <executorch/runtime/executor/method_meta.h>
+#include <executorch/runtime/executor/task_runner.h>
 #include <executorch/runtime/platform/compiler.h>
 
 // Forward declare flatbuffer types. This is a public header and must not
@@ -63,7 +64,8 @@ class Method final {
         chains_(rhs.chains_),
         init_state_(rhs.init_state_),
         pre_allocated_input_(rhs.pre_allocated_input_),
-        pre_allocated_output_(rhs.pre_allocated_output_) {
+        pre_allocated_output_(rhs.pre_allocated_output_),
+        parallel_plan_ready_(rhs.parallel_plan_ready_) {
     // Required: clear out fields that the dtor looks at, so that we don't free
     // anything twice.
     rhs.n_value_ = 0;
@@ -83,6 +85,7 @@ class Method final {
     rhs.chains_ = nullptr;
     rhs.pre_allocated_input_ = false;
     rhs.pre_allocated_output_ = false;
+    rhs.parallel_plan_ready_ = false;
   }
 
   /**
@@ -187,6 +190,40 @@ class Method final {
    */
   ET_NODISCARD Error execute();
 
+  /**
+   * EXPERIMENTAL: Execute the method, running instructions that do not depend
+   * on each other concurrently.
+   *
+   * Two instructions are considered dependent if any of their arguments
+   * share an EValue or overlapping tensor memory, or if they call the same
+   * delegate. Instructions are grouped into levels such that every
+   * instruction only depends on instructions in earlier levels, and each
+   * level is handed to `runner` in turn. Chains that contain control flow,
+   * and methods with an EventTracer, are executed sequentially.
+   *
+   * Memory planned tensors are placed by the memory plan and sized by their
+   * upper bound, so the dependency plan is computed on the first call and
+   * reused. It is computed again after set_input() or set_output_data_ptr()
+   * changes the data of a tensor that is not memory planned. The plan is
+   * allocated from the method allocator; `temp_allocators[0]` is used as
+   * scratch space while computing it.
+   *
+   * NOTE: Will fail if the method has been partially executed using the
+   * `step()` api.
+   *
+   * @param[in] runner Runs the independent instructions of a level. Kernels
+   *     may use their own thread pool internally, so `runner` should not
+   *     block on that same pool.
+   * @param[in] temp_allocators The temp allocators to use in place of the
+   *     MemoryManager's. Each concurrently-running group of instructions gets
+   *     its own allocator, so the number of allocators bounds the
+   *     parallelism. Must not be empty.
+   *
+   * @returns Error::Ok on success, non-Ok on failure.
+   */
+  ET_EXPERIMENTAL ET_NODISCARD Error
+  execute_parallel(TaskRunner& runner, Span<MemoryAllocator*> temp_allocators);
+
   /**
    * EXPERIMENTAL: Advances/executes a single instruction in the method.
    *
@@ -287,7 +324,8 @@ class Method final {
         chains_(nullptr),
         init_state_(InitializationState::Uninitialized),
         pre_allocated_input_(false),
-        pre_allocated_output_(false) {}
+        pre_allocated_output_(false),
+        parallel_plan_ready_(false) {}
 
   /// Static factory used by Program.
   ET_NODISCARD static Result<Method> load(
@@ -316,6 +354,22 @@ class Method final {
   // Executes a single instruction using the state in step_state_
   ET_NODISCARD Error execute_instruction();
 
+  // Executes the given instruction using the given temp allocator, and sets
+  // `next_instr_idx` to the index of the instruction that should run next.
+  ET_NODISCARD Error run_instruction(
+      size_t chain_idx,
+      size_t instr_idx,
+      MemoryAllocator* temp_allocator,
+      size_t* next_instr_idx);
+
+  // Computes the levels used by execute_parallel(), using `scratch_allocator`
+  // for temporary state.
+  ET_NODISCARD Error prepare_parallel_plan(MemoryAllocator* scratch_allocator);
+
+  // TaskRunner task that runs one group of instructions of a level for
+  // execute_parallel().
+  static void run_parallel_group(void* context, size_t group);
+
   StepState step_state_;
   const Program* program_;
   MemoryManager* memory_manager_;
@@ -334,6 +388,7 @@ class Method final {
   InitializationState init_state_;
   bool pre_allocated_input_;
   bool pre_allocated_output_;
+  bool parallel_plan_ready_;
 
   /**
    * Parses the elements of the values_ array. On error, n_value_ will be set to
@@ -344,8 +399,7 @@ class Method final {
 
   ET_NODISCARD Error resolve_operator(
       int32_t op_index,
-      OpFunction* kernels,
-      size_t kernel_index,
+      OpFunction* kernel,
       InstructionArgs args,
       size_t n_args);
 
@@ -60,6 +60,48 @@ Result<executorch_flatbuffer::ExecutionPlan*> get_execution_plan(
   return Error::InvalidArgument;
 }
 
+/**
+ * Calls DataLoader::prefetch() for each segment that will be loaded whole.
+ * Mutable data segments are skipped since they are read piecewise with
+ * load_into().
+ */
+void prefetch_segments(
+    DataLoader* loader,
+    const executorch_flatbuffer::Program* flatbuffer_program,
+    size_t segment_base_offset) {
+  const auto* segments = flatbuffer_program->segments();
+  if (segment_base_offset == 0 || segments == nullptr) {
+    return;
+  }
+  const auto* constant_segment = flatbuffer_program->constant_segment();
+  const auto* mutable_data_segments =
+      flatbuffer_program->mutable_data_segments();
+  for (size_t i = 0; i < segments->size(); ++i) {
+    bool is_mutable = false;
+    if (mutable_data_segments != nullptr) {
+      for (size_t j = 0; j < mutable_data_segments->size(); ++j) {
+        if (mutable_data_segments->Get(j)->segment_index() == i) {
+          is_mutable = true;
+          break;
+        }
+      }
+    }
+    if (is_mutable) {
+      continue;
+    }
+    const bool is_constant =
+        constant_segment != nullptr && constant_segment->segment_index() == i;
+    const executorch_flatbuffer::DataSegment* segment = segments->Get(i);
+    loader->prefetch(
+        segment_base_offset + segment->offset(),
+        segment->size(),
+        DataLoader::SegmentInfo(
+            is_constant ? DataLoader::SegmentInfo::Type::Constant
+                        : DataLoader::SegmentInfo::Type::Backend,
+            i));
+  }
+}
+
 } // namespace
 
 /* static */ Result<Program> Program::load(
@@ -148,6 +190,10 @@ Result<executorch_flatbuffer::ExecutionPlan*> get_execution_plan(
   const executorch_flatbuffer::Program* flatbuffer_program =
       executorch_flatbuffer::GetProgram(program_data->data());
 
+  // Let the loader start reading the segments before they are needed. The
+  // constant segment is loaded below; the rest are loaded by LoadSegment().
+  prefetch_segments(loader, flatbuffer_program, segment_base_offset);
+
   // Constant data may live inside the flatbuffer data (constant_buffer) or in a
   // separate segment (constant_segment). It should not be in both.
   const auto* constant_segment = flatbuffer_program->constant_segment();
@@ -42,6 +42,17 @@ def define_common_targets():
         ],
     )
 
+    runtime.cxx_library(
+        name = "task_runner",
+        exported_headers = [
+            "task_runner.h",
+        ],
+        visibility = [
+            "//executorch/...",
+            "@EXECUTORCH_CLIENTS",
+        ],
+    )
+
     for aten_mode in (True, False):
         aten_suffix = "_aten" if aten_mode else ""
         runtime.cxx_library(
@@ -74,6 +85,7 @@ def define_common_targets():
             preprocessor_flags = _program_preprocessor_flags(),
             exported_deps = [
                 ":memory_manager",
+                ":task_runner",
                 "//executorch/runtime/backend:interface",
                 "//executorch/runtime/core:core",
                 "//executorch/runtime/core:evalue" + aten_suffix,
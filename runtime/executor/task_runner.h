@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace executorch {
+namespace runtime {
+
+/**
+ * EXPERIMENTAL: Interface for running a batch of independent tasks, possibly
+ * concurrently. Used by Method::execute_parallel() to run instructions that do
+ * not depend on each other.
+ *
+ * The core runtime does not create threads itself; implementations typically
+ * wrap a thread pool owned by the client.
+ */
+class TaskRunner {
+ public:
+  virtual ~TaskRunner() = default;
+
+  /// Signature of a task. `index` is in the range `[0, num_tasks)`.
+  using TaskFunction = void (*)(void* context, size_t index);
+
+  /**
+   * Calls `task(context, i)` exactly once for every `i` in `[0, num_tasks)`.
+   * Calls may happen in any order and on any thread, but this must not return
+   * until all of them have completed.
+   */
+  virtual void run(TaskFunction task, void* context, size_t num_tasks) = 0;
+};
+
+} // namespace runtime
+} // namespace executorch
@@ -6,6 +6,7 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
 #include <cstdlib>
 #include <filesystem>
 
@@ -24,9 +25,12 @@ using exec_aten::ArrayRef;
 using executorch::extension::prepare_input_tensors;
 using executorch::runtime::Error;
 using executorch::runtime::EValue;
+using executorch::runtime::MemoryAllocator;
 using executorch::runtime::Method;
 using executorch::runtime::Program;
 using executorch::runtime::Result;
+using executorch::runtime::Span;
+using executorch::runtime::TaskRunner;
 using executorch::runtime::testing::ManagedMemoryManager;
 using torch::executor::util::FileDataLoader;
 
@@ -65,6 +69,8 @@ class MethodTest : public ::testing::Test {
     load_program(
         std::getenv("ET_MODULE_LINEAR_CONSTANT_BUFFER_PATH"),
         "linear_constant_buffer");
+    load_program(
+        std::getenv("ET_MODULE_PARALLEL_BRANCHES_PATH"), "parallel_branches");
   }
 
  private:
@@ -294,6 +300,142 @@ TEST_F(MethodTest, ConstantBufferTest) {
   ASSERT_EQ(err, Error::Ok);
 }
 
+namespace {
+// Runs tasks on the calling thread in reverse order, so that tests notice if
+// execute_parallel() relies on the order of instructions within a level.
+class ReverseOrderTaskRunner final : public TaskRunner {
+ public:
+  void run(TaskFunction task, void* context, size_t num_tasks) override {
+    for (size_t i = num_tasks; i > 0; --i) {
+      task(context, i - 1);
+    }
+    num_runs_++;
+    max_num_tasks_ = std::max(max_num_tasks_, num_tasks);
+  }
+
+  size_t num_runs_ = 0;
+  size_t max_num_tasks_ = 0;
+};
+
+// Checks that execute_parallel() gives the same outputs as execute(), both
+// when it builds the plan and when it reuses it.
+void expect_execute_parallel_matches_execute(
+    Method& method,
+    ReverseOrderTaskRunner& runner) {
+  auto input_cleanup = prepare_input_tensors(method);
+  ASSERT_EQ(input_cleanup.error(), Error::Ok);
+  Error err = method.execute();
+  ASSERT_EQ(err, Error::Ok);
+  auto expected = method.get_output(0).toTensor();
+  std::vector<float> expected_data(
+      expected.const_data_ptr<float>(),
+      expected.const_data_ptr<float>() + expected.numel());
+
+  constexpr size_t kTempBytes = 32 * 1024U;
+  std::vector<uint8_t> temp_buffers[2] = {
+      std::vector<uint8_t>(kTempBytes), std::vector<uint8_t>(kTempBytes)};
+  MemoryAllocator temp_0(kTempBytes, temp_buffers[0].data());
+  MemoryAllocator temp_1(kTempBytes, temp_buffers[1].data());
+  MemoryAllocator* temp_allocators[] = {&temp_0, &temp_1};
+
+  for (int i = 0; i < 2; ++i) {
+    err = method.execute_parallel(
+        runner, Span<MemoryAllocator*>(temp_allocators, 2));
+    ASSERT_EQ(err, Error::Ok);
+    auto actual = method.get_output(0).toTensor();
+    ASSERT_EQ(actual.numel(), expected_data.size());
+    for (size_t j = 0; j < expected_data.size(); ++j) {
+      EXPECT_FLOAT_EQ(actual.const_data_ptr<float>()[j], expected_data[j]);
+    }
+  }
+}
+} // namespace
+
+TEST_F(MethodTest, ExecuteParallelMatchesExecute) {
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method = programs_["add"]->load_method("forward", &mmm.get());
+  ASSERT_EQ(method.error(), Error::Ok);
+
+  ReverseOrderTaskRunner runner;
+  expect_execute_parallel_matches_execute(*method, runner);
+}
+
+TEST_F(MethodTest, ExecuteParallelRunsIndependentBranchesConcurrently) {
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method =
+      programs_["parallel_branches"]->load_method("forward", &mmm.get());
+  ASSERT_EQ(method.error(), Error::Ok);
+
+  // The runner runs the groups of a level in reverse order, so an
+  // instruction that overwrites memory that an earlier instruction of its
+  // level still reads would change the outputs.
+  ReverseOrderTaskRunner runner;
+  expect_execute_parallel_matches_execute(*method, runner);
+  EXPECT_GT(runner.max_num_tasks_, 1);
+}
+
+TEST_F(MethodTest, ExecuteParallelWithNewIOBuffers) {
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method = programs_["cat"]->load_method("forward", &mmm.get());
+  ASSERT_EQ(method.error(), Error::Ok);
+
+  constexpr size_t kTempBytes = 32 * 1024U;
+  std::vector<uint8_t> temp_buffer(kTempBytes);
+  MemoryAllocator temp(kTempBytes, temp_buffer.data());
+  MemoryAllocator* temp_allocators[] = {&temp};
+  ReverseOrderTaskRunner runner;
+
+  // The input and output are not memory planned, so the plan is rebuilt for
+  // the buffers of each run. Cat a 1x4 of ones to a 2x4 input.
+  std::vector<float> inputs[2] = {std::vector<float>(8), std::vector<float>(8)};
+  std::vector<float> outputs[2] = {
+      std::vector<float>(16), std::vector<float>(16)};
+  for (int run = 0; run < 2; ++run) {
+    for (int i = 0; i < 8; ++i) {
+      inputs[run][i] = static_cast<float>(run * 8 + i);
+    }
+    int32_t sizes[2] = {2, 4};
+    uint8_t dim_order[2] = {0, 1};
+    int32_t strides[2] = {4, 1};
+    exec_aten::TensorImpl impl(
+        exec_aten::ScalarType::Float,
+        2,
+        sizes,
+        inputs[run].data(),
+        dim_order,
+        strides);
+    Error err = method->set_input(EValue(exec_aten::Tensor(&impl)), 0);
+    ASSERT_EQ(err, Error::Ok);
+    err = method->set_output_data_ptr(
+        outputs[run].data(), outputs[run].size() * sizeof(float), 0);
+    ASSERT_EQ(err, Error::Ok);
+
+    err = method->execute_parallel(
+        runner, Span<MemoryAllocator*>(temp_allocators, 1));
+    ASSERT_EQ(err, Error::Ok);
+    auto output = method->get_output(0).toTensor();
+    ASSERT_EQ(output.const_data_ptr<float>(), outputs[run].data());
+    ASSERT_EQ(output.numel(), 12);
+    for (int i = 0; i < 8; ++i) {
+      EXPECT_FLOAT_EQ(outputs[run][i], inputs[run][i]);
+    }
+    for (int i = 8; i < 12; ++i) {
+      EXPECT_FLOAT_EQ(outputs[run][i], 1.f);
+    }
+  }
+}
+
+TEST_F(MethodTest, ExecuteParallelRequiresTempAllocator) {
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method = programs_["add"]->load_method("forward", &mmm.get());
+  ASSERT_EQ(method.error(), Error::Ok);
+
+  ReverseOrderTaskRunner runner;
+  Error err = method->execute_parallel(runner, Span<MemoryAllocator*>());
+  EXPECT_EQ(err, Error::InvalidArgument);
+  EXPECT_EQ(runner.num_runs_, 0);
+}
+
 /*
  * TODO(T161163608): Test is disabled due to a resize bug in tensor_index_out of
  * the portable op lib
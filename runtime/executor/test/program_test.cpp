@@ -13,6 +13,7 @@
 
 #include <cstring>
 #include <memory>
+#include <vector>
 
 #include <executorch/extension/data_loader/buffer_data_loader.h>
 #include <executorch/extension/data_loader/file_data_loader.h>
@@ -424,6 +425,100 @@ TEST_F(ProgramTest, LoadConstantSegment) {
   EXPECT_GE(flatbuffer_program->constant_segment()->offsets()->size(), 1);
 }
 
+namespace {
+
+/// Forwards to another DataLoader, recording the ranges passed to prefetch()
+/// and load().
+class PrefetchSpyDataLoader final : public DataLoader {
+ public:
+  struct Call {
+    size_t offset;
+    size_t size;
+    DataLoader::SegmentInfo segment_info;
+  };
+
+  explicit PrefetchSpyDataLoader(DataLoader* delegate) : delegate_(delegate) {}
+
+  Result<FreeableBuffer> load(
+      size_t offset,
+      size_t size,
+      const SegmentInfo& segment_info) const override {
+    loads_.push_back({offset, size, segment_info});
+    return delegate_->load(offset, size, segment_info);
+  }
+
+  Result<size_t> size() const override {
+    return delegate_->size();
+  }
+
+  void prefetch(size_t offset, size_t size, const SegmentInfo& segment_info)
+      const override {
+    prefetches_.push_back({offset, size, segment_info});
+  }
+
+  const std::vector<Call>& loads() const {
+    return loads_;
+  }
+
+  const std::vector<Call>& prefetches() const {
+    return prefetches_;
+  }
+
+ private:
+  DataLoader* delegate_;
+  mutable std::vector<Call> loads_;
+  mutable std::vector<Call> prefetches_;
+};
+
+} // namespace
+
+TEST_F(ProgramTest, LoadPrefetchesConstantSegment) {
+  const char* linear_path =
+      std::getenv("ET_MODULE_LINEAR_CONSTANT_SEGMENT_PATH");
+  Result<FileDataLoader> linear_loader = FileDataLoader::from(linear_path);
+  ASSERT_EQ(linear_loader.error(), Error::Ok);
+  PrefetchSpyDataLoader spy_loader(&linear_loader.get());
+
+  Result<Program> program = Program::load(&spy_loader);
+  ASSERT_EQ(program.error(), Error::Ok);
+
+  // The only segment holds the constants. It should be prefetched, then
+  // loaded with exactly the same range.
+  ASSERT_EQ(spy_loader.prefetches().size(), 1);
+  const auto& prefetch = spy_loader.prefetches()[0];
+  EXPECT_EQ(
+      prefetch.segment_info.segment_type,
+      DataLoader::SegmentInfo::Type::Constant);
+  EXPECT_EQ(prefetch.segment_info.segment_index, 0);
+
+  const auto& load = spy_loader.loads().back();
+  EXPECT_EQ(
+      load.segment_info.segment_type, DataLoader::SegmentInfo::Type::Constant);
+  EXPECT_EQ(load.offset, prefetch.offset);
+  EXPECT_EQ(load.size, prefetch.size);
+}
+
+TEST_F(ProgramTest, LoadDoesNotPrefetchMutableSegments) {
+  // ModuleSimpleTrain has a mutable data segment, which is only ever read in
+  // pieces.
+  const char* path = std::getenv("ET_MODULE_SIMPLE_TRAIN_PATH");
+  Result<FileDataLoader> training_loader = FileDataLoader::from(path);
+  ASSERT_EQ(training_loader.error(), Error::Ok);
+  PrefetchSpyDataLoader spy_loader(&training_loader.get());
+
+  Result<Program> program = Program::load(&spy_loader);
+  ASSERT_EQ(program.error(), Error::Ok);
+
+  const executorch_flatbuffer::Program* flatbuffer_program =
+      ProgramTestFriend::GetInternalProgram(&program.get());
+  ASSERT_NE(flatbuffer_program->mutable_data_segments(), nullptr);
+  const size_t mutable_index =
+      flatbuffer_program->mutable_data_segments()->Get(0)->segment_index();
+  for (const auto& prefetch : spy_loader.prefetches()) {
+    EXPECT_NE(prefetch.segment_info.segment_index, mutable_index);
+  }
+}
+
 TEST_F(ProgramTest, LoadConstantSegmentWithNoConstantSegment) {
   // Load the serialized ModuleLinear data, with constants in the flatbuffer and
   // no constants in the segment.
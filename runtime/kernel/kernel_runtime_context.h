@@ -99,6 +99,20 @@ class KernelRuntimeContext {
     return temp_memory;
   }
 
+  /**
+   * Returns temporary memory to the temp allocator before the kernel returns,
+   * so that later allocate_temp() calls of the kernel can reuse it. Whether
+   * the memory is reused depends on the temp allocator; it is released when
+   * the kernel returns either way.
+   *
+   * @param[in] ptr A pointer returned by allocate_temp(), or null.
+   */
+  void free_temp(void* ptr) {
+    if (temp_allocator_ != nullptr) {
+      temp_allocator_->deallocate(ptr);
+    }
+  }
+
   // TODO(T147221312): Add a way to resize a tensor.
 
  private:
@@ -23,6 +23,33 @@ OperatorRegistry& getOperatorRegistry() {
   return operator_registry;
 }
 
+namespace {
+/// 32-bit FNV-1a hash of a NUL-terminated string.
+uint32_t hash_op_name(const char* name) {
+  uint32_t hash = 2166136261u;
+  for (const char* c = name; *c != '\0'; c++) {
+    hash ^= static_cast<uint8_t>(*c);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+} // namespace
+
+uint32_t OperatorRegistry::find_bucket(const char* name) const {
+  constexpr uint32_t kMask = kOpNameTableSize - 1;
+  // The table is never more than half full, so this always terminates.
+  uint32_t bucket = hash_op_name(name) & kMask;
+  while (op_name_table_[bucket] != 0 &&
+         strcmp(kernels_[op_name_table_[bucket] - 1].name_, name) != 0) {
+    bucket = (bucket + 1) & kMask;
+  }
+  return bucket;
+}
+
+int32_t OperatorRegistry::find_first_kernel(const char* name) const {
+  return static_cast<int32_t>(op_name_table_[find_bucket(name)]) - 1;
+}
+
 Error register_kernels(const ArrayRef<Kernel>& kernels) {
   Error success = getOperatorRegistry().register_kernels(kernels);
   if (success == Error::InvalidArgument || success == Error::Internal) {
@@ -67,17 +94,23 @@ Error OperatorRegistry::register_kernels(const ArrayRef<Kernel>& kernels) {
   const char* lib_name = et_pal_get_shared_library_name(kernels.data());
 
   for (const auto& kernel : kernels) {
-    // linear search. This is fine if the number of kernels are small.
-    for (int32_t i = 0; i < this->num_kernels_; i++) {
-      Kernel k = this->kernels_[i];
-      if (strcmp(kernel.name_, k.name_) == 0 &&
-          kernel.kernel_key_ == k.kernel_key_) {
+    // Only kernels with the same op name can collide, and those are chained
+    // together behind a single bucket.
+    uint32_t bucket = find_bucket(kernel.name_);
+    uint32_t* link = &this->op_name_table_[bucket];
+    while (*link != 0) {
+      const Kernel& k = this->kernels_[*link - 1];
+      if (kernel.kernel_key_ == k.kernel_key_) {
         ET_LOG(Error, "Re-registering %s, from %s", k.name_, lib_name);
         ET_LOG_KERNEL_KEY(k.kernel_key_);
         return Error::InvalidArgument;
       }
+      link = &this->next_kernel_[*link - 1];
     }
-    this->kernels_[this->num_kernels_++] = kernel;
+    this->kernels_[this->num_kernels_] = kernel;
+    this->next_kernel_[this->num_kernels_] = 0;
+    // Append to the end of the chain to preserve registration order.
+    *link = ++this->num_kernels_;
   }
   ET_LOG(
       Debug,
@@ -134,16 +167,20 @@ void make_kernel_key_string(ArrayRef<TensorMeta> key, char* buf) {
 bool OperatorRegistry::hasOpsFn(
     const char* name,
     ArrayRef<TensorMeta> meta_list) {
+  int32_t first_idx = find_first_kernel(name);
+  if (first_idx < 0) {
+    return false;
+  }
+
   char buf[KernelKey::MAX_SIZE] = {0};
   make_kernel_key_string(meta_list, buf);
   KernelKey kernel_key = KernelKey(buf);
 
-  for (size_t idx = 0; idx < this->num_kernels_; idx++) {
-    if (strcmp(this->kernels_[idx].name_, name) == 0) {
-      if (this->kernels_[idx].kernel_key_.is_fallback() ||
-          this->kernels_[idx].kernel_key_ == kernel_key) {
-        return true;
-      }
+  for (int32_t idx = first_idx; idx >= 0;
+       idx = static_cast<int32_t>(this->next_kernel_[idx]) - 1) {
+    if (this->kernels_[idx].kernel_key_.is_fallback() ||
+        this->kernels_[idx].kernel_key_ == kernel_key) {
+      return true;
     }
   }
 
@@ -162,14 +199,13 @@ const OpFunction& OperatorRegistry::getOpsFn(
   KernelKey kernel_key = KernelKey(buf);
 
   int32_t fallback_idx = -1;
-  for (size_t idx = 0; idx < this->num_kernels_; idx++) {
-    if (strcmp(this->kernels_[idx].name_, name) == 0) {
-      if (this->kernels_[idx].kernel_key_ == kernel_key) {
-        return this->kernels_[idx].op_;
-      }
-      if (this->kernels_[idx].kernel_key_.is_fallback()) {
-        fallback_idx = idx;
-      }
+  for (int32_t idx = find_first_kernel(name); idx >= 0;
+       idx = static_cast<int32_t>(this->next_kernel_[idx]) - 1) {
+    if (this->kernels_[idx].kernel_key_ == kernel_key) {
+      return this->kernels_[idx].op_;
+    }
+    if (this->kernels_[idx].kernel_key_.is_fallback()) {
+      fallback_idx = idx;
     }
   }
   if (fallback_idx != -1) {
@@ -200,6 +200,23 @@ constexpr uint32_t kMaxNumOfKernels = MAX_KERNEL_NUM;
 constexpr uint32_t kMaxNumOfKernels =
     kOperatorTableMaxSize * kMaxNumOfKernelPerOp;
 #endif
+
+namespace internal {
+/// Returns the smallest power of two that is greater than or equal to `n`.
+constexpr uint32_t next_power_of_two(uint32_t n) {
+  uint32_t p = 1;
+  while (p < n) {
+    p <<= 1;
+  }
+  return p;
+}
+} // namespace internal
+
+// Number of buckets in the op name index. Kept at no more than 50% load so
+// that probe sequences stay short.
+constexpr uint32_t kOpNameTableSize =
+    internal::next_power_of_two(2 * kMaxNumOfKernels);
+
 /**
  * See OperatorRegistry::hasOpsFn()
  */
@@ -226,7 +243,7 @@ ET_NODISCARD Error register_kernels(const ArrayRef<Kernel>&);
 
 struct OperatorRegistry {
  public:
-  OperatorRegistry() : num_kernels_(0) {}
+  OperatorRegistry() : next_kernel_(), op_name_table_(), num_kernels_(0) {}
 
   /**
    * Registers the Kernels object (i.e. string name and function reference
@@ -255,7 +272,26 @@ struct OperatorRegistry {
   ArrayRef<Kernel> get_kernels();
 
  private:
+  /**
+   * Returns the op_name_table_ bucket for `name`: either the bucket that
+   * already holds kernels for `name`, or the empty bucket where they would be
+   * inserted.
+   */
+  uint32_t find_bucket(const char* name) const;
+
+  /**
+   * Returns the index into kernels_ of the first kernel registered for
+   * `name`, or -1 if there is none.
+   */
+  int32_t find_first_kernel(const char* name) const;
+
   Kernel kernels_[kMaxNumOfKernels];
+  /// For each entry in kernels_, one plus the index of the next kernel with
+  /// the same op name in registration order, or 0 for the last one.
+  uint32_t next_kernel_[kMaxNumOfKernels];
+  /// Open-addressing hash index from op name to one plus the index of the
+  /// first kernel registered under that name, or 0 for an empty bucket.
+  uint32_t op_name_table_[kOpNameTableSize];
   uint32_t num_kernels_;
 };
 
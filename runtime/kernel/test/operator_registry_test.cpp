@@ -23,6 +23,7 @@ using exec_aten::Tensor;
 using executorch::runtime::ArrayRef;
 using executorch::runtime::Error;
 using executorch::runtime::EValue;
+using executorch::runtime::getOpsFn;
 using executorch::runtime::hasOpsFn;
 using executorch::runtime::Kernel;
 using executorch::runtime::KernelKey;
@@ -283,3 +284,66 @@ TEST_F(OperatorRegistryTest, ExecutorUsesFallbackKernel) {
   auto val = values[0].toScalar().to<int64_t>();
   ASSERT_EQ(val, 100);
 }
+
+TEST_F(OperatorRegistryTest, ManyOpsAreIndependentlyFound) {
+  // Register enough distinct op names that some of them share hash buckets.
+  constexpr size_t kNumOps = 64;
+  static char names[kNumOps][32];
+  Kernel kernels[kNumOps];
+  for (size_t i = 0; i < kNumOps; i++) {
+    snprintf(names[i], sizeof(names[i]), "test::many_%zu", i);
+    kernels[i] = Kernel(names[i], [](KernelRuntimeContext&, EValue**) {});
+  }
+  auto s1 = register_kernels(ArrayRef<Kernel>(kernels, kNumOps));
+  EXPECT_EQ(s1, Error::Ok);
+
+  for (size_t i = 0; i < kNumOps; i++) {
+    EXPECT_TRUE(hasOpsFn(names[i]));
+  }
+  EXPECT_FALSE(hasOpsFn("test::many_"));
+  EXPECT_FALSE(hasOpsFn("test::many_64"));
+}
+
+TEST_F(OperatorRegistryTest, ExactKernelPreferredOverEarlierFallback) {
+  char buf_long_contiguous[BUF_SIZE];
+  make_kernel_key({{ScalarType::Long, {0, 1, 2, 3}}}, buf_long_contiguous);
+  KernelKey key = KernelKey(buf_long_contiguous);
+
+  // Register the fallback first so that lookup has to keep walking the
+  // kernels for this op to find the specialized one.
+  Kernel fallback = Kernel(
+      "test::grault",
+      KernelKey{},
+      [](KernelRuntimeContext& context, EValue** stack) {
+        (void)context;
+        *(stack[0]) = Scalar(100);
+      });
+  Kernel specialized = Kernel(
+      "test::grault", key, [](KernelRuntimeContext& context, EValue** stack) {
+        (void)context;
+        *(stack[0]) = Scalar(50);
+      });
+  Kernel kernels[] = {fallback, specialized};
+  auto s1 = register_kernels(kernels);
+  EXPECT_EQ(s1, Error::Ok);
+
+  Tensor::DimOrderType dims[] = {0, 1, 2, 3};
+  auto dim_order_type = ArrayRef<Tensor::DimOrderType>(dims, 4);
+  TensorMeta meta_long[] = {TensorMeta(ScalarType::Long, dim_order_type)};
+  TensorMeta meta_float[] = {TensorMeta(ScalarType::Float, dim_order_type)};
+
+  EValue values[1];
+  EValue* evalues[1] = {&values[0]};
+  KernelRuntimeContext context{};
+
+  // The exact match wins.
+  values[0] = Scalar(0);
+  getOpsFn("test::grault", ArrayRef<TensorMeta>(meta_long))(context, evalues);
+  EXPECT_EQ(values[0].toScalar().to<int64_t>(), 50);
+
+  // Anything else uses the fallback.
+  EXPECT_TRUE(hasOpsFn("test::grault", ArrayRef<TensorMeta>(meta_float)));
+  values[0] = Scalar(0);
+  getOpsFn("test::grault", ArrayRef<TensorMeta>(meta_float))(context, evalues);
+  EXPECT_EQ(values[0].toScalar().to<int64_t>(), 100);
+}
@@ -832,6 +832,7 @@ ATEN_OPS = (
         deps = [
             ":vec_ops",
             "//executorch/kernels/portable/cpu/util:normalization_ops_util",
+            "//executorch/kernels/portable/cpu/util:parallel_util",
         ],
     ),
     op_target(
@@ -131,6 +131,25 @@ class ModuleDynamicCatUnallocatedIO(nn.Module):
         return {"capture_config": CaptureConfig(pt2_mode=True, enable_aot=True)}
 
 
+class ModuleAddDynamicBatch(nn.Module):
+    def __init__(self):
+        super(ModuleAddDynamicBatch, self).__init__()
+
+    def forward(self, x, y):
+        return torch.add(x, y)
+
+    def get_random_inputs(self):
+        return (torch.randn(2, 3), torch.randn(2, 3))
+
+    def get_dynamic_shapes(self):
+        batch = Dim("batch", max=8)
+        return ({0: batch}, {0: batch})
+
+    @staticmethod
+    def get_export_kwargs():
+        return {"capture_config": CaptureConfig(pt2_mode=True, enable_aot=True)}
+
+
 class ModuleLinear(torch.nn.Module):
     def __init__(self):
         super().__init__()
@@ -166,6 +185,24 @@ class ModuleMultipleEntry(torch.nn.Module):
         return ["forward", "forward2"]
 
 
+class ModuleParallelBranches(torch.nn.Module):
+    def __init__(self):
+        super().__init__()
+        self.a = 3 * torch.ones(2, 2, dtype=torch.float)
+        self.b = 2 * torch.ones(2, 2, dtype=torch.float)
+
+    def forward(self, x: torch.Tensor):
+        # Independent branches, some of which the memory plan may place in the
+        # memory of tensors that other branches still read.
+        c = (x + self.a) * (x * self.b)
+        d = x - self.a
+        e = x * self.a
+        return c + d * e
+
+    def get_random_inputs(self):
+        return (torch.randn(2, 2, dtype=torch.float),)
+
+
 class ModuleSimpleTrain(torch.nn.Module):
     def __init__(self):
         super().__init__()
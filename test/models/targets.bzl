@@ -60,11 +60,13 @@ def define_common_targets():
     # Class names of nn.Modules for :exported_programs to export.
     MODULES_TO_EXPORT = [
         "ModuleAdd",
+        "ModuleAddDynamicBatch",
         "ModuleAddHalf",
         "ModuleBasic",
         "ModuleLinear",
         "ModuleMultipleEntry",
         "ModuleIndex",
+        "ModuleParallelBranches",
         "ModuleDynamicCatUnallocatedIO",
         "ModuleSimpleTrain",
     ]